@@ -15,14 +15,53 @@
 #endif
 
 
+#include <chrono>
+#include <cstdint>
+#include <cmath>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <limits>
 
+//Narrow-band sparse output ("SDFS"), read by Claymore's SparseLevelSet. Flags and values from make_sparse_level_set3.
+static void write_sparse(const std::string &outname, int ni, int nj, int nk, const Vec3f &origin, float dx, int block_size, float band,
+                         const std::vector<unsigned char> &flags, const std::vector<float> &values) {
+  int32_t header_i[3] = {ni, nj, nk};
+  float header_f[4] = {origin[0], origin[1], origin[2], dx};
+  int32_t near_count = (int32_t)(values.size() / ((size_t)block_size*block_size*block_size));
+  std::ofstream outfile(outname.c_str(), std::ios::binary);
+  outfile.write("SDFS", 4);
+  outfile.write(reinterpret_cast<const char*>(header_i), sizeof(header_i));
+  outfile.write(reinterpret_cast<const char*>(header_f), sizeof(header_f));
+  outfile.write(reinterpret_cast<const char*>(&block_size), sizeof(int32_t));
+  outfile.write(reinterpret_cast<const char*>(&band), sizeof(float));
+  outfile.write(reinterpret_cast<const char*>(&near_count), sizeof(near_count));
+  outfile.write(reinterpret_cast<const char*>(flags.data()), flags.size());
+  outfile.write(reinterpret_cast<const char*>(values.data()), values.size()*sizeof(float));
+  outfile.close();
+  std::cout << "Narrow-band blocks: " << near_count << " of " << flags.size() << ", "
+            << (flags.size() + values.size()*sizeof(float)) / (1024.0*1024.0) << " MB instead of "
+            << (double)ni*nj*nk*sizeof(float) / (1024.0*1024.0) << " MB dense.\n";
+}
+
 int main(int argc, char* argv[]) {
   
-  if(argc != 4) {
+  //optional flags after the three positional arguments
+  bool binary = false;
+  bool sparse = false;
+  float band_cells = 3.f;
+  int num_threads = 0;
+  bool bad_flag = false;
+  for(int a = 4; a < argc; ++a) {
+    std::string flag(argv[a]);
+    if(flag == "-b" || flag == "--binary") binary = true;
+    else if(flag == "-s" || flag == "--sparse") sparse = true;
+    else if(flag == "--band" && a+1 < argc) std::stringstream(argv[++a]) >> band_cells;
+    else if((flag == "-t" || flag == "--threads") && a+1 < argc) std::stringstream(argv[++a]) >> num_threads;
+    else bad_flag = true;
+  }
+
+  if(argc < 4 || bad_flag) {
     std::cout << "SDFGen - A utility for converting closed oriented triangle meshes into grid-based signed distance fields.\n";
     std::cout << "\nThe output file format is:";
     std::cout << "<ni> <nj> <nk>\n";
@@ -37,11 +76,22 @@ int main(int argc, char* argv[]) {
 
     std::cout << "The output filename will match that of the input, with the OBJ suffix replaced with SDF.\n\n";
 
-    std::cout << "Usage: SDFGen <filename> <dx> <padding>\n\n";
+    std::cout << "With --binary the same fields are written raw (little-endian) after the 4-byte magic \"SDFB\":\n";
+    std::cout << "int32 ni, nj, nk; float32 origin_x, origin_y, origin_z; float32 dx; float32 values[ni*nj*nk].\n\n";
+
+    std::cout << "With --sparse only blocks of 8^3 cells near the surface keep their values, after the magic \"SDFS\":\n";
+    std::cout << "int32 ni, nj, nk; float32 origin_x, origin_y, origin_z; float32 dx; int32 block_size; float32 band; int32 near_blocks;\n";
+    std::cout << "uint8 flags[block count] (0 outside, 1 inside, 2 near); float32 values[near_blocks][block_size^3].\n\n";
+
+    std::cout << "Usage: SDFGen <filename> <dx> <padding> [--binary] [--sparse [--band <cells>]] [--threads <n>]\n\n";
     std::cout << "Where:\n";
     std::cout << "\t<filename> specifies a Wavefront OBJ (text) file representing a *triangle* mesh (no quad or poly meshes allowed). File must use the suffix \".obj\".\n";
     std::cout << "\t<dx> specifies the length of grid cell in the resulting distance field.\n";
-    std::cout << "\t<padding> specifies the number of cells worth of padding between the object bound box and the boundary of the distance field grid. Minimum is 1.\n\n";
+    std::cout << "\t<padding> specifies the number of cells worth of padding between the object bound box and the boundary of the distance field grid. Minimum is 1.\n";
+    std::cout << "\t--binary (-b) writes the binary SDF format instead of text (and instead of VTK output, if compiled with VTK).\n";
+    std::cout << "\t--sparse (-s) writes the narrow-band sparse SDF format, for geometries too large for a dense grid.\n";
+    std::cout << "\t--band <cells> sets the narrow-band half-width in cells for --sparse. Default is 3, minimum is 2.\n";
+    std::cout << "\t--threads (-t) <n> sets the number of worker threads. Default uses all hardware threads.\n\n";
     
     exit(-1);
   }
@@ -119,12 +169,49 @@ int main(int argc, char* argv[]) {
   
   std::cout << "Bound box size: (" << min_box << ") to (" << max_box << ") with dimensions " << sizes << "." << std::endl;
 
+  if(sparse) {
+    //no dense grid at all, memory follows the surface
+    const int block_size = 8;
+    band_cells = max(band_cells, 2.f); //2 cells keeps trilinear signs exact beside far blocks
+    std::cout << "Computing narrow-band signed distance field.\n";
+    std::vector<unsigned char> flags;
+    std::vector<float> values;
+    auto start = std::chrono::steady_clock::now();
+    make_sparse_level_set3(faceList, vertList, min_box, dx, sizes[0], sizes[1], sizes[2], block_size, band_cells, flags, values, num_threads);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Computed in " << elapsed.count() << " seconds.\n";
+    std::string outname = filename.substr(0, filename.size()-4) + std::string(".sdf");
+    std::cout << "Writing sparse results to: " << outname << "\n";
+    write_sparse(outname, sizes[0], sizes[1], sizes[2], min_box, dx, block_size, band_cells*dx, flags, values);
+    std::cout << "Processing complete.\n";
+    return 0;
+  }
+
   std::cout << "Computing signed distance field.\n";
   Array3f phi_grid;
-  make_level_set3(faceList, vertList, min_box, dx, sizes[0], sizes[1], sizes[2], phi_grid);
+  auto start = std::chrono::steady_clock::now();
+  make_level_set3(faceList, vertList, min_box, dx, sizes[0], sizes[1], sizes[2], phi_grid, 1, num_threads);
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  std::cout << "Computed in " << elapsed.count() << " seconds.\n";
 
   std::string outname;
 
+  if(binary) {
+    outname = filename.substr(0, filename.size()-4) + std::string(".sdf");
+    std::cout << "Writing binary results to: " << outname << "\n";
+
+    std::ofstream outfile(outname.c_str(), std::ios::binary);
+    int32_t dims[3] = {phi_grid.ni, phi_grid.nj, phi_grid.nk};
+    float header[4] = {min_box[0], min_box[1], min_box[2], dx};
+    outfile.write("SDFB", 4);
+    outfile.write(reinterpret_cast<const char*>(dims), sizeof(dims));
+    outfile.write(reinterpret_cast<const char*>(header), sizeof(header));
+    outfile.write(reinterpret_cast<const char*>(phi_grid.a.data), phi_grid.a.size()*sizeof(float));
+    outfile.close();
+    std::cout << "Processing complete.\n";
+    return 0;
+  }
+
   #ifdef HAVE_VTK
     // If compiled with VTK, we can directly output a volumetric image format instead
     //Very hackily strip off file suffix.
@@ -169,7 +256,7 @@ int main(int argc, char* argv[]) {
     outfile << min_box[0] << " " << min_box[1] << " " << min_box[2] << std::endl;
     outfile << dx << std::endl;
     for(unsigned int i = 0; i < phi_grid.a.size(); ++i) {
-      outfile << phi_grid.a[i] << std::endl;
+      outfile << phi_grid.a[i] << '\n'; //no per-value flush
     }
     outfile.close();
   #endif
@@ -1,5 +1,30 @@
 #include "makelevelset3.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <thread>
+
+// run f(n) for n in [0,count) on up to num_threads threads, handing out items one at a time
+template<class F>
+static void parallel_for(int count, int num_threads, const F &f)
+{
+   num_threads=min(num_threads, count);
+   if(num_threads<=1){
+      for(int n=0; n<count; ++n) f(n);
+      return;
+   }
+   std::atomic<int> next(0);
+   auto worker=[&](){ for(int n=next++; n<count; n=next++) f(n); };
+   std::vector<std::thread> pool;
+   for(int t=1; t<num_threads; ++t) pool.emplace_back(worker);
+   worker();
+   for(unsigned int t=0; t<pool.size(); ++t) pool[t].join();
+}
+
 // find distance x0 is from segment x1-x2
 static float point_segment_distance(const Vec3f &x0, const Vec3f &x1, const Vec3f &x2)
 {
@@ -54,28 +79,40 @@ static void check_neighbour(const std::vector<Vec3ui> &tri, const std::vector<Ve
    }
 }
 
+// one fast-sweeping pass in direction (di,dj,dk), done as a wavefront over tiles of sweep_tile^3 cells.
+// every neighbour read lies upwind in all three axes, so it sits in the same tile or in a tile of an
+// earlier wavefront; tiles on one wavefront are independent and the result matches the serial sweep.
+static const int sweep_tile=16;
+
 static void sweep(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x,
                   Array3f &phi, Array3i &closest_tri, const Vec3f &origin, float dx,
-                  int di, int dj, int dk)
+                  int di, int dj, int dk, int num_threads)
 {
-   int i0, i1;
-   if(di>0){ i0=1; i1=phi.ni; }
-   else{ i0=phi.ni-2; i1=-1; }
-   int j0, j1;
-   if(dj>0){ j0=1; j1=phi.nj; }
-   else{ j0=phi.nj-2; j1=-1; }
-   int k0, k1;
-   if(dk>0){ k0=1; k1=phi.nk; }
-   else{ k0=phi.nk-2; k1=-1; }
-   for(int k=k0; k!=k1; k+=dk) for(int j=j0; j!=j1; j+=dj) for(int i=i0; i!=i1; i+=di){
-      Vec3f gx(i*dx+origin[0], j*dx+origin[1], k*dx+origin[2]);
-      check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i-di, j,    k);
-      check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i,    j-dj, k);
-      check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i-di, j-dj, k);
-      check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i,    j,    k-dk);
-      check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i-di, j,    k-dk);
-      check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i,    j-dj, k-dk);
-      check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i-di, j-dj, k-dk);
+   int i0=(di>0) ? 1 : phi.ni-2, j0=(dj>0) ? 1 : phi.nj-2, k0=(dk>0) ? 1 : phi.nk-2;
+   int ci=phi.ni-1, cj=phi.nj-1, ck=phi.nk-1; // cells visited along each axis
+   if(ci<=0 || cj<=0 || ck<=0) return;
+   int ti=(ci+sweep_tile-1)/sweep_tile, tj=(cj+sweep_tile-1)/sweep_tile, tk=(ck+sweep_tile-1)/sweep_tile;
+   std::vector<Vec3i> tiles;
+   for(int wave=0; wave<ti+tj+tk-2; ++wave){
+      tiles.clear();
+      for(int c=max(0, wave-(ti-1)-(tj-1)); c<=min(tk-1, wave); ++c)
+         for(int b=max(0, wave-c-(ti-1)); b<=min(tj-1, wave-c); ++b)
+            tiles.push_back(Vec3i(wave-c-b, b, c));
+      parallel_for((int)tiles.size(), num_threads, [&](int n){
+         const Vec3i &tile=tiles[n];
+         int pk1=min(ck, (tile[2]+1)*sweep_tile), pj1=min(cj, (tile[1]+1)*sweep_tile), pi1=min(ci, (tile[0]+1)*sweep_tile);
+         for(int pk=tile[2]*sweep_tile; pk<pk1; ++pk) for(int pj=tile[1]*sweep_tile; pj<pj1; ++pj) for(int pi=tile[0]*sweep_tile; pi<pi1; ++pi){
+            int i=i0+pi*di, j=j0+pj*dj, k=k0+pk*dk;
+            Vec3f gx(i*dx+origin[0], j*dx+origin[1], k*dx+origin[2]);
+            check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i-di, j,    k);
+            check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i,    j-dj, k);
+            check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i-di, j-dj, k);
+            check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i,    j,    k-dk);
+            check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i-di, j,    k-dk);
+            check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i,    j-dj, k-dk);
+            check_neighbour(tri, x, phi, closest_tri, gx, i, j, k, i-di, j-dj, k-dk);
+         }
+      });
    }
 }
 
@@ -117,14 +154,19 @@ static bool point_in_triangle_2d(double x0, double y0,
 
 void make_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x,
                      const Vec3f &origin, float dx, int ni, int nj, int nk,
-                     Array3f &phi, const int exact_band)
+                     Array3f &phi, const int exact_band, int num_threads)
 {
+   if(num_threads<=0) num_threads=max(1, (int)std::thread::hardware_concurrency());
    phi.resize(ni, nj, nk);
    phi.assign((ni+nj+nk)*dx); // upper bound on distance
    Array3i closest_tri(ni, nj, nk, -1);
    Array3i intersection_count(ni, nj, nk, 0); // intersection_count(i,j,k) is # of tri intersections in (i-1,i]x{j}x{k}
-   // we begin by initializing distances near the mesh, and figuring out intersection counts
-   Vec3f ijkmin, ijkmax;
+   // we begin by initializing distances near the mesh, and figuring out intersection counts.
+   // the grid is split into k-slabs, each owned by one thread. a slab visits every triangle overlapping it,
+   // in order, so ties between triangles resolve exactly as in a single pass over the mesh.
+   int num_slabs=(num_threads>1) ? min(nk, 4*num_threads) : 1;
+   parallel_for(num_slabs, num_threads, [&](int slab){
+   int slab_k0=slab*nk/num_slabs, slab_k1=(slab+1)*nk/num_slabs-1;
    for(unsigned int t=0; t<tri.size(); ++t){
      unsigned int p, q, r; assign(tri[t], p, q, r);
      // coordinates in grid to high precision
@@ -135,6 +177,7 @@ void make_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x
       int i0=clamp(int(min(fip,fiq,fir))-exact_band, 0, ni-1), i1=clamp(int(max(fip,fiq,fir))+exact_band+1, 0, ni-1);
       int j0=clamp(int(min(fjp,fjq,fjr))-exact_band, 0, nj-1), j1=clamp(int(max(fjp,fjq,fjr))+exact_band+1, 0, nj-1);
       int k0=clamp(int(min(fkp,fkq,fkr))-exact_band, 0, nk-1), k1=clamp(int(max(fkp,fkq,fkr))+exact_band+1, 0, nk-1);
+      k0=max(k0, slab_k0); k1=min(k1, slab_k1);
       for(int k=k0; k<=k1; ++k) for(int j=j0; j<=j1; ++j) for(int i=i0; i<=i1; ++i){
          Vec3f gx(i*dx+origin[0], j*dx+origin[1], k*dx+origin[2]);
          float d=point_triangle_distance(gx, x[p], x[q], x[r]);
@@ -148,6 +191,7 @@ void make_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x
       j1=clamp((int)std::floor(max(fjp,fjq,fjr)), 0, nj-1);
       k0=clamp((int)std::ceil(min(fkp,fkq,fkr)), 0, nk-1);
       k1=clamp((int)std::floor(max(fkp,fkq,fkr)), 0, nk-1);
+      k0=max(k0, slab_k0); k1=min(k1, slab_k1);
       for(int k=k0; k<=k1; ++k) for(int j=j0; j<=j1; ++j){
          double a, b, c;
          if(point_in_triangle_2d(j, k, fjp, fkp, fjq, fkq, fjr, fkr, a, b, c)){
@@ -159,19 +203,21 @@ void make_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x
          }
       }
    }
+   });
    // and now we fill in the rest of the distances with fast sweeping
    for(unsigned int pass=0; pass<2; ++pass){
-      sweep(tri, x, phi, closest_tri, origin, dx, +1, +1, +1);
-      sweep(tri, x, phi, closest_tri, origin, dx, -1, -1, -1);
-      sweep(tri, x, phi, closest_tri, origin, dx, +1, +1, -1);
-      sweep(tri, x, phi, closest_tri, origin, dx, -1, -1, +1);
-      sweep(tri, x, phi, closest_tri, origin, dx, +1, -1, +1);
-      sweep(tri, x, phi, closest_tri, origin, dx, -1, +1, -1);
-      sweep(tri, x, phi, closest_tri, origin, dx, +1, -1, -1);
-      sweep(tri, x, phi, closest_tri, origin, dx, -1, +1, +1);
+      sweep(tri, x, phi, closest_tri, origin, dx, +1, +1, +1, num_threads);
+      sweep(tri, x, phi, closest_tri, origin, dx, -1, -1, -1, num_threads);
+      sweep(tri, x, phi, closest_tri, origin, dx, +1, +1, -1, num_threads);
+      sweep(tri, x, phi, closest_tri, origin, dx, -1, -1, +1, num_threads);
+      sweep(tri, x, phi, closest_tri, origin, dx, +1, -1, +1, num_threads);
+      sweep(tri, x, phi, closest_tri, origin, dx, -1, +1, -1, num_threads);
+      sweep(tri, x, phi, closest_tri, origin, dx, +1, -1, -1, num_threads);
+      sweep(tri, x, phi, closest_tri, origin, dx, -1, +1, +1, num_threads);
    }
    // then figure out signs (inside/outside) from intersection counts
-   for(int k=0; k<nk; ++k) for(int j=0; j<nj; ++j){
+   parallel_for(nk, num_threads, [&](int k){
+   for(int j=0; j<nj; ++j){
       int total_count=0;
       for(int i=0; i<ni; ++i){
          total_count+=intersection_count(i,j,k);
@@ -180,5 +226,138 @@ void make_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x
          }
       }
    }
+   });
 }
 
+void make_sparse_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x,
+                            const Vec3f &origin, float dx, int ni, int nj, int nk,
+                            int block_size, float band_cells,
+                            std::vector<unsigned char> &flags, std::vector<float> &values, int num_threads)
+{
+   if(num_threads<=0) num_threads=max(1, (int)std::thread::hardware_concurrency());
+   const int bs=block_size;
+   const size_t bs3=(size_t)bs*bs*bs;
+   const float band=band_cells*dx;
+   const int reach=(int)std::ceil(band_cells)+1; // a cell within the band of a triangle lies within reach cells of its bound box
+   const int nbi=(ni+bs-1)/bs, nbj=(nj+bs-1)/bs, nbk=(nk+bs-1)/bs;
+   auto block_index=[&](int bi, int bj, int bk){ return bi+(uint64_t)nbi*(bj+(uint64_t)nbj*bk); };
+   // cells of triangle t's bound box grown by reach
+   auto cell_box=[&](unsigned int t, int lo[3], int hi[3]){
+      unsigned int p, q, r; assign(tri[t], p, q, r);
+      const int n[3]={ni, nj, nk};
+      for(int d=0; d<3; ++d){
+         double fp=((double)x[p][d]-origin[d])/dx, fq=((double)x[q][d]-origin[d])/dx, fr=((double)x[r][d]-origin[d])/dx;
+         lo[d]=clamp((int)std::floor(min(fp,fq,fr))-reach, 0, n[d]-1);
+         hi[d]=clamp((int)std::ceil(max(fp,fq,fr))+reach, 0, n[d]-1);
+      }
+   };
+   // candidate blocks touched by a grown triangle box, merged in chunks so memory stays near the block count
+   std::vector<uint64_t> blocks, chunk, merged;
+   auto merge_chunk=[&](){
+      std::sort(chunk.begin(), chunk.end());
+      chunk.erase(std::unique(chunk.begin(), chunk.end()), chunk.end());
+      merged.clear();
+      std::set_union(blocks.begin(), blocks.end(), chunk.begin(), chunk.end(), std::back_inserter(merged));
+      blocks.swap(merged);
+      chunk.clear();
+   };
+   // parity crossings (row j+nj*k, i_interval) of make_level_set3, they grow with the surface, not the grid
+   std::vector<std::pair<uint64_t, int> > crossings;
+   for(unsigned int t=0; t<tri.size(); ++t){
+      int lo[3], hi[3]; cell_box(t, lo, hi);
+      for(int bk=lo[2]/bs; bk<=hi[2]/bs; ++bk) for(int bj=lo[1]/bs; bj<=hi[1]/bs; ++bj) for(int bi=lo[0]/bs; bi<=hi[0]/bs; ++bi)
+         chunk.push_back(block_index(bi, bj, bk));
+      if(chunk.size()>=(1u<<20)) merge_chunk();
+      unsigned int p, q, r; assign(tri[t], p, q, r);
+      double fip=((double)x[p][0]-origin[0])/dx, fjp=((double)x[p][1]-origin[1])/dx, fkp=((double)x[p][2]-origin[2])/dx;
+      double fiq=((double)x[q][0]-origin[0])/dx, fjq=((double)x[q][1]-origin[1])/dx, fkq=((double)x[q][2]-origin[2])/dx;
+      double fir=((double)x[r][0]-origin[0])/dx, fjr=((double)x[r][1]-origin[1])/dx, fkr=((double)x[r][2]-origin[2])/dx;
+      int j0=clamp((int)std::ceil(min(fjp,fjq,fjr)), 0, nj-1), j1=clamp((int)std::floor(max(fjp,fjq,fjr)), 0, nj-1);
+      int k0=clamp((int)std::ceil(min(fkp,fkq,fkr)), 0, nk-1), k1=clamp((int)std::floor(max(fkp,fkq,fkr)), 0, nk-1);
+      for(int k=k0; k<=k1; ++k) for(int j=j0; j<=j1; ++j){
+         double a, b, c;
+         if(point_in_triangle_2d(j, k, fjp, fkp, fjq, fkq, fjr, fkr, a, b, c)){
+            int i_interval=int(std::ceil(a*fip+b*fiq+c*fir));
+            if(i_interval<ni) crossings.push_back(std::make_pair(j+(uint64_t)nj*k, max(i_interval, 0)));
+         }
+      }
+   }
+   merge_chunk();
+   std::vector<uint64_t>().swap(merged);
+   std::sort(crossings.begin(), crossings.end());
+   // triangles of each candidate block (compressed rows), in mesh order so ties resolve as in make_level_set3
+   const int candidates=(int)blocks.size();
+   std::vector<size_t> starts(candidates+1, 0);
+   std::vector<unsigned int> tris;
+   for(int pass=0; pass<2; ++pass){
+      if(pass==1){
+         for(int c=0; c<candidates; ++c) starts[c+1]+=starts[c];
+         tris.resize(starts[candidates]);
+      }
+      std::vector<size_t> fill(starts.begin(), starts.end()-1);
+      for(unsigned int t=0; t<tri.size(); ++t){
+         int lo[3], hi[3]; cell_box(t, lo, hi);
+         for(int bk=lo[2]/bs; bk<=hi[2]/bs; ++bk) for(int bj=lo[1]/bs; bj<=hi[1]/bs; ++bj) for(int bi=lo[0]/bs; bi<=hi[0]/bs; ++bi){
+            size_t c=std::lower_bound(blocks.begin(), blocks.end(), block_index(bi, bj, bk))-blocks.begin();
+            if(pass==0) ++starts[c+1];
+            else tris[fill[c]++]=t;
+         }
+      }
+   }
+   // inside if an odd number of crossings lie at or before i in the row
+   auto inside=[&](int i, int j, int k){
+      uint64_t row=j+(uint64_t)nj*k;
+      auto first=std::lower_bound(crossings.begin(), crossings.end(), std::make_pair(row, std::numeric_limits<int>::min()));
+      auto last=std::upper_bound(first, crossings.end(), std::make_pair(row, i));
+      return ((last-first)&1)!=0;
+   };
+   std::vector<float> candidate_values((size_t)candidates*bs3);
+   std::vector<char> near(candidates, 0);
+   parallel_for(candidates, num_threads, [&](int c){
+      uint64_t b=blocks[c];
+      int bi=(int)(b%nbi), bj=(int)((b/nbi)%nbj), bk=(int)(b/((uint64_t)nbi*nbj));
+      int ci0=bi*bs, cj0=bj*bs, ck0=bk*bs;
+      int ci1=min(ci0+bs, ni)-1, cj1=min(cj0+bs, nj)-1, ck1=min(ck0+bs, nk)-1;
+      float *block=candidate_values.data()+(size_t)c*bs3;
+      std::fill(block, block+bs3, std::numeric_limits<float>::max());
+      for(size_t n=starts[c]; n<starts[c+1]; ++n){
+         unsigned int p, q, r; assign(tri[tris[n]], p, q, r);
+         int lo[3], hi[3]; cell_box(tris[n], lo, hi);
+         for(int k=max(ck0, lo[2]); k<=min(ck1, hi[2]); ++k)
+            for(int j=max(cj0, lo[1]); j<=min(cj1, hi[1]); ++j)
+               for(int i=max(ci0, lo[0]); i<=min(ci1, hi[0]); ++i){
+                  Vec3f gx(i*dx+origin[0], j*dx+origin[1], k*dx+origin[2]);
+                  float d=point_triangle_distance(gx, x[p], x[q], x[r]);
+                  float &v=block[(i-ci0)+bs*((j-cj0)+(size_t)bs*(k-ck0))];
+                  if(d<v) v=d;
+               }
+      }
+      for(int k=ck0; k<=ck1; ++k) for(int j=cj0; j<=cj1; ++j){
+         uint64_t row=j+(uint64_t)nj*k;
+         auto it=std::lower_bound(crossings.begin(), crossings.end(), std::make_pair(row, std::numeric_limits<int>::min()));
+         int count=0;
+         for(int i=ci0; i<=ci1; ++i){
+            while(it!=crossings.end() && it->first==row && it->second<=i){ ++count; ++it; }
+            float &v=block[(i-ci0)+bs*((j-cj0)+(size_t)bs*(k-ck0))];
+            near[c]=near[c] || v<=band;
+            v=min(v, band); // beyond the band only the sign is kept, as far blocks read back
+            if(count&1) v=-v;
+         }
+      }
+      for(int k=0; k<bs; ++k) for(int j=0; j<bs; ++j) for(int i=0; i<bs; ++i) // pad past the grid edge
+         if(ci0+i>ci1 || cj0+j>cj1 || ck0+k>ck1)
+            block[i+bs*(j+(size_t)bs*k)]=block[min(i, ci1-ci0)+bs*(min(j, cj1-cj0)+(size_t)bs*min(k, ck1-ck0))];
+   });
+   // far blocks are one sign throughout, as a crossing puts both neighbouring cells within the band
+   flags.assign((size_t)nbi*nbj*nbk, 0);
+   parallel_for(nbk, num_threads, [&](int bk){
+      for(int bj=0; bj<nbj; ++bj) for(int bi=0; bi<nbi; ++bi)
+         flags[block_index(bi, bj, bk)]=inside(bi*bs, bj*bs, bk*bs) ? 1 : 0;
+   });
+   values.clear();
+   for(int c=0; c<candidates; ++c){
+      if(!near[c]) continue;
+      flags[blocks[c]]=2;
+      values.insert(values.end(), candidate_values.begin()+(size_t)c*bs3, candidate_values.begin()+(size_t)(c+1)*bs3);
+   }
+}
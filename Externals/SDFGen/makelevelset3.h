@@ -9,8 +9,19 @@
 // needed for accurate signs. Distances for all grid cells within exact_band cells of
 // a triangle should be exact; further away a distance is calculated but it might not
 // be to the closest triangle - just one nearby.
+// num_threads<=0 uses all hardware threads; the result does not depend on the thread count.
 void make_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x,
                      const Vec3f &origin, float dx, int nx, int ny, int nz,
-                     Array3f &phi, const int exact_band=1);
+                     Array3f &phi, const int exact_band=1, int num_threads=0);
+
+// narrow-band version for grids too large to hold densely. the grid is tiled into block_size^3 blocks,
+// only blocks with a cell within band_cells of the surface get values (exact distances clamped to +-band,
+// signs from the same ray parity as make_level_set3), every other block gets flag 0 (outside) or 1 (inside).
+// near blocks are flagged 2 and their values appended to values in block order, cell i fastest; cells past
+// the grid edge repeat the last cell. memory follows the surface area, not the grid volume.
+void make_sparse_level_set3(const std::vector<Vec3ui> &tri, const std::vector<Vec3f> &x,
+                            const Vec3f &origin, float dx, int ni, int nj, int nk,
+                            int block_size, float band_cells,
+                            std::vector<unsigned char> &flags, std::vector<float> &values, int num_threads=0);
 
 #endif
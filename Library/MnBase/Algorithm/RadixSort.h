@@ -0,0 +1,161 @@
+#ifndef __RADIX_SORT_H_
+#define __RADIX_SORT_H_
+#include <MnBase/Concurrency/Concurrency.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+namespace mn {
+
+/// @brief Stable LSD radix sort of (key, value) pairs on the host by key bits [begin_bit, end_bit), as cub::DeviceRadixSort::SortPairs.
+/// Each pass: per-chunk digit histograms, a digit-major exclusive scan over chunks, then a stable scatter. No atomics.
+/// Digits are up to 11 bits wide, as few passes as the bit range needs. Passes whose digit is the same for every key are skipped.
+/// Sorted pairs end up in keys / values; keys_alt / values_alt are scratch of the same size.
+template <typename Key, typename Value>
+void radix_sort_pairs(thread_pool &pool, std::size_t count, Key *keys, Value *values, Key *keys_alt, Value *values_alt,
+                      int end_bit = 8 * static_cast<int>(sizeof(Key)), int begin_bit = 0) {
+  static_assert(std::is_unsigned<Key>::value, "radix_sort_pairs needs unsigned integer keys");
+  if (count < 2 || end_bit <= begin_bit) return;
+  const int passes = (end_bit - begin_bit + 10) / 11;
+  const int radix_bits = (end_bit - begin_bit + passes - 1) / passes;
+  const std::size_t radix = std::size_t{1} << radix_bits;
+  const std::size_t chunks = std::min<std::size_t>((count + 65535) / 65536, static_cast<std::size_t>(pool.size()) * 4);
+  const std::size_t chunk_size = (count + chunks - 1) / chunks;
+  std::vector<std::size_t> hist(chunks * radix);
+  Key *src_k = keys, *dst_k = keys_alt;
+  Value *src_v = values, *dst_v = values_alt;
+
+  for (int shift = begin_bit; shift < end_bit; shift += radix_bits) {
+    const std::size_t mask = (std::size_t{1} << std::min(radix_bits, end_bit - shift)) - 1;
+    std::fill(hist.begin(), hist.end(), 0);
+    pool.parallel_for(chunks, [&](std::size_t cb, std::size_t ce) {
+      for (std::size_t c = cb; c < ce; ++c) {
+        std::size_t *h = hist.data() + c * radix;
+        const std::size_t end = std::min(count, (c + 1) * chunk_size);
+        for (std::size_t i = c * chunk_size; i < end; ++i) ++h[(src_k[i] >> shift) & mask];
+      }
+    });
+    // Digit-major, chunk-minor offsets keep equal digits in input order (stability)
+    std::size_t offset = 0;
+    bool trivial = false;
+    for (std::size_t d = 0; d < radix; ++d) {
+      std::size_t digit_count = 0;
+      for (std::size_t c = 0; c < chunks; ++c) {
+        std::size_t n = hist[c * radix + d];
+        hist[c * radix + d] = offset;
+        offset += n, digit_count += n;
+      }
+      if (digit_count == count) trivial = true;
+    }
+    if (trivial) continue; //< Every key has this digit
+    pool.parallel_for(chunks, [&](std::size_t cb, std::size_t ce) {
+      for (std::size_t c = cb; c < ce; ++c) {
+        std::size_t *h = hist.data() + c * radix;
+        const std::size_t end = std::min(count, (c + 1) * chunk_size);
+        for (std::size_t i = c * chunk_size; i < end; ++i) {
+          std::size_t dst = h[(src_k[i] >> shift) & mask]++;
+          dst_k[dst] = src_k[i], dst_v[dst] = src_v[i];
+        }
+      }
+    });
+    std::swap(src_k, dst_k), std::swap(src_v, dst_v);
+  }
+  if (src_k != keys) { //< Odd number of scatter passes
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      std::memcpy(keys + b, src_k + b, (e - b) * sizeof(Key));
+      std::memcpy(values + b, src_v + b, (e - b) * sizeof(Value));
+    }, 1 << 16);
+  }
+}
+
+/// @brief Host particle binning by (block number, cell number), the counterpart of build_particle_cell_buckets,
+/// cell_bucket_to_block and compute_bin_capacity + exclScan, in the same layout: _ppcs, _ppbs, _binsts, and block
+/// buckets padded to MaxPPC * BlockVolume (g_particle_num_per_block) entries per block. As the kernels, a cell keeps at most
+/// MaxPPC particles and the rest are dropped (counted in dropped). Unused bucket entries are -1.
+/// Instead of contended per-cell atomics: a parallel radix sort by block number, then a counting sort by cell within each block
+/// (in cache, one block per task). Bucket order within a block is deterministic: by cell, then by particle ID,
+/// so overflowing cells keep their lowest particle IDs. The kernels keep whichever particles arrive first.
+template <int BlockVolume, int BinCapacity, int MaxPPC>
+struct particle_bins {
+  static_assert((BlockVolume & (BlockVolume - 1)) == 0, "BlockVolume must be a power of 2");
+  static constexpr int particle_num_per_block = MaxPPC * BlockVolume; //< Bucket stride of a block, as g_particle_num_per_block
+  std::vector<int> ppcs;    //< Particles per cell, [blockno * BlockVolume + cellno], as _ppcs
+  std::vector<int> ppbs;    //< Particles per block, as _ppbs
+  std::vector<int> binsts;  //< First particle bin of block, block_count + 1 entries, as _binsts
+  std::vector<int> buckets; //< Particle IDs of block b at [b * particle_num_per_block, + ppbs[b]), as _blockbuckets
+  std::size_t dropped = 0;  //< Particles beyond MaxPPC in their cell, not binned
+
+  /// Particle bins of all blocks, as bincnt
+  int bin_count() const noexcept { return binsts.empty() ? 0 : binsts.back(); }
+
+  /// @brief Bin count particles. cell_keys[p] = blockno * BlockVolume + cellno of particle p, blockno < block_count.
+  void build(thread_pool &pool, std::size_t count, const uint32_t *cell_keys, int block_count) {
+    constexpr int cell_bits = ilog2(BlockVolume);
+    keys.resize(count), keys_alt.resize(count), ids.resize(count), ids_alt.resize(count);
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      std::memcpy(keys.data() + b, cell_keys + b, (e - b) * sizeof(uint32_t));
+      for (std::size_t p = b; p < e; ++p) ids[p] = static_cast<int>(p);
+    }, 1 << 16);
+    int end_bit = cell_bits;
+    while ((uint64_t(1) << end_bit) < uint64_t(block_count) * BlockVolume) ++end_bit;
+    radix_sort_pairs(pool, count, keys.data(), ids.data(), keys_alt.data(), ids_alt.data(), end_bit, cell_bits);
+
+    // Start of each block's run of sorted keys, written once per block
+    runs.assign(block_count + 1, -1);
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i)
+        if (i == 0 || (keys[i] >> cell_bits) != (keys[i - 1] >> cell_bits)) runs[keys[i] >> cell_bits] = static_cast<int>(i);
+    }, 1 << 16);
+    runs[block_count] = static_cast<int>(count);
+    for (int blk = block_count - 1; blk >= 0; --blk)
+      if (runs[blk] < 0) runs[blk] = runs[blk + 1]; //< Empty block
+
+    // Per block: cell counts capped at MaxPPC, then IDs by cell into the block's padded bucket
+    ppcs.resize(static_cast<std::size_t>(block_count) * BlockVolume);
+    ppbs.resize(block_count);
+    buckets.resize(static_cast<std::size_t>(block_count) * particle_num_per_block);
+    std::vector<std::size_t> block_dropped(block_count);
+    pool.parallel_for(block_count, [&](std::size_t bb, std::size_t be) {
+      for (std::size_t blk = bb; blk < be; ++blk) {
+        int *cnt = ppcs.data() + blk * BlockVolume;
+        int *bucket = buckets.data() + blk * particle_num_per_block;
+        int offset[BlockVolume], end[BlockVolume];
+        std::fill(cnt, cnt + BlockVolume, 0);
+        for (int i = runs[blk]; i < runs[blk + 1]; ++i) ++cnt[keys[i] & (BlockVolume - 1)];
+        block_dropped[blk] = 0;
+        for (int c = 0, o = 0; c < BlockVolume; ++c) {
+          if (cnt[c] > MaxPPC) block_dropped[blk] += cnt[c] - MaxPPC, cnt[c] = MaxPPC;
+          offset[c] = o, o += cnt[c], end[c] = o;
+        }
+        for (int i = runs[blk]; i < runs[blk + 1]; ++i) {
+          const int c = keys[i] & (BlockVolume - 1);
+          if (offset[c] < end[c]) bucket[offset[c]++] = ids[i];
+        }
+        ppbs[blk] = end[BlockVolume - 1];
+        std::fill(bucket + ppbs[blk], bucket + particle_num_per_block, -1);
+      }
+    }, 16);
+
+    binsts.resize(block_count + 1);
+    int bins = 0;
+    dropped = 0;
+    for (int blk = 0; blk < block_count; ++blk) {
+      binsts[blk] = bins;
+      bins += (ppbs[blk] + BinCapacity - 1) / BinCapacity;
+      dropped += block_dropped[blk];
+    }
+    binsts[block_count] = bins;
+  }
+
+private:
+  static constexpr int ilog2(int v) { return v > 1 ? 1 + ilog2(v >> 1) : 0; }
+  std::vector<uint32_t> keys, keys_alt;
+  std::vector<int> ids, ids_alt, runs;
+};
+
+} // namespace mn
+
+#endif
@@ -2,13 +2,16 @@
 #define __CONCURRENCY_H_
 
 #include <MnBase/Meta/Optional.h>
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
+#include <cstdint>
 #include <future>
 #include <memory>
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <vector>
 
 namespace mn {
 
@@ -88,6 +91,91 @@ public:
   }
 };
 
+/// @brief Persistent worker threads for data-parallel host loops (e.g. CPU MPM backend).
+/// parallel_for splits [0, count) into grain-sized chunks taken by workers and the calling thread, and returns once all are done.
+/// One loop runs at a time; body must not throw.
+class thread_pool {
+public:
+  explicit thread_pool(int num_threads = 0) {
+    if (num_threads <= 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int t = 1; t < num_threads; ++t) workers.emplace_back([this]() { this->worker(); });
+  }
+  ~thread_pool() {
+    {
+      std::lock_guard<std::mutex> lk{mut};
+      stopping = true;
+    }
+    cv_work.notify_all();
+    for (auto &th : workers) th.join();
+  }
+  thread_pool(const thread_pool &) = delete;
+  thread_pool &operator=(const thread_pool &) = delete;
+
+  /// Threads sharing a loop, calling thread included
+  int size() const noexcept { return static_cast<int>(workers.size()) + 1; }
+
+  /// @brief Call body(begin, end) over chunks of [0, count). Serial when count <= grain or pool has one thread.
+  template <typename F>
+  void parallel_for(std::size_t count, F &&body, std::size_t grain = 1) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+    if (workers.empty() || count <= grain) { body(std::size_t{0}, count); return; }
+    job_t j{const_cast<void *>(static_cast<const void *>(std::addressof(body))),
+            [](void *ctx, std::size_t b, std::size_t e) { (*static_cast<std::remove_reference_t<F> *>(ctx))(b, e); },
+            count, grain};
+    {
+      std::lock_guard<std::mutex> lk{mut};
+      job = j;
+      next = 0;
+      busy = static_cast<int>(workers.size());
+      ++generation;
+    }
+    cv_work.notify_all();
+    run(j);
+    std::unique_lock<std::mutex> lk{mut};
+    cv_done.wait(lk, [this]() { return busy == 0; });
+  }
+
+private:
+  struct job_t {
+    void *ctx;
+    void (*call)(void *, std::size_t, std::size_t);
+    std::size_t count, grain;
+  };
+  void run(const job_t &j) {
+    for (;;) {
+      std::size_t b = next.fetch_add(j.grain, std::memory_order_relaxed);
+      if (b >= j.count) break;
+      j.call(j.ctx, b, std::min(b + j.grain, j.count));
+    }
+  }
+  void worker() {
+    uint64_t seen = 0;
+    for (;;) {
+      job_t j;
+      {
+        std::unique_lock<std::mutex> lk{mut};
+        cv_work.wait(lk, [&]() { return stopping || generation != seen; });
+        if (stopping) return;
+        seen = generation;
+        j = job;
+      }
+      run(j);
+      std::lock_guard<std::mutex> lk{mut};
+      if (--busy == 0) cv_done.notify_one();
+    }
+  }
+
+  std::vector<std::thread> workers;
+  std::mutex mut;
+  std::condition_variable cv_work, cv_done;
+  job_t job{};
+  uint64_t generation = 0;
+  int busy = 0;
+  bool stopping = false;
+  std::atomic<std::size_t> next{0};
+};
+
 } // namespace mn
 
 #endif
\ No newline at end of file
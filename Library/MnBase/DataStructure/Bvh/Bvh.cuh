@@ -1,10 +1,375 @@
 #ifndef __BVH_CUH_
 #define __BVH_CUH_
+#include <MnBase/Algorithm/RadixSort.h>
+#include <MnBase/Concurrency/Concurrency.h>
+#include <MnBase/Math/Bit/Bits.h>
+#include <MnBase/Meta/HostDevice.h>
 #include <stdint.h>
-#include <tuple>
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <utility>
+#include <vector>
 
 namespace mn {
 
+namespace bvh_detail {
+__forceinline__ __host__ __device__ int clz64(uint64_t v) {
+#if defined(__CUDA_ARCH__)
+  return __clzll(static_cast<long long>(v));
+#else
+  return v ? __builtin_clzll(v) : 64;
+#endif
 }
+__forceinline__ __host__ __device__ int clz32(uint32_t v) {
+#if defined(__CUDA_ARCH__)
+  return __clz(static_cast<int>(v));
+#else
+  return v ? __builtin_clz(v) : 32;
+#endif
+}
+/// Count a visit of a node during the bottom-up fit, the child boxes written before are visible to the second visitor
+__forceinline__ __host__ __device__ int visit(int *flag) {
+#if defined(__CUDA_ARCH__)
+  __threadfence();
+  return atomicAdd(flag, 1);
+#else
+  return __atomic_fetch_add(flag, 1, __ATOMIC_ACQ_REL);
+#endif
+}
+} // namespace bvh_detail
+
+/// Axis-aligned bounding box, closed on both ends
+template <typename T = float>
+struct aabb {
+  T lo[3], hi[3];
+
+  /// Box that contains nothing, merge() identity
+  static constexpr aabb empty() noexcept {
+    constexpr T m = std::numeric_limits<T>::max();
+    return aabb{{m, m, m}, {-m, -m, -m}};
+  }
+  __forceinline__ __host__ __device__ void merge(const aabb &o) noexcept {
+    for (int d = 0; d < 3; ++d) {
+      lo[d] = lo[d] < o.lo[d] ? lo[d] : o.lo[d];
+      hi[d] = hi[d] > o.hi[d] ? hi[d] : o.hi[d];
+    }
+  }
+  __forceinline__ __host__ __device__ bool overlaps(const aabb &o) const noexcept {
+    return lo[0] <= o.hi[0] && o.lo[0] <= hi[0] && lo[1] <= o.hi[1] && o.lo[1] <= hi[1] && lo[2] <= o.hi[2] &&
+           o.lo[2] <= hi[2];
+  }
+  __forceinline__ __host__ __device__ bool contains(const T *p) const noexcept {
+    return lo[0] <= p[0] && p[0] <= hi[0] && lo[1] <= p[1] && p[1] <= hi[1] && lo[2] <= p[2] && p[2] <= hi[2];
+  }
+  /// Squared distance from p to the box, 0 inside
+  __forceinline__ __host__ __device__ T distance2(const T *p) const noexcept {
+    T d2 = 0;
+    for (int d = 0; d < 3; ++d) {
+      T e = p[d] < lo[d] ? lo[d] - p[d] : (p[d] > hi[d] ? p[d] - hi[d] : T(0));
+      d2 += e * e;
+    }
+    return d2;
+  }
+  __forceinline__ __host__ __device__ T center(int d) const noexcept { return (lo[d] + hi[d]) * T(0.5); }
+};
+
+/// @brief Linear BVH (Karras 2012) over AABB primitives: leaves sorted by the Morton code of their box center,
+/// internal nodes built independently of each other from the sorted codes, boxes fitted bottom-up.
+/// A plain view of device or host memory, passed by value into kernels like block_hash. Every step of the build is a
+/// per-element __host__ __device__ function, so the same code runs in host loops (host_lbvh) and in the kernels below.
+/// Layout: 2n-1 nodes, internal nodes [0, n-1) with the root at 0, leaves [n-1, 2n-1) in Morton order.
+/// A leaf has right == leaf_tag and left = its primitive index. With a single primitive the root is that leaf.
+template <typename T = float>
+struct lbvh {
+  using box_t = aabb<T>;
+  struct node {
+    box_t box;
+    int left, right; //< Child nodes, or primitive index and leaf_tag
+  };
+  static constexpr int leaf_tag = -1;
+  static constexpr int morton_bits = 21; //< Per axis, 63-bit codes
+  /// Stack entries needed by traversal, the tree is at most 63 code bits + 32 index bits deep
+  static constexpr int stack_size = 96;
+
+  int _leafCnt = 0;
+  node *_nodes = nullptr;
+  int *_parents = nullptr; //< Parent of every node, -1 at the root. Build only
+  int *_flags = nullptr;   //< Visits of internal nodes during the fit, zeroed before. Build only
+
+  __forceinline__ __host__ __device__ int leaf_count() const noexcept { return _leafCnt; }
+  __forceinline__ __host__ __device__ int node_count() const noexcept { return _leafCnt ? 2 * _leafCnt - 1 : 0; }
+  __forceinline__ __host__ __device__ const node &operator[](int i) const noexcept { return _nodes[i]; }
+
+  /// Morton code of the box center quantized within bounds (of all centers)
+  static __forceinline__ __host__ __device__ uint64_t morton_code(const box_t &box, const box_t &bounds) noexcept {
+    constexpr T scale = T((1u << morton_bits) - 1);
+    uint32_t q[3];
+    for (int d = 0; d < 3; ++d) {
+      T extent = bounds.hi[d] - bounds.lo[d];
+      T t = extent > T(0) ? (box.center(d) - bounds.lo[d]) / extent : T(0);
+      t = t < T(0) ? T(0) : (t > T(1) ? T(1) : t);
+      q[d] = static_cast<uint32_t>(t * scale);
+    }
+    return morton_encode_3d(q[0], q[1], q[2]);
+  }
+
+  /// Common prefix length of sorted codes i and j, equal codes are told apart by index. -1 if j is out of range.
+  __forceinline__ __host__ __device__ int delta(const uint64_t *codes, int i, int j) const noexcept {
+    if (j < 0 || j >= _leafCnt) return -1;
+    uint64_t x = codes[i] ^ codes[j];
+    return x ? bvh_detail::clz64(x) : 64 + bvh_detail::clz32(static_cast<uint32_t>(i ^ j));
+  }
+  /// Build step 1, leaf k of the sorted primitive ids (also sets its parent to -1 if it is the root)
+  __forceinline__ __host__ __device__ void init_leaf(const box_t *boxes, const int *sorted_ids, int k) const noexcept {
+    _nodes[_leafCnt - 1 + k] = node{boxes[sorted_ids[k]], sorted_ids[k], leaf_tag};
+    if (_leafCnt == 1) _parents[0] = -1;
+  }
+  /// Build step 2, internal node i < n-1 from the sorted codes: find its key range, then the split where the prefix changes
+  __host__ __device__ void build_internal(const uint64_t *codes, int i) const noexcept {
+    const int d = delta(codes, i, i + 1) - delta(codes, i, i - 1) >= 0 ? 1 : -1;
+    const int delta_min = delta(codes, i, i - d);
+    int lmax = 2;
+    while (delta(codes, i, i + lmax * d) > delta_min) lmax *= 2;
+    int l = 0;
+    for (int t = lmax / 2; t >= 1; t /= 2)
+      if (delta(codes, i, i + (l + t) * d) > delta_min) l += t;
+    const int j = i + l * d;
+    const int delta_node = delta(codes, i, j);
+    int s = 0;
+    for (int div = 2;; div *= 2) {
+      const int t = (l + div - 1) / div;
+      if (delta(codes, i, i + (s + t) * d) > delta_node) s += t;
+      if (t <= 1) break;
+    }
+    const int gamma = i + s * d + (d < 0 ? d : 0);
+    const int left = (i < j ? i : j) == gamma ? _leafCnt - 1 + gamma : gamma;
+    const int right = (i > j ? i : j) == gamma + 1 ? _leafCnt - 1 + gamma + 1 : gamma + 1;
+    _nodes[i].left = left, _nodes[i].right = right;
+    _parents[left] = i, _parents[right] = i;
+    if (i == 0) _parents[0] = -1;
+  }
+  /// Build step 3, from leaf k upwards. The second of the two children to arrive fits the parent and carries on.
+  __host__ __device__ void fit_from_leaf(int k) const noexcept {
+    int i = _parents[_leafCnt - 1 + k];
+    while (i >= 0) {
+      if (bvh_detail::visit(_flags + i) == 0) return;
+      box_t box = _nodes[_nodes[i].left].box;
+      box.merge(_nodes[_nodes[i].right].box);
+      _nodes[i].box = box;
+      i = _parents[i];
+    }
+  }
+
+  /// Call f(primitive) for every primitive whose box overlaps q
+  template <typename F>
+  __host__ __device__ void overlap(const box_t &q, F &&f) const {
+    if (!_leafCnt) return;
+    int stack[stack_size];
+    int top = 0;
+    stack[top++] = 0;
+    while (top) {
+      const node &n = _nodes[stack[--top]];
+      if (!n.box.overlaps(q)) continue;
+      if (n.right == leaf_tag)
+        f(n.left);
+      else
+        stack[top++] = n.right, stack[top++] = n.left;
+    }
+  }
+  /// Call f(primitive) for every primitive whose box contains p, e.g. candidate regions of a point-in-region test
+  template <typename F>
+  __host__ __device__ void contain(const T *p, F &&f) const {
+    overlap(box_t{{p[0], p[1], p[2]}, {p[0], p[1], p[2]}}, f);
+  }
+  /// @brief Nearest primitive to p within sqrt(best_d2), nearer child first, subtrees farther than the best so far skipped.
+  /// @param dist2 dist2(primitive, box_d2) returns the squared distance from p to the primitive, box_d2 is the distance
+  /// to its box (a lower bound). Return box_d2 itself to find the nearest box.
+  /// @return Primitive index and its distance in best_d2, or -1 and best_d2 unchanged if none is within range.
+  template <typename F>
+  __host__ __device__ int nearest(const T *p, T &best_d2, F &&dist2) const {
+    if (!_leafCnt) return -1;
+    int best = -1;
+    int stack[stack_size];
+    int top = 0;
+    stack[top++] = 0;
+    while (top) {
+      const node &n = _nodes[stack[--top]];
+      const T box_d2 = n.box.distance2(p);
+      if (box_d2 >= best_d2) continue;
+      if (n.right == leaf_tag) {
+        const T d2 = dist2(n.left, box_d2);
+        if (d2 < best_d2) best_d2 = d2, best = n.left;
+        continue;
+      }
+      const T dl = _nodes[n.left].box.distance2(p), dr = _nodes[n.right].box.distance2(p);
+      const int near = dl <= dr ? n.left : n.right, far = dl <= dr ? n.right : n.left;
+      if ((dl <= dr ? dr : dl) < best_d2) stack[top++] = far;
+      if ((dl <= dr ? dl : dr) < best_d2) stack[top++] = near;
+    }
+    return best;
+  }
+  __host__ __device__ int nearest(const T *p, T &best_d2) const {
+    return nearest(p, best_d2, [](int, T box_d2) { return box_d2; });
+  }
+};
+
+#if defined(__CUDACC__)
+/// Device build, in order: lbvh_morton_codes, sort codes/ids pairs (cub::DeviceRadixSort::SortPairs, 63 bits),
+/// lbvh_init_leaves, lbvh_build_internal, zero _flags, lbvh_fit_boxes. bounds are those of the box centers.
+template <typename T>
+__global__ void lbvh_morton_codes(uint32_t count, const aabb<T> *boxes, aabb<T> bounds, uint64_t *codes, int *ids) {
+  uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= count) return;
+  codes[i] = lbvh<T>::morton_code(boxes[i], bounds);
+  ids[i] = static_cast<int>(i);
+}
+template <typename T>
+__global__ void lbvh_init_leaves(lbvh<T> bvh, const aabb<T> *boxes, const int *sorted_ids) {
+  int k = blockIdx.x * blockDim.x + threadIdx.x;
+  if (k >= bvh.leaf_count()) return;
+  bvh.init_leaf(boxes, sorted_ids, k);
+}
+template <typename T>
+__global__ void lbvh_build_internal(lbvh<T> bvh, const uint64_t *sorted_codes) {
+  int i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= bvh.leaf_count() - 1) return;
+  bvh.build_internal(sorted_codes, i);
+}
+template <typename T>
+__global__ void lbvh_fit_boxes(lbvh<T> bvh) {
+  int k = blockIdx.x * blockDim.x + threadIdx.x;
+  if (k >= bvh.leaf_count()) return;
+  bvh.fit_from_leaf(k);
+}
+/// Batched overlap query, pairs (query, primitive) appended at *cnt. *cnt counts past capacity, rerun with more room if so.
+template <typename T>
+__global__ void lbvh_query_overlaps(lbvh<T> bvh, uint32_t count, const aabb<T> *queries, int *out_query, int *out_prim,
+                                    uint32_t capacity, uint32_t *cnt) {
+  uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= count) return;
+  bvh.overlap(queries[i], [&](int prim) {
+    uint32_t slot = atomicAdd(cnt, 1u);
+    if (slot < capacity) out_query[slot] = static_cast<int>(i), out_prim[slot] = prim;
+  });
+}
+/// Batched nearest-box query of xyz points, out_ids[i] = -1 if nothing is within sqrt(max_d2)
+template <typename T>
+__global__ void lbvh_query_nearest(lbvh<T> bvh, uint32_t count, const T *points, T max_d2, int *out_ids, T *out_d2) {
+  uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= count) return;
+  T d2 = max_d2;
+  out_ids[i] = bvh.nearest(points + 3 * i, d2);
+  if (out_d2) out_d2[i] = d2;
+}
+#endif
+
+/// @brief lbvh on host memory, built on a thread_pool with the same per-node code as the device kernels.
+/// Each build step is one parallel_for; the Morton sort is radix_sort_pairs. Bulk queries split the queries across the pool.
+/// voxelize_mesh (MeshVoxelizer.h) casts its lattice lines through one, built over the (y,z) bounds of the triangles.
+/// For device traversal, copy nodes() to device memory and pass lbvh<T>{leaf_count(), d_nodes} into kernels.
+template <typename T = float>
+struct host_lbvh {
+  using bvh_t = lbvh<T>;
+  using box_t = aabb<T>;
+  using node_t = typename bvh_t::node;
+
+  host_lbvh() = default;
+  host_lbvh(thread_pool &pool, std::size_t count, const box_t *boxes) { build(pool, count, boxes); }
+
+  void build(thread_pool &pool, std::size_t count, const box_t *boxes) {
+    const int n = static_cast<int>(count);
+    _leafCnt = n;
+    _nodes.resize(n ? 2 * std::size_t(n) - 1 : 0);
+    if (!n) return;
+    // Bounds of the box centers, per chunk then merged
+    const std::size_t chunks = std::min<std::size_t>((count + 4095) / 4096, static_cast<std::size_t>(pool.size()) * 4);
+    std::vector<box_t> partial(chunks, box_t::empty());
+    pool.parallel_for(chunks, [&](std::size_t cb, std::size_t ce) {
+      for (std::size_t c = cb; c < ce; ++c)
+        for (std::size_t i = c * count / chunks; i < (c + 1) * count / chunks; ++i) {
+          T center[3] = {boxes[i].center(0), boxes[i].center(1), boxes[i].center(2)};
+          partial[c].merge(box_t{{center[0], center[1], center[2]}, {center[0], center[1], center[2]}});
+        }
+    });
+    box_t bounds = box_t::empty();
+    for (const auto &b : partial) bounds.merge(b);
+
+    _codes.resize(count), _codesAlt.resize(count), _ids.resize(count), _idsAlt.resize(count);
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i) _codes[i] = bvh_t::morton_code(boxes[i], bounds), _ids[i] = static_cast<int>(i);
+    }, 1 << 14);
+    radix_sort_pairs(pool, count, _codes.data(), _ids.data(), _codesAlt.data(), _idsAlt.data(), 3 * bvh_t::morton_bits);
+
+    _parents.resize(_nodes.size());
+    _flags.assign(n - 1, 0);
+    bvh_t bvh = build_port();
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      for (std::size_t k = b; k < e; ++k) bvh.init_leaf(boxes, _ids.data(), static_cast<int>(k));
+    }, 1 << 14);
+    pool.parallel_for(count - 1, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i) bvh.build_internal(_codes.data(), static_cast<int>(i));
+    }, 1 << 12);
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      for (std::size_t k = b; k < e; ++k) bvh.fit_from_leaf(static_cast<int>(k));
+    }, 1 << 12);
+  }
+
+  /// Traversal view, build arrays left out
+  bvh_t port() const noexcept { return bvh_t{_leafCnt, const_cast<node_t *>(_nodes.data()), nullptr, nullptr}; }
+  int leaf_count() const noexcept { return _leafCnt; }
+  const std::vector<node_t> &nodes() const noexcept { return _nodes; }
+  /// Bounds of all primitives
+  box_t bounds() const noexcept { return _leafCnt ? _nodes[0].box : box_t::empty(); }
+  /// Primitive indices in leaf (Morton) order
+  const std::vector<int> &order() const noexcept { return _ids; }
+
+  template <typename F>
+  void overlap(const box_t &q, F &&f) const { port().overlap(q, f); }
+  template <typename F>
+  int nearest(const T *p, T &best_d2, F &&dist2) const { return port().nearest(p, best_d2, dist2); }
+  int nearest(const T *p, T &best_d2) const { return port().nearest(p, best_d2); }
+
+  /// @brief Overlapping (query, primitive) pairs of count query boxes, ordered by query
+  void overlap_bulk(thread_pool &pool, std::size_t count, const box_t *queries, std::vector<std::pair<int, int>> &pairs) const {
+    constexpr std::size_t grain = 256;
+    const std::size_t chunks = (count + grain - 1) / grain;
+    std::vector<std::vector<std::pair<int, int>>> found(chunks);
+    bvh_t bvh = port();
+    pool.parallel_for(chunks, [&](std::size_t cb, std::size_t ce) {
+      for (std::size_t c = cb; c < ce; ++c)
+        for (std::size_t q = c * grain; q < std::min(count, (c + 1) * grain); ++q)
+          bvh.overlap(queries[q], [&](int prim) { found[c].emplace_back(static_cast<int>(q), prim); });
+    });
+    pairs.clear();
+    std::size_t total = 0;
+    for (const auto &f : found) total += f.size();
+    pairs.reserve(total);
+    for (const auto &f : found) pairs.insert(pairs.end(), f.begin(), f.end());
+  }
+  /// @brief Nearest primitive box of count xyz points within sqrt(max_d2), out_ids[i] = -1 if none. out_d2 may be null.
+  void nearest_bulk(thread_pool &pool, std::size_t count, const T *points, int *out_ids, T *out_d2 = nullptr,
+                    T max_d2 = std::numeric_limits<T>::max()) const {
+    bvh_t bvh = port();
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i) {
+        T d2 = max_d2;
+        out_ids[i] = bvh.nearest(points + 3 * i, d2);
+        if (out_d2) out_d2[i] = d2;
+      }
+    }, 256);
+  }
+
+private:
+  bvh_t build_port() noexcept { return bvh_t{_leafCnt, _nodes.data(), _parents.data(), _flags.data()}; }
+
+  int _leafCnt = 0;
+  std::vector<node_t> _nodes;
+  std::vector<int> _parents, _flags;
+  std::vector<uint64_t> _codes, _codesAlt;
+  std::vector<int> _ids, _idsAlt;
+};
+
+} // namespace mn
 
-#endif
\ No newline at end of file
+#endif
@@ -1,165 +1,197 @@
 #ifndef __HASH_CUH_
 #define __HASH_CUH_
-#include <MnBase/AggregatedAttribs.cuh>
+#include <MnBase/Concurrency/Concurrency.h>
 #include <MnBase/Math/Bit/Bits.h>
-#include <MnSystem/Cuda/HostUtils.hpp>
-///< For multiGPU_TEST Flag only
-#include <MnWorld/SimulationSetting.h>
+#include <MnBase/Meta/HostDevice.h>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 namespace mn {
-#if 0
-	template<typename KeyType, typename ValueType, typename HashTableAttribList = std::tuple<KeyType, ValueType>>
-#if MULTI_GPU_TEST		///< HashTable on UM
-	struct HashTable : public CudaAttribs<HashTableAttribList, 1> {
-		using Base = CudaAttribs<HashTableAttribList, 1>;
-#else	
-	struct HashTable : public CudaAttribs<HashTableAttribList> {
-		using Base = CudaAttribs<HashTableAttribList>;
+
+namespace hash_detail {
+/// Atomics used by the probing code, CUDA intrinsics on device and GCC/Clang builtins on host
+__forceinline__ __host__ __device__ uint64_t atomic_cas(uint64_t *addr, uint64_t expected, uint64_t desired) {
+#if defined(__CUDA_ARCH__)
+  return atomicCAS(reinterpret_cast<unsigned long long int *>(addr), static_cast<unsigned long long int>(expected),
+                   static_cast<unsigned long long int>(desired));
+#else
+  __atomic_compare_exchange_n(addr, &expected, desired, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+  return expected;
+#endif
+}
+template <typename T>
+__forceinline__ __host__ __device__ T atomic_add(T *addr, T val) {
+#if defined(__CUDA_ARCH__)
+  return atomicAdd(addr, val);
+#else
+  return __atomic_fetch_add(addr, val, __ATOMIC_RELAXED);
 #endif
+}
+__forceinline__ __host__ __device__ uint64_t atomic_load(const uint64_t *addr) {
+#if defined(__CUDA_ARCH__)
+  return *reinterpret_cast<const volatile uint64_t *>(addr);
+#else
+  return __atomic_load_n(addr, __ATOMIC_ACQUIRE);
 #endif
-template<typename KeyType, typename ValueType, int opt=1, typename HashTableAttribList = std::tuple<KeyType, ValueType>>
-	struct HashTable : public CudaAttribs<HashTableAttribList, opt> {
-		using Base = CudaAttribs<HashTableAttribList, opt>;
-		struct CudaPort {
-			static_assert(sizeof(KeyType) == 8 || sizeof(KeyType) == 4, "Hashtable KeyType neither 64-bit or 32-bit!\n");
-			static_assert(sizeof(unsigned long long int) == 8 && sizeof(unsigned int) == 4, 
-				"\'unsigned long long int\' not 64-bit or \'unsigned int\' not 32-bit!\n");
-			using KT = std::conditional_t<sizeof(KeyType) == 8, unsigned long long int, unsigned int>;
-			using VT = ValueType;
-			enum : uint64_t { HashKeyOffset = 127 };
-			enum : KT { SentinelValue = (KT)-1 };
-			std::size_t	_mask;
-			KT		*_keyTable;	///< should be cuda compatible!
-			VT		*_valueTable;
-			VT		*_entryCount;
-			CudaPort(std::size_t mask, KeyType* keyTable, ValueType* valTable, ValueType* entryCount) :
-				_mask{ std::move(mask) }, _keyTable{ reinterpret_cast<KT*>(keyTable) }, _valueTable{ reinterpret_cast<VT*>(valTable) },
-				_entryCount{ reinterpret_cast<VT*>(entryCount) } {}
-			template<typename KeyT = KT>
-			__forceinline__ __device__ void insert(KeyT && key) {
-				KeyType hashkey = std::forward<KeyT>(key) & _mask, ori;
+}
+/// splitmix64 finalizer. Morton keys of neighbouring blocks differ only in low bits, so they are mixed before masking.
+__forceinline__ __host__ __device__ constexpr uint64_t mix(uint64_t k) noexcept {
+  k ^= k >> 30, k *= 0xbf58476d1ce4e5b9ull;
+  k ^= k >> 27, k *= 0x94d049bb133111ebull;
+  return k ^ (k >> 31);
+}
+} // namespace hash_detail
 
-				while ((ori = _keyTable[hashkey]) != std::forward<KeyT>(key)) {
-					if (ori == SentinelValue)
-						ori = atomicCAS(_keyTable + hashkey, SentinelValue, std::forward<KeyT>(key));
-					if (_keyTable[hashkey] == std::forward<KeyT>(key)) {	///< found
-						if (ori == SentinelValue) {
-							_valueTable[hashkey] = atomicAdd(_entryCount, 1); ///< created a record
-						}
-						break;
-					}
-					hashkey += HashKeyOffset; ///< search next entry
-					if (hashkey > _mask)
-						hashkey = hashkey & _mask;
-				};
-			}
-			template<typename RecoverKeyOp, typename KeyT = KT>
-			__forceinline__ __device__ void insert(KeyT && key, KeyT* _records, RecoverKeyOp recover_op) {
-				KeyType hashkey = std::forward<KeyT>(key) & _mask, ori;
+/// @brief Lock-free open-addressing hash from 64-bit keys (e.g. Morton codes of grid-blocks) to indices, linear probing.
+/// Table size is a power of 2 at least twice the capacity, so memory follows active blocks instead of the domain extent.
+/// A plain view of device or host memory, passed by value into kernels like Partition. Keys are never erased, clear all at once
+/// by filling both arrays with 0xff bytes (sentinel_key / sentinel_v). A value is visible once the inserting kernel or loop is done.
+template <typename ValueType = int>
+struct block_hash {
+  using key_t = uint64_t;
+  using value_t = ValueType;
+  static constexpr key_t sentinel_key = ~key_t(0);
+  static constexpr value_t sentinel_v = value_t(-1);
+  std::size_t _mask = 0;
+  key_t *_keys = nullptr;
+  value_t *_values = nullptr;
 
-				while ((ori = _keyTable[hashkey]) != std::forward<KeyT>(key)) {
-					if (ori == SentinelValue)
-						ori = atomicCAS(_keyTable + hashkey, SentinelValue, std::forward<KeyT>(key));
-					if (_keyTable[hashkey] == std::forward<KeyT>(key)) {	///< found
-						if (ori == SentinelValue) {
-							_records[_valueTable[hashkey] = atomicAdd(_entryCount, 1)] = recover_op(std::forward<KeyT>(key)); ///< created a record
-						}
-						break;
-					}
-					hashkey += HashKeyOffset; ///< search next entry
-					if (hashkey > _mask)
-						hashkey = hashkey & _mask;
-				};
-			}
-			template<typename KeyT = KeyType>
-			__forceinline__ __device__ auto query(KeyT && key) const ->ValueType {
-				KeyType hashkey = std::forward<KeyT>(key) & _mask, ori;
-				while ((ori = _keyTable[hashkey]) != std::forward<KeyT>(key)) {
-					if (ori == SentinelValue) return -1;
-					hashkey += HashKeyOffset; ///< search next entry
-					if (hashkey > _mask)
-						hashkey = hashkey & _mask;
-				}
-				return _valueTable[hashkey];
-			}
-		};
+  /// Slots for up to capacity keys, load factor <= 0.5
+  static constexpr std::size_t table_size(std::size_t capacity) noexcept {
+    std::size_t size = 16;
+    while (size < 2 * capacity) size <<= 1;
+    return size;
+  }
+  /// Morton key of a (non-negative) block coordinate, never sentinel_key
+  static constexpr key_t block_key(int x, int y, int z) noexcept {
+    return morton_encode_3d(static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(z));
+  }
+  std::size_t size() const noexcept { return _mask + 1; }
 
-		auto estimateTableSize(std::size_t entrySize) const noexcept { return entrySize << 5; }
-		// auto estimateTableSize(std::size_t entrySize) const noexcept { return entrySize << 5; }
-		HashTable() = delete;
-		template<typename Integer>
-		HashTable(Integer size) : Base{ static_cast<std::size_t>(1) << bit_count(estimateTableSize(size)) }, 
-			_entrySize{ size },
-			_tableSize{ static_cast<std::size_t>(1) << bit_count(estimateTableSize(size)) } {
-			static_assert(std::is_integral<ValueType>::value, "Hashtable value type is not integer.");
-			_mask = _tableSize - 1;
-			//printf("required size: %llu, actual alloced size: %llu, mask: %llx(%llu)\n", size, _tableSize, _mask, _mask);
-			_keyTable = reinterpret_cast<KeyType*>(Base::_attribs[0]);
-			_valueTable = reinterpret_cast<ValueType*>(Base::_attribs[1]);
-// #if MULTI_GPU_TEST
-// 			checkCudaErrors(cudaMallocManaged((void**)&_entryCount, sizeof(int)));
-// #else
-// 			checkCudaErrors(cudaMalloc((void**)&_entryCount, sizeof(int)));
-// #endif
-			if(opt == 1) {
-				checkCudaErrors(cudaMallocManaged((void**)&_entryCount, sizeof(int)));
-			}
-			else {
-				checkCudaErrors(cudaMalloc((void**)&_entryCount, sizeof(int)));				
-			}
+  template <typename Allocator>
+  void allocate_hash(Allocator allocator, std::size_t capacity) {
+    _mask = table_size(capacity) - 1;
+    _keys = static_cast<key_t *>(allocator.allocate(sizeof(key_t) * size()));
+    _values = static_cast<value_t *>(allocator.allocate(sizeof(value_t) * size()));
+  }
+  template <typename Allocator>
+  void deallocate_hash(Allocator allocator) {
+    allocator.deallocate(_keys, sizeof(key_t) * size());
+    allocator.deallocate(_values, sizeof(value_t) * size());
+    _mask = 0, _keys = nullptr, _values = nullptr;
+  }
 
-		}
-		~HashTable() {
-			cudaFree(_entryCount);
-		}
-		std::size_t		_entrySize;
-		std::size_t		_tableSize, _mask;
-		KeyType		*_keyTable;
-		ValueType	*_valueTable;
-		ValueType	*_entryCount;
+  /// @brief Insert key, numbered by incrementing *cnt as Partition::insert.
+  /// @return New index if key was inserted by this call, sentinel_v if already present or table full.
+  __forceinline__ __host__ __device__ value_t insert(key_t key, value_t *cnt) const noexcept {
+    std::size_t slot = hash_detail::mix(key) & _mask;
+    for (std::size_t probe = 0; probe <= _mask; ++probe, slot = (slot + 1) & _mask) {
+      key_t cur = hash_detail::atomic_load(_keys + slot);
+      if (cur == sentinel_key) cur = hash_detail::atomic_cas(_keys + slot, sentinel_key, key);
+      if (cur == sentinel_key) { //< Claimed the slot
+        value_t idx = hash_detail::atomic_add(cnt, value_t(1));
+        _values[slot] = idx;
+        return idx;
+      }
+      if (cur == key) return sentinel_v;
+    }
+    return sentinel_v;
+  }
+  /// @brief Insert key with a known index, e.g. to rebuild the table from active keys.
+  /// @return false if key was already present or table full.
+  __forceinline__ __host__ __device__ bool insert(key_t key, value_t value) const noexcept {
+    std::size_t slot = hash_detail::mix(key) & _mask;
+    for (std::size_t probe = 0; probe <= _mask; ++probe, slot = (slot + 1) & _mask) {
+      key_t cur = hash_detail::atomic_load(_keys + slot);
+      if (cur == sentinel_key) cur = hash_detail::atomic_cas(_keys + slot, sentinel_key, key);
+      if (cur == sentinel_key) {
+        _values[slot] = value;
+        return true;
+      }
+      if (cur == key) return false;
+    }
+    return false;
+  }
+  /// @return Index of key, sentinel_v if absent
+  __forceinline__ __host__ __device__ value_t query(key_t key) const noexcept {
+    std::size_t slot = hash_detail::mix(key) & _mask;
+    for (std::size_t probe = 0; probe <= _mask; ++probe, slot = (slot + 1) & _mask) {
+      key_t cur = hash_detail::atomic_load(_keys + slot);
+      if (cur == key) return _values[slot];
+      if (cur == sentinel_key) return sentinel_v;
+    }
+    return sentinel_v;
+  }
+};
 
-		void clearCount() {
-			cudaMemset(_entryCount, 0, sizeof(ValueType));
-		}
-		void clearCount(cudaStream_t stream) {
-			cudaMemsetAsync(_entryCount, 0, sizeof(ValueType), stream);
-		}
-		void clear() {
-			cudaMemset(_entryCount, 0, sizeof(ValueType));
-			cudaMemset(_keyTable, 0xff, sizeof(KeyType) * _tableSize);
-			cudaMemset(_valueTable, 0xff, sizeof(ValueType) * _tableSize);
-		}
-		void clear(cudaStream_t stream) {
-			cudaMemsetAsync(_entryCount, 0, sizeof(ValueType), stream);
-			cudaMemsetAsync(_keyTable, 0xff, sizeof(KeyType) * _tableSize, stream);
-			cudaMemsetAsync(_valueTable, 0xff, sizeof(ValueType) * _tableSize, stream);
-		}
-		auto getPort() {
-			return CudaPort{ _mask, _keyTable, _valueTable, _entryCount };
-		}
-		void retrieveEntryCount(ValueType* addr, cudaStream_t stream=cudaStreamDefault) {
-			cudaMemcpyAsync(addr, _entryCount, sizeof(ValueType), cudaMemcpyDeviceToHost, stream);
-		}
-#if MULTI_GPU_TEST
-		void umAdvise_AccessBy_Init(int dev_id) {
-	#if DEBUG
-			printf("[DEBUG] Setting HashTable_UM_Advice AccessBy for Dev %d\n", dev_id);
-	#endif
-			// checkCudaErrors(cudaMemAdvise(_entryCount, sizeof(int), cudaMemAdviseSetAccessedBy, dev_id));
-			// checkCudaErrors(cudaMemAdvise(_keyTable, sizeof(KeyType) * _tableSize, cudaMemAdviseSetAccessedBy, dev_id));
-			// checkCudaErrors(cudaMemAdvise(_valueTable, sizeof(ValueType) * _tableSize, cudaMemAdviseSetAccessedBy, dev_id));
-		}
-		void umAdvise_PreferredLoc_Init(int dev_id = 0) {
-	#if DEBUG
-			printf("[DEBUG] Setting HashTable_UM_Advice PreferredLocation for Dev %d\n", dev_id);
-	#endif
-			// checkCudaErrors(cudaMemAdvise(_entryCount, sizeof(int), cudaMemAdviseSetPreferredLocation, dev_id));
-			// checkCudaErrors(cudaMemAdvise(_keyTable, sizeof(KeyType) * _tableSize, cudaMemAdviseSetPreferredLocation, dev_id));
-			// checkCudaErrors(cudaMemAdvise(_valueTable, sizeof(ValueType) * _tableSize, cudaMemAdviseSetPreferredLocation, dev_id));
-		}
+#if defined(__CUDACC__)
+/// Bulk insert, out[i] = new index of keys[i] or sentinel_v if it was already present
+template <typename ValueType>
+__global__ void hash_insert_keys(block_hash<ValueType> table, uint32_t count, const uint64_t *keys, ValueType *cnt,
+                                 ValueType *out) {
+  uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= count) return;
+  ValueType idx = table.insert(keys[i], cnt);
+  if (out) out[i] = idx;
+}
+/// Bulk query, out[i] = index of keys[i] or sentinel_v
+template <typename ValueType>
+__global__ void hash_query_keys(block_hash<ValueType> table, uint32_t count, const uint64_t *keys, ValueType *out) {
+  uint32_t i = blockIdx.x * blockDim.x + threadIdx.x;
+  if (i >= count) return;
+  out[i] = table.query(keys[i]);
+}
 #endif
-	};
 
-}
+/// @brief block_hash on host memory with the same probing code, for the CPU backend and host-side checks of device tables.
+/// Bulk operations run on a thread_pool.
+template <typename ValueType = int>
+struct host_block_hash {
+  using table_t = block_hash<ValueType>;
+  using key_t = typename table_t::key_t;
+  using value_t = ValueType;
+
+  explicit host_block_hash(std::size_t capacity = 0) { reserve(capacity); }
+  /// Resize for capacity keys, clears the table
+  void reserve(std::size_t capacity) {
+    keys.resize(table_t::table_size(capacity)), values.resize(keys.size());
+    clear();
+  }
+  void clear() {
+    std::fill(keys.begin(), keys.end(), table_t::sentinel_key);
+    std::fill(values.begin(), values.end(), table_t::sentinel_v);
+    cnt = 0;
+  }
+  table_t port() noexcept { return table_t{keys.size() - 1, keys.data(), values.data()}; }
+  /// Keys inserted since clear()
+  value_t count() const noexcept { return cnt; }
+
+  value_t insert(key_t key) { return port().insert(key, &cnt); }
+  value_t query(key_t key) { return port().query(key); }
+  void insert_bulk(thread_pool &pool, std::size_t count, const key_t *in, value_t *out = nullptr) {
+    table_t table = port();
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i) {
+        value_t idx = table.insert(in[i], &cnt);
+        if (out) out[i] = idx;
+      }
+    }, 4096);
+  }
+  void query_bulk(thread_pool &pool, std::size_t count, const key_t *in, value_t *out) {
+    table_t table = port();
+    pool.parallel_for(count, [&](std::size_t b, std::size_t e) {
+      for (std::size_t i = b; i < e; ++i) out[i] = table.query(in[i]);
+    }, 4096);
+  }
 
-#endif
\ No newline at end of file
+private:
+  std::vector<key_t> keys;
+  std::vector<value_t> values;
+  value_t cnt = 0;
+};
+
+} // namespace mn
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef __MESH_VOXELIZER_H_
+#define __MESH_VOXELIZER_H_
+#include <MnBase/Concurrency/Concurrency.h>
+#include <MnBase/DataStructure/Bvh/Bvh.cuh>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace mn {
+
+/// @brief Fill a closed triangle mesh with particles on a regular lattice, without an SDF.
+/// Each lattice line along x is cast against an lbvh of the triangles' (y,z) projections (x collapsed to 0).
+/// Crossings are sorted along the line and ray parity marks the inside points.
+/// Lines are independent, so they are split across threads.
+
+namespace detail {
+/// Twice the signed area of (0,0)-(x1,y1)-(x2,y2), with a simulation-of-simplicity sign for exact zeros (as in SDFGen)
+inline int sos_orientation(double x1, double y1, double x2, double y2, double &twice_signed_area) {
+  twice_signed_area = y1 * x2 - x1 * y2;
+  if (twice_signed_area > 0) return 1;
+  if (twice_signed_area < 0) return -1;
+  if (y2 > y1) return 1;
+  if (y2 < y1) return -1;
+  if (x1 > x2) return 1;
+  if (x1 < x2) return -1;
+  return 0;
+}
+
+/// Robust test of (x0,y0) in triangle (x1,y1)-(x2,y2)-(x3,y3). Sets barycentric coordinates on a hit.
+/// Points on shared edges/vertices count for exactly one of the triangles, so parity stays exact.
+inline bool point_in_triangle_2d(double x0, double y0, double x1, double y1, double x2, double y2,
+                                 double x3, double y3, double &a, double &b, double &c) {
+  x1 -= x0; x2 -= x0; x3 -= x0;
+  y1 -= y0; y2 -= y0; y3 -= y0;
+  int signa = sos_orientation(x2, y2, x3, y3, a);
+  if (signa == 0) return false;
+  if (sos_orientation(x3, y3, x1, y1, b) != signa) return false;
+  if (sos_orientation(x1, y1, x2, y2, c) != signa) return false;
+  double sum = a + b + c;
+  a /= sum; b /= sum; c /= sum;
+  return true;
+}
+} // namespace detail
+
+/// @brief Particles of a closed mesh on the lattice lo + (i+0.5)*spacing, clipped to [lo, hi).
+/// @param vertices Mesh vertices, already in simulation coordinates.
+/// @param triangles Vertex indices per triangle. Orientation does not matter, the mesh must be closed.
+/// @return Positions in k, j, i order (i fastest).
+template <typename T>
+std::vector<std::array<T, 3>> voxelize_mesh(const std::vector<std::array<double, 3>> &vertices,
+                                            const std::vector<std::array<int, 3>> &triangles, T spacing,
+                                            std::array<T, 3> lo, std::array<T, 3> hi,
+                                            unsigned num_threads = std::thread::hardware_concurrency()) {
+  std::vector<std::array<T, 3>> particles;
+  int n[3];
+  for (int d = 0; d < 3; ++d) n[d] = std::max(0, static_cast<int>((hi[d] - lo[d]) / spacing + 1.0));
+  if (!n[0] || !n[1] || !n[2] || triangles.empty()) return particles;
+
+  thread_pool pool(static_cast<int>(std::max(1u, std::min<unsigned>(num_threads, n[2]))));
+  std::vector<aabb<double>> boxes(triangles.size());
+  pool.parallel_for(triangles.size(), [&](std::size_t b, std::size_t e) {
+    for (std::size_t t = b; t < e; ++t) {
+      auto &box = boxes[t];
+      box = aabb<double>::empty();
+      box.lo[0] = box.hi[0] = 0.;
+      for (int c = 0; c < 3; ++c)
+        for (int d = 1; d < 3; ++d) {
+          box.lo[d] = std::min(box.lo[d], vertices[triangles[t][c]][d]);
+          box.hi[d] = std::max(box.hi[d], vertices[triangles[t][c]][d]);
+        }
+    }
+  }, 4096);
+  const host_lbvh<double> bvh(pool, boxes.size(), boxes.data());
+  const lbvh<double> tree = bvh.port();
+
+  auto lattice = [&](int d, int i) { return static_cast<double>(lo[d]) + (i + 0.5) * spacing; };
+  std::vector<std::vector<std::array<T, 3>>> slabs(n[2]); //< Per z-layer, joined in order
+  pool.parallel_for(n[2], [&](std::size_t k_begin, std::size_t k_end) {
+    std::vector<double> crossings;
+    for (int k = (int)k_begin; k < (int)k_end; ++k) {
+      auto &slab = slabs[k];
+      double z = lattice(2, k);
+      if (z >= hi[2]) continue;
+      for (int j = 0; j < n[1]; ++j) {
+        double y = lattice(1, j);
+        if (y >= hi[1]) continue;
+        crossings.clear();
+        const double line[3] = {0., y, z};
+        tree.contain(line, [&](int t) {
+          const auto &p = vertices[triangles[t][0]], &q = vertices[triangles[t][1]], &r = vertices[triangles[t][2]];
+          double a, b, c;
+          if (detail::point_in_triangle_2d(y, z, p[1], p[2], q[1], q[2], r[1], r[2], a, b, c))
+            crossings.push_back(a * p[0] + b * q[0] + c * r[0]);
+        });
+        if (crossings.size() < 2) continue;
+        std::sort(crossings.begin(), crossings.end());
+        std::size_t passed = 0; //< Crossings before x, odd means inside
+        for (int i = 0; i < n[0]; ++i) {
+          double x = lattice(0, i);
+          if (x >= hi[0]) break;
+          while (passed < crossings.size() && crossings[passed] < x) ++passed;
+          if (passed == crossings.size()) break;
+          if (passed & 1) slab.push_back(std::array<T, 3>{static_cast<T>(x), static_cast<T>(y), static_cast<T>(z)});
+        }
+      }
+    }
+  });
+  std::size_t total = 0;
+  for (const auto &slab : slabs) total += slab.size();
+  particles.reserve(total);
+  for (const auto &slab : slabs) particles.insert(particles.end(), slab.begin(), slab.end());
+  return particles;
+}
+
+} // namespace mn
+
+#endif
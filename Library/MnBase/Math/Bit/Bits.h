@@ -110,6 +110,62 @@ constexpr uint64_t bit_spread(const uint64_t mask, const int data) {
   result = binary_reverse(result) >> count_leading_zeros(mask);
   return result;
 }
+/**
+ *	\fn uint64_t morton_spread_3d(uint32_t v)
+ *	\brief spread the lower 21 bits of v to every third bit, i.e.
+ *interleaved_bit_mask<uint64_t>(3)
+ */
+constexpr uint64_t morton_spread_3d(uint32_t v) noexcept {
+  uint64_t x = v & 0x1fffff;
+  x = (x | x << 32) & 0x1f00000000ffffull;
+  x = (x | x << 16) & 0x1f0000ff0000ffull;
+  x = (x | x << 8) & 0x100f00f00f00f00full;
+  x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+  x = (x | x << 2) & 0x1249249249249249ull;
+  return x;
+}
+/**
+ *	\fn uint64_t morton_encode_3d(uint32_t x, uint32_t y, uint32_t z)
+ *	\brief z-order key of a 3D coordinate (21 bits per axis), x most
+ *significant
+ */
+constexpr uint64_t morton_encode_3d(uint32_t x, uint32_t y,
+                                    uint32_t z) noexcept {
+  return morton_spread_3d(x) << 2 | morton_spread_3d(y) << 1 |
+         morton_spread_3d(z);
+}
+/**
+ *	\fn uint64_t hilbert_encode_3d(uint32_t x, uint32_t y, uint32_t z)
+ *	\brief hilbert-curve key of a 3D coordinate (21 bits per axis), via
+ *Skilling's axes-to-transpose. Every aligned 2^k cube is one contiguous key
+ *range.
+ */
+constexpr uint64_t hilbert_encode_3d(uint32_t x, uint32_t y,
+                                     uint32_t z) noexcept {
+  constexpr int dim = 3;
+  constexpr uint32_t top = 1u << 20;
+  uint32_t X[dim] = {x & 0x1fffff, y & 0x1fffff, z & 0x1fffff};
+  for (uint32_t q = top; q > 1; q >>= 1) { ///< inverse undo
+    uint32_t p = q - 1;
+    for (int i = 0; i < dim; ++i) {
+      if (X[i] & q)
+        X[0] ^= p;
+      else {
+        uint32_t t = (X[0] ^ X[i]) & p;
+        X[0] ^= t, X[i] ^= t;
+      }
+    }
+  }
+  for (int i = 1; i < dim; ++i) ///< gray encode
+    X[i] ^= X[i - 1];
+  uint32_t t = 0;
+  for (uint32_t q = top; q > 1; q >>= 1)
+    if (X[dim - 1] & q)
+      t ^= q - 1;
+  for (int i = 0; i < dim; ++i)
+    X[i] ^= t;
+  return morton_encode_3d(X[0], X[1], X[2]);
+}
 } // namespace mn
 
 #endif
\ No newline at end of file
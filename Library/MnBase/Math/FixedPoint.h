@@ -0,0 +1,93 @@
+#ifndef __FIXED_POINT_H_
+#define __FIXED_POINT_H_
+#include <MnBase/Meta/HostDevice.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+namespace mn {
+
+namespace fixed_point_detail {
+/// splitmix64 finalizer
+__forceinline__ __host__ __device__ constexpr std::uint64_t mix(std::uint64_t k) noexcept {
+  k ^= k >> 30, k *= 0xbf58476d1ce4e5b9ull;
+  k ^= k >> 27, k *= 0x94d049bb133111ebull;
+  return k ^ (k >> 31);
+}
+/// Fresh random bits for every write, mixed with the value. Host: per-thread counter, so a host loop is reproducible
+/// per thread. Device: cycle counter and thread index, no state (as the order of atomics, not reproducible).
+__forceinline__ __host__ __device__ std::uint64_t dither_bits(double x) noexcept {
+  std::uint64_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+#if defined(__CUDA_ARCH__)
+  const std::uint64_t entropy = (std::uint64_t)clock64() ^
+      ((std::uint64_t)(blockIdx.x * blockDim.x + threadIdx.x) << 32);
+#else
+  static thread_local std::uint64_t counter = 0;
+  const std::uint64_t entropy = counter += 0x9e3779b97f4a7c15ull;
+#endif
+  return mix(bits ^ mix(entropy));
+}
+} // namespace fixed_point_detail
+
+/// @brief Signed fixed-point number, value = _v * 2^-FracBits, decoded to Real in registers.
+/// Usable as the vt of a structural_entity: reads convert to Real, writes from Real round stochastically (up with
+/// probability equal to the fraction of a step) and saturate to [min(), max()], so structural code written for Real
+/// attributes compiles unchanged. Stochastic rounding keeps repeated writes unbiased: x += v*dt drifts as a random walk
+/// of ~sqrt(steps) half-steps instead of up to a half-step per write, and moves on average even when |v*dt| is below
+/// half a step, where round-to-nearest would keep the value forever. Values on the grid (copies) are stored exactly.
+/// E.g. fixed_point<int32_t, 31> covers [-1, 1) in steps of 2^-31 (~4.7e-10) with 4 bytes instead of 8.
+/// Same code on host and device, so host-side encode/decode is the reference for device storage.
+template <typename Int, int FracBits, typename Real = double>
+struct fixed_point {
+  static_assert(std::is_integral<Int>::value && std::is_signed<Int>::value, "fixed_point needs a signed integer");
+  static_assert(FracBits > 0 && FracBits < (int)sizeof(Int) * 8, "fixed_point needs 0 < FracBits < bits of Int");
+  using int_type = Int;
+  using real_type = Real;
+  static constexpr int frac_bits = FracBits;
+  Int _v; //< Raw value, left uninitialized as for Real attributes
+
+  /// Step between neighbouring values
+  __forceinline__ __host__ __device__ static constexpr double resolution() noexcept { return 1.0 / (double)(std::uint64_t{1} << FracBits); }
+  static constexpr double min() noexcept { return (double)std::numeric_limits<Int>::min() * resolution(); }
+  static constexpr double max() noexcept { return (double)std::numeric_limits<Int>::max() * resolution(); }
+
+  /// Round to nearest, saturate outside [min(), max()]
+  __forceinline__ __host__ __device__ static Int encode(Real x) noexcept {
+    const double scaled = (double)x * (double)(std::uint64_t{1} << FracBits);
+    if (!(scaled > (double)std::numeric_limits<Int>::min())) return std::numeric_limits<Int>::min(); //< Also NaN
+    if (scaled >= (double)std::numeric_limits<Int>::max()) return std::numeric_limits<Int>::max();
+    return (Int)floor(scaled + 0.5);
+  }
+  /// Round down, then up if the top 53 of random bits, as a number in [0, 1), are below the fraction. Saturate as encode().
+  __forceinline__ __host__ __device__ static Int encode_stochastic(Real x, std::uint64_t random) noexcept {
+    const double scaled = (double)x * (double)(std::uint64_t{1} << FracBits);
+    if (!(scaled > (double)std::numeric_limits<Int>::min())) return std::numeric_limits<Int>::min(); //< Also NaN
+    if (scaled >= (double)std::numeric_limits<Int>::max()) return std::numeric_limits<Int>::max();
+    const double down = floor(scaled);
+    return (Int)down + (Int)((double)(random >> 11) * 0x1.0p-53 < scaled - down);
+  }
+  __forceinline__ __host__ __device__ static constexpr Real decode(Int v) noexcept {
+    return (Real)((double)v * resolution());
+  }
+  /// x rounded to nearest step
+  __forceinline__ __host__ __device__ static Real quantize(Real x) noexcept { return decode(encode(x)); }
+  /// x as it reads back after storage (operator=)
+  __forceinline__ __host__ __device__ static Real quantize_stochastic(Real x) noexcept {
+    return decode(encode_stochastic(x, fixed_point_detail::dither_bits((double)x)));
+  }
+
+  __forceinline__ __host__ __device__ constexpr operator Real() const noexcept { return decode(_v); }
+  __forceinline__ __host__ __device__ fixed_point &operator=(Real x) noexcept {
+    _v = encode_stochastic(x, fixed_point_detail::dither_bits((double)x));
+    return *this;
+  }
+  __forceinline__ __host__ __device__ fixed_point &operator+=(Real x) noexcept { return *this = decode(_v) + x; }
+  __forceinline__ __host__ __device__ fixed_point &operator-=(Real x) noexcept { return *this = decode(_v) - x; }
+};
+
+} // namespace mn
+
+#endif
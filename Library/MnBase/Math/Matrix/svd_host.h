@@ -0,0 +1,231 @@
+#ifndef __SVD_HOST_H_
+#define __SVD_HOST_H_
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace mn {
+
+namespace math {
+
+/// @brief 3x3 SVD on the host, A = U * diag(S) * V^T. Same convention as the device math::svd used by constitutive models:
+/// U and V are rotations, S sorted by decreasing magnitude, S[2] negative for inverted A.
+/// Matrices are column-major (A[0], A[1], A[2] is the first column), as particle deformation gradients are stored.
+/// Jacobi eigen-decomposition of A^T A, then Gram-Schmidt of A V. Computed in double for T = float.
+template <typename T>
+inline void svd_host(const T *A, T *U, T *S, T *V) {
+  double a[9], b[9], v[9] = {1., 0., 0., 0., 1., 0., 0., 0., 1.};
+  for (int i = 0; i < 9; ++i) a[i] = static_cast<double>(A[i]);
+  auto at = [](const double *m, int r, int c) -> double { return m[c * 3 + r]; };
+  for (int r = 0; r < 3; ++r)
+    for (int c = 0; c < 3; ++c)
+      b[c * 3 + r] = at(a, 0, r) * at(a, 0, c) + at(a, 1, r) * at(a, 1, c) + at(a, 2, r) * at(a, 2, c);
+
+  // Cyclic Jacobi on symmetric b = A^T A
+  const double scale = b[0] * b[0] + b[4] * b[4] + b[8] * b[8];
+  for (int sweep = 0; sweep < 16; ++sweep) {
+    double off = b[3] * b[3] + b[6] * b[6] + b[7] * b[7];
+    if (off <= 1e-30 * scale || off == 0.) break;
+    for (int pq = 0; pq < 3; ++pq) {
+      int p = pq == 2 ? 1 : 0, q = pq == 0 ? 1 : 2;
+      double bpq = b[q * 3 + p];
+      if (bpq == 0.) continue;
+      double theta = (b[q * 3 + q] - b[p * 3 + p]) / (2. * bpq);
+      double t = (theta >= 0. ? 1. : -1.) / (std::abs(theta) + std::sqrt(theta * theta + 1.));
+      double c = 1. / std::sqrt(t * t + 1.), s = t * c;
+      for (int k = 0; k < 3; ++k) { //< b = b G
+        double bkp = b[p * 3 + k], bkq = b[q * 3 + k];
+        b[p * 3 + k] = c * bkp - s * bkq, b[q * 3 + k] = s * bkp + c * bkq;
+      }
+      for (int k = 0; k < 3; ++k) { //< b = G^T b
+        double bpk = b[k * 3 + p], bqk = b[k * 3 + q];
+        b[k * 3 + p] = c * bpk - s * bqk, b[k * 3 + q] = s * bpk + c * bqk;
+      }
+      for (int k = 0; k < 3; ++k) { //< v = v G
+        double vkp = v[p * 3 + k], vkq = v[q * 3 + k];
+        v[p * 3 + k] = c * vkp - s * vkq, v[q * 3 + k] = s * vkp + c * vkq;
+      }
+    }
+  }
+
+  // Sort eigenvalues descending, V a rotation
+  int order[3] = {0, 1, 2};
+  std::sort(order, order + 3, [&](int i, int j) { return b[i * 4] > b[j * 4]; });
+  double vs[9];
+  for (int c = 0; c < 3; ++c)
+    for (int r = 0; r < 3; ++r) vs[c * 3 + r] = v[order[c] * 3 + r];
+  double det_v = vs[0] * (vs[4] * vs[8] - vs[7] * vs[5]) - vs[3] * (vs[1] * vs[8] - vs[7] * vs[2]) + vs[6] * (vs[1] * vs[5] - vs[4] * vs[2]);
+  if (det_v < 0.) for (int r = 0; r < 3; ++r) vs[6 + r] = -vs[6 + r];
+
+  // Columns of A V, orthonormalized into rotation U. Sign of det(A) ends up in S[2].
+  double av[9], u[9];
+  for (int c = 0; c < 3; ++c)
+    for (int r = 0; r < 3; ++r)
+      av[c * 3 + r] = at(a, r, 0) * vs[c * 3] + at(a, r, 1) * vs[c * 3 + 1] + at(a, r, 2) * vs[c * 3 + 2];
+  const double tiny = 1e-14 * std::sqrt(std::max(b[0] + b[4] + b[8], 0.)) + 1e-300;
+  auto norm = [](const double *x) { return std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]); };
+  double n0 = norm(av);
+  if (n0 > tiny) for (int r = 0; r < 3; ++r) u[r] = av[r] / n0;
+  else u[0] = 1., u[1] = 0., u[2] = 0.;
+  double d01 = u[0] * av[3] + u[1] * av[4] + u[2] * av[5];
+  for (int r = 0; r < 3; ++r) u[3 + r] = av[3 + r] - d01 * u[r];
+  double n1 = norm(u + 3);
+  if (n1 > tiny) for (int r = 0; r < 3; ++r) u[3 + r] /= n1;
+  else { //< Any unit vector orthogonal to the first column
+    int k = std::abs(u[0]) < std::abs(u[1]) ? (std::abs(u[0]) < std::abs(u[2]) ? 0 : 2) : (std::abs(u[1]) < std::abs(u[2]) ? 1 : 2);
+    double e[3] = {0., 0., 0.};
+    e[k] = 1.;
+    double d = u[k];
+    for (int r = 0; r < 3; ++r) u[3 + r] = e[r] - d * u[r];
+    n1 = norm(u + 3);
+    for (int r = 0; r < 3; ++r) u[3 + r] /= n1;
+  }
+  u[6] = u[1] * u[5] - u[2] * u[4];
+  u[7] = u[2] * u[3] - u[0] * u[5];
+  u[8] = u[0] * u[4] - u[1] * u[3];
+
+  for (int c = 0; c < 3; ++c)
+    S[c] = static_cast<T>(u[c * 3] * av[c * 3] + u[c * 3 + 1] * av[c * 3 + 1] + u[c * 3 + 2] * av[c * 3 + 2]);
+  for (int i = 0; i < 9; ++i) U[i] = static_cast<T>(u[i]), V[i] = static_cast<T>(vs[i]);
+}
+
+/// @brief Batched 3x3 SVD on the host, N matrices in SoA layout: entry e (column-major) of matrix l at [e * N + l].
+/// Same result convention as svd_host. Branch-free, each step a loop over the N lanes that compiles to SIMD
+/// (e.g. N = 8 doubles or 16 floats per AVX-512 register). Fixed Jacobi sweeps on A^T A, sorting network, Gram-Schmidt of A V.
+/// Computed in T, as accurate as the device math::svd for T = float.
+template <int N, typename T>
+inline void svd_host_batch(const T *A, T *U, T *S, T *V) {
+  constexpr int sweeps = sizeof(T) > 4 ? 5 : 4;
+  constexpr T eps = std::numeric_limits<T>::epsilon();
+  constexpr T tiny = std::numeric_limits<T>::min();
+  T b[6][N], c[N], s[N]; //< A^T A as b00, b11, b22, b01, b02, b12. Rotation cos, sin per lane.
+  auto a = [&](int r, int col, int l) -> T { return A[(col * 3 + r) * N + l]; };
+  for (int l = 0; l < N; ++l) {
+    b[0][l] = a(0, 0, l) * a(0, 0, l) + a(1, 0, l) * a(1, 0, l) + a(2, 0, l) * a(2, 0, l);
+    b[1][l] = a(0, 1, l) * a(0, 1, l) + a(1, 1, l) * a(1, 1, l) + a(2, 1, l) * a(2, 1, l);
+    b[2][l] = a(0, 2, l) * a(0, 2, l) + a(1, 2, l) * a(1, 2, l) + a(2, 2, l) * a(2, 2, l);
+    b[3][l] = a(0, 0, l) * a(0, 1, l) + a(1, 0, l) * a(1, 1, l) + a(2, 0, l) * a(2, 1, l);
+    b[4][l] = a(0, 0, l) * a(0, 2, l) + a(1, 0, l) * a(1, 2, l) + a(2, 0, l) * a(2, 2, l);
+    b[5][l] = a(0, 1, l) * a(0, 2, l) + a(1, 1, l) * a(1, 2, l) + a(2, 1, l) * a(2, 2, l);
+  }
+  for (int e = 0; e < 9; ++e)
+    for (int l = 0; l < N; ++l) V[e * N + l] = (e & 0x3) ? T(0) : T(1);
+
+  // Cyclic Jacobi. Rotation of (p, q) zeroes b_pq: b_pp -= t b_pq, b_qq += t b_pq, rotates (b_pr, b_qr) and V columns p, q.
+  constexpr int P[3] = {0, 0, 1}, Q[3] = {1, 2, 2};
+  constexpr int PQ[3] = {3, 4, 5}, PR[3] = {4, 3, 3}, QR[3] = {5, 5, 4};
+  for (int sweep = 0; sweep < sweeps; ++sweep)
+    for (int r = 0; r < 3; ++r) {
+      T *bpp = b[P[r]], *bqq = b[Q[r]], *bpq = b[PQ[r]], *bpr = b[PR[r]], *bqr = b[QR[r]];
+      for (int l = 0; l < N; ++l) {
+        bool skip = std::abs(bpq[l]) <= eps * eps * (std::abs(bpp[l]) + std::abs(bqq[l])) + tiny;
+        T theta = (bqq[l] - bpp[l]) / (skip ? T(1) : T(2) * bpq[l]);
+        T t = (theta >= T(0) ? T(1) : T(-1)) / (std::abs(theta) + std::sqrt(theta * theta + T(1)));
+        t = skip ? T(0) : t;
+        c[l] = T(1) / std::sqrt(t * t + T(1)), s[l] = t * c[l];
+        bpp[l] -= t * bpq[l], bqq[l] += t * bpq[l], bpq[l] = T(0);
+        T xr = bpr[l], yr = bqr[l];
+        bpr[l] = c[l] * xr - s[l] * yr, bqr[l] = s[l] * xr + c[l] * yr;
+      }
+      for (int k = 0; k < 3; ++k) {
+        T *vp = V + (P[r] * 3 + k) * N, *vq = V + (Q[r] * 3 + k) * N;
+        for (int l = 0; l < N; ++l) {
+          T x = vp[l], y = vq[l];
+          vp[l] = c[l] * x - s[l] * y, vq[l] = s[l] * x + c[l] * y;
+        }
+      }
+    }
+
+  // Sort eigenvalues descending. Swapping columns (i, j) -> (j, -i) keeps V a rotation.
+  constexpr int SI[3] = {0, 0, 1}, SJ[3] = {1, 2, 2};
+  for (int n = 0; n < 3; ++n) {
+    T *di = b[SI[n]], *dj = b[SJ[n]];
+    for (int l = 0; l < N; ++l) {
+      bool swap = di[l] < dj[l];
+      T x = di[l], y = dj[l];
+      di[l] = swap ? y : x, dj[l] = swap ? x : y;
+      c[l] = swap ? T(1) : T(0); //< Reused as swap mask
+    }
+    for (int k = 0; k < 3; ++k) {
+      T *vi = V + (SI[n] * 3 + k) * N, *vj = V + (SJ[n] * 3 + k) * N;
+      for (int l = 0; l < N; ++l) {
+        T x = vi[l], y = vj[l];
+        vi[l] = c[l] != T(0) ? y : x, vj[l] = c[l] != T(0) ? -x : y;
+      }
+    }
+  }
+
+  // Columns of A V, orthonormalized into rotation U. Sign of det(A) ends up in S[2].
+  for (int l = 0; l < N; ++l) {
+    T av[9];
+    for (int col = 0; col < 3; ++col)
+      for (int r = 0; r < 3; ++r)
+        av[col * 3 + r] = a(r, 0, l) * V[(col * 3) * N + l] + a(r, 1, l) * V[(col * 3 + 1) * N + l] + a(r, 2, l) * V[(col * 3 + 2) * N + l];
+    const T small = T(16) * eps * std::sqrt(std::max(b[0][l], T(0))) + tiny;
+    T n0 = std::sqrt(av[0] * av[0] + av[1] * av[1] + av[2] * av[2]);
+    bool ok0 = n0 > small;
+    T inv0 = T(1) / (ok0 ? n0 : T(1));
+    T u0[3] = {ok0 ? av[0] * inv0 : T(1), ok0 ? av[1] * inv0 : T(0), ok0 ? av[2] * inv0 : T(0)};
+    T d01 = u0[0] * av[3] + u0[1] * av[4] + u0[2] * av[5];
+    T u1[3] = {av[3] - d01 * u0[0], av[4] - d01 * u0[1], av[5] - d01 * u0[2]};
+    T n1 = std::sqrt(u1[0] * u1[0] + u1[1] * u1[1] + u1[2] * u1[2]);
+    bool ok1 = n1 > small;
+    // Fallback: u0 x e, e the axis least aligned with u0 of x and y
+    bool ex = std::abs(u0[0]) < T(0.5);
+    T w[3] = {ex ? T(0) : -u0[2], ex ? u0[2] : T(0), ex ? -u0[1] : u0[0]};
+    T nw = std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    T inv1 = T(1) / (ok1 ? n1 : nw);
+    for (int r = 0; r < 3; ++r) u1[r] = (ok1 ? u1[r] : w[r]) * inv1;
+    T u2[3] = {u0[1] * u1[2] - u0[2] * u1[1], u0[2] * u1[0] - u0[0] * u1[2], u0[0] * u1[1] - u0[1] * u1[0]};
+    for (int r = 0; r < 3; ++r) U[r * N + l] = u0[r], U[(3 + r) * N + l] = u1[r], U[(6 + r) * N + l] = u2[r];
+    S[l] = u0[0] * av[0] + u0[1] * av[1] + u0[2] * av[2];
+    S[N + l] = u1[0] * av[3] + u1[1] * av[4] + u1[2] * av[5];
+    S[2 * N + l] = u2[0] * av[6] + u2[1] * av[7] + u2[2] * av[8];
+  }
+}
+
+/// @brief Batched polar decomposition A = R P on the host, R = U V^T a rotation, P = V S V^T symmetric (indefinite for
+/// inverted A). SoA layout as svd_host_batch.
+template <int N, typename T>
+inline void polar_host_batch(const T *A, T *R, T *P) {
+  T U[9 * N], S[3 * N], V[9 * N];
+  svd_host_batch<N>(A, U, S, V);
+  for (int col = 0; col < 3; ++col)
+    for (int r = 0; r < 3; ++r)
+      for (int l = 0; l < N; ++l) {
+        R[(col * 3 + r) * N + l] = U[r * N + l] * V[col * N + l] + U[(3 + r) * N + l] * V[(3 + col) * N + l] +
+                                   U[(6 + r) * N + l] * V[(6 + col) * N + l];
+        P[(col * 3 + r) * N + l] = S[l] * V[r * N + l] * V[col * N + l] + S[N + l] * V[(3 + r) * N + l] * V[(3 + col) * N + l] +
+                                   S[2 * N + l] * V[(6 + r) * N + l] * V[(6 + col) * N + l];
+      }
+}
+
+#if !defined(__CUDACC__)
+/// @brief Host stand-in for the device math::svd (svd.cuh) with the same row-major scalar signature,
+/// so __host__ __device__ callers such as the constitutive models compile unchanged for host-only targets.
+template <typename T>
+inline void svd(T a11, T a12, T a13, T a21, T a22, T a23, T a31, T a32, T a33, // input A
+                T &u11, T &u12, T &u13, T &u21, T &u22, T &u23, T &u31, T &u32, T &u33, // output U
+                T &s11, T &s22, T &s33, // output S
+                T &v11, T &v12, T &v13, T &v21, T &v22, T &v23, T &v31, T &v32, T &v33) { // output V
+  const T A[9] = {a11, a21, a31, a12, a22, a32, a13, a23, a33};
+  T U[9], S[3], V[9];
+  svd_host(A, U, S, V);
+  u11 = U[0], u21 = U[1], u31 = U[2], u12 = U[3], u22 = U[4], u32 = U[5], u13 = U[6], u23 = U[7], u33 = U[8];
+  s11 = S[0], s22 = S[1], s33 = S[2];
+  v11 = V[0], v21 = V[1], v31 = V[2], v12 = V[3], v22 = V[4], v32 = V[5], v13 = V[6], v23 = V[7], v33 = V[8];
+}
+#endif
+
+} // namespace math
+
+} // namespace mn
+
+#if !defined(__CUDACC__)
+/// CUDA math API reciprocal cube root, used by constitutive models
+inline float rcbrt(float x) { return 1.f / std::cbrt(x); }
+inline double rcbrt(double x) { return 1. / std::cbrt(x); }
+#endif
+
+#endif
@@ -4,6 +4,7 @@
 #include <functional>
 #include <type_traits>
 #include <utility>
+#include <MnBase/Meta/HostDevice.h>
 #include <MnBase/Meta/MathMeta.h>
 #include <MnBase/Meta/Meta.h>
 #include <MnBase/Meta/PatternMeta.h>
@@ -2,7 +2,9 @@
 #define __ALLOCATOR_H_
 
 #include "MemoryResource.h"
+#include <new>
 #include <type_traits>
+#include <utility>
 
 namespace mn {
 
@@ -20,6 +22,7 @@ struct heap_allocator {
 /// stateful allocator
 template <typename memory_resource_t> struct stack_allocator {
   using mr_type = memory_resource<memory_resource_t>;
+  using marker_t = char *;
 
   explicit stack_allocator(mr_type *mr, std::size_t alignBytes,
                            std::size_t totalMemBytes)
@@ -38,11 +41,11 @@ template <typename memory_resource_t> struct stack_allocator {
   void *allocate(std::size_t bytes) {
     /// first align head
     char *ret = _head + _align - 1 - ((std::size_t)_head + _align - 1) % _align;
-    _head = ret + bytes;
-    if (_head > _tail)
+    if (ret + bytes > _tail) //< Head stays put, the stack is still usable
       throw std::bad_alloc{};
-    else
-      return ret;
+    _head = ret + bytes;
+    if (used() > _high) _high = used();
+    return ret;
   }
   void deallocate(void *p, std::size_t) {
     if (p >= _head)
@@ -53,13 +56,56 @@ template <typename memory_resource_t> struct stack_allocator {
   }
   void reset() { _head = _data; }
 
+  /// Current top of the stack, rewind(marker) frees everything allocated since
+  marker_t marker() const noexcept { return _head; }
+  void rewind(marker_t m) {
+    if (m < _data || m > _head) throw std::bad_alloc{};
+    _head = m;
+  }
+
+  std::size_t used() const noexcept { return (std::size_t)(_head - _data); }
+  std::size_t capacity() const noexcept { return (std::size_t)(_tail - _data); }
+  /// Most bytes in use at once since construction or reset_high_water()
+  std::size_t high_water() const noexcept { return _high; }
+  void reset_high_water() noexcept { _high = used(); }
+
   char *_data, *_head, *_tail;
   std::size_t _align;
+  std::size_t _high = 0;
 
 private:
   mr_type *_mr;
 };
 
+/// stack_allocator on host memory, e.g. to exercise scratch usage without a device
+struct heap_stack_allocator : stack_allocator<heap_memory_resource> {
+  heap_stack_allocator(std::size_t alignBytes, std::size_t totalMemBytes)
+      : stack_allocator<heap_memory_resource>{&heap_memory_resource::instance(),
+                                              alignBytes, totalMemBytes} {}
+};
+
+/// @brief Scoped arena marker: everything allocated from the stack while in scope is released on exit.
+/// Scopes nest like the stack itself, an inner scope must end before the outer one.
+template <typename StackAllocator> struct stack_scope {
+  explicit stack_scope(StackAllocator &stack)
+      : _stack{stack}, _marker{stack.marker()} {}
+  stack_scope(const stack_scope &) = delete;
+  stack_scope &operator=(const stack_scope &) = delete;
+  ~stack_scope() {
+    if (_stack.marker() >= _marker) _stack.rewind(_marker); //< Unless the stack was reset meanwhile
+  }
+
+  void *allocate(std::size_t bytes) { return _stack.allocate(bytes); }
+  /// Bytes allocated within this scope
+  std::size_t used() const noexcept {
+    return (std::size_t)(_stack.marker() - _marker);
+  }
+
+private:
+  StackAllocator &_stack;
+  typename StackAllocator::marker_t _marker;
+};
+
 template <typename value_t, typename memory_resource_t>
 struct object_allocator {
   using value_type = value_t;
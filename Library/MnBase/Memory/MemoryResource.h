@@ -1,6 +1,8 @@
 #ifndef __MEMORY_RESOURCE_H_
 #define __MEMORY_RESOURCE_H_
 #include <MnBase/Singleton.h>
+#include <cstddef>
+#include <new>
 
 namespace mn {
 
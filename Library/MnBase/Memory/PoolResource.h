@@ -0,0 +1,205 @@
+#ifndef __POOL_RESOURCE_H_
+#define __POOL_RESOURCE_H_
+#include "MemoryResource.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <vector>
+
+namespace mn {
+
+/// Release fence of host memory, a released block is reusable at once
+struct immediate_fence {
+  bool ready() const noexcept { return true; }
+  void wait() const noexcept {}
+  void destroy() noexcept {}
+};
+
+/// @brief Caching pool on top of an upstream memory_resource (heap_memory_resource, device_memory_resource, ...).
+/// Freed blocks are cached per size class and handed out again instead of going back upstream, so repeated resizes
+/// of the same buffers neither fragment memory nor pay for upstream allocation. Thread-safe.
+/// Size classes are powers of two split in 4 steps (256, 320, 384, 448, 512, 640, ...), at most 25% slack per block.
+/// Blocks released with a fence (e.g. an event recorded on a stream) are only reused once the fence is ready,
+/// or after waiting on it when nothing else in the class is free: stream-ordered release.
+/// When upstream runs out of memory, cached blocks are returned upstream and the allocation retried (trim-on-pressure).
+template <typename upstream_t, typename fence_t = immediate_fence>
+struct caching_pool_resource : memory_resource<caching_pool_resource<upstream_t, fence_t>> {
+  using upstream_mr_t = memory_resource<upstream_t>;
+  struct statistics {
+    std::size_t requests = 0;        //< allocate() calls
+    std::size_t cache_hits = 0;      //< Served from cached blocks
+    std::size_t upstream_allocs = 0; //< Served by upstream
+    std::size_t upstream_frees = 0;  //< Blocks returned upstream (trims, uncached sizes, release)
+    std::size_t fence_waits = 0;     //< Reuses that waited on a release fence
+    std::size_t trims = 0;           //< trim() calls, incl. on upstream out-of-memory
+    std::size_t bytes_in_use = 0;    //< Class bytes handed out
+    std::size_t bytes_cached = 0;    //< Class bytes held for reuse
+    std::size_t peak_bytes_in_use = 0;
+    std::size_t peak_bytes_reserved = 0; //< Peak of in use + cached, i.e. upstream footprint
+  };
+
+  /// @param min_block Smallest size class in bytes, also the alignment of small requests
+  /// @param max_block Larger requests bypass the cache
+  /// @param max_cached Cache limit in bytes, released blocks beyond it go back upstream
+  explicit caching_pool_resource(upstream_mr_t *upstream = &upstream_t::instance(), std::size_t min_block = 256,
+                                 std::size_t max_block = std::size_t{1} << 34, std::size_t max_cached = ~std::size_t{0})
+      : _upstream{upstream}, _min_block{min_block}, _max_block{max_block}, _max_cached{max_cached} {}
+  caching_pool_resource(const caching_pool_resource &) = delete;
+  caching_pool_resource &operator=(const caching_pool_resource &) = delete;
+  ~caching_pool_resource() {
+    try {
+      release();
+    } catch (...) {
+    } //< Upstream may already be torn down at exit
+  }
+
+  /// Size class of a request, 0 if it bypasses the cache
+  std::size_t size_class(std::size_t bytes) const noexcept {
+    if (bytes > _max_block) return 0;
+    if (bytes <= _min_block) return _min_block;
+    std::size_t pow2 = _min_block;
+    while (pow2 * 2 <= bytes) pow2 *= 2;
+    const std::size_t step = std::max<std::size_t>(pow2 / 4, 1);
+    return pow2 + ((bytes - pow2 + step - 1) / step) * step;
+  }
+
+  void *do_allocate(std::size_t bytes, std::size_t alignment) {
+    std::lock_guard<std::mutex> lk{_mut};
+    ++_stats.requests;
+    const std::size_t cls = size_class(bytes);
+    if (cls) {
+      auto it = _free.find(cls);
+      if (it != _free.end() && !it->second.empty()) {
+        auto &list = it->second;
+        auto ready = std::find_if(list.begin(), list.end(), [](const cached_block &b) { return b.fence.ready(); });
+        if (ready == list.end()) { //< Everything in class still in flight, wait on the oldest release
+          ready = list.begin();
+          ready->fence.wait();
+          ++_stats.fence_waits;
+        }
+        cached_block block = *ready;
+        list.erase(ready);
+        block.fence.destroy();
+        _stats.bytes_cached -= cls;
+        ++_stats.cache_hits;
+        return track(block.ptr, cls);
+      }
+    }
+    const std::size_t size = cls ? cls : bytes;
+    void *ptr = nullptr;
+    try {
+      ptr = _upstream->allocate(size, alignment);
+    } catch (const std::bad_alloc &) {
+      trim_locked(0);
+      ptr = _upstream->allocate(size, alignment); //< Throws again if still out of memory
+    }
+    ++_stats.upstream_allocs;
+    _stats.peak_bytes_reserved = std::max(_stats.peak_bytes_reserved, _stats.bytes_in_use + _stats.bytes_cached + size);
+    return track(ptr, size, cls != 0);
+  }
+  void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) {
+    release_block(ptr, bytes, alignment, fence_t{});
+  }
+  /// @brief Deallocate once work issued before fence is done, e.g. fence_t{stream} for device memory
+  void deallocate(void *ptr, std::size_t bytes, fence_t fence) {
+    release_block(ptr, bytes, alignof(max_align_t), fence);
+  }
+  using memory_resource<caching_pool_resource<upstream_t, fence_t>>::deallocate;
+
+  /// @brief Return cached blocks upstream, largest classes first, until at most keep_bytes stay cached
+  void trim(std::size_t keep_bytes = 0) {
+    std::lock_guard<std::mutex> lk{_mut};
+    trim_locked(keep_bytes);
+  }
+  /// Return all cached blocks upstream. Blocks in use are left alone.
+  void release() { trim(0); }
+  statistics stats() const {
+    std::lock_guard<std::mutex> lk{_mut};
+    return _stats;
+  }
+  upstream_mr_t *upstream() const noexcept { return _upstream; }
+
+private:
+  struct cached_block {
+    void *ptr;
+    fence_t fence;
+  };
+  struct live_block {
+    std::size_t bytes;
+    bool cached; //< Size class block, else bypasses cache
+  };
+
+  void *track(void *ptr, std::size_t bytes, bool cached = true) {
+    _live[ptr] = live_block{bytes, cached};
+    _stats.bytes_in_use += bytes;
+    _stats.peak_bytes_in_use = std::max(_stats.peak_bytes_in_use, _stats.bytes_in_use);
+    return ptr;
+  }
+  void release_block(void *ptr, std::size_t bytes, std::size_t alignment, fence_t fence) {
+    if (!ptr) return;
+    std::lock_guard<std::mutex> lk{_mut};
+    auto it = _live.find(ptr);
+    if (it == _live.end()) { //< Not from this pool
+      fence.wait(), fence.destroy();
+      _upstream->deallocate(ptr, bytes, alignment);
+      return;
+    }
+    const live_block block = it->second;
+    _live.erase(it);
+    _stats.bytes_in_use -= block.bytes;
+    if (!block.cached || _stats.bytes_cached + block.bytes > _max_cached) {
+      fence.wait(), fence.destroy();
+      _upstream->deallocate(ptr, block.bytes, alignment);
+      ++_stats.upstream_frees;
+      return;
+    }
+    _free[block.bytes].push_back(cached_block{ptr, fence});
+    _stats.bytes_cached += block.bytes;
+  }
+  void trim_locked(std::size_t keep_bytes) {
+    ++_stats.trims;
+    for (auto it = _free.rbegin(); it != _free.rend() && _stats.bytes_cached > keep_bytes; ++it) {
+      auto &list = it->second;
+      while (!list.empty() && _stats.bytes_cached > keep_bytes) {
+        cached_block block = list.back();
+        list.pop_back();
+        block.fence.wait(), block.fence.destroy();
+        _upstream->deallocate(block.ptr, it->first);
+        _stats.bytes_cached -= it->first;
+        ++_stats.upstream_frees;
+      }
+    }
+  }
+
+  upstream_mr_t *_upstream;
+  std::size_t _min_block, _max_block, _max_cached;
+  mutable std::mutex _mut;
+  std::map<std::size_t, std::vector<cached_block>> _free; //< Cached blocks per size class
+  std::unordered_map<void *, live_block> _live;           //< Blocks handed out
+  statistics _stats;
+};
+
+/// Caching pool over heap_memory_resource
+struct pooled_heap_memory_resource : Singleton<pooled_heap_memory_resource>,
+                                     caching_pool_resource<heap_memory_resource> {
+  pooled_heap_memory_resource() {}
+};
+
+/// stateless allocator on the pooled heap
+struct pooled_heap_allocator {
+  using mr_type = pooled_heap_memory_resource;
+  pooled_heap_allocator() = default;
+  pooled_heap_allocator(const pooled_heap_allocator &) noexcept = default;
+  mr_type *resource() const { return &pooled_heap_memory_resource::instance(); }
+
+  void *allocate(std::size_t bytes) { return resource()->allocate(bytes); }
+  void deallocate(void *p, std::size_t bytes) { resource()->deallocate(p, bytes); }
+};
+
+} // namespace mn
+
+#endif
@@ -0,0 +1,38 @@
+#ifndef __HOST_DEVICE_H_
+#define __HOST_DEVICE_H_
+
+/// Lets headers written for nvcc (e.g. Vec.cuh, settings.cuh) compile as plain C++ for host-only targets.
+/// No effect when compiled by nvcc or when the CUDA runtime headers are already included.
+#if !defined(__CUDACC__) && !defined(__CUDA_RUNTIME_H__)
+#ifndef __host__
+#define __host__
+#endif
+#ifndef __device__
+#define __device__
+#endif
+#ifndef __global__
+#define __global__
+#endif
+#ifndef __forceinline__
+#define __forceinline__ inline __attribute__((always_inline))
+#endif
+#ifndef __VECTOR_TYPES_H__
+#define MN_HOST_VECTOR_TYPES 1
+struct float3 {
+  float x, y, z;
+};
+inline float3 make_float3(float x, float y, float z) { return float3{x, y, z}; }
+#endif
+#endif
+
+/// Loop unroll hint for nvcc, GCC's own spelling on host, nothing elsewhere (plain #pragma unroll warns on g++ -Wall)
+#define MN_PRAGMA(x) _Pragma(#x)
+#if defined(__CUDACC__) || defined(__clang__)
+#define MN_UNROLL(n) MN_PRAGMA(unroll n)
+#elif defined(__GNUC__)
+#define MN_UNROLL(n) MN_PRAGMA(GCC unroll n)
+#else
+#define MN_UNROLL(n)
+#endif
+
+#endif
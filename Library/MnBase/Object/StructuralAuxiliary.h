@@ -5,8 +5,19 @@
 
 namespace mn {
 
+/// aos: attributes of an element together. soa: one array per attribute.
+/// aosoa: tiles of W elements, one W-wide array per attribute within a tile (SIMD lanes, coalesced warps).
+/// Values >= 2 are the tile width W, a power of 2; aosoa_8/16/32 or memory_layout::aosoa<W>.
 struct memory_layout {
-  enum class element : unsigned char { aos = 0, soa = 1 };
+  enum class element : unsigned char { aos = 0, soa = 1, aosoa_8 = 8, aosoa_16 = 16, aosoa_32 = 32 };
+  template <unsigned W>
+  static constexpr element aosoa = (W >= 2 && W <= 128 && (W & (W - 1)) == 0)
+                                       ? static_cast<element>(W)
+                                       : throw "aosoa tile width must be a power of 2 in [2, 128]";
+  /// Elements per tile, 1 for aos and soa
+  static constexpr std::size_t tile_width(element layout) noexcept {
+    return static_cast<std::size_t>(layout) >= 2 ? static_cast<std::size_t>(layout) : 1;
+  }
 };
 using attrib_layout = memory_layout::element;
 
@@ -59,12 +59,23 @@ struct structural_traits {
                            element_size,
                            /// on-demand
                            sizeof(void *) * sizeof...(Structurals)>::value;
+  /// aosoa: elements per tile, 1 for aos and soa
+  static constexpr std::size_t tile_width = memory_layout::tile_width(Layout);
+  /// Bytes for count elements, aosoa rounds up to whole tiles
+  static constexpr std::size_t storage_size(std::size_t count) noexcept {
+    return (count + tile_width - 1) / tile_width * tile_width *
+           element_storage_size;
+  }
   /// for allocation
-  static constexpr std::size_t size = domain::extent * element_storage_size;
-  // soa -> multipool, aos -> pool
+  static constexpr std::size_t size = storage_size(domain::extent);
+  // soa -> multipool, aos -> pool, aosoa -> pool of tiles
 
   template <attrib_index AttribNo> struct accessor {
   private:
+    static_assert(tile_width == 1 ||
+                      decoration::alloc_policy ==
+                          structural_allocation_policy::full_allocation,
+                  "aosoa layout needs full_allocation");
     static constexpr uintptr_t elementStrideInBytes() {
       switch (decoration::alloc_policy) {
       case structural_allocation_policy::full_allocation:
@@ -82,7 +93,9 @@ struct structural_traits {
     static constexpr uintptr_t attribBaseOffset() {
       switch (decoration::alloc_policy) {
       case structural_allocation_policy::full_allocation:
-        return (elementLayout == attrib_layout::aos ? 1 : domain::extent) *
+        return (elementLayout == attrib_layout::aos
+                    ? 1
+                    : (tile_width > 1 ? tile_width : domain::extent)) *
                excl_prefix_sum<(std::size_t)AttribNo,
                                std::integer_sequence<
                                    uintptr_t, Structurals::size...>>::value;
@@ -95,18 +108,32 @@ struct structural_traits {
     }
 
   public:
+    /// Between consecutive elements (within a tile for aosoa)
     static constexpr uintptr_t element_stride_in_bytes = elementStrideInBytes();
+    /// aosoa: between tiles, i.e. W elements of all attributes
+    static constexpr uintptr_t tile_stride_in_bytes =
+        tile_width * element_storage_size;
 
     static constexpr uintptr_t attrib_base_offset = attribBaseOffset();
+    /// Offset of linear element e, tile-major then lane for aosoa (W is a power of 2, so shift and mask)
+    static constexpr uintptr_t element_offset(uintptr_t e) noexcept {
+      if (tile_width > 1)
+        return attrib_base_offset + (e / tile_width) * tile_stride_in_bytes +
+               (e % tile_width) * element_stride_in_bytes;
+      return attrib_base_offset + e * element_stride_in_bytes;
+    }
+    /// aosoa: offset of lane l in tile t. Loops over tiles then lanes see W contiguous values per attribute.
+    static constexpr uintptr_t tile_offset(uintptr_t t, uintptr_t l) noexcept {
+      return attrib_base_offset + t * tile_stride_in_bytes +
+             l * element_stride_in_bytes;
+    }
     template <typename... Indices>
     static constexpr uintptr_t coord_offset(Indices &&... is) noexcept {
-      return attrib_base_offset + domain::offset(std::forward<Indices>(is)...) *
-                                      element_stride_in_bytes;
+      return element_offset(domain::offset(std::forward<Indices>(is)...));
     }
     template <typename Index>
     static constexpr uintptr_t linear_offset(Index &&i) noexcept {
-      return attrib_base_offset +
-             std::forward<Index>(i) * element_stride_in_bytes;
+      return element_offset(std::forward<Index>(i));
     }
   };
 
@@ -165,6 +192,14 @@ struct structural_traits {
         _handle.ptrval +
         accessor<ChAttribNo>::linear_offset(std::forward<Index>(index)));
   }
+  /// aosoa: lane of a tile, element tile * tile_width + lane
+  template <attrib_index ChAttribNo, typename Type = value_type<ChAttribNo>>
+  constexpr auto &val_tile(std::integral_constant<attrib_index, ChAttribNo>,
+                           std::size_t tile, std::size_t lane) {
+    static_assert(tile_width > 1, "val_tile needs an aosoa layout");
+    return *reinterpret_cast<Type *>(
+        _handle.ptrval + accessor<ChAttribNo>::tile_offset(tile, lane));
+  }
   template <attrib_index ChAttribNo, typename Type = value_type<ChAttribNo>,
             typename... Indices>
   constexpr const auto &val(std::integral_constant<attrib_index, ChAttribNo>,
@@ -187,6 +222,14 @@ struct structural_traits {
         _handle.ptrval +
         accessor<ChAttribNo>::linear_offset(std::forward<Index>(index)));
   }
+  template <attrib_index ChAttribNo, typename Type = value_type<ChAttribNo>>
+  constexpr const auto &
+  val_tile(std::integral_constant<attrib_index, ChAttribNo>, std::size_t tile,
+           std::size_t lane) const {
+    static_assert(tile_width > 1, "val_tile needs an aosoa layout");
+    return *reinterpret_cast<Type *>(
+        _handle.ptrval + accessor<ChAttribNo>::tile_offset(tile, lane));
+  }
 
   MemResource _handle;
 };
@@ -351,7 +394,7 @@ struct structural<structural_type::dynamic, Decoration, Domain, Layout,
                        std::size_t capacity = Domain::extent) {
     if (capacity != 0) {
       this->_handle.ptr =
-          allocator.allocate(capacity * base_t::element_storage_size);
+          allocator.allocate(base_t::storage_size(capacity));
       // std::cout << "Allocated structural dynamic, size: " << capacity * base_t::element_storage_size << "\n";
     }
     else {
@@ -365,11 +408,11 @@ struct structural<structural_type::dynamic, Decoration, Domain, Layout,
     allocator.deallocate(this->_handle.ptr, _capacity);
     _capacity = capacity; ///< each time multiply by 2
     this->_handle.ptr =
-        allocator.allocate(_capacity * base_t::element_storage_size);
+        allocator.allocate(base_t::storage_size(_capacity));
   }
   template <typename Allocator> void deallocate(Allocator allocator) {
     allocator.deallocate(this->_handle.ptr,
-                         _capacity * base_t::element_storage_size);
+                         base_t::storage_size(_capacity));
     //std::cout << "Deallocated structural dynamic, capacity: "<< (_capacity) << ," size:" << (_capacity * base_t::element_storage_size)  << " bytes\n";
     _capacity = 0;
     this->_handle.ptr = nullptr;
@@ -0,0 +1,395 @@
+#ifndef __STRUCTURAL_SERIALIZER_H_
+#define __STRUCTURAL_SERIALIZER_H_
+#include "Structural.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace mn {
+
+/// @brief Self-describing binary dumps of structural Instances (GridBuffer, ParticleBuffer, HaloGridBlocks, ...).
+/// The schema is walked from the structural's attribute list at compile time: per node its type, layout, policies,
+/// domain extents and, per attribute, the offsets the accessors use. A blob is the schema plus the raw storage, so:
+/// - same schema on load: one bulk copy, or a zero-copy view of the blob (view_structural)
+/// - different schema (precision, attribute count, padding, layout, extents): converted attribute by attribute,
+///   matched by position. Attributes missing from the blob are zero, extra ones are dropped.
+/// Device Instances pass a copy functor (e.g. wrapping cudaMemcpy with cudaMemcpyDefault) instead of memcpy.
+///
+/// File layout: "MNSB", uint32 version, uint64 schema bytes, schema, uint64 count (root elements), uint64 payload
+/// bytes, payload (the Instance's storage of count root elements). Native endianness.
+struct structural_schema {
+  enum scalar_e : uint8_t { raw = 0, f32, f64, i8, u8, i16, u16, i32, u32, i64, u64 };
+  struct attrib {
+    uint64_t base, stride, tile_width, tile_stride; //< As structural_traits::accessor
+    uint32_t node;                                  //< Child node
+  };
+  struct node {
+    uint8_t is_entity = 0;
+    uint8_t scalar = raw;                     //< Entity
+    uint8_t node_type = 0, layout = 0, alloc = 0, padding = 0; //< Structural
+    uint64_t size = 0;                        //< Entity bytes, or element_storage_size of a structural
+    std::vector<uint64_t> extents;            //< Domain extents, last fastest
+    std::vector<attrib> attribs;
+
+    uint64_t extent() const noexcept {
+      uint64_t e = 1;
+      for (auto n : extents) e *= n;
+      return e;
+    }
+    /// Offset of element e of attribute a, as accessor::element_offset
+    static uint64_t offset(const attrib &a, uint64_t e) noexcept {
+      return a.tile_width > 1 ? a.base + (e / a.tile_width) * a.tile_stride + (e % a.tile_width) * a.stride
+                              : a.base + e * a.stride;
+    }
+  };
+  std::vector<node> nodes; //< Preorder, root first
+
+  template <typename T> static constexpr uint8_t scalar_of() noexcept {
+    using U = std::remove_cv_t<T>;
+    if (std::is_floating_point<U>::value) return sizeof(U) == 4 ? f32 : (sizeof(U) == 8 ? f64 : raw);
+    if (!std::is_integral<U>::value) return raw;
+    const bool s = std::is_signed<U>::value;
+    switch (sizeof(U)) {
+    case 1: return s ? i8 : u8;
+    case 2: return s ? i16 : u16;
+    case 4: return s ? i32 : u32;
+    case 8: return s ? i64 : u64;
+    default: return raw;
+    }
+  }
+
+  /// Schema of a structural type, built once
+  template <typename Structural> static const structural_schema &of() {
+    static const structural_schema schema = [] {
+      structural_schema s;
+      s.add<Structural>();
+      return s;
+    }();
+    return schema;
+  }
+
+  /// Storage bytes of count root elements (soa roots always hold their full domain)
+  uint64_t payload_bytes(uint64_t count) const noexcept {
+    const node &r = nodes[0];
+    if (r.is_entity) return r.size;
+    if (r.layout == static_cast<uint8_t>(attrib_layout::soa)) return r.extent() * r.size;
+    const uint64_t w = memory_layout::tile_width(static_cast<attrib_layout>(r.layout));
+    return (count + w - 1) / w * w * r.size;
+  }
+
+  void write(std::ostream &os) const {
+    put<uint32_t>(os, static_cast<uint32_t>(nodes.size()));
+    for (const node &n : nodes) {
+      put(os, n.is_entity), put(os, n.scalar), put(os, n.node_type), put(os, n.layout), put(os, n.alloc),
+          put(os, n.padding), put(os, n.size);
+      put<uint32_t>(os, static_cast<uint32_t>(n.extents.size()));
+      for (auto e : n.extents) put(os, e);
+      put<uint32_t>(os, static_cast<uint32_t>(n.attribs.size()));
+      for (const attrib &a : n.attribs) put(os, a.base), put(os, a.stride), put(os, a.tile_width), put(os, a.tile_stride), put(os, a.node);
+    }
+  }
+  /// Returns false on a truncated or inconsistent schema
+  bool read(std::istream &is) {
+    uint32_t cnt = 0;
+    if (!get(is, cnt) || cnt == 0 || cnt > (1u << 20)) return false;
+    nodes.assign(cnt, node{});
+    for (node &n : nodes) {
+      uint32_t dims = 0, attribs = 0;
+      if (!(get(is, n.is_entity) && get(is, n.scalar) && get(is, n.node_type) && get(is, n.layout) && get(is, n.alloc) &&
+            get(is, n.padding) && get(is, n.size) && get(is, dims)) || dims > 16)
+        return false;
+      n.extents.resize(dims);
+      for (auto &e : n.extents)
+        if (!get(is, e)) return false;
+      if (!get(is, attribs) || attribs > cnt) return false;
+      n.attribs.resize(attribs);
+      for (attrib &a : n.attribs)
+        if (!(get(is, a.base) && get(is, a.stride) && get(is, a.tile_width) && get(is, a.tile_stride) && get(is, a.node)) ||
+            a.node >= cnt)
+          return false;
+    }
+    return true;
+  }
+  bool operator==(const structural_schema &o) const noexcept {
+    if (nodes.size() != o.nodes.size()) return false;
+    for (std::size_t i = 0; i < nodes.size(); ++i) {
+      const node &a = nodes[i], &b = o.nodes[i];
+      if (a.is_entity != b.is_entity || a.scalar != b.scalar || a.node_type != b.node_type || a.layout != b.layout ||
+          a.alloc != b.alloc || a.padding != b.padding || a.size != b.size || a.extents != b.extents ||
+          a.attribs.size() != b.attribs.size())
+        return false;
+      for (std::size_t j = 0; j < a.attribs.size(); ++j) {
+        const attrib &x = a.attribs[j], &y = b.attribs[j];
+        if (x.base != y.base || x.stride != y.stride || x.tile_width != y.tile_width || x.tile_stride != y.tile_stride ||
+            x.node != y.node)
+          return false;
+      }
+    }
+    return true;
+  }
+  bool operator!=(const structural_schema &o) const noexcept { return !(*this == o); }
+
+  /// One line per node, for debugging dumps
+  void describe(std::ostream &os, uint32_t n = 0, int depth = 0) const {
+    static const char *scalars[] = {"raw", "f32", "f64", "i8", "u8", "i16", "u16", "i32", "u32", "i64", "u64"};
+    const node &nd = nodes[n];
+    os << std::string(2 * depth, ' ');
+    if (nd.is_entity) {
+      os << (nd.scalar <= u64 ? scalars[nd.scalar] : "?") << " (" << nd.size << " B)\n";
+      return;
+    }
+    const uint64_t w = memory_layout::tile_width(static_cast<attrib_layout>(nd.layout));
+    os << "structural type " << int(nd.node_type) << ", layout "
+       << (w > 1 ? "aosoa" + std::to_string(w) : (nd.layout ? "soa" : "aos")) << ", padding " << int(nd.padding)
+       << ", domain [";
+    for (std::size_t d = 0; d < nd.extents.size(); ++d) os << (d ? "x" : "") << nd.extents[d];
+    os << "], element " << nd.size << " B, " << nd.attribs.size() << " attribs\n";
+    for (const attrib &a : nd.attribs) describe(os, a.node, depth + 1);
+  }
+
+private:
+  template <typename T> struct is_entity : std::false_type {};
+  template <typename T> struct is_entity<structural_entity<T>> : std::true_type {};
+
+  template <typename S> uint32_t add() {
+    const uint32_t id = static_cast<uint32_t>(nodes.size());
+    nodes.emplace_back();
+    if constexpr (is_entity<S>::value) {
+      nodes[id].is_entity = 1;
+      nodes[id].scalar = scalar_of<typename S::vt>();
+      nodes[id].size = S::size;
+    } else {
+      static_assert(S::decoration::alloc_policy == structural_allocation_policy::full_allocation,
+                    "only full_allocation structurals hold their data inline");
+      node n;
+      n.node_type = static_cast<uint8_t>(S::node_type);
+      n.layout = static_cast<uint8_t>(S::elementLayout);
+      n.alloc = static_cast<uint8_t>(S::decoration::alloc_policy);
+      n.padding = static_cast<uint8_t>(S::decoration::padding_policy);
+      n.size = S::element_storage_size;
+      add_extents(n, typename S::domain::extents{});
+      nodes[id] = std::move(n);
+      add_attribs<S>(id, std::make_index_sequence<S::attrib_count>{});
+    }
+    return id;
+  }
+  template <typename Tn, Tn... Ns> static void add_extents(node &n, std::integer_sequence<Tn, Ns...>) {
+    n.extents = {static_cast<uint64_t>(Ns)...};
+  }
+  template <typename S, std::size_t... Is> void add_attribs(uint32_t id, std::index_sequence<Is...>) {
+    (void)std::initializer_list<int>{(add_attrib<S, Is>(id), 0)...};
+  }
+  template <typename S, std::size_t I> void add_attrib(uint32_t id) {
+    using A = typename S::template accessor<static_cast<attrib_index>(I)>;
+    const uint32_t child = add<typename S::attribs::template type<I>>();
+    nodes[id].attribs.push_back(attrib{A::attrib_base_offset, A::element_stride_in_bytes, S::tile_width,
+                                       A::tile_stride_in_bytes, child});
+  }
+
+  template <typename T> static void put(std::ostream &os, const T &v) {
+    os.write(reinterpret_cast<const char *>(&v), sizeof(T));
+  }
+  template <typename T> static bool get(std::istream &is, T &v) {
+    return static_cast<bool>(is.read(reinterpret_cast<char *>(&v), sizeof(T)));
+  }
+};
+
+namespace structural_io {
+/// Copy functor of host Instances
+struct host_copy {
+  void operator()(void *dst, const void *src, std::size_t bytes) const { std::memcpy(dst, src, bytes); }
+};
+constexpr char magic[4] = {'M', 'N', 'S', 'B'};
+constexpr uint32_t version = 1;
+
+template <typename Inst> using structural_of = typename Inst::self;
+
+/// Element of dst extents mapped into src extents by coordinate, false if outside
+inline bool map_element(const std::vector<uint64_t> &dst_ext, const std::vector<uint64_t> &src_ext, uint64_t e,
+                        uint64_t &se) {
+  if (dst_ext == src_ext || dst_ext.size() != src_ext.size()) {
+    se = e;
+    uint64_t src_extent = 1;
+    for (auto n : src_ext) src_extent *= n;
+    return e < src_extent;
+  }
+  se = 0;
+  uint64_t stride = 1;
+  for (std::size_t d = dst_ext.size(); d-- > 0;) {
+    const uint64_t c = e % dst_ext[d];
+    e /= dst_ext[d];
+    if (c >= src_ext[d]) return false;
+    se += c * stride, stride *= src_ext[d];
+  }
+  return true;
+}
+
+inline void convert_scalar(uint8_t dst_t, uint64_t dst_size, char *dst, uint8_t src_t, uint64_t src_size, const char *src) {
+  using S = structural_schema;
+  if (dst_t == src_t || dst_t == S::raw || src_t == S::raw) {
+    if (dst_size == src_size) std::memcpy(dst, src, dst_size);
+    return;
+  }
+  const bool dst_int = dst_t >= S::i8, src_int = src_t >= S::i8;
+  double f = 0;
+  int64_t i = 0;
+  auto load = [&](auto v) {
+    std::memcpy(&v, src, sizeof(v));
+    f = static_cast<double>(v), i = static_cast<int64_t>(v);
+  };
+  switch (src_t) {
+  case S::f32: load(float{}); break;
+  case S::f64: load(double{}); break;
+  case S::i8: load(int8_t{}); break;
+  case S::u8: load(uint8_t{}); break;
+  case S::i16: load(int16_t{}); break;
+  case S::u16: load(uint16_t{}); break;
+  case S::i32: load(int32_t{}); break;
+  case S::u32: load(uint32_t{}); break;
+  case S::i64: load(int64_t{}); break;
+  case S::u64: load(uint64_t{}); break;
+  }
+  auto store = [&](auto v) {
+    v = src_int && dst_int ? static_cast<decltype(v)>(i) : static_cast<decltype(v)>(f);
+    std::memcpy(dst, &v, sizeof(v));
+  };
+  switch (dst_t) {
+  case S::f32: store(float{}); break;
+  case S::f64: store(double{}); break;
+  case S::i8: store(int8_t{}); break;
+  case S::u8: store(uint8_t{}); break;
+  case S::i16: store(int16_t{}); break;
+  case S::u16: store(uint16_t{}); break;
+  case S::i32: store(int32_t{}); break;
+  case S::u32: store(uint32_t{}); break;
+  case S::i64: store(int64_t{}); break;
+  case S::u64: store(uint64_t{}); break;
+  }
+}
+
+/// Convert dst_count elements of dst node dn from src node sn, attributes matched by position
+inline void convert(const structural_schema &dst, uint32_t dn, char *dbase, uint64_t dst_count,
+                    const structural_schema &src, uint32_t sn, const char *sbase, uint64_t src_count, bool root) {
+  using node = structural_schema::node;
+  const node &d = dst.nodes[dn], &s = src.nodes[sn];
+  if (d.is_entity || s.is_entity) {
+    if (d.is_entity && s.is_entity) convert_scalar(d.scalar, d.size, dbase, s.scalar, s.size, sbase);
+    return;
+  }
+  const std::size_t attribs = std::min(d.attribs.size(), s.attribs.size());
+  for (uint64_t e = 0; e < dst_count; ++e) {
+    uint64_t se;
+    if (root && d.extents.size() <= 1) { //< Dynamic roots are linear, up to the saved count
+      se = e;
+      if (se >= src_count) break;
+    } else if (!map_element(d.extents, s.extents, e, se))
+      continue;
+    for (std::size_t a = 0; a < attribs; ++a) {
+      const auto &da = d.attribs[a], &sa = s.attribs[a];
+      convert(dst, da.node, dbase + node::offset(da, e), dst.nodes[da.node].extent(), src, sa.node,
+              sbase + node::offset(sa, se), src.nodes[sa.node].extent(), false);
+    }
+  }
+}
+} // namespace structural_io
+
+/// Root elements held by an Instance: capacity of dynamic structurals, domain extent otherwise
+template <typename Inst>
+std::size_t structural_count(const Inst &inst) {
+  using S = structural_io::structural_of<Inst>;
+  if constexpr (S::node_type == structural_type::dynamic)
+    return inst._capacity;
+  else
+    return S::domain::extent;
+}
+
+/// @brief Write the first count root elements of inst. copy(dst_host, src, bytes) reads the Instance's memory.
+template <typename Inst, typename Copy = structural_io::host_copy>
+bool save_structural(std::ostream &os, const Inst &inst, std::size_t count, Copy copy = {}) {
+  const structural_schema &schema = structural_schema::of<structural_io::structural_of<Inst>>();
+  const uint64_t bytes = schema.payload_bytes(count);
+  std::vector<char> staging(bytes);
+  if (bytes) copy(staging.data(), inst._handle.ptr, bytes);
+  std::vector<char> schema_bytes;
+  {
+    std::ostringstream ss;
+    schema.write(ss);
+    const std::string str = ss.str();
+    schema_bytes.assign(str.begin(), str.end());
+  }
+  const uint64_t schema_size = schema_bytes.size(), cnt = count;
+  os.write(structural_io::magic, 4);
+  os.write(reinterpret_cast<const char *>(&structural_io::version), sizeof(uint32_t));
+  os.write(reinterpret_cast<const char *>(&schema_size), sizeof(uint64_t));
+  os.write(schema_bytes.data(), schema_size);
+  os.write(reinterpret_cast<const char *>(&cnt), sizeof(uint64_t));
+  os.write(reinterpret_cast<const char *>(&bytes), sizeof(uint64_t));
+  os.write(staging.data(), bytes);
+  return static_cast<bool>(os);
+}
+
+/// A blob read back: schema, root element count and the raw storage
+struct structural_blob {
+  structural_schema schema;
+  uint64_t count = 0;
+  std::vector<char> payload;
+
+  /// Returns false on a wrong magic/version or a truncated blob
+  bool read(std::istream &is) {
+    char magic[4] = {};
+    uint32_t version = 0;
+    uint64_t schema_size = 0, bytes = 0;
+    is.read(magic, 4);
+    is.read(reinterpret_cast<char *>(&version), sizeof(uint32_t));
+    is.read(reinterpret_cast<char *>(&schema_size), sizeof(uint64_t));
+    if (!is || std::memcmp(magic, structural_io::magic, 4) != 0 || version != structural_io::version) return false;
+    const auto schema_start = is.tellg();
+    if (!schema.read(is) || is.tellg() - schema_start != static_cast<std::streamoff>(schema_size)) return false;
+    is.read(reinterpret_cast<char *>(&count), sizeof(uint64_t));
+    is.read(reinterpret_cast<char *>(&bytes), sizeof(uint64_t));
+    if (!is || bytes != schema.payload_bytes(count)) return false;
+    payload.resize(bytes);
+    is.read(payload.data(), bytes);
+    return static_cast<bool>(is);
+  }
+  template <typename Structural> bool matches() const { return schema == structural_schema::of<Structural>(); }
+};
+
+/// @brief Zero-copy: point inst at the blob's storage if the schema matches. The blob must outlive inst.
+template <typename Inst>
+bool view_structural(structural_blob &blob, Inst &inst) {
+  using S = structural_io::structural_of<Inst>;
+  if (!blob.template matches<S>()) return false;
+  inst._handle.ptr = blob.payload.data();
+  if constexpr (S::node_type == structural_type::dynamic) inst._capacity = blob.count;
+  return true;
+}
+
+/// @brief Load a blob into inst, already allocated for capacity root elements. A matching schema is one bulk copy,
+/// otherwise the blob is converted into a host staging copy first. copy(dst, src_host, bytes) writes the Instance's memory.
+/// @return Root elements loaded, min(blob.count, capacity)
+template <typename Inst, typename Copy = structural_io::host_copy>
+std::size_t load_structural(const structural_blob &blob, Inst &inst, std::size_t capacity, Copy copy = {}) {
+  const structural_schema &schema = structural_schema::of<structural_io::structural_of<Inst>>();
+  const std::size_t count = std::min<std::size_t>(blob.count, capacity);
+  const uint64_t bytes = schema.payload_bytes(count);
+  if (blob.schema == schema) {
+    if (bytes) copy(inst._handle.ptr, blob.payload.data(), std::min<uint64_t>(bytes, blob.payload.size()));
+    return count;
+  }
+  std::vector<char> staging(bytes, 0);
+  structural_io::convert(schema, 0, staging.data(), count, blob.schema, 0, blob.payload.data(), blob.count, true);
+  if (bytes) copy(inst._handle.ptr, staging.data(), bytes);
+  return count;
+}
+
+} // namespace mn
+
+#endif
@@ -2,6 +2,7 @@
 #define __ALLOCATORS_CUH_
 #include "HostUtils.hpp"
 #include <MnBase/Memory/Allocator.h>
+#include <MnBase/Memory/PoolResource.h>
 #include <cuda_runtime_api.h>
 #include <iostream>
 #include <memory>
@@ -42,6 +43,70 @@ struct unified_memory_resource : Singleton<unified_memory_resource>,
   }
 };
 
+/// Release fence of device memory for caching_pool_resource. Recorded on a stream, the block is reusable once
+/// work queued on that stream before the release is done. Default (no stream) waits for the whole device,
+/// as the implicit synchronization of cudaFree.
+struct cuda_stream_fence {
+  cudaEvent_t event = nullptr;
+  cuda_stream_fence() = default;
+  explicit cuda_stream_fence(cudaStream_t stream) {
+    checkCudaErrors(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+    checkCudaErrors(cudaEventRecord(event, stream));
+  }
+  bool ready() const { return event && cudaEventQuery(event) == cudaSuccess; }
+  void wait() const {
+    if (event) checkCudaErrors(cudaEventSynchronize(event));
+    else checkCudaErrors(cudaDeviceSynchronize());
+  }
+  void destroy() {
+    if (event) cudaEventDestroy(event);
+    event = nullptr;
+  }
+};
+
+/// Caching pool over device_memory_resource, one pool per device as blocks belong to the device current at allocation
+struct pooled_device_memory_resource : Singleton<pooled_device_memory_resource>,
+                                       memory_resource<pooled_device_memory_resource> {
+  using pool_t = caching_pool_resource<device_memory_resource, cuda_stream_fence>;
+  pooled_device_memory_resource() = default;
+  pool_t &pool() {
+    int dev = 0;
+    checkCudaErrors(cudaGetDevice(&dev));
+    std::lock_guard<std::mutex> lk{_mut};
+    if (dev >= (int)_pools.size()) _pools.resize(dev + 1);
+    if (!_pools[dev]) _pools[dev] = std::make_unique<pool_t>();
+    return *_pools[dev];
+  }
+  void *do_allocate(std::size_t bytes, std::size_t alignment) {
+    if (alignment > 256)
+      throw std::bad_alloc{};
+    return pool().allocate(bytes, alignment);
+  }
+  /// No stream known, so reuse of the block waits with cudaDeviceSynchronize. Use deallocate_async where the stream is known.
+  void do_deallocate(void *ptr, std::size_t bytes, std::size_t alignment) {
+    pool().deallocate(ptr, bytes, alignment);
+  }
+  /// Reusable once work on stream issued so far is done, no device-wide synchronization
+  void deallocate_async(void *ptr, std::size_t bytes, cudaStream_t stream) {
+    if (ptr) pool().deallocate(ptr, bytes, cuda_stream_fence{stream});
+  }
+  /// Pool statistics of the current device
+  pool_t::statistics stats() { return pool().stats(); }
+  /// Return cached blocks of all devices upstream (cudaFree). Call before CUDA shut-down.
+  void release() {
+    int cur = 0;
+    checkCudaErrors(cudaGetDevice(&cur));
+    std::lock_guard<std::mutex> lk{_mut};
+    for (int dev = 0; dev < (int)_pools.size(); ++dev)
+      if (_pools[dev]) checkCudaErrors(cudaSetDevice(dev)), _pools[dev]->release();
+    checkCudaErrors(cudaSetDevice(cur));
+  }
+
+private:
+  std::mutex _mut;
+  std::vector<std::unique_ptr<pool_t>> _pools;
+};
+
 /// std::allocator
 /// stateless allocator
 struct device_allocator {
@@ -54,6 +119,16 @@ struct device_allocator {
   void deallocate(void *p, std::size_t) { resource()->deallocate(p); }
 };
 
+struct pooled_device_allocator {
+  using mr_type = pooled_device_memory_resource;
+  pooled_device_allocator() = default;
+  pooled_device_allocator(const pooled_device_allocator &) noexcept = default;
+  mr_type *resource() const { return &pooled_device_memory_resource::instance(); }
+
+  void *allocate(std::size_t bytes) { return resource()->allocate(bytes); }
+  void deallocate(void *p, std::size_t bytes) { resource()->deallocate(p, bytes); }
+};
+
 struct unified_allocator {
   using mr_type = memory_resource<unified_memory_resource>;
   unified_allocator() = default;
@@ -79,8 +154,10 @@ struct MonotonicAllocator : stack_allocator<device_memory_resource> {
   }
 
   auto borrow(std::size_t bytes) -> void * { return allocate(bytes); }
+  /// Rewind to empty, growing by half if the high-water mark came within 3/4 of capacity.
+  /// Uses the high-water mark rather than current usage, as scoped borrows are already rewound.
   void reset() {
-    std::size_t usedBytes = _head - _data;
+    std::size_t usedBytes = high_water();
     std::size_t totalBytes = _tail - _data;
     if (usedBytes >= totalBytes * 3 / 4) {
       base_t::resource()->deallocate((void *)this->_data, totalBytes);
@@ -111,8 +188,10 @@ struct MonotonicVirtualAllocator : stack_allocator<unified_memory_resource> {
   }
 
   auto borrow(std::size_t bytes) -> void * { return allocate(bytes); }
+  /// Rewind to empty, growing by half if the high-water mark came within 3/4 of capacity.
+  /// Uses the high-water mark rather than current usage, as scoped borrows are already rewound.
   void reset() {
-    std::size_t usedBytes = _head - _data;
+    std::size_t usedBytes = high_water();
     std::size_t totalBytes = _tail - _data;
     if (usedBytes >= totalBytes * 3 / 4) {
       this->resource()->deallocate((void *)this->_data, totalBytes);
@@ -230,6 +230,15 @@ public:
       return monotonicAllocator().borrow(bytes);
     }
     void resetMem() { monotonicAllocator().reset(); }
+    /// Borrowed memory is returned when the scope ends, e.g. auto scratch = cuDev.borrowScope();
+    auto borrowScope() -> stack_scope<MonotonicAllocator> {
+      return stack_scope<MonotonicAllocator>{monotonicAllocator()};
+    }
+    /// Borrowed bytes: current, most at once since the last resetMemHighWater(), pre-allocated
+    std::size_t memUsed() { return monotonicAllocator().used(); }
+    std::size_t memHighWater() { return monotonicAllocator().high_water(); }
+    std::size_t memCapacity() { return monotonicAllocator().capacity(); }
+    void resetMemHighWater() { monotonicAllocator().reset_high_water(); }
 
   private:
     auto monotonicAllocator() -> MonotonicAllocator & {
@@ -77,6 +77,13 @@ __inline__ __host__ thrust::device_ptr<T> getDevicePtr(T *V) {
   return thrust::device_ptr<T>(V);
 }
 
+/// Copy functor for save_structural / load_structural of device Instances
+struct cuda_copy {
+  void operator()(void *dst, const void *src, std::size_t bytes) const {
+    checkCudaErrors(cudaMemcpy(dst, src, bytes, cudaMemcpyDefault));
+  }
+};
+
 inline void reportMemory(std::string msg) {
   std::size_t free_byte;
   std::size_t total_byte;
@@ -16,29 +16,39 @@ private:
     while (bRunning) {
       wait();
       auto job = jobs.try_pop();
-      if (job)
+      if (job) {
         (*job)();
+        std::lock_guard<std::mutex> lk{mut};
+        --pending;
+        idle.notify_all();
+      }
     }
   }
 
 public:
-  IO() : bRunning{true} {
+  IO() : bRunning{true}, pending{0} {
     th = std::thread([this]() { this->worker(); });
   }
   ~IO() {
-    while (!jobs.empty())
-      cv.notify_all();
-    bRunning = false;
+    {
+      std::unique_lock<std::mutex> lk{mut};
+      idle.wait(lk, [this]() { return this->pending == 0; });
+      bRunning = false;
+    }
+    cv.notify_all(); //< Wake the idle worker, else join() never returns
     th.join();
   }
 
+  /// Block until every inserted job has finished running, not only left the queue.
+  /// Jobs may then reference caller data that outlives the flush() call.
   static void flush() {
-    while (!instance().jobs.empty())
-      instance().cv.notify_all();
+    std::unique_lock<std::mutex> lk{instance().mut};
+    instance().idle.wait(lk, []() { return instance().pending == 0; });
   }
   static void insert_job(std::function<void()> job) {
     std::unique_lock<std::mutex> lk{instance().mut};
-    instance().jobs.push(job);
+    ++instance().pending;
+    instance().jobs.push(std::move(job));
     lk.unlock();
     instance().cv.notify_all();
   }
@@ -47,6 +57,8 @@ private:
   bool bRunning;
   std::mutex mut;
   std::condition_variable cv;
+  std::condition_variable idle; //< Signalled when a job finishes
+  std::size_t pending; //< Jobs inserted and not finished yet, guarded by mut
   threadsafe_queue<std::function<void()>> jobs;
   std::thread th;
 };
@@ -0,0 +1,113 @@
+#ifndef __MESH_IO_HPP_
+#define __MESH_IO_HPP_
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace mn {
+
+/// @brief Triangle soup / indexed mesh read from OBJ or STL. Vertices in file units.
+struct TriangleMesh {
+  std::vector<std::array<double, 3>> vertices;
+  std::vector<std::array<int, 3>> triangles;
+
+  /// Axis-aligned bounds of the vertices.
+  void bounds(std::array<double, 3> &lo, std::array<double, 3> &hi) const {
+    for (int d = 0; d < 3; ++d) lo[d] = std::numeric_limits<double>::max(), hi[d] = -std::numeric_limits<double>::max();
+    for (auto &v : vertices)
+      for (int d = 0; d < 3; ++d) lo[d] = std::min(lo[d], v[d]), hi[d] = std::max(hi[d], v[d]);
+  }
+};
+
+/// @brief Read Wavefront OBJ vertices and faces. Polygons are fan-triangulated, "f v/vt/vn" and negative indices are accepted.
+inline bool read_obj_mesh(const std::string &fn, TriangleMesh &mesh) {
+  std::ifstream in(fn);
+  if (!in) return false;
+  std::string line;
+  while (std::getline(in, line)) {
+    std::istringstream ss(line);
+    std::string tag;
+    ss >> tag;
+    if (tag == "v") {
+      std::array<double, 3> v;
+      ss >> v[0] >> v[1] >> v[2];
+      mesh.vertices.push_back(v);
+    } else if (tag == "f") {
+      std::vector<int> face;
+      std::string corner;
+      while (ss >> corner) {
+        int id = std::stoi(corner.substr(0, corner.find('/')));
+        face.push_back(id < 0 ? (int)mesh.vertices.size() + id : id - 1);
+      }
+      for (std::size_t c = 2; c < face.size(); ++c)
+        mesh.triangles.push_back(std::array<int, 3>{face[0], face[c - 1], face[c]});
+    }
+  }
+  return !mesh.triangles.empty();
+}
+
+/// @brief Read binary or ASCII STL. Vertices are not welded, each facet adds three.
+inline bool read_stl_mesh(const std::string &fn, TriangleMesh &mesh) {
+  std::ifstream in(fn, std::ios::binary | std::ios::ate);
+  if (!in) return false;
+  const std::size_t file_size = (std::size_t)in.tellg();
+  in.seekg(0);
+  char header[80] = {};
+  uint32_t count = 0;
+  in.read(header, 80);
+  in.read(reinterpret_cast<char *>(&count), sizeof(count));
+  // ASCII files start with "solid", but so do some binary ones. Trust the binary size check first.
+  if (in && file_size == 84 + (std::size_t)count * 50) {
+    mesh.vertices.reserve(mesh.vertices.size() + 3 * count);
+    mesh.triangles.reserve(mesh.triangles.size() + count);
+    for (uint32_t t = 0; t < count; ++t) {
+      float facet[12]; //< Normal, then three vertices
+      uint16_t attribute;
+      in.read(reinterpret_cast<char *>(facet), sizeof(facet));
+      in.read(reinterpret_cast<char *>(&attribute), sizeof(attribute));
+      int base = (int)mesh.vertices.size();
+      for (int c = 0; c < 3; ++c)
+        mesh.vertices.push_back(std::array<double, 3>{facet[3 + 3 * c], facet[4 + 3 * c], facet[5 + 3 * c]});
+      mesh.triangles.push_back(std::array<int, 3>{base, base + 1, base + 2});
+    }
+    return (bool)in && count > 0;
+  }
+  in.clear();
+  in.seekg(0);
+  std::string tag;
+  std::vector<int> facet;
+  while (in >> tag) {
+    if (tag == "vertex") {
+      std::array<double, 3> v;
+      in >> v[0] >> v[1] >> v[2];
+      facet.push_back((int)mesh.vertices.size());
+      mesh.vertices.push_back(v);
+    } else if (tag == "endfacet") {
+      for (std::size_t c = 2; c < facet.size(); ++c)
+        mesh.triangles.push_back(std::array<int, 3>{facet[0], facet[c - 1], facet[c]});
+      facet.clear();
+    }
+  }
+  return !mesh.triangles.empty();
+}
+
+/// @brief Read a triangle mesh by extension (.obj or .stl, either case).
+inline bool read_triangle_mesh(const std::string &fn, TriangleMesh &mesh) {
+  std::string ext = fn.substr(fn.find_last_of('.') + 1);
+  for (auto &c : ext) c = (char)std::tolower(c);
+  if (ext == "obj") return read_obj_mesh(fn, mesh);
+  if (ext == "stl") return read_stl_mesh(fn, mesh);
+  std::cerr << "ERROR: Mesh file " << fn << " must be .obj or .stl\n";
+  return false;
+}
+
+} // namespace mn
+
+#endif
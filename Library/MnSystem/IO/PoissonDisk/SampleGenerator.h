@@ -1,4 +1,5 @@
 #if 1
+#include <cstdint>
 #include <string>
 #include <iostream>
 #include <fstream>
@@ -10,6 +11,7 @@
 
 #include "cySampleElim.h"
 #include "cyPoint.h"
+#include "SparseLevelSet.h"
 
 class SampleGenerator
 {
@@ -27,7 +29,7 @@ public:
 	int GenerateCartesianSamples(float samplesPerVol, std::vector<float>& outputSamples);
 
 protected:
-	inline float fetchGrid(int i, int j, int k) { return m_phiGrid[i + m_ni*(j + m_nj*k)];}
+	inline float fetchGrid(int i, int j, int k) { return m_isSparse ? m_sparse.fetch(i, j, k) : m_phiGrid[i + (size_t)m_ni*(j + (size_t)m_nj*k)];}
 	inline float fetchGridTrilinear(float x, float y, float z)
 	{
 		float dx = x - floor(x);
@@ -59,6 +61,8 @@ private:
 	int					m_padding;
 	cyPoint3f			m_minBox;
 	std::vector<float>	m_phiGrid;
+	SparseLevelSet		m_sparse; //< Narrow-band storage, used instead of m_phiGrid for SDFGen --sparse files
+	bool				m_isSparse = false;
 	cy::WeightedSampleElimination<cy::Point3f, float, 3, int> m_wse;
 };
 
@@ -72,10 +76,34 @@ SampleGenerator::~SampleGenerator()
 
 void SampleGenerator::LoadSDF(std::string filename, float& pDx, float& minx, float& miny, float& minz, int& ni, int& nj, int& nk)
 {
-	std::ifstream in(filename, std::ifstream::in);
-	in >> m_ni >> m_nj >> m_nk;
-	in >> m_minBox[0] >> m_minBox[1] >> m_minBox[2];
-	in >> m_dx;
+	std::ifstream in(filename, std::ifstream::in | std::ifstream::binary);
+	// SDFGen --binary: "SDFB", int32 ni nj nk, float32 origin xyz, float32 dx, float32 values
+	// SDFGen --sparse: "SDFS", see SparseLevelSet.h
+	char magic[4] = {0, 0, 0, 0};
+	in.read(magic, 4);
+	const bool binary = in && magic[0] == 'S' && magic[1] == 'D' && magic[2] == 'F' && magic[3] == 'B';
+	m_isSparse = in && magic[0] == 'S' && magic[1] == 'D' && magic[2] == 'F' && magic[3] == 'S';
+	if (m_isSparse) {
+		float origin[3];
+		if (!m_sparse.read(in, m_ni, m_nj, m_nk, origin, m_dx))
+			std::cout << "ERROR: Sparse SDF file " << filename << " is truncated." << std::endl;
+		m_minBox[0] = origin[0]; m_minBox[1] = origin[1]; m_minBox[2] = origin[2];
+		m_phiGrid.clear();
+	} else if (binary) {
+		int32_t dims[3];
+		float header[4];
+		in.read(reinterpret_cast<char*>(dims), sizeof(dims));
+		in.read(reinterpret_cast<char*>(header), sizeof(header));
+		m_ni = dims[0]; m_nj = dims[1]; m_nk = dims[2];
+		m_minBox[0] = header[0]; m_minBox[1] = header[1]; m_minBox[2] = header[2];
+		m_dx = header[3];
+	} else {
+		in.clear();
+		in.seekg(0);
+		in >> m_ni >> m_nj >> m_nk;
+		in >> m_minBox[0] >> m_minBox[1] >> m_minBox[2];
+		in >> m_dx;
+	}
 
 	pDx = m_dx;
 	ni = m_ni;
@@ -87,11 +115,21 @@ void SampleGenerator::LoadSDF(std::string filename, float& pDx, float& minx, flo
 
 	std::cout << "Load SDF grid size: " << m_ni << ", " << m_nj << ", " << m_nk << std::endl;
 
-	int gridSize = m_ni * m_nj * m_nk;
-	m_phiGrid.resize(gridSize);
-	for (int i = 0; i < gridSize; ++i) {
-		in >> m_phiGrid[i];
+	if (m_isSparse) {
+		std::cout << "Sparse SDF: " << m_sparse.nearBlocks() << " of " << m_sparse.totalBlocks() << " blocks in narrow-band, "
+			<< m_sparse.bytes() / (1024.0 * 1024.0) << " MB instead of " << (double)m_ni * m_nj * m_nk * sizeof(float) / (1024.0 * 1024.0) << " MB dense." << std::endl;
+		in.close();
+		return;
 	}
+
+	size_t gridSize = (size_t)m_ni * m_nj * m_nk;
+	m_phiGrid.resize(gridSize);
+	if (binary)
+		in.read(reinterpret_cast<char*>(m_phiGrid.data()), gridSize * sizeof(float));
+	else
+		for (size_t i = 0; i < gridSize; ++i) {
+			in >> m_phiGrid[i];
+		}
 	in.close();
 }
 
@@ -124,7 +162,7 @@ void SampleGenerator::GeneratePoissonSamples(int length, int width, int height,
 
 void SampleGenerator::GeneratePoissonSamples(float samplesPerVol, std::vector<float>& outputSamples, int inputScale)
 {
-	int numSamples = m_phiGrid.size() * samplesPerVol;
+	int numSamples = (size_t)m_ni * m_nj * m_nk * samplesPerVol;
 
 	std::cout << "Generate input " << numSamples * inputScale << " samples...";
 	std::vector<cy::Point3f> inputPoints(numSamples * inputScale);
@@ -0,0 +1,74 @@
+#ifndef SPARSE_LEVEL_SET_H
+#define SPARSE_LEVEL_SET_H
+#include <cstdint>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+// Narrow-band signed distance field, as written by SDFGen --sparse.
+// The grid is tiled into blockSize^3 blocks. Blocks holding a cell with |phi| <= band keep their values,
+// every other block keeps only an inside/outside flag and reads back as -band or +band.
+// A far block is more than band (>= 2 cells) from the surface, so trilinear signs next to it stay exact.
+//
+// File layout, after the 4-byte magic "SDFS":
+//   int32 ni nj nk, float32 origin xyz, float32 dx, int32 blockSize, float32 band, int32 nearBlocks,
+//   uint8 flags[nbi*nbj*nbk] (block i fastest, values in BlockFlag),
+//   float32 values[nearBlocks][blockSize^3] (near blocks in flag order, cell i fastest)
+class SparseLevelSet
+{
+public:
+	enum BlockFlag : uint8_t { Outside = 0, Inside = 1, Near = 2 };
+
+	// Read everything after the magic. Returns false on a truncated file.
+	bool read(std::istream& in, int& ni, int& nj, int& nk, float origin[3], float& dx)
+	{
+		int32_t dims[3], bs, nearCount;
+		in.read(reinterpret_cast<char*>(dims), sizeof(dims));
+		in.read(reinterpret_cast<char*>(origin), 3 * sizeof(float));
+		in.read(reinterpret_cast<char*>(&dx), sizeof(float));
+		in.read(reinterpret_cast<char*>(&bs), sizeof(bs));
+		in.read(reinterpret_cast<char*>(&m_band), sizeof(float));
+		in.read(reinterpret_cast<char*>(&nearCount), sizeof(nearCount));
+		if (!in || bs <= 0) return false;
+		ni = dims[0]; nj = dims[1]; nk = dims[2];
+		m_bs = bs;
+		m_bs3 = (size_t)bs * bs * bs;
+		m_nbi = (ni + bs - 1) / bs; m_nbj = (nj + bs - 1) / bs; m_nbk = (nk + bs - 1) / bs;
+
+		m_flags.resize((size_t)m_nbi * m_nbj * m_nbk);
+		in.read(reinterpret_cast<char*>(m_flags.data()), m_flags.size());
+		m_values.resize((size_t)nearCount * m_bs3);
+		in.read(reinterpret_cast<char*>(m_values.data()), m_values.size() * sizeof(float));
+
+		m_slots.clear();
+		m_slots.reserve(nearCount);
+		for (size_t b = 0; b < m_flags.size(); ++b)
+			if (m_flags[b] == Near) m_slots.emplace(b, (uint32_t)m_slots.size());
+		return (bool)in && (int)m_slots.size() == nearCount;
+	}
+
+	// O(1): flag lookup, plus one hash lookup inside the band
+	inline float fetch(int i, int j, int k) const
+	{
+		size_t b = (size_t)(i / m_bs) + m_nbi * ((size_t)(j / m_bs) + m_nbj * (size_t)(k / m_bs));
+		uint8_t flag = m_flags[b];
+		if (flag != Near) return flag == Inside ? -m_band : m_band;
+		const float* block = m_values.data() + m_slots.find(b)->second * m_bs3;
+		return block[(i % m_bs) + m_bs * ((j % m_bs) + m_bs * (k % m_bs))];
+	}
+
+	size_t nearBlocks() const { return m_slots.size(); }
+	size_t totalBlocks() const { return m_flags.size(); }
+	size_t bytes() const { return m_flags.size() + m_values.size() * sizeof(float) + m_slots.size() * (sizeof(size_t) + sizeof(uint32_t) + 2 * sizeof(void*)); }
+
+private:
+	int m_bs = 8;
+	size_t m_bs3 = 512;
+	size_t m_nbi = 0, m_nbj = 0, m_nbk = 0;
+	float m_band = 0.f;
+	std::vector<uint8_t> m_flags;
+	std::vector<float> m_values;
+	std::unordered_map<size_t, uint32_t> m_slots; //< Linear block index -> near-block slot in m_values
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef __MN_BENCH_H_
+#define __MN_BENCH_H_
+#include <MnBase/Profile/CppTimers.hpp>
+#include <algorithm>
+#include <cstring>
+#include <fmt/core.h>
+#include <limits>
+
+/// @brief Helpers of the host benchmarks: --quick for smoke runs, best-of-N timing, reference checks.
+namespace mn_bench {
+inline int failures = 0;
+
+inline bool quick(int argc, char **argv) {
+  for (int a = 1; a < argc; ++a)
+    if (!std::strcmp(argv[a], "--quick")) return true;
+  return false;
+}
+
+/// Best wall time in ms of reps runs of f, after one warm-up run
+template <typename F> double best_ms(int reps, F &&f) {
+  mn::CppTimer timer;
+  f();
+  double best = std::numeric_limits<double>::max();
+  for (int r = 0; r < reps; ++r) {
+    timer.tick();
+    f();
+    timer.tock();
+    best = std::min(best, (double)timer.elapsed());
+  }
+  return best;
+}
+
+/// Print one result row: items per second of a run of count items in ms
+inline void report(const char *what, std::size_t count, double ms) {
+  fmt::print("  {:<40} {:>12} items {:>10.3f} ms {:>10.3g} items/s\n", what, count, ms, count / (ms * 1e-3));
+}
+
+/// Print the summary line and return the exit code of main(), non-zero if a reference check failed
+inline int result(const char *name) {
+  fmt::print("{}: {}\n", name, failures ? "FAILED" : "done");
+  return failures ? 1 : 0;
+}
+} // namespace mn_bench
+
+#define MN_BENCH_CHECK(cond, ...)                                                                                      \
+  do {                                                                                                                 \
+    if (!(cond)) {                                                                                                     \
+      fmt::print(__VA_ARGS__);                                                                                         \
+      ++mn_bench::failures;                                                                                            \
+    }                                                                                                                  \
+  } while (0)
+
+#endif
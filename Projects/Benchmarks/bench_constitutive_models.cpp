@@ -0,0 +1,245 @@
+#include "bench.h"
+#include "constitutive_models.cuh"
+#include <array>
+#include <cmath>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+// Host throughput of the __host__ __device__ constitutive models (constitutive_models.cuh) over SoA batches, the
+// layout particle bins store F in: each particle gathers its F (and logJp) from per-component arrays, calls the model
+// and scatters stress and the projected state to separate output arrays, so every repetition sees the same inputs.
+// States are drawn near identity (within +-0.05) and far from it (0.05 to 0.3 off) and sorted into elastic and
+// yielding pools by running the model on them, so the return mapping and plastic branches are timed on their own.
+// Each model runs in float and double, and the two must agree before timing counts.
+namespace {
+using namespace mn;
+
+/// Material parameters in SI, a soft solid and water. JFluid reads F as its affine C = (F - I) dx, Dp_inv = 4 / dx^2
+template <typename T> struct Params {
+  T vol = 1e-6, mu = 4e5, lambda = 6e5, bulk = 2.2e9, gamma = 7.1, visc = 1e-3;
+  T yield = 1e5; //< Von Mises tensile yield strength, above the stress of the near-identity states
+  T dx = 0.01, Dp_inv = 4. / (0.01 * 0.01);
+};
+
+/// One deformation state as the double reference keeps it
+struct State {
+  std::array<double, 9> F;
+  double log_jp;
+};
+
+/// A batch of states in SoA, inputs and outputs apart
+template <typename T> struct Batch {
+  std::array<std::vector<T>, 9> F, F_out, PF;
+  std::vector<T> log_jp, log_jp_out;
+  explicit Batch(const std::vector<State> &states) {
+    const std::size_t n = states.size();
+    for (int e = 0; e < 9; ++e) {
+      F[e].resize(n), F_out[e].resize(n), PF[e].resize(n);
+      for (std::size_t i = 0; i < n; ++i) F[e][i] = static_cast<T>(states[i].F[e]);
+    }
+    log_jp.resize(n), log_jp_out.resize(n);
+    for (std::size_t i = 0; i < n; ++i) log_jp[i] = static_cast<T>(states[i].log_jp);
+  }
+  std::size_t size() const { return log_jp.size(); }
+};
+
+template <typename T, typename Model> void apply(Batch<T> &b, Model &model) {
+  const Params<T> p{};
+  for (std::size_t i = 0; i < b.size(); ++i) {
+    vec<T, 9> F, PF;
+    for (int e = 0; e < 9; ++e) F[e] = b.F[e][i];
+    T log_jp = b.log_jp[i];
+    PF.set(T(0));
+    model(p, F, log_jp, PF);
+    for (int e = 0; e < 9; ++e) b.F_out[e][i] = F[e], b.PF[e][i] = PF[e];
+    b.log_jp_out[i] = log_jp;
+  }
+}
+
+/// Run model on a single state, as T
+template <typename T, typename Model> State step(const State &s, Model &model, vec<T, 9> &PF) {
+  Batch<T> b{std::vector<State>{s}};
+  apply(b, model);
+  State out;
+  for (int e = 0; e < 9; ++e) out.F[e] = b.F_out[e][0], PF[e] = b.PF[e][0];
+  out.log_jp = b.log_jp_out[0];
+  return out;
+}
+
+/// Default yield test: the model projected F or moved logJp
+template <typename T> bool state_changed(const State &in, const State &out, const vec<T, 9> &) {
+  const double tol = std::is_same_v<T, float> ? 1e-4 : 1e-9;
+  double d = std::abs(out.log_jp - in.log_jp);
+  for (int e = 0; e < 9; ++e) d = std::max(d, std::abs(out.F[e] - in.F[e]));
+  return d > tol;
+}
+
+/// state_changed for either precision
+constexpr auto projected = [](const State &in, const State &out, const auto &PF) { return state_changed(in, out, PF); };
+
+/// Von Mises leaves F alone and caps the stress, so it yielded when the output sits on the yield surface
+template <typename T> bool on_vonmises_surface(const State &, const State &, const vec<T, 9> &PF) {
+  const Params<double> p{};
+  auto s = [&](int e) { return (double)PF[e] / p.vol; };
+  const double sq = 0.5 * ((s(0) - s(4)) * (s(0) - s(4)) + (s(4) - s(8)) * (s(4) - s(8)) +
+                           (s(8) - s(0)) * (s(8) - s(0)) + 6. * (s(1) * s(1) + s(2) * s(2) + s(5) * s(5)));
+  return std::sqrt(sq) >= std::sqrt(1.5) * p.yield * (1. - (std::is_same_v<T, float> ? 1e-4 : 1e-9));
+}
+
+/// Elastic and yielding pools of n states each, only states float and double sort the same way. A pool stays short
+/// when the model never (or always) yields on the states drawn
+template <typename Model, typename Yielded>
+std::array<std::vector<State>, 2> classify(std::size_t n, double log_jp0, Model &model, Yielded &&yielded) {
+  std::mt19937 rng(1);
+  std::uniform_real_distribution<double> near(-0.05, 0.05), far(0.05, 0.3);
+  std::bernoulli_distribution sign(0.5);
+  std::array<std::vector<State>, 2> pools;
+  for (std::size_t attempt = 0; attempt < 64 * n && (pools[0].size() < n || pools[1].size() < n); ++attempt) {
+    State s{{}, log_jp0};
+    const bool draw_far = attempt & 1;
+    for (int e = 0; e < 9; ++e) {
+      const double off = draw_far ? (sign(rng) ? 1. : -1.) * far(rng) : near(rng);
+      s.F[e] = ((e & 0x3) ? 0. : 1.) + off;
+    }
+    if (matrixDeterminant3d(s.F.data()) < 0.2) continue; //< Keep clear of inverted and collapsed cells
+    vec<float, 9> PFf;
+    vec<double, 9> PFd;
+    const bool yf = yielded(s, step<float>(s, model, PFf), PFf);
+    const bool yd = yielded(s, step<double>(s, model, PFd), PFd);
+    if (yf != yd) continue;
+    if (pools[yd].size() < n) pools[yd].push_back(s);
+  }
+  return pools;
+}
+
+/// Per-particle time of model over states in float and double, check float against double
+template <typename Model> std::array<double, 3> timings(const std::vector<State> &states, int reps, Model &model) {
+  Batch<float> bf{states};
+  Batch<double> bd{states};
+  const double ms_f = mn_bench::best_ms(reps, [&]() { apply(bf, model); });
+  const double ms_d = mn_bench::best_ms(reps, [&]() { apply(bd, model); });
+  double scale = 0., diff = 0.;
+  for (int e = 0; e < 9; ++e)
+    for (std::size_t i = 0; i < states.size(); ++i) {
+      scale = std::max(scale, std::abs(bd.PF[e][i]));
+      diff = std::max(diff, std::abs(bf.PF[e][i] - bd.PF[e][i]));
+    }
+  const double n = (double)states.size();
+  return {ms_f * 1e6 / n, ms_d * 1e6 / n, std::isfinite(scale) ? diff / (scale > 0. ? scale : 1.) : 1.};
+}
+
+constexpr double yield_fraction = 0.25; //< Yielding share of the mixed batch
+
+/// Time model on its elastic pool, its yielding pool and a shuffled mix of the two. plastic says the model has a
+/// return mapping, and then both pools must fill
+template <typename Model, typename Yielded>
+void run(const char *what, std::size_t n, int reps, bool plastic, double log_jp0, Model &&model, Yielded &&yielded) {
+  auto pools = classify(n, log_jp0, model, yielded);
+  MN_BENCH_CHECK(pools[0].size() == n, "{}: only {} of {} elastic states\n", what, pools[0].size(), n);
+  if (plastic)
+    MN_BENCH_CHECK(pools[1].size() == n, "{}: only {} of {} yielding states\n", what, pools[1].size(), n);
+  else
+    MN_BENCH_CHECK(pools[1].empty(), "{}: elastic model changed its state\n", what);
+  if (pools[0].empty() || (plastic && pools[1].empty())) return;
+  auto el = timings(pools[0], reps, model);
+  double rel = el[2];
+  if (!plastic) {
+    fmt::print("  {:<26} {:>7.1f} {:>7.1f} {:>31} {:>9.2g}\n", what, el[0], el[1], "", rel);
+  } else {
+    std::vector<State> mix;
+    const std::size_t n_plastic = (std::size_t)(yield_fraction * pools[0].size());
+    mix.insert(mix.end(), pools[1].begin(), pools[1].begin() + std::min(n_plastic, pools[1].size()));
+    mix.insert(mix.end(), pools[0].begin(), pools[0].begin() + (pools[0].size() - n_plastic));
+    std::shuffle(mix.begin(), mix.end(), std::mt19937(2));
+    auto pl = timings(pools[1], reps, model);
+    auto mx = timings(mix, reps, model);
+    rel = std::max({el[2], pl[2], mx[2]});
+    fmt::print("  {:<26} {:>7.1f} {:>7.1f} {:>7.1f} {:>7.1f} {:>7.1f} {:>7.1f} {:>9.2g}\n", what, el[0], el[1], pl[0],
+               pl[1], mx[0], mx[1], rel);
+  }
+  MN_BENCH_CHECK(rel < 1e-2, "{}: float and double disagree by {}\n", what, rel);
+}
+template <typename Model> void run(const char *what, std::size_t n, int reps, Model &&model) {
+  run(what, n, reps, false, 0., model, projected);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const bool quick = mn_bench::quick(argc, argv);
+  const std::size_t n = quick ? (1u << 10) : 100000;
+  const int reps = quick ? 1 : 3;
+  fmt::print("bench_constitutive_models: [{}] states per pool, ns per particle, single thread, mix {:.0f}% yielding\n",
+             n, yield_fraction * 100);
+  fmt::print("  {:<26} {:>15} {:>15} {:>15} {:>9}\n", "", "elastic", "yielding", "mixed", "");
+  fmt::print("  {:<26} {:>7} {:>7} {:>7} {:>7} {:>7} {:>7} {:>9}\n", "model", "float", "double", "float", "double",
+             "float", "double", "f vs d");
+  run("stress_jfluid", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    vec<T, 9> C;
+    for (int e = 0; e < 9; ++e) C[e] = (F[e] - ((e & 0x3) ? T(0) : T(1))) * p.dx;
+    compute_stress_jfluid<T>(p.vol, p.bulk, p.gamma, p.Dp_inv, p.visc, matrixDeterminant3d(F.data()), C, PF);
+  });
+  run("energy_jfluid", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    compute_energy_jfluid<T>(p.vol, p.bulk, p.gamma, matrixDeterminant3d(F.data()), PF[0]);
+  });
+  run("stress_fixedcorotated", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    compute_stress_fixedcorotated<T>(p.vol, p.mu, p.lambda, F, PF);
+  });
+  run("stress_PK1_fixedcorotated", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    compute_stress_PK1_fixedcorotated<T>(p.vol, p.mu, p.lambda, F, PF);
+  });
+  run("energy_fixedcorotated", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    compute_energy_fixedcorotated<T>(p.vol, p.mu, p.lambda, F, PF[0]);
+  });
+  run("stress_neohookean", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    compute_stress_neohookean<T>(p.vol, p.mu, p.lambda, F, PF);
+  });
+  run("stress_PK1_neohookean", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    compute_stress_PK1_neohookean<T>(p.vol, p.mu, p.lambda, F, PF);
+  });
+  run("energy_neohookean", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    compute_energy_neohookean<T>(p.vol, p.mu, p.lambda, F, PF[0]);
+  });
+  run("stress_PK1_vonmises", n, reps, [](auto p, auto &F, auto &, auto &PF) {
+    using T = decltype(p.vol);
+    compute_stress_PK1_vonmises<T>(p.vol, p.mu, p.lambda, F, PF);
+  });
+  run(
+      "stress_vonmises", n, reps, true, 0.,
+      [](auto p, auto &F, auto &, auto &PF) {
+        using T = decltype(p.vol);
+        compute_stress_vonmises<T>(p.vol, p.mu, p.lambda, p.yield, F, PF);
+      },
+      [](const State &in, const State &out, const auto &PF) { return on_vonmises_surface(in, out, PF); });
+  run(
+      "stress_sand", n, reps, true, 0.,
+      [](auto p, auto &F, auto &log_jp, auto &PF) {
+        using T = decltype(p.vol);
+        compute_stress_sand<T>(p.vol, p.mu, p.lambda, T(0), T(0.5), T(0.8), true, log_jp, F, PF);
+      },
+      projected);
+  run(
+      "stress_CoupledUP", n, reps, true, 0.,
+      [](auto p, auto &F, auto &log_jp, auto &PF) {
+        using T = decltype(p.vol);
+        T pw = 0;
+        compute_stress_CoupledUP<T>(p.vol, p.mu, p.lambda, T(0), T(0.5), T(0.8), true, log_jp, pw, F, PF);
+      },
+      projected);
+  run(
+      "stress_nacc", n, reps, true, -0.1, //< Compacted enough to leave an elastic region
+      [](auto p, auto &F, auto &log_jp, auto &PF) {
+        using T = decltype(p.vol);
+        compute_stress_nacc<T>(p.vol, p.mu, p.lambda, T(1e6), T(0.8), T(0.5), T(2.36), true, log_jp, F, PF);
+      },
+      projected);
+  return mn_bench::result("bench_constitutive_models");
+}
@@ -0,0 +1,310 @@
+#include "bench.h"
+#include <MnBase/Algorithm/RadixSort.h>
+#include <MnBase/DataStructure/Bvh/Bvh.cuh>
+#include <MnBase/DataStructure/Hash/Hash.cuh>
+#include <MnBase/Memory/Allocator.h>
+#include <MnBase/Object/Structural.h>
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <random>
+#include <vector>
+
+// Host benchmarks of the particle data structures, one section each (all by default, or name them, e.g. "sort"):
+//   sort  radix_sort_pairs and particle_bins::build at 1M to 50M particles, against std::sort
+//   hash  partition block lookups, block_hash (g_partition_block_hash) against the dense _indexTable
+//   bvh   host_lbvh build, overlap and nearest queries at 200k and 1M boxes, against brute force
+//   layout  particle update and gather kernels on structurals in aos, soa and aosoa_8/16/32 attribute layouts
+namespace {
+bool section(int argc, char **argv, const char *name) {
+  bool named = false;
+  for (int a = 1; a < argc; ++a) {
+    if (argv[a][0] == '-') continue;
+    named = true;
+    if (!std::strcmp(argv[a], name)) return true;
+  }
+  return !named;
+}
+
+// * sort: particles at 8 per cell on average, cell keys blockno * 64 + cellno as build_particle_cell_buckets
+void bench_sort(mn::thread_pool &pool, bool quick) {
+  constexpr int block_volume = 64, bin_capacity = 32, max_ppc = 32;
+  const std::vector<std::size_t> sizes = quick ? std::vector<std::size_t>{100000} : std::vector<std::size_t>{1000000, 10000000, 50000000};
+  const int reps = quick ? 1 : 3;
+  fmt::print("sort: radix_sort_pairs / particle_bins on [{}] threads, 8 particles per cell\n", pool.size());
+  for (std::size_t n : sizes) {
+    const int block_count = (int)std::max<std::size_t>(1, n / (8 * block_volume));
+    std::mt19937 rng(1);
+    std::vector<uint32_t> random_keys(n), nearly_sorted(n);
+    for (auto &k : random_keys) k = rng() % (uint32_t)(block_count * block_volume);
+    nearly_sorted = random_keys;
+    std::sort(nearly_sorted.begin(), nearly_sorted.end());
+    for (std::size_t i = 0; i < n / 20; ++i) std::swap(nearly_sorted[rng() % n], nearly_sorted[rng() % n]); //< ~5% moved, as after one step
+
+    std::vector<uint32_t> keys(n), keys_alt(n);
+    std::vector<int> ids(n), ids_alt(n);
+    auto reset = [&]() {
+      std::memcpy(keys.data(), random_keys.data(), n * sizeof(uint32_t));
+      for (std::size_t i = 0; i < n; ++i) ids[i] = (int)i;
+    };
+    int end_bit = 0;
+    while ((std::size_t{1} << end_bit) < (std::size_t)block_count * block_volume) ++end_bit;
+    double ms = mn_bench::best_ms(reps, [&]() {
+      reset();
+      mn::radix_sort_pairs(pool, n, keys.data(), ids.data(), keys_alt.data(), ids_alt.data(), end_bit);
+    });
+    mn_bench::report("radix_sort_pairs (incl. reset)", n, ms);
+    std::vector<uint64_t> pairs(n);
+    ms = mn_bench::best_ms(reps, [&]() {
+      for (std::size_t i = 0; i < n; ++i) pairs[i] = (uint64_t)random_keys[i] << 32 | i;
+      std::sort(pairs.begin(), pairs.end());
+    });
+    mn_bench::report("std::sort of packed pairs", n, ms);
+    bool same = true;
+    for (std::size_t i = 0; i < n && same; ++i) same = keys[i] == (uint32_t)(pairs[i] >> 32) && ids[i] == (int)(uint32_t)pairs[i];
+    MN_BENCH_CHECK(same, "  radix_sort_pairs differs from the stable std::sort order at n = {}\n", n);
+    std::vector<uint64_t>().swap(pairs);
+
+    mn::particle_bins<block_volume, bin_capacity, max_ppc> bins;
+    mn_bench::report("particle_bins::build, random", n, mn_bench::best_ms(reps, [&]() { bins.build(pool, n, random_keys.data(), block_count); }));
+    std::size_t binned = 0;
+    for (int b : bins.ppbs) binned += b;
+    MN_BENCH_CHECK(binned + bins.dropped == n, "  particle_bins lost particles: {} binned + {} dropped != {}\n", binned, bins.dropped, n);
+    mn_bench::report("particle_bins::build, 95% sorted", n, mn_bench::best_ms(reps, [&]() { bins.build(pool, n, nearly_sorted.data(), block_count); }));
+    fmt::print("  {} blocks, {} bins, {} particles over MAX_PPC {} dropped\n", block_count, bins.bin_count(), bins.dropped, max_ppc);
+  }
+}
+
+// * hash: a 512 x 16 x 32-block flume in a 512^3-block domain (DOMAIN_BITS 11, 4^3-cell blocks), as Partition::query
+void bench_hash(mn::thread_pool &pool, bool quick) {
+  using hash_t = mn::host_block_hash<int>;
+  const int domain = quick ? 64 : 512, nx = quick ? 64 : 512, ny = 16, nz = 32;
+  const int reps = quick ? 1 : 5;
+  std::vector<uint64_t> keys;
+  std::vector<int> coords;
+  for (int x = 0; x < nx; ++x)
+    for (int y = 0; y < ny; ++y)
+      for (int z = 0; z < nz; ++z) keys.push_back(hash_t::table_t::block_key(x, y + 8, z + 64)), coords.push_back((x * domain + y + 8) * domain + z + 64);
+  const std::size_t blocks = keys.size();
+  fmt::print("hash: [{}] active blocks of a [{}^3]-block domain\n", blocks, domain);
+  hash_t hash(blocks);
+  std::vector<int> dense((std::size_t)domain * domain * domain, -1); //< _indexTable, one entry per possible block
+  mn_bench::report("block_hash bulk insert", blocks, mn_bench::best_ms(reps, [&]() {
+    hash.clear();
+    hash.insert_bulk(pool, blocks, keys.data());
+  }));
+  for (std::size_t i = 0; i < blocks; ++i) dense[coords[i]] = hash.query(keys[i]);
+  fmt::print("  memory: block_hash {:.1f} MB, dense table {:.1f} MB\n", hash.port().size() * (sizeof(uint64_t) + sizeof(int)) / 1e6,
+             dense.size() * sizeof(int) / 1e6);
+
+  // In block order, as g2p2g walks sorted blocks and their neighbours, and in random order, as scattered queries
+  std::vector<uint32_t> order(blocks);
+  for (std::size_t i = 0; i < blocks; ++i) order[i] = (uint32_t)i;
+  std::mt19937 rng(2);
+  std::vector<uint32_t> shuffled = order;
+  std::shuffle(shuffled.begin(), shuffled.end(), rng);
+  volatile long long sink = 0;
+  bool same = true;
+  for (const auto *ord : {&order, &shuffled}) {
+    const bool random = ord == &shuffled;
+    double hash_ms = mn_bench::best_ms(reps, [&]() {
+      long long acc = 0;
+      auto table = hash.port();
+      for (uint32_t i : *ord) acc += table.query(keys[i]);
+      sink = sink + acc;
+    });
+    double dense_ms = mn_bench::best_ms(reps, [&]() {
+      long long acc = 0;
+      for (uint32_t i : *ord) acc += dense[coords[i]];
+      sink = sink + acc;
+    });
+    mn_bench::report(random ? "block_hash query, random order" : "block_hash query, block order", blocks, hash_ms);
+    mn_bench::report(random ? "dense table query, random order" : "dense table query, block order", blocks, dense_ms);
+  }
+  for (std::size_t i = 0; i < blocks && same; ++i) same = hash.query(keys[i]) == dense[coords[i]];
+  MN_BENCH_CHECK(same, "  block_hash and dense table disagree\n");
+}
+
+// * bvh: small boxes scattered in the unit cube, as triangles of boundary meshes. Brute force runs a subset of the
+// queries, the report is per query either way.
+void bench_bvh(mn::thread_pool &pool, bool quick) {
+  using box_t = mn::aabb<float>;
+  const std::vector<std::size_t> sizes = quick ? std::vector<std::size_t>{20000} : std::vector<std::size_t>{200000, 1000000};
+  const std::size_t queries = quick ? 2000 : 20000, brute_queries = quick ? 50 : 200;
+  const int reps = quick ? 1 : 3;
+  fmt::print("bvh: host_lbvh on [{}] threads, [{}] queries ([{}] by brute force)\n", pool.size(), queries, brute_queries);
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<float> uni(0.f, 1.f);
+  auto random_box = [&](float size) {
+    box_t b;
+    for (int d = 0; d < 3; ++d) b.lo[d] = uni(rng), b.hi[d] = b.lo[d] + size * uni(rng);
+    return b;
+  };
+  std::vector<box_t> query_boxes(queries);
+  std::vector<float> points(3 * queries);
+  for (auto &q : query_boxes) q = random_box(0.02f);
+  for (auto &p : points) p = uni(rng);
+  for (std::size_t n : sizes) {
+    std::vector<box_t> boxes(n);
+    const float size = 0.5f / std::cbrt((float)n); //< ~1 box per query box on average
+    for (auto &b : boxes) b = random_box(size);
+    fmt::print(" [{}] boxes\n", n);
+    mn::host_lbvh<float> bvh;
+    mn_bench::report("host_lbvh build", n, mn_bench::best_ms(reps, [&]() { bvh.build(pool, n, boxes.data()); }));
+
+    std::vector<std::pair<int, int>> pairs;
+    mn_bench::report("lbvh overlap_bulk", queries, mn_bench::best_ms(reps, [&]() { bvh.overlap_bulk(pool, queries, query_boxes.data(), pairs); }));
+    std::vector<std::pair<int, int>> brute_pairs;
+    mn_bench::report("brute-force overlap", brute_queries, mn_bench::best_ms(1, [&]() {
+      brute_pairs.clear();
+      for (std::size_t q = 0; q < brute_queries; ++q)
+        for (std::size_t i = 0; i < n; ++i)
+          if (boxes[i].overlaps(query_boxes[q])) brute_pairs.emplace_back((int)q, (int)i);
+    }));
+    std::vector<std::pair<int, int>> head(pairs.begin(), std::lower_bound(pairs.begin(), pairs.end(), std::make_pair((int)brute_queries, 0)));
+    std::sort(head.begin(), head.end());
+    MN_BENCH_CHECK(head == brute_pairs, "  lbvh overlap pairs differ from brute force ({} vs {})\n", head.size(), brute_pairs.size());
+
+    std::vector<int> ids(queries);
+    std::vector<float> d2(queries);
+    mn_bench::report("lbvh nearest_bulk", queries, mn_bench::best_ms(reps, [&]() { bvh.nearest_bulk(pool, queries, points.data(), ids.data(), d2.data()); }));
+    std::vector<float> brute_d2(brute_queries, std::numeric_limits<float>::max());
+    mn_bench::report("brute-force nearest", brute_queries, mn_bench::best_ms(1, [&]() {
+      for (std::size_t q = 0; q < brute_queries; ++q) {
+        float best = std::numeric_limits<float>::max();
+        for (std::size_t i = 0; i < n; ++i) best = std::min(best, boxes[i].distance2(points.data() + 3 * q));
+        brute_d2[q] = best;
+      }
+    }));
+    bool same = true;
+    for (std::size_t q = 0; q < brute_queries && same; ++q) same = d2[q] == brute_d2[q];
+    MN_BENCH_CHECK(same, "  lbvh nearest distances differ from brute force\n");
+  }
+}
+// * layout: 1M particles of 13 float channels (position, deformation gradient, J) as a dense structural per
+// attrib_layout. The update streams every channel, aosoa looping over tiles then lanes with val_tile. The gather reads
+// all channels of particles in random order, as g2p2g reads particles of a block through the bucket indices.
+constexpr int layout_channels = 13;
+constexpr int layout_particles = 1 << 20;
+using layout_f_ = mn::structural_entity<float>;
+template <mn::attrib_layout Layout>
+using layout_bin_ = mn::structural<mn::structural_type::dense,
+                                   mn::decorator<mn::structural_allocation_policy::full_allocation,
+                                                 mn::structural_padding_policy::compact>,
+                                   mn::compact_domain<int, layout_particles>, Layout, layout_f_, layout_f_, layout_f_,
+                                   layout_f_, layout_f_, layout_f_, layout_f_, layout_f_, layout_f_, layout_f_,
+                                   layout_f_, layout_f_, layout_f_>;
+
+template <typename Bin, std::size_t... C>
+void layout_load(Bin &bin, std::size_t i, float *v, std::index_sequence<C...>) {
+  if constexpr (Bin::tile_width > 1)
+    ((v[C] = bin.val_tile(std::integral_constant<mn::attrib_index, C>{}, i / Bin::tile_width, i % Bin::tile_width)), ...);
+  else
+    ((v[C] = bin.val_1d(std::integral_constant<mn::attrib_index, C>{}, i)), ...);
+}
+template <typename Bin, std::size_t... C>
+void layout_store(Bin &bin, std::size_t i, const float *v, std::index_sequence<C...>) {
+  if constexpr (Bin::tile_width > 1)
+    ((bin.val_tile(std::integral_constant<mn::attrib_index, C>{}, i / Bin::tile_width, i % Bin::tile_width) = v[C]), ...);
+  else
+    ((bin.val_1d(std::integral_constant<mn::attrib_index, C>{}, i) = v[C]), ...);
+}
+/// x += dt * F e_x, F *= 1 + dt, J *= (1 + dt)^3
+inline void layout_kernel(float *v, float dt) {
+  for (int d = 0; d < 3; ++d) v[d] += dt * v[3 + 3 * d];
+  for (int c = 3; c < 12; ++c) v[c] *= 1.f + dt;
+  v[12] *= (1.f + dt) * (1.f + dt) * (1.f + dt);
+}
+
+template <mn::attrib_layout Layout>
+void bench_layout_one(const char *name, const std::vector<uint32_t> &order, int reps, std::vector<float> &final_values,
+                      double &gathered) {
+  constexpr auto channels = std::make_index_sequence<layout_channels>{};
+  constexpr std::size_t n = layout_particles;
+  mn::heap_allocator allocator;
+  auto bin = mn::spawn<layout_bin_<Layout>, mn::orphan_signature>(allocator);
+  using bin_t = decltype(bin);
+  auto reset = [&]() {
+    for (std::size_t i = 0; i < n; ++i) {
+      float v[layout_channels];
+      for (int c = 0; c < layout_channels; ++c) v[c] = (float)((i * 7 + c * 13) % 101) * 0.01f;
+      layout_store(bin, i, v, channels);
+    }
+  };
+  reset();
+  double ms = mn_bench::best_ms(reps, [&]() {
+    if constexpr (bin_t::tile_width > 1) {
+      for (std::size_t t = 0; t < n / bin_t::tile_width; ++t)
+        for (std::size_t l = 0; l < bin_t::tile_width; ++l) {
+          float v[layout_channels];
+          layout_load(bin, t * bin_t::tile_width + l, v, channels);
+          layout_kernel(v, 1e-4f);
+          layout_store(bin, t * bin_t::tile_width + l, v, channels);
+        }
+    } else {
+      for (std::size_t i = 0; i < n; ++i) {
+        float v[layout_channels];
+        layout_load(bin, i, v, channels);
+        layout_kernel(v, 1e-4f);
+        layout_store(bin, i, v, channels);
+      }
+    }
+  });
+  fmt::print(" {}\n", name);
+  mn_bench::report("update, all channels", n, ms);
+  // Same reps of the kernel on every layout, so the values must agree
+  reset();
+  for (int r = 0; r < reps + 1; ++r)
+    for (std::size_t i = 0; i < n; ++i) {
+      float v[layout_channels];
+      layout_load(bin, i, v, channels);
+      layout_kernel(v, 1e-4f);
+      layout_store(bin, i, v, channels);
+    }
+  final_values.resize(n * layout_channels);
+  for (std::size_t i = 0; i < n; ++i) layout_load(bin, i, final_values.data() + i * layout_channels, channels);
+
+  double sum = 0.;
+  ms = mn_bench::best_ms(reps, [&]() {
+    double acc = 0.;
+    for (uint32_t i : order) {
+      float v[layout_channels];
+      layout_load(bin, i, v, channels);
+      for (int c = 0; c < layout_channels; ++c) acc += v[c];
+    }
+    sum = acc;
+  });
+  mn_bench::report("gather, random order", order.size(), ms);
+  gathered = sum;
+  bin.deallocate(allocator);
+}
+
+void bench_layout(bool quick) {
+  const int reps = quick ? 1 : 5;
+  fmt::print("layout: [{}] particles, [{}] float channels\n", layout_particles, layout_channels);
+  std::vector<uint32_t> order(layout_particles);
+  std::iota(order.begin(), order.end(), 0u);
+  std::mt19937 rng(4);
+  std::shuffle(order.begin(), order.end(), rng);
+  std::vector<float> reference, values;
+  double reference_sum, sum;
+  bench_layout_one<mn::attrib_layout::soa>("soa", order, reps, reference, reference_sum);
+  auto check = [&](const char *name) {
+    MN_BENCH_CHECK(values == reference && sum == reference_sum, "  {} values differ from soa\n", name);
+  };
+  bench_layout_one<mn::attrib_layout::aos>("aos", order, reps, values, sum), check("aos");
+  bench_layout_one<mn::attrib_layout::aosoa_8>("aosoa_8", order, reps, values, sum), check("aosoa_8");
+  bench_layout_one<mn::attrib_layout::aosoa_16>("aosoa_16", order, reps, values, sum), check("aosoa_16");
+  bench_layout_one<mn::attrib_layout::aosoa_32>("aosoa_32", order, reps, values, sum), check("aosoa_32");
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const bool quick = mn_bench::quick(argc, argv);
+  mn::thread_pool pool;
+  if (section(argc, argv, "sort")) bench_sort(pool, quick);
+  if (section(argc, argv, "hash")) bench_hash(pool, quick);
+  if (section(argc, argv, "bvh")) bench_bvh(pool, quick);
+  if (section(argc, argv, "layout")) bench_layout(quick);
+  return mn_bench::result("bench_particle_structures");
+}
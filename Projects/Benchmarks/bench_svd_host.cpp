@@ -0,0 +1,66 @@
+#include "bench.h"
+#include <MnBase/Math/Matrix/svd_host.h>
+#include <random>
+#include <vector>
+
+// Throughput of the batched host SVD (svd_host_batch, polar_host_batch) against one svd_host call per matrix,
+// on near-identity deformation gradients as the CPU backend decomposes them. Accuracy: Projects/Tests/test_svd_host_batch.
+namespace {
+/// count column-major matrices F = I + 0.2 R, stored SoA in batches of N: entry e of matrix b * N + l at [(b * 9 + e) * N + l]
+template <int N, typename T> std::vector<T> make_batches(std::size_t count) {
+  std::mt19937_64 rng(3);
+  std::uniform_real_distribution<double> u(-1., 1.);
+  std::vector<T> A(count * 9);
+  for (std::size_t b = 0; b < count / N; ++b)
+    for (int e = 0; e < 9; ++e)
+      for (int l = 0; l < N; ++l) A[(b * 9 + e) * N + l] = static_cast<T>(((e & 0x3) ? 0. : 1.) + 0.2 * u(rng));
+  return A;
+}
+
+template <int N, typename T> void bench_batch(const char *what, std::size_t count, int reps) {
+  auto A = make_batches<N, T>(count);
+  std::vector<T> U(count * 9), S(count * 3), V(count * 9);
+  mn_bench::report(what, count, mn_bench::best_ms(reps, [&]() {
+    for (std::size_t b = 0; b < count / N; ++b)
+      mn::math::svd_host_batch<N>(&A[b * 9 * N], &U[b * 9 * N], &S[b * 3 * N], &V[b * 9 * N]);
+  }));
+  MN_BENCH_CHECK(S[0] > T(0.5) && S[0] < T(2), "{}: S[0] = {} out of range\n", what, S[0]);
+}
+
+template <int N, typename T> void bench_polar(const char *what, std::size_t count, int reps) {
+  auto A = make_batches<N, T>(count);
+  std::vector<T> R(count * 9), P(count * 9);
+  mn_bench::report(what, count, mn_bench::best_ms(reps, [&]() {
+    for (std::size_t b = 0; b < count / N; ++b) mn::math::polar_host_batch<N>(&A[b * 9 * N], &R[b * 9 * N], &P[b * 9 * N]);
+  }));
+}
+
+template <typename T> void bench_scalar(const char *what, std::size_t count, int reps) {
+  constexpr int N = 8;
+  auto A = make_batches<N, T>(count);
+  std::vector<T> U(count * 9), S(count * 3), V(count * 9);
+  mn_bench::report(what, count, mn_bench::best_ms(reps, [&]() {
+    for (std::size_t m = 0; m < count; ++m) {
+      const std::size_t b = m / N, l = m % N;
+      T a[9];
+      for (int e = 0; e < 9; ++e) a[e] = A[(b * 9 + e) * N + l];
+      mn::math::svd_host(a, &U[m * 9], &S[m * 3], &V[m * 9]);
+    }
+  }));
+  MN_BENCH_CHECK(S[0] > T(0.5) && S[0] < T(2), "{}: S[0] = {} out of range\n", what, S[0]);
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const bool quick = mn_bench::quick(argc, argv);
+  const std::size_t count = quick ? (1u << 10) : (1u << 20); //< Multiple of 16
+  const int reps = quick ? 1 : 5;
+  fmt::print("bench_svd_host: [{}] near-identity 3x3 matrices, single thread\n", count);
+  bench_scalar<double>("svd_host, double, one per call", count, reps);
+  bench_scalar<float>("svd_host, float, one per call", count, reps);
+  bench_batch<8, double>("svd_host_batch<8, double>", count, reps);
+  bench_batch<16, float>("svd_host_batch<16, float>", count, reps);
+  bench_polar<8, double>("polar_host_batch<8, double>", count, reps);
+  bench_polar<16, float>("polar_host_batch<16, float>", count, reps);
+  return mn_bench::result("bench_svd_host");
+}
@@ -0,0 +1,200 @@
+#include "bench.h"
+#include "transfer_simd.h"
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Throughput of the batched CPU backend transfers (transfer_simd.h) against the per-particle scalar loop they replace:
+// B-spline weights, APIC gather (G2P) and mass / momentum scatter (P2G) in one 8^3 arena.
+// Build with -DMN_BENCH_MARCH_NATIVE=ON to time the AVX2 / AVX-512 paths, else the portable scalar lanes
+// (which cpu_benchmark does not use, simd::batched is false and it keeps the per-particle loop).
+namespace {
+using namespace mn;
+constexpr int L = simd::lanes, A = simd::arena_size, V = simd::arena_volume;
+constexpr double dx = 1.0 / 64, dx_inv = 64;
+
+struct Particles {
+  std::vector<double> x[3], mass, v[3], c[9]; //< Structure of arrays, as the CPU backend batches
+};
+
+/// Per-particle reference, same math as bspline_weight and g2p2g
+struct Stencil {
+  int base;
+  double local, w[3];
+};
+Stencil scalar_weights(double x) {
+  Stencil s;
+  s.base = (int)std::floor(x * dx_inv + 0.5) - 1;
+  s.local = x - s.base * dx;
+  double d = s.local * dx_inv;
+  s.w[0] = 0.5 * (1.5 - d) * (1.5 - d);
+  s.w[1] = 0.75 - (d - 1.0) * (d - 1.0);
+  s.w[2] = 0.5 * (d - 0.5) * (d - 0.5);
+  return s;
+}
+void scalar_g2p(const float *vel, const Stencil s[3], double v[3], double C[9]) {
+  for (int d = 0; d < 3; ++d) v[d] = 0.;
+  for (int d = 0; d < 9; ++d) C[d] = 0.;
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      for (int k = 0; k < 3; ++k) {
+        double W = s[0].w[i] * s[1].w[j] * s[2].w[k];
+        double xi[3] = {i * dx - s[0].local, j * dx - s[1].local, k * dx - s[2].local};
+        int cell = ((s[0].base + i) * A + s[1].base + j) * A + s[2].base + k;
+        for (int r = 0; r < 3; ++r) {
+          double Wv = W * vel[r * V + cell];
+          v[r] += Wv;
+          for (int col = 0; col < 3; ++col) C[col * 3 + r] += Wv * xi[col];
+        }
+      }
+}
+void scalar_p2g(float *arena, const Stencil s[3], double mass, const double v[3], const double contrib[9]) {
+  for (int i = 0; i < 3; ++i)
+    for (int j = 0; j < 3; ++j)
+      for (int k = 0; k < 3; ++k) {
+        double W = s[0].w[i] * s[1].w[j] * s[2].w[k];
+        double xi[3] = {i * dx - s[0].local, j * dx - s[1].local, k * dx - s[2].local};
+        int cell = ((s[0].base + i) * A + s[1].base + j) * A + s[2].base + k;
+        arena[cell] += (float)(W * mass);
+        for (int r = 0; r < 3; ++r)
+          arena[(1 + r) * V + cell] += (float)(W * (mass * v[r] + contrib[r] * xi[0] + contrib[3 + r] * xi[1] + contrib[6 + r] * xi[2]));
+      }
+}
+} // namespace
+
+int main(int argc, char **argv) {
+  const bool quick = mn_bench::quick(argc, argv);
+  const std::size_t n = quick ? (1u << 12) : (1u << 21); //< Multiple of the 8 lanes
+  const int reps = quick ? 1 : 5;
+  fmt::print("bench_transfer_simd: [{}] particles, ISA [{}], {} lanes\n", n, simd::isa, L);
+
+  // Particles anywhere in cells [1.5, 5.5) of the arena, so every stencil stays inside it
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> pos(1.5 * dx, 5.5 * dx), unit(-1., 1.);
+  Particles p;
+  for (int d = 0; d < 3; ++d) p.x[d].resize(n), p.v[d].resize(n);
+  for (int d = 0; d < 9; ++d) p.c[d].resize(n);
+  p.mass.resize(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    for (int d = 0; d < 3; ++d) p.x[d][i] = pos(rng), p.v[d][i] = unit(rng);
+    for (int d = 0; d < 9; ++d) p.c[d][i] = unit(rng);
+    p.mass[i] = 1e-3 * (1.5 + unit(rng));
+  }
+  std::vector<float> vel(3 * V);
+  for (auto &f : vel) f = (float)unit(rng);
+
+  // Reference check on the first batches: weights, gathered velocity and C, scattered arena
+  {
+    const std::size_t check = std::min<std::size_t>(n, 1024);
+    double max_v = 0., max_arena = 0.;
+    std::vector<float> ref_arena(4 * V, 0.f), arena(4 * V, 0.f), lane_arena(4 * V * L, 0.f);
+    const double origin[3] = {0., 0., 0.};
+    for (std::size_t b = 0; b < check; b += L) {
+      simd::stencil_1d s[3];
+      for (int d = 0; d < 3; ++d) s[d] = simd::bspline_weights(simd::load(&p.x[d][b]), dx, dx_inv);
+      simd::pd v[3], C[9], contrib[9], vin[3];
+      simd::g2p_gather(vel.data(), simd::arena_corner(s, origin), s, dx, v, C);
+      for (int d = 0; d < 9; ++d) contrib[d] = simd::load(&p.c[d][b]);
+      for (int d = 0; d < 3; ++d) vin[d] = simd::load(&p.v[d][b]);
+      simd::p2g_scatter(lane_arena.data(), simd::arena_corner(s, origin), s, dx, simd::load(&p.mass[b]), vin, contrib);
+      alignas(64) double out[12][L];
+      for (int d = 0; d < 3; ++d) simd::store(out[d], v[d]);
+      for (int d = 0; d < 9; ++d) simd::store(out[3 + d], C[d]);
+      for (int l = 0; l < L; ++l) {
+        Stencil r[3];
+        for (int d = 0; d < 3; ++d) r[d] = scalar_weights(p.x[d][b + l]);
+        double rv[3], rC[9], pv[3] = {p.v[0][b + l], p.v[1][b + l], p.v[2][b + l]}, pc[9];
+        for (int d = 0; d < 9; ++d) pc[d] = p.c[d][b + l];
+        scalar_g2p(vel.data(), r, rv, rC);
+        scalar_p2g(ref_arena.data(), r, p.mass[b + l], pv, pc);
+        for (int d = 0; d < 3; ++d) max_v = std::max(max_v, std::abs(out[d][l] - rv[d]));
+        for (int d = 0; d < 9; ++d) max_v = std::max(max_v, std::abs(out[3 + d][l] - rC[d]));
+      }
+    }
+    simd::reduce_lanes(lane_arena.data(), arena.data(), 4);
+    for (int c = 0; c < 4 * V; ++c) max_arena = std::max(max_arena, (double)std::abs(arena[c] - ref_arena[c]));
+    MN_BENCH_CHECK(max_v < 1e-12, "G2P differs from the scalar reference by {}\n", max_v);
+    MN_BENCH_CHECK(max_arena < 1e-4, "P2G arena differs from the scalar reference by {}\n", max_arena);
+    fmt::print("  reference check over [{}] particles: G2P max |diff| {:.3g}, P2G arena max |diff| {:.3g}\n", check, max_v, max_arena);
+  }
+
+  volatile double sink = 0.;
+  std::vector<float> arena(4 * V, 0.f), lane_arena(4 * V * L, 0.f);
+  const double origin[3] = {0., 0., 0.};
+  double scalar_ms = 0., batched_ms = 0.;
+
+  fmt::print("Scalar, one particle at a time:\n");
+  mn_bench::report("weights", n, mn_bench::best_ms(reps, [&]() {
+    double acc = 0.;
+    for (std::size_t i = 0; i < n; ++i)
+      for (int d = 0; d < 3; ++d) acc += scalar_weights(p.x[d][i]).w[1];
+    sink = sink + acc;
+  }));
+  mn_bench::report("weights + G2P + P2G", n, scalar_ms = mn_bench::best_ms(reps, [&]() {
+    double acc = 0.;
+    for (std::size_t i = 0; i < n; ++i) {
+      Stencil s[3];
+      for (int d = 0; d < 3; ++d) s[d] = scalar_weights(p.x[d][i]);
+      double v[3], C[9], pc[9];
+      scalar_g2p(vel.data(), s, v, C);
+      for (int d = 0; d < 9; ++d) pc[d] = p.c[d][i];
+      scalar_p2g(arena.data(), s, p.mass[i], v, pc);
+      acc += v[0];
+    }
+    sink = sink + acc;
+  }));
+
+  fmt::print("Batched, [{}] particles per call:\n", L);
+  mn_bench::report("bspline_weights", n, mn_bench::best_ms(reps, [&]() {
+    simd::pd acc = simd::set1(0.);
+    for (std::size_t b = 0; b < n; b += L)
+      for (int d = 0; d < 3; ++d) acc = acc + simd::bspline_weights(simd::load(&p.x[d][b]), dx, dx_inv).w[1];
+    alignas(64) double out[L];
+    simd::store(out, acc);
+    sink = sink + out[0];
+  }));
+  mn_bench::report("bspline_weights_at (clamped stencil)", n, mn_bench::best_ms(reps, [&]() {
+    simd::pd acc = simd::set1(0.);
+    for (std::size_t b = 0; b < n; b += L)
+      for (int d = 0; d < 3; ++d) {
+        simd::stencil_1d s;
+        s.base = simd::set1(2.);
+        s.local = simd::load(&p.x[d][b]) - s.base * simd::set1(dx);
+        simd::bspline_weights_at(s, dx_inv);
+        acc = acc + s.w[1];
+      }
+    alignas(64) double out[L];
+    simd::store(out, acc);
+    sink = sink + out[0];
+  }));
+  mn_bench::report("weights + g2p_gather", n, mn_bench::best_ms(reps, [&]() {
+    simd::pd acc = simd::set1(0.);
+    for (std::size_t b = 0; b < n; b += L) {
+      simd::stencil_1d s[3];
+      for (int d = 0; d < 3; ++d) s[d] = simd::bspline_weights(simd::load(&p.x[d][b]), dx, dx_inv);
+      simd::pd v[3], C[9];
+      simd::g2p_gather(vel.data(), simd::arena_corner(s, origin), s, dx, v, C);
+      acc = acc + v[0] + C[4];
+    }
+    alignas(64) double out[L];
+    simd::store(out, acc);
+    sink = sink + out[0];
+  }));
+  mn_bench::report("weights + g2p_gather + p2g_scatter", n, batched_ms = mn_bench::best_ms(reps, [&]() {
+    for (std::size_t b = 0; b < n; b += L) {
+      simd::stencil_1d s[3];
+      for (int d = 0; d < 3; ++d) s[d] = simd::bspline_weights(simd::load(&p.x[d][b]), dx, dx_inv);
+      simd::pi corner = simd::arena_corner(s, origin);
+      simd::pd v[3], C[9], contrib[9];
+      simd::g2p_gather(vel.data(), corner, s, dx, v, C);
+      for (int d = 0; d < 9; ++d) contrib[d] = simd::load(&p.c[d][b]);
+      simd::p2g_scatter(lane_arena.data(), corner, s, dx, simd::load(&p.mass[b]), v, contrib);
+      if ((b / L) % 4 == 3) simd::reduce_lanes(lane_arena.data(), arena.data(), 4); //< One particle block of 32 slots
+    }
+    simd::reduce_lanes(lane_arena.data(), arena.data(), 4);
+  }));
+  sink = sink + arena[0];
+  fmt::print("  batched / scalar speedup of weights + G2P + P2G: {:.2f}x{}\n", scalar_ms / batched_ms,
+             simd::batched ? "" : " (scalar lanes, cpu_benchmark runs the per-particle loop)");
+  return mn_bench::result("bench_transfer_simd");
+}
@@ -0,0 +1,72 @@
+#ifndef __BODY_PIPELINE_H_
+#define __BODY_PIPELINE_H_
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace mn {
+
+/// @brief Orders concurrent host initialization of scene bodies.
+/// Bodies are parsed and sampled on worker threads, taken in scene order.
+/// Two bodies on the same GPU and model append to one particle vector, so the later waits for the earlier before sampling.
+/// initModel appends particle buffers per GPU, so a body uploads only after earlier bodies on its GPU finished.
+/// Bodies on other GPUs or models never wait on each other.
+struct BodyPipeline {
+  explicit BodyPipeline(int num_bodies)
+      : gpu(num_bodies, unknown), model(num_bodies, unknown), done(num_bodies, 0) {}
+
+  /// @brief Finishes a body on every exit path (skipped, sampled, uploaded or thrown).
+  struct Ticket {
+    BodyPipeline &pipeline;
+    int body;
+    ~Ticket() { pipeline.finish(body); }
+  };
+
+  /// @brief Record target of body b once its GPU and model IDs are valid. Unassigned bodies hold back later ones until finished.
+  void assign(int b, int gpu_id, int model_id) {
+    {
+      std::lock_guard<std::mutex> lk{mut};
+      gpu[b] = gpu_id, model[b] = model_id;
+    }
+    cv.notify_all();
+  }
+
+  /// @brief Block until every earlier body on the same GPU and model has finished.
+  void wait_for_model(int b) {
+    wait(b, [&](int e) { return gpu[e] != gpu[b] || model[e] != model[b]; });
+  }
+
+  /// @brief Block until every earlier body on the same GPU has finished, i.e. its upload turn.
+  void wait_for_device(int b) {
+    wait(b, [&](int e) { return gpu[e] != gpu[b]; });
+  }
+
+  void finish(int b) {
+    {
+      std::lock_guard<std::mutex> lk{mut};
+      done[b] = 1;
+    }
+    cv.notify_all();
+  }
+
+private:
+  static constexpr int unknown = -2;
+  std::mutex mut;
+  std::condition_variable cv;
+  std::vector<int> gpu, model;
+  std::vector<char> done;
+
+  template <typename F>
+  void wait(int b, F &&independent) {
+    std::unique_lock<std::mutex> lk{mut};
+    cv.wait(lk, [&]() {
+      for (int e = 0; e < b; ++e)
+        if (!done[e] && (gpu[e] == unknown || !independent(e))) return false;
+      return true;
+    });
+  }
+};
+
+} // namespace mn
+
+#endif
@@ -0,0 +1,211 @@
+#ifndef __BUFFER_LAYOUTS_H_
+#define __BUFFER_LAYOUTS_H_
+#include "settings.cuh"
+#include <MnBase/Object/Structural.h>
+#include <type_traits>
+
+/// Structural layouts of the device buffers (grid-blocks, particle bins, halos, partitions). Host-compilable, so
+/// memory_planner.h sizes them without CUDA. Buffers themselves live in grid_buffer.cuh, particle_buffer.cuh, etc.
+namespace mn {
+
+using BlockDomain = compact_domain<char, config::g_blocksize,
+                                   config::g_blocksize, config::g_blocksize>;
+using GridDomain = compact_domain<int, config::g_grid_size_x, config::g_grid_size_y,
+                                  config::g_grid_size_z>;
+
+#if (DEBUG_COUPLED_UP)
+using grid_block_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         structural_padding_policy::sum_pow2_align>,
+               BlockDomain, attrib_layout::soa, fg_, fg_, fg_, fg_,
+               fg_, fg_, fg_, fg_, fg_, fg_, fg_>; //< mass, vel + dt*fint, 
+                                              //< vel, 
+                                              //< Vol, J
+                                              //< mass_water, pressure_water
+#else
+using grid_block_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         structural_padding_policy::sum_pow2_align>,
+               BlockDomain, attrib_layout::soa, fg_, fg_, fg_, fg_,
+               fg_, fg_, fg_, fg_, fg_>; //< mass, vel + dt*fint, 
+                                              //< vel, 
+                                              //< Vol, J
+#endif
+
+using ParticleBinDomain = aligned_domain<char, config::g_bin_capacity>;
+using ParticleBufferDomain = compact_domain<int, config::g_max_particle_bin>;
+using ParticleArrayDomain = compact_domain<int, config::g_max_particle_num>;
+using ParticleArrayHalfDomain = compact_domain<int, config::g_max_particle_num / 2>;
+using ParticleArrayEigthDomain = compact_domain<int, config::g_max_particle_num / 8>;
+using ParticleTargetDomain = compact_domain<int, config::g_max_particle_target_nodes>;
+
+/// Position attributes of particle bins, PREC or fixed-point (config::g_particle_fixed_point, EXPERIMENTAL: not yet built with nvcc)
+using pos_ = std::conditional_t<config::g_particle_fixed_point,
+                                structural_entity<config::particle_pos_fixed_t>, f_>;
+/// Fixed-point bins are compact, pow2 padding would take the saved bytes back
+constexpr structural_padding_policy particle_bin_padding =
+    config::g_particle_fixed_point ? structural_padding_policy::compact
+                                   : structural_padding_policy::sum_pow2_align;
+
+using particle_bin4_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_,
+               f_>; ///< pos, J
+using particle_bin6_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_,
+               f_, f_, f_>; ///< pos, J, JBar, ID
+using particle_bin7_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_,
+               f_, f_, f_, f_>; ///< pos, J / ID, vel
+using particle_bin9_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, f_, 
+               f_, f_, f_, 
+               f_, f_>; ///< pos, J, vel, vol JBar
+using particle_bin11_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_,
+               f_, f_, f_, f_, f_,
+               f_, f_, f_>; ///< pos, ID, forces, restVolume, normals
+using particle_bin12_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, 
+               f_, f_, f_, f_, f_, f_, f_, f_, f_>; ///< pos, F
+using particle_bin13_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, f_,
+               f_, f_, f_, f_, f_, f_, f_, f_,
+               f_>; ///< pos, F, logJp
+using particle_bin14_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, f_,
+               f_, f_, f_, f_, f_, f_, f_, f_,
+               f_, f_>; ///< pos, F, logJp, vel               
+using particle_bin15_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, f_,
+               f_, f_, f_, f_, f_, f_, f_, f_, 
+               f_, f_, f_>; ///< pos, F, vel
+using particle_bin16_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, f_,
+               f_, f_, f_, f_, f_, f_, f_, f_, 
+               f_, f_, f_, f_>; ///< pos, F, logJp, vel
+using particle_bin17_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, 
+               f_, f_, f_, f_, f_, f_, f_, f_, f_, 
+               f_, f_, f_,
+               f_, 
+               f_>; ///< pos, F, vel, J_Bar, ID
+using particle_bin18_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, 
+               f_, f_, f_, f_, f_, f_, f_, f_, f_, 
+               f_, f_, f_,
+               f_, f_,
+               f_>; ///< pos, F, vel, vol_Bar, J_Bar, ID
+using particle_bin19_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, 
+               f_, f_, f_, f_, f_, f_, f_, f_, f_, 
+               f_, f_, f_,
+               f_, f_,
+               f_,
+               f_>; ///< pos, F, vel, vol_Bar, J_Bar, etc, ID
+using particle_bin20_f_ =
+    structural<structural_type::dense,
+               decorator<structural_allocation_policy::full_allocation,
+                         particle_bin_padding>,
+               ParticleBinDomain, attrib_layout::soa, pos_, pos_, pos_, 
+               f_, f_, f_, f_, f_, f_, f_, f_, f_, 
+               f_, f_, f_,
+               f_, f_,
+               f_, f_,
+               f_>; ///< pos, F, vel, vol_Bar, J_Bar, mass_water, rho_water, ID
+
+template <material_e mt> struct particle_bin_;
+template <> struct particle_bin_<material_e::JFluid> : particle_bin4_f_ {}; // No ID
+template <> struct particle_bin_<material_e::JFluid_ASFLIP> : particle_bin7_f_ {}; // No ID
+template <> struct particle_bin_<material_e::JFluid_FBAR> : particle_bin6_f_ {};
+template <> struct particle_bin_<material_e::JBarFluid> : particle_bin9_f_ {};
+template <> struct particle_bin_<material_e::FixedCorotated> : particle_bin13_f_ {};
+template <> struct particle_bin_<material_e::FixedCorotated_ASFLIP> : particle_bin16_f_ {};
+template <> struct particle_bin_<material_e::FixedCorotated_FBAR> : particle_bin14_f_ {};
+template <> struct particle_bin_<material_e::FixedCorotated_ASFLIP_FBAR> : particle_bin17_f_ {};
+template <> struct particle_bin_<material_e::NeoHookean> : particle_bin13_f_ {};
+template <> struct particle_bin_<material_e::NeoHookean_ASFLIP> : particle_bin16_f_ {};
+template <> struct particle_bin_<material_e::NeoHookean_FBAR> : particle_bin14_f_ {};
+template <> struct particle_bin_<material_e::NeoHookean_ASFLIP_FBAR> : particle_bin17_f_ {};
+template <> struct particle_bin_<material_e::Sand> : particle_bin14_f_ {};
+template <> struct particle_bin_<material_e::Sand_ASFLIP> : particle_bin17_f_ {};
+template <> struct particle_bin_<material_e::Sand_FBAR> : particle_bin15_f_ {};
+template <> struct particle_bin_<material_e::Sand_ASFLIP_FBAR> : particle_bin18_f_ {};
+template <> struct particle_bin_<material_e::NACC> : particle_bin14_f_ {};
+template <> struct particle_bin_<material_e::NACC_ASFLIP> : particle_bin17_f_ {};
+template <> struct particle_bin_<material_e::NACC_FBAR> : particle_bin15_f_ {};
+template <> struct particle_bin_<material_e::NACC_ASFLIP_FBAR> : particle_bin18_f_ {};
+template <> struct particle_bin_<material_e::CoupledUP> : particle_bin20_f_ {}; //< Changed to bin20 (JB)
+template <> struct particle_bin_<material_e::Meshed> : particle_bin11_f_ {};
+template <> struct particle_bin_<material_e::VonMises> : particle_bin13_f_ {};
+
+template <typename ParticleBin>
+using particle_buffer_ =
+    structural<structural_type::dynamic,
+               decorator<structural_allocation_policy::full_allocation,
+                         structural_padding_policy::compact>,
+               ParticleBufferDomain, attrib_layout::aos, ParticleBin>;
+
+using particle_array_ =
+    structural<structural_type::dynamic,
+               decorator<structural_allocation_policy::full_allocation,
+                         structural_padding_policy::compact>,
+               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_>;
+
+using HaloGridBlocksDomain = compact_domain<int, config::g_max_halo_block>;
+using halo_grid_blocks_ =
+    structural<structural_type::dynamic,
+               decorator<structural_allocation_policy::full_allocation,
+                         structural_padding_policy::sum_pow2_align>,
+               HaloGridBlocksDomain, attrib_layout::soa, grid_block_>;
+
+// Basic data-structure for Partitions
+using block_partition_ =
+    structural<structural_type::hash,
+               decorator<structural_allocation_policy::full_allocation,
+                         structural_padding_policy::compact>,
+               GridDomain, attrib_layout::aos, empty_>;
+
+} // namespace mn
+
+#endif
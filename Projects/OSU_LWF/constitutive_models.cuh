@@ -1,6 +1,11 @@
 #ifndef __CONSTITUTIVE_MODELS_CUH_
 #define __CONSTITUTIVE_MODELS_CUH_
+#include <MnBase/Meta/HostDevice.h>
+#if defined(__CUDACC__)
 #include <MnBase/Math/Matrix/svd.cuh>
+#else
+#include <MnBase/Math/Matrix/svd_host.h> //< Host math::svd and rcbrt, so models also build for the CPU backend
+#endif
 #include <MnBase/Math/Matrix/MatrixUtils.h>
 #include <MnBase/Math/Vec.cuh>
 #include "settings.cuh"
@@ -15,7 +20,7 @@ namespace mn {
 // Here we throttle stress to disallow transgression of the yield circle using the tensile_yield_strength as user-input.
 // Because stress is throttle, the forces produced aren't able to resist all deformation so we get plasticity. 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_vonmises(T volume, T mu, T lambda, T tensile_yield_strength, const vec<T, 9> &F,
                             vec<T, 9> &PF) {
 
@@ -82,7 +87,7 @@ compute_stress_vonmises(T volume, T mu, T lambda, T tensile_yield_strength, cons
 
 // TODO: This is for FixedCorotated, not VonMises
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_PK1_vonmises(T volume, T mu, T lambda, const vec<T, 9> &F,
                               vec<T, 9> &P) {
   T U[9], S[3], V[9];
@@ -119,7 +124,7 @@ compute_stress_PK1_vonmises(T volume, T mu, T lambda, const vec<T, 9> &F,
 
 // TODO: This is for FixedCorotated, not VonMises
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_energy_vonmises(T volume, T mu, T lambda, const vec<T, 9> &F,
                               T &strain_energy) {
   T U[9], S[3], V[9];
@@ -177,20 +182,20 @@ compute_energy_vonmises(T volume, T mu, T lambda, const vec<T, 9> &F,
 /// * J-Fluid - Pressure, Stress, and Energy
 /// * Isotropic Tait-Murnaghan fluid, uses the deformation gradient determinant J
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_pressure_jfluid(T volume, T bulk, T bulk_wrt_pressure, T sJ, T &pressure)
 {
   //pressure =  (bulk / bulk_wrt_pressure) * (  pow(J, -bulk_wrt_pressure) - 1.0 );
   pressure = (bulk / bulk_wrt_pressure) * expm1(-bulk_wrt_pressure*log1p(-sJ));
 }
 template <>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_pressure_jfluid(float volume, float bulk, float bulk_wrt_pressure, float J, float &pressure)
 {
   pressure =  (bulk / bulk_wrt_pressure) * (  powf(J, -bulk_wrt_pressure) - 1.f );
 }
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_jfluid(T volume, T bulk, T bulk_wrt_pressure, T Dp_inv, T viscosity, T J, const vec<T, 9> &C, vec<T, 9> &PF)
 {
   T pressure =  (bulk / bulk_wrt_pressure) * (  pow(J, -bulk_wrt_pressure) - 1.0 );
@@ -208,7 +213,7 @@ compute_stress_jfluid(T volume, T bulk, T bulk_wrt_pressure, T Dp_inv, T viscosi
 }
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_jfluid(T volume, T bulk, T bulk_wrt_pressure, T Dp_inv, T viscosity, T J, const vec<T, 9> &C, vec<T, 6> &PF)
 {
   // Use symmetry of Cauchy stress to reduce size.
@@ -230,7 +235,7 @@ compute_stress_jfluid(T volume, T bulk, T bulk_wrt_pressure, T Dp_inv, T viscosi
 }
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_energy_jfluid( T volume, T bulk, T bulk_wrt_pressure, T J, T& strain_energy)
 {
   // Based on Pradhana 2017 Multi-Species MPM paper. Modified pressure constant term for gamma
@@ -252,7 +257,7 @@ compute_energy_jfluid( T volume, T bulk, T bulk_wrt_pressure, T J, T& strain_ene
 }
 
 template <>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_energy_jfluid(float volume, float bulk, float bulk_wrt_pressure, float J, float& strain_energy)
 {
   float one_minus_bwp = 1.f - bulk_wrt_pressure;
@@ -265,7 +270,7 @@ compute_energy_jfluid(float volume, float bulk, float bulk_wrt_pressure, float J
 /// * Hyperelastic solid model. Similar to NeoHookean, popular in graphics.
 /// TODO : Force derivative
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_fixedcorotated(T volume, T mu, T lambda, const vec<T, 9> &F,
                               vec<T, 9> &PF) {
   T U[9], S[3], V[9];
@@ -313,7 +318,7 @@ compute_stress_fixedcorotated(T volume, T mu, T lambda, const vec<T, 9> &F,
 }
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_PK1_fixedcorotated(T volume, T mu, T lambda, const vec<T, 9> &F,
                               vec<T, 9> &P) {
   T U[9], S[3], V[9];
@@ -349,7 +354,7 @@ compute_stress_PK1_fixedcorotated(T volume, T mu, T lambda, const vec<T, 9> &F,
 }
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_energy_fixedcorotated(T volume, T mu, T lambda, const vec<T, 9> &F,
                               T &strain_energy) {
   T U[9], S[3], V[9];
@@ -363,7 +368,7 @@ compute_energy_fixedcorotated(T volume, T mu, T lambda, const vec<T, 9> &F,
                         (S[2] - 1.0)*(S[2] - 1.0)) + 0.5 * lambda*(J - 1.0)*(J - 1.0)) * volume;
 }
 template <>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_energy_fixedcorotated(float volume, float mu, float lambda, const vec<float, 9> &F,
                               float &strain_energy) {
   float U[9], S[3], V[9];
@@ -381,7 +386,7 @@ compute_energy_fixedcorotated(float volume, float mu, float lambda, const vec<fl
 /// * Neo-Hookean - Stress and Energy
 /// * Hyperelastic model for solids. Abaqus uses a slighly different formulation.
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_neohookean(T volume, T mu, T lambda, const vec<T, 9> &F,
                              vec<T, 9> &PF)
 {
@@ -419,7 +424,7 @@ compute_stress_neohookean(T volume, T mu, T lambda, const vec<T, 9> &F,
 }
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_PK1_neohookean(T volume, T mu, T lambda, const vec<T, 9> &F,
                              vec<T, 9> &P)
 {
@@ -443,7 +448,7 @@ compute_stress_PK1_neohookean(T volume, T mu, T lambda, const vec<T, 9> &F,
 }
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_energy_neohookean(T volume, T mu, T lambda, const vec<T, 9> &F,
                              T &strain_energy)
 {
@@ -463,7 +468,7 @@ compute_energy_neohookean(T volume, T mu, T lambda, const vec<T, 9> &F,
 /// Drucker-Prager - Stress and Energy
 /// Granular materials.
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_energy_sand(T volume, T mu, T lambda, T cohesion, T beta,
                     T yieldSurface, bool volCorrection, T logJp, vec<T, 9> &F, T &strain_energy) {
   T U[9], S[3], V[9];
@@ -476,7 +481,7 @@ compute_energy_sand(T volume, T mu, T lambda, T cohesion, T beta,
 
   T epsilon[3]; ///< logarithmic strain
   // 'Cohesion' uses a strange definition to account for wet sand tensile effects
-#pragma unroll 3
+MN_UNROLL(3)
   for (int i = 0; i < 3; i++) 
   {
     T abs_S = S[i] > 0 ? S[i] : -S[i];
@@ -493,7 +498,7 @@ compute_energy_sand(T volume, T mu, T lambda, T cohesion, T beta,
 
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_sand(T volume, T mu, T lambda, T cohesion, T beta,
                     T yieldSurface, bool volCorrection, T &logJp, vec<T, 9> &F,
                     vec<T, 9> &PF) {
@@ -507,7 +512,7 @@ compute_stress_sand(T volume, T mu, T lambda, T cohesion, T beta,
   T New_F[9];
 
   constexpr T small = 1e-9;
-#pragma unroll 3
+MN_UNROLL(3)
   for (int i = 0; i < 3; i++) {
     T abs_S = S[i] > 0 ? S[i] : -S[i];
     abs_S = abs_S > small ? abs_S : small;
@@ -517,7 +522,7 @@ compute_stress_sand(T volume, T mu, T lambda, T cohesion, T beta,
   T trace_epsilon = sum_epsilon + logJp;
 
   T epsilon_hat[3];
-#pragma unroll 3
+MN_UNROLL(3)
   for (int i = 0; i < 3; i++)
     epsilon_hat[i] = epsilon[i] - (trace_epsilon / (T)3);
 
@@ -530,7 +535,7 @@ compute_stress_sand(T volume, T mu, T lambda, T cohesion, T beta,
     New_S[0] = New_S[1] = New_S[2] = exp(cohesion);
     matmul_mat_diag_matT_3D(New_F, U, New_S, V); // new F_e
                                                  /* Update F */
-#pragma unroll 9
+MN_UNROLL(9)
     for (int i = 0; i < 9; i++)
       F[i] = New_F[i];
     if (volCorrection) {
@@ -542,21 +547,21 @@ compute_stress_sand(T volume, T mu, T lambda, T cohesion, T beta,
                                            trace_epsilon * yieldSurface;
     T H[3];
     if (delta_gamma <= 0) { ///< case I: inside the yield surface cone
-#pragma unroll 3
+MN_UNROLL(3)
       for (int i = 0; i < 3; i++)
         H[i] = epsilon[i] + cohesion;
     } else { ///< case III: project to the cone surface
-#pragma unroll 3
+MN_UNROLL(3)
       for (int i = 0; i < 3; i++)
         H[i] = epsilon[i] - (delta_gamma / epsilon_hat_norm) * epsilon_hat[i] +
                cohesion;
     }
-#pragma unroll 3
+MN_UNROLL(3)
     for (int i = 0; i < 3; i++)
       New_S[i] = exp(H[i]);
     matmul_mat_diag_matT_3D(New_F, U, New_S, V); // new F_e
                                                  /* Update F */
-#pragma unroll 9
+MN_UNROLL(9)
     for (int i = 0; i < 9; i++)
       F[i] = New_F[i];
   }
@@ -569,7 +574,7 @@ compute_stress_sand(T volume, T mu, T lambda, T cohesion, T beta,
   // T S_inverse[3] = {1.f / New_S[0], 1.f / New_S[1], 1.f / New_S[2]}; // TO
   // CHECK
   T trace_log_S = New_S_log[0] + New_S_log[1] + New_S_log[2];
-#pragma unroll 3
+MN_UNROLL(3)
   for (int i = 0; i < 3; i++)
     P_hat[i] = (scaled_mu * New_S_log[i] + lambda * trace_log_S) / New_S[i];
 
@@ -592,7 +597,7 @@ compute_stress_sand(T volume, T mu, T lambda, T cohesion, T beta,
 /// U-P, Drucker-Prager - Stress and Energy (JLM)
 /// Granular materials.
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_energy_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
                     T yieldSurface, bool volCorrection, T logJp, vec<T, 9> &F, T &strain_energy) {
   T U[9], S[3], V[9];
@@ -605,7 +610,7 @@ compute_energy_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
 
   T epsilon[3]; ///< logarithmic strain
   // 'Cohesion' uses a strange definition to account for wet sand tensile effects
-#pragma unroll 3
+MN_UNROLL(3)
   for (int i = 0; i < 3; i++) 
   {
     T abs_S = S[i] > 0 ? S[i] : -S[i];
@@ -621,7 +626,7 @@ compute_energy_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
 
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
                     T yieldSurface, bool volCorrection, T &logJp, T &pw, 
                     vec<T, 9> &F, vec<T, 9> &PF) {
@@ -634,7 +639,7 @@ compute_stress_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
   T epsilon[3], New_S[3]; ///< helper
   T New_F[9];
 
-#pragma unroll 3
+MN_UNROLL(3)
   for (int i = 0; i < 3; i++) {
     T abs_S = S[i] > 0 ? S[i] : -S[i];
     abs_S = abs_S > 1e-4 ? abs_S : 1e-4;
@@ -644,7 +649,7 @@ compute_stress_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
   T trace_epsilon = sum_epsilon + logJp;
 
   T epsilon_hat[3];
-#pragma unroll 3
+MN_UNROLL(3)
   for (int i = 0; i < 3; i++)
     epsilon_hat[i] = epsilon[i] - (trace_epsilon / (T)3);
 
@@ -657,7 +662,7 @@ compute_stress_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
     New_S[0] = New_S[1] = New_S[2] = exp(cohesion);
     matmul_mat_diag_matT_3D(New_F, U, New_S, V); // new F_e
                                                  /* Update F */
-#pragma unroll 9
+MN_UNROLL(9)
     for (int i = 0; i < 9; i++)
       F[i] = New_F[i];
     if (volCorrection) {
@@ -669,21 +674,21 @@ compute_stress_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
                                            trace_epsilon * yieldSurface;
     T H[3];
     if (delta_gamma <= 0) { ///< case I: inside the yield surface cone
-#pragma unroll 3
+MN_UNROLL(3)
       for (int i = 0; i < 3; i++)
         H[i] = epsilon[i] + cohesion;
     } else { ///< case III: project to the cone surface
-#pragma unroll 3
+MN_UNROLL(3)
       for (int i = 0; i < 3; i++)
         H[i] = epsilon[i] - (delta_gamma / epsilon_hat_norm) * epsilon_hat[i] +
                cohesion;
     }
-#pragma unroll 3
+MN_UNROLL(3)
     for (int i = 0; i < 3; i++)
       New_S[i] = exp(H[i]);
     matmul_mat_diag_matT_3D(New_F, U, New_S, V); // new F_e
                                                  /* Update F */
-#pragma unroll 9
+MN_UNROLL(9)
     for (int i = 0; i < 9; i++)
       F[i] = New_F[i];
   }
@@ -696,7 +701,7 @@ compute_stress_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
   // T S_inverse[3] = {1.f / New_S[0], 1.f / New_S[1], 1.f / New_S[2]}; // TO
   // CHECK
   T trace_log_S = New_S_log[0] + New_S_log[1] + New_S_log[2];
-#pragma unroll 3
+MN_UNROLL(3)
   for (int i = 0; i < 3; i++)
     P_hat[i] = (scaled_mu * New_S_log[i] + lambda * trace_log_S) / New_S[i];
 
@@ -717,7 +722,7 @@ compute_stress_CoupledUP(T volume, T mu, T lambda, T cohesion, T beta,
 /// * Non-Associative Cam-Clay - Stress and Energy
 /// * Elasto-plastic model. Good for snow, clay, concrete, etc.
 template <typename T = float>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_nacc(T volume, T mu, T lambda, T bm, T xi, T beta, T Msqr,
                     bool hardeningOn, T &logJp, vec<T, 9> &F, vec<T, 9> &PF) {
   T U[9], S[3], V[9];
@@ -757,7 +762,7 @@ compute_stress_nacc(T volume, T mu, T lambda, T bm, T xi, T beta, T Msqr,
     S[0] = S[1] = S[2] = powf(Je_new, 1.f / 3.f);
     T New_F[9];
     matmul_mat_diag_matT_3D(New_F, U, S, V);
-#pragma unroll 9
+MN_UNROLL(9)
     for (int i = 0; i < 9; i++)
       F[i] = New_F[i];
     if (hardeningOn)
@@ -770,7 +775,7 @@ compute_stress_nacc(T volume, T mu, T lambda, T bm, T xi, T beta, T Msqr,
     S[0] = S[1] = S[2] = powf(Je_new, 1.f / 3.f);
     T New_F[9];
     matmul_mat_diag_matT_3D(New_F, U, S, V);
-#pragma unroll 9
+MN_UNROLL(9)
     for (int i = 0; i < 9; i++)
       F[i] = New_F[i];
     if (hardeningOn)
@@ -785,12 +790,12 @@ compute_stress_nacc(T volume, T mu, T lambda, T bm, T xi, T beta, T Msqr,
       T B_s_coeff = powf(Je_trial, 2.f / 3.f) / mu *
                     sqrtf(-y_p_half / y_s_half_coeff) /
                     sqrtf(s_hat_trial_sqrnorm);
-#pragma unroll 3
+MN_UNROLL(3)
       for (int i = 0; i < 3; i++)
         S[i] = sqrt(s_hat_trial[i] * B_s_coeff + trace_B_hat_trial_divdim);
       T New_F[9];
       matmul_mat_diag_matT_3D(New_F, U, S, V);
-#pragma unroll 9
+MN_UNROLL(9)
       for (int i = 0; i < 9; i++)
         F[i] = New_F[i];
 
@@ -859,7 +864,7 @@ compute_stress_nacc(T volume, T mu, T lambda, T bm, T xi, T beta, T Msqr,
 }
 
 template <>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_stress_nacc(double volume, double mu, double lambda, double bm, double xi, double beta, double Msqr,
                     bool hardeningOn, double &logJp, vec<double, 9> &F, vec<double, 9> &PF) {
   using T = double;
@@ -900,7 +905,7 @@ compute_stress_nacc(double volume, double mu, double lambda, double bm, double x
     S[0] = S[1] = S[2] = cbrt(Je_new);
     T New_F[9];
     matmul_mat_diag_matT_3D(New_F, U, S, V);
-#pragma unroll 9
+MN_UNROLL(9)
     for (int i = 0; i < 9; i++)
       F[i] = New_F[i];
     if (hardeningOn)
@@ -913,7 +918,7 @@ compute_stress_nacc(double volume, double mu, double lambda, double bm, double x
     S[0] = S[1] = S[2] = cbrt(Je_new);
     T New_F[9];
     matmul_mat_diag_matT_3D(New_F, U, S, V);
-#pragma unroll 9
+MN_UNROLL(9)
     for (int i = 0; i < 9; i++)
       F[i] = New_F[i];
     if (hardeningOn)
@@ -928,12 +933,12 @@ compute_stress_nacc(double volume, double mu, double lambda, double bm, double x
       T B_s_coeff = cbrt(Je_trial*Je_trial) / mu *
                     sqrt(-y_p_half / y_s_half_coeff) /
                     sqrt(s_hat_trial_sqrnorm);
-#pragma unroll 3
+MN_UNROLL(3)
       for (int i = 0; i < 3; i++)
         S[i] = sqrt(s_hat_trial[i] * B_s_coeff + trace_B_hat_trial_divdim);
       T New_F[9];
       matmul_mat_diag_matT_3D(New_F, U, S, V);
-#pragma unroll 9
+MN_UNROLL(9)
       for (int i = 0; i < 9; i++)
         F[i] = New_F[i];
 
@@ -1005,7 +1010,7 @@ compute_stress_nacc(double volume, double mu, double lambda, double bm, double x
 /// * Various continuum mechanics / matrix functions
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_SVD_DefGrad(const vec<T, 9> &F,
                               vec<T, 9> &U, vec<T, 3> &S, vec<T, 9> &V) 
 {
@@ -1016,7 +1021,7 @@ compute_SVD_DefGrad(const vec<T, 9> &F,
 
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_DefGradRate_from_DefGrad_and_VelocityGrad(const vec<T, 9> &F,
                                const vec<T, 9> &C, vec<T, 9> &Fdot) 
 {
@@ -1024,13 +1029,13 @@ compute_DefGradRate_from_DefGrad_and_VelocityGrad(const vec<T, 9> &F,
 }
 
 template <typename T = double>
-__forceinline__ __device__ void
+__forceinline__ __host__ __device__ void
 compute_StressCauchy_from_DefGrad_and_StressPK1(const vec<T, 9> &F,
                                const vec<T, 9> &P, vec<T, 9> &C) 
 {
   T J = matrixDeterminant3d(F.data());
   matrixMatrixTransposeMultiplication3d(P.data(), F.data(), C.data());
-#pragma unroll 9
+MN_UNROLL(9)
   for (int i = 0; i < 9; i++) C[i] = C[i] / J;
 }
 
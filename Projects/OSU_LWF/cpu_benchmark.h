@@ -0,0 +1,703 @@
+#ifndef __CPU_BENCHMARK_H_
+#define __CPU_BENCHMARK_H_
+#include "settings.cuh"
+#include "transfer_simd.h"
+#include <MnBase/Algorithm/RadixSort.h>
+#include <MnBase/Concurrency/Concurrency.h>
+#include <MnBase/Math/Matrix/MatrixUtils.h>
+#include <MnBase/Math/Matrix/svd_host.h>
+#include <MnBase/Math/Vec.cuh>
+#include <MnSystem/IO/IO.h>
+#include <MnSystem/IO/ParticleIO.hpp>
+
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <climits>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace mn {
+
+/// @brief Host (multi-threaded) backend of the G2P2G MPM pipeline. Runs small verification scenes, debugging and CI without a GPU.
+/// Same data layout and kernel structure as the device path:
+/// - Grid in g_blocksize^3 blocks with SoA channels (mass, momentum -> velocity), as the first four channels of grid_block_.
+/// - Particles in g_bin_capacity SoA bins grouped by particle block, rebinned every step, as particle_bin_ with _binsts / _ppbs.
+/// - G2P2G per particle block on the shifted 8x8x8 arena of blocks [b, b+1], as g2p2g's shared memory arena.
+/// Particle blocks run in 8 parity colors, so arenas of one color never overlap and P2G needs no atomics.
+/// Positions are in meters on a hashed (sparse) block grid of spacing dx, not normalized to the DOMAIN_BITS grid.
+/// Supports JFluid and FixedCorotated bodies, "Walls" and "Box" grid-boundaries.
+struct cpu_benchmark {
+  using key_t = uint64_t;
+  static constexpr int arena_size = config::g_blocksize << 1; //< Cells per arena direction
+  static constexpr int arena_volume = arena_size * arena_size * arena_size;
+
+  /// @brief Grid-block, channels mass and momentum (velocity after update_grid) as grid_block_ _0 to _3
+  struct GridBlock {
+    PREC_G val[4][config::g_blockvolume];
+  };
+
+  /// @brief One body. Particle channels per bin: x, y, z, J (JFluid) or F (FixedCorotated, column-major), ID, vx, vy, vz.
+  struct Model {
+    material_e material;
+    PREC volume, mass;              //< Per particle
+    PREC bulk, gamma, visco;        //< JFluid
+    PREC mu, lambda;                //< FixedCorotated
+    int strain_channels, channels;  //< 1 or 9 strain values, total values per particle
+    std::size_t count = 0;          //< Particles
+    std::vector<PREC> bins, next_bins; //< [bin][channel][g_bin_capacity]
+    std::vector<key_t> keys;           //< Particle block after advection, per bin slot
+    std::vector<key_t> block_keys;     //< Particle blocks
+    std::vector<key_t> sort_keys, sort_keys_alt;       //< rebin() scratch
+    std::vector<uint32_t> sort_slots, sort_slots_alt;  //< rebin() scratch
+    std::vector<int> ppbs, binsts;     //< Particles per block, first bin of block
+    std::vector<int> colors[8];        //< Blocks per parity color
+    std::vector<std::array<int, 8>> arena_grid, arena_next_grid; //< Grid-block per arena block, -1 if inactive
+    int ch_id() const noexcept { return 3 + strain_channels; }
+    int ch_vel() const noexcept { return 4 + strain_channels; }
+    PREC &val(std::vector<PREC> &b, std::size_t slot, int ch) const noexcept {
+      return b[((slot / config::g_bin_capacity) * channels + ch) * config::g_bin_capacity + slot % config::g_bin_capacity];
+    }
+  };
+
+  cpu_benchmark(PREC dx, double dt, double t0, int fps, int frames, pvec3 grav, std::string suffix, int num_threads = 0)
+      : dx{dx}, dxInv{1. / dx}, dtDefault{dt}, initTime{t0}, curTime{t0}, fps{fps}, nframes{frames}, grav{grav},
+        save_suffix{suffix}, pool{num_threads} {
+    fmt::print(fg(fmt::color::cyan), "CPU backend with [{}] threads, [{}] transfers, dx[{}] m, dt[{}] s.\n", pool.size(), simd::batched ? simd::isa : "per-particle", dx, dt);
+  }
+
+  /// @brief Add a JFluid body. bulk: bulk modulus [Pa], gamma: d(bulk)/d(pressure), visco: dynamic viscosity [Pa s]
+  void initJFluid(const std::vector<std::array<PREC, 3>> &positions, pvec3 v0, PREC rho, PREC ppc, PREC bulk, PREC gamma, PREC visco) {
+    Model &m = addModel(material_e::JFluid, rho, ppc, 1);
+    m.bulk = bulk, m.gamma = gamma, m.visco = visco;
+    fillModel(m, positions, v0);
+  }
+  /// @brief Add a FixedCorotated body. E: Young's modulus [Pa], nu: Poisson ratio
+  void initFixedCorotated(const std::vector<std::array<PREC, 3>> &positions, pvec3 v0, PREC rho, PREC ppc, PREC E, PREC nu) {
+    Model &m = addModel(material_e::FixedCorotated, rho, ppc, 9);
+    m.mu = E / (2. * (1. + nu)), m.lambda = E * nu / ((1. + nu) * (1. - 2. * nu));
+    fillModel(m, positions, v0);
+  }
+  void initGridBoundary(const config::GridBoundaryConfigs &gb) { gridBoundaries.push_back(gb); }
+  int getModelCnt() const noexcept { return static_cast<int>(models.size()); }
+  std::size_t getParticleCnt() const noexcept {
+    std::size_t n = 0;
+    for (auto &m : models) n += m.count;
+    return n;
+  }
+
+  void main_loop() {
+    nextTime = initTime + 1.0 / fps;
+    dt = dtDefault;
+    buildGrid();
+    rasterize();
+    std::swap(grid, next_grid), std::swap(grid_table, next_grid_table);
+    for (auto &m : models) std::swap(m.arena_grid, m.arena_next_grid);
+    fmt::print("Begin main loop.\n");
+    curTime += dt;
+    for (curFrame = 1; curFrame <= nframes; ++curFrame) {
+      auto start = std::chrono::steady_clock::now();
+      int step_cnt = 0;
+      for (; curTime < nextTime; curTime += dt, curStep++, step_cnt++) {
+        PREC_G maxVel = std::sqrt(update_grid(dt));
+        double nextDt = dtDefault; //< Fixed time-step as device main_loop
+        if (maxVel * nextDt > config::g_cfl * dx && g_log_level >= (int)config::log_e::Warn)
+          fmt::print(fg(fmt::color::orange), "WARNING: maxVel[{}] m/s exceeds CFL for dt[{}] s at step[{}].\n", maxVel, nextDt, curStep);
+        buildGrid();
+        g2p2g(dt, nextDt);
+        for (auto &m : models) rebin(m);
+        std::swap(grid, next_grid), std::swap(grid_table, next_grid_table);
+        for (auto &m : models) std::swap(m.arena_grid, m.arena_next_grid);
+        dt = nextDt;
+      }
+      double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+      fmt::print(fg(fmt::color::green), "Frame[{}] at curTime[{}] s: [{}] steps in [{:.3f}] s wall, [{:.3e}] particle-steps/s, [{}] grid-blocks.\n",
+                 curFrame, curTime, step_cnt, wall, wall > 0. ? getParticleCnt() * step_cnt / wall : 0., grid.size());
+      output_particles();
+      nextTime = initTime + (curFrame + 1) * (1.0 / fps);
+    }
+    IO::flush();
+  }
+
+private:
+  static constexpr int key_bias = 1 << 20; //< Block coordinates in [-2^20, 2^20)
+  static key_t block_key(int bx, int by, int bz) noexcept {
+    return (key_t(bx + key_bias) << 42) | (key_t(by + key_bias) << 21) | key_t(bz + key_bias);
+  }
+  static ivec3 block_coord(key_t key) noexcept {
+    constexpr key_t mask = (key_t(1) << 21) - 1;
+    return ivec3{(int)((key >> 42) & mask) - key_bias, (int)((key >> 21) & mask) - key_bias, (int)(key & mask) - key_bias};
+  }
+  /// Base cell of the quadratic B-spline stencil, as (pos * g_dx_inv + 0.5).cast<int>() - 1 on device
+  int base_cell(PREC x) const noexcept { return static_cast<int>(std::floor(x * dxInv + 0.5)) - 1; }
+  /// Particle block of a base cell, as add_advection(base - 1)
+  static int base_block(int base) noexcept { return (base - 1) >> config::g_blockbits; }
+  key_t particle_key(const PREC *pos) const noexcept {
+    return block_key(base_block(base_cell(pos[0])), base_block(base_cell(pos[1])), base_block(base_cell(pos[2])));
+  }
+  void weights(PREC local, PREC *w) const noexcept {
+    PREC d = local * dxInv;
+    w[0] = 0.5 * (1.5 - d) * (1.5 - d);
+    d -= 1.0;
+    w[1] = 0.75 - d * d;
+    d = 0.5 + d;
+    w[2] = 0.5 * d * d;
+  }
+
+  Model &addModel(material_e material, PREC rho, PREC ppc, int strain_channels) {
+    models.emplace_back();
+    Model &m = models.back();
+    m.material = material;
+    m.volume = dx * dx * dx / ppc, m.mass = rho * m.volume;
+    m.strain_channels = strain_channels, m.channels = 7 + strain_channels;
+    return m;
+  }
+
+  /// Particles start in one pseudo-block in input order, rebin() then sorts them into blocks
+  void fillModel(Model &m, const std::vector<std::array<PREC, 3>> &positions, pvec3 v0) {
+    m.count = positions.size();
+    std::size_t nbins = (m.count + config::g_bin_capacity - 1) / config::g_bin_capacity;
+    m.bins.assign(nbins * m.channels * config::g_bin_capacity, 0.);
+    m.keys.assign(nbins * config::g_bin_capacity, 0);
+    m.ppbs.assign(1, static_cast<int>(m.count));
+    m.binsts.assign(1, 0);
+    for (std::size_t p = 0; p < m.count; ++p) {
+      for (int d = 0; d < 3; ++d) m.val(m.bins, p, d) = config::stored_particle_position(positions[p][d]);
+      if (m.strain_channels == 1) m.val(m.bins, p, 3) = 1.;
+      else for (int d = 0; d < 9; ++d) m.val(m.bins, p, 3 + d) = (d & 0x3) ? 0. : 1.;
+      m.val(m.bins, p, m.ch_id()) = static_cast<PREC>(p);
+      for (int d = 0; d < 3; ++d) m.val(m.bins, p, m.ch_vel() + d) = v0[d];
+      m.keys[p] = particle_key(positions[p].data());
+    }
+    rebin(m);
+    IO::insert_job([fn = std::string{"model["} + std::to_string(models.size() - 1) + "]_dev[0]_frame[-1]" + save_suffix,
+                    positions]() { write_partio<PREC, 3>(fn, positions); });
+    fmt::print(fg(fmt::color::green), "CPU model[{}]: [{}] particles in [{}] blocks.\n", models.size() - 1, m.count, m.block_keys.size());
+  }
+
+  /// @brief Sort particles into bins of their (advected) particle blocks, as the device advection buckets and _binsts.
+  /// Stable radix sort of (block, slot) pairs, so blocks come out in key order (z fastest, neighbours close in memory)
+  /// and each block keeps the previous particle order. Blocks are keyed densely over their bounding box to keep passes few.
+  void rebin(Model &m) {
+    const std::size_t n = m.count, old_blocks = m.ppbs.size();
+    std::vector<std::array<int, 6>> bounds(old_blocks); //< Advected block range per previous block
+    pool.parallel_for(old_blocks, [&](std::size_t bb, std::size_t be) {
+      for (std::size_t b = bb; b < be; ++b) {
+        std::array<int, 6> r{INT_MAX, INT_MAX, INT_MAX, INT_MIN, INT_MIN, INT_MIN};
+        for (int k = 0; k < m.ppbs[b]; ++k) {
+          ivec3 c = block_coord(m.keys[(std::size_t)m.binsts[b] * config::g_bin_capacity + k]);
+          for (int d = 0; d < 3; ++d) r[d] = std::min(r[d], c[d]), r[3 + d] = std::max(r[3 + d], c[d]);
+        }
+        bounds[b] = r;
+      }
+    }, 64);
+    std::array<int, 6> box{INT_MAX, INT_MAX, INT_MAX, INT_MIN, INT_MIN, INT_MIN};
+    std::vector<std::size_t> first(old_blocks + 1, 0); //< First particle of previous block in bin order
+    for (std::size_t b = 0; b < old_blocks; ++b) {
+      for (int d = 0; d < 3; ++d) box[d] = std::min(box[d], bounds[b][d]), box[3 + d] = std::max(box[3 + d], bounds[b][3 + d]);
+      first[b + 1] = first[b] + m.ppbs[b];
+    }
+    const key_t ny = key_t(box[4] - box[1] + 1), nz = key_t(box[5] - box[2] + 1);
+    const key_t nkeys = n ? key_t(box[3] - box[0] + 1) * ny * nz : 1;
+    auto dense_key = [&](const ivec3 &c) { return (key_t(c[0] - box[0]) * ny + key_t(c[1] - box[1])) * nz + key_t(c[2] - box[2]); };
+
+    m.sort_keys.resize(n), m.sort_keys_alt.resize(n), m.sort_slots.resize(n), m.sort_slots_alt.resize(n);
+    pool.parallel_for(old_blocks, [&](std::size_t bb, std::size_t be) {
+      for (std::size_t b = bb; b < be; ++b)
+        for (int k = 0; k < m.ppbs[b]; ++k) {
+          uint32_t slot = static_cast<uint32_t>(m.binsts[b] * config::g_bin_capacity + k);
+          m.sort_keys[first[b] + k] = dense_key(block_coord(m.keys[slot])), m.sort_slots[first[b] + k] = slot;
+        }
+    }, 64);
+    int end_bit = 1;
+    while (end_bit < 64 && (key_t(1) << end_bit) < nkeys) ++end_bit;
+    radix_sort_pairs(pool, n, m.sort_keys.data(), m.sort_slots.data(), m.sort_keys_alt.data(), m.sort_slots_alt.data(), end_bit);
+
+    // Block starts in sorted order: counted per chunk, then written at scanned offsets
+    const std::size_t chunk = 1 << 16, chunks = (n + chunk - 1) / chunk;
+    std::vector<std::size_t> starts_before(chunks + 1, 0);
+    auto is_start = [&](std::size_t q) { return q == 0 || m.sort_keys[q] != m.sort_keys[q - 1]; };
+    pool.parallel_for(chunks, [&](std::size_t cb, std::size_t ce) {
+      for (std::size_t c = cb; c < ce; ++c)
+        for (std::size_t q = c * chunk; q < std::min(n, (c + 1) * chunk); ++q) starts_before[c + 1] += is_start(q);
+    });
+    for (std::size_t c = 0; c < chunks; ++c) starts_before[c + 1] += starts_before[c];
+    const std::size_t nblocks = starts_before[chunks];
+    std::vector<std::size_t> block_first(nblocks + 1, n);
+    pool.parallel_for(chunks, [&](std::size_t cb, std::size_t ce) {
+      for (std::size_t c = cb; c < ce; ++c) {
+        std::size_t i = starts_before[c];
+        for (std::size_t q = c * chunk; q < std::min(n, (c + 1) * chunk); ++q)
+          if (is_start(q)) block_first[i++] = q;
+      }
+    });
+
+    m.block_keys.resize(nblocks);
+    m.ppbs.resize(nblocks);
+    m.binsts.resize(nblocks);
+    int nbins = 0;
+    for (std::size_t i = 0; i < nblocks; ++i) {
+      m.block_keys[i] = m.keys[m.sort_slots[block_first[i]]];
+      m.ppbs[i] = static_cast<int>(block_first[i + 1] - block_first[i]);
+      m.binsts[i] = nbins;
+      nbins += (m.ppbs[i] + config::g_bin_capacity - 1) / config::g_bin_capacity;
+    }
+
+    m.next_bins.assign((std::size_t)nbins * m.channels * config::g_bin_capacity, 0.);
+    pool.parallel_for(nblocks, [&](std::size_t bb, std::size_t be) {
+      for (std::size_t i = bb; i < be; ++i)
+        for (int k = 0; k < m.ppbs[i]; ++k) {
+          std::size_t dst = (std::size_t)m.binsts[i] * config::g_bin_capacity + k, src = m.sort_slots[block_first[i] + k];
+          for (int ch = 0; ch < m.channels; ++ch) m.val(m.next_bins, dst, ch) = m.val(m.bins, src, ch);
+        }
+    }, 64);
+    std::swap(m.bins, m.next_bins);
+    m.keys.assign((std::size_t)nbins * config::g_bin_capacity, 0);
+    for (auto &c : m.colors) c.clear();
+    for (std::size_t i = 0; i < m.block_keys.size(); ++i) {
+      ivec3 b = block_coord(m.block_keys[i]);
+      m.colors[((b[0] & 1) << 2) | ((b[1] & 1) << 1) | (b[2] & 1)].push_back((int)i);
+    }
+  }
+
+  /// @brief Activate next grid on the arenas of all particle blocks, and find each arena block in the current grid
+  void buildGrid() {
+    next_grid_table.clear();
+    std::vector<key_t> next_keys;
+    for (auto &m : models) {
+      m.arena_next_grid.resize(m.block_keys.size());
+      m.arena_grid.resize(m.block_keys.size());
+      for (std::size_t i = 0; i < m.block_keys.size(); ++i) {
+        ivec3 b = block_coord(m.block_keys[i]);
+        for (int o = 0; o < 8; ++o) {
+          key_t key = block_key(b[0] + ((o & 4) ? 1 : 0), b[1] + ((o & 2) ? 1 : 0), b[2] + ((o & 1) ? 1 : 0));
+          auto it = next_grid_table.find(key);
+          if (it == next_grid_table.end()) {
+            it = next_grid_table.emplace(key, (int)next_keys.size()).first;
+            next_keys.push_back(key);
+          }
+          m.arena_next_grid[i][o] = it->second;
+          auto prev = grid_table.find(key);
+          m.arena_grid[i][o] = prev == grid_table.end() ? -1 : prev->second;
+        }
+      }
+    }
+    next_grid_keys = std::move(next_keys);
+    next_grid.resize(next_grid_keys.size());
+    pool.parallel_for(next_grid.size(), [&](std::size_t begin, std::size_t end) {
+      std::memset(static_cast<void *>(next_grid.data() + begin), 0, (end - begin) * sizeof(GridBlock));
+    }, 256);
+  }
+
+  /// @brief Run kernel(model, block, p2g_arena) on every particle block in parity-color passes, then add arenas to next grid
+  template <typename Kernel>
+  void p2g_passes(Kernel &&kernel) {
+    for (auto &m : models)
+      for (int c = 0; c < 8; ++c) {
+        const auto &blocks = m.colors[c];
+        pool.parallel_for(blocks.size(), [&](std::size_t begin, std::size_t end) {
+          std::vector<PREC_G> arena(4 * arena_volume);
+          for (std::size_t i = begin; i < end; ++i) {
+            int blk = blocks[i];
+            std::fill(arena.begin(), arena.end(), (PREC_G)0);
+            kernel(m, blk, arena.data());
+            for (int o = 0; o < 8; ++o) {
+              GridBlock &gb = next_grid[m.arena_next_grid[blk][o]];
+              int ox = (o & 4) ? config::g_blocksize : 0, oy = (o & 2) ? config::g_blocksize : 0, oz = (o & 1) ? config::g_blocksize : 0;
+              for (int cell = 0; cell < config::g_blockvolume; ++cell) {
+                int cx = (cell >> (config::g_blockbits << 1)) & config::g_blockmask;
+                int cy = (cell >> config::g_blockbits) & config::g_blockmask;
+                int cz = cell & config::g_blockmask;
+                int a = ((cx + ox) * arena_size + (cy + oy)) * arena_size + (cz + oz);
+                for (int ch = 0; ch < 4; ++ch) gb.val[ch][cell] += arena[ch * arena_volume + a];
+              }
+            }
+          }
+        });
+      }
+  }
+
+  /// @brief Initial P2G of mass and momentum, as rasterize (no stress at F = I)
+  void rasterize() {
+    p2g_passes([&](Model &m, int blk, PREC_G *arena) {
+      ivec3 b = block_coord(m.block_keys[blk]);
+      for (int k = 0; k < m.ppbs[blk]; ++k) {
+        std::size_t slot = (std::size_t)m.binsts[blk] * config::g_bin_capacity + k;
+        PREC pos[3], vel[3], w[3][3];
+        int a0[3];
+        for (int d = 0; d < 3; ++d) {
+          pos[d] = m.val(m.bins, slot, d), vel[d] = m.val(m.bins, slot, m.ch_vel() + d);
+          int base = base_cell(pos[d]);
+          weights(pos[d] - base * dx, w[d]);
+          a0[d] = base - b[d] * config::g_blocksize;
+        }
+        for (int i = 0; i < 3; ++i)
+          for (int j = 0; j < 3; ++j)
+            for (int k2 = 0; k2 < 3; ++k2) {
+              int a = ((a0[0] + i) * arena_size + (a0[1] + j)) * arena_size + (a0[2] + k2);
+              PREC wm = m.mass * w[0][i] * w[1][j] * w[2][k2];
+              arena[a] += (PREC_G)wm;
+              for (int d = 0; d < 3; ++d) arena[(1 + d) * arena_volume + a] += (PREC_G)(wm * vel[d]);
+            }
+      }
+    });
+  }
+
+  /// @brief Momentum to velocity, grid-boundaries, gravity. Returns max velocity squared. As update_grid_velocity_query_max.
+  PREC_G update_grid(double step_dt) {
+    const std::size_t grain = 64;
+    std::vector<PREC_G> maxVels((grid.size() + grain - 1) / grain, 0.f);
+    std::vector<key_t> keys(grid_table.size());
+    for (auto &kv : grid_table) keys[kv.second] = kv.first;
+    pool.parallel_for(grid.size(), [&](std::size_t begin, std::size_t end) {
+      PREC_G velSqr = 0.f;
+      for (std::size_t g = begin; g < end; ++g) {
+        ivec3 b = block_coord(keys[g]);
+        GridBlock &gb = grid[g];
+        for (int cell = 0; cell < config::g_blockvolume; ++cell) {
+          PREC_G mass = gb.val[0][cell];
+          if (mass <= 0.f) continue;
+          mass = 1.f / mass;
+          PREC_G xc[3] = {(PREC_G)((b[0] * config::g_blocksize + ((cell >> (config::g_blockbits << 1)) & config::g_blockmask)) * dx),
+                          (PREC_G)((b[1] * config::g_blocksize + ((cell >> config::g_blockbits) & config::g_blockmask)) * dx),
+                          (PREC_G)((b[2] * config::g_blocksize + (cell & config::g_blockmask)) * dx)};
+          PREC_G vel[3] = {gb.val[1][cell], gb.val[2][cell], gb.val[3][cell]};
+          int isInBound = boundary_mask(xc, vel);
+          for (int d = 0; d < 3; ++d) {
+            vel[d] = (isInBound & (4 >> d)) ? 0.f : vel[d] * mass;
+            vel[d] += (PREC_G)(grav[d] * step_dt);
+            gb.val[1 + d][cell] = vel[d];
+          }
+          velSqr = std::max(velSqr, vel[0] * vel[0] + vel[1] * vel[1] + vel[2] * vel[2]);
+        }
+      }
+      maxVels[begin / grain] = velSqr;
+    }, grain);
+    PREC_G maxVel = 0.f;
+    for (auto v : maxVels) maxVel = std::max(maxVel, v);
+    return maxVel;
+  }
+
+  /// Per-axis bits (x = 4, y = 2, z = 1) of grid-node velocity to zero, for Walls and Box boundaries active at curTime
+  int boundary_mask(const PREC_G *xc, const PREC_G *mom) const {
+    int isInBound = 0;
+    const PREC_G layer = 1.5f * (PREC_G)dx;
+    for (const auto &gb : gridBoundaries) {
+      if (curTime < gb._time[0] || curTime > gb._time[1]) continue;
+      const auto &lo = gb._domain_start, &hi = gb._domain_end;
+      if (gb._object == config::boundary_object_t::Walls) {
+        bool outside = false;
+        int on_wall = 0;
+        for (int d = 0; d < 3; ++d) {
+          PREC_G pad = gb._contact == config::boundary_contact_t::Sticky ? 0.f : layer;
+          if (xc[d] <= lo[d] - pad || xc[d] >= hi[d] + pad) outside = true;
+          bool below = xc[d] <= lo[d], above = xc[d] >= hi[d];
+          if (gb._contact == config::boundary_contact_t::Separable) {
+            below = below && mom[d] < 0.f, above = above && mom[d] > 0.f;
+          }
+          if (below || above) on_wall |= 4 >> d;
+        }
+        if (gb._contact == config::boundary_contact_t::Sticky) { if (on_wall) isInBound |= 7; }
+        else isInBound |= on_wall;
+        if (outside) isInBound |= 7;
+      } else if (gb._object == config::boundary_object_t::Box) {
+        PREC_G t = gb._contact == config::boundary_contact_t::Sticky ? 0.f : 0.99f * (PREC_G)dx;
+        bool inside = true, in_layer = true;
+        for (int d = 0; d < 3; ++d) {
+          inside = inside && xc[d] > lo[d] + t && xc[d] < hi[d] - t;
+          in_layer = in_layer && xc[d] >= lo[d] && xc[d] <= hi[d];
+        }
+        if (inside) isInBound |= 7;
+        else if (in_layer) { //< Slip layer, zero velocity normal to the nearest face
+          int face = 0;
+          PREC_G best = std::numeric_limits<PREC_G>::max();
+          for (int d = 0; d < 3; ++d) {
+            PREC_G dl = xc[d] - lo[d], dh = hi[d] - xc[d];
+            if (dl < best) best = dl, face = d * 2;
+            if (dh < best) best = dh, face = d * 2 + 1;
+          }
+          int d = face / 2;
+          bool into = (face & 1) ? mom[d] < 0.f : mom[d] > 0.f;
+          if (gb._contact != config::boundary_contact_t::Separable || into) isInBound |= 4 >> d;
+        }
+      }
+    }
+    return isInBound;
+  }
+
+  /// @brief Fused G2P (APIC), constitutive update and P2G into next grid, as g2p2g for JFluid / FixedCorotated.
+  /// Transfers run simd::lanes particles at a time (transfer_simd.h) with a SIMD ISA compiled in, else per particle.
+  void g2p2g(double step_dt, double newDt) {
+    std::atomic<std::size_t> lost{0};
+    p2g_passes([&](Model &m, int blk, PREC_G *p2g) {
+      // Velocities of the arena from the current grid, zero for blocks not active in it
+      PREC_G g2p[3][arena_volume];
+      for (int o = 0; o < 8; ++o) {
+        int src = m.arena_grid[blk][o];
+        int ox = (o & 4) ? config::g_blocksize : 0, oy = (o & 2) ? config::g_blocksize : 0, oz = (o & 1) ? config::g_blocksize : 0;
+        for (int cell = 0; cell < config::g_blockvolume; ++cell) {
+          int cx = (cell >> (config::g_blockbits << 1)) & config::g_blockmask;
+          int cy = (cell >> config::g_blockbits) & config::g_blockmask;
+          int cz = cell & config::g_blockmask;
+          int a = ((cx + ox) * arena_size + (cy + oy)) * arena_size + (cz + oz);
+          for (int ch = 0; ch < 3; ++ch) g2p[ch][a] = src < 0 ? 0.f : grid[src].val[1 + ch][cell];
+        }
+      }
+      std::size_t clamped = simd::batched ? g2p2g_lanes(m, blk, g2p, p2g, step_dt, newDt) : g2p2g_particles(m, blk, g2p, p2g, step_dt, newDt);
+      if (clamped) lost.fetch_add(clamped, std::memory_order_relaxed);
+    });
+    if (lost && g_log_level >= (int)config::log_e::Warn)
+      fmt::print(fg(fmt::color::orange), "WARNING: [{}] particles moved over a cell in step[{}], P2G clamped to the arena. Lower dt.\n", lost.load(), curStep);
+  }
+
+  /// @brief g2p2g of one particle block, one particle at a time. Returns particles clamped to the arena.
+  std::size_t g2p2g_particles(Model &m, int blk, const PREC_G (&g2p)[3][arena_volume], PREC_G *p2g, double step_dt, double newDt) {
+    const PREC Dp_inv = 4. * dxInv * dxInv; //< Quad. B-spline, D_p^-1 = 4 / dx^2
+    ivec3 b = block_coord(m.block_keys[blk]);
+    std::size_t clamped = 0;
+    for (int k = 0; k < m.ppbs[blk]; ++k) {
+      std::size_t slot = (std::size_t)m.binsts[blk] * config::g_bin_capacity + k;
+      PREC pos[3], local_pos[3], w[3][3], vel[3] = {0., 0., 0.}, C[9] = {};
+      int base[3], a0[3];
+      for (int d = 0; d < 3; ++d) {
+        pos[d] = m.val(m.bins, slot, d);
+        base[d] = base_cell(pos[d]);
+        local_pos[d] = pos[d] - base[d] * dx;
+        weights(local_pos[d], w[d]);
+        a0[d] = base[d] - b[d] * config::g_blocksize;
+      }
+      for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+          for (int k2 = 0; k2 < 3; ++k2) {
+            int a = ((a0[0] + i) * arena_size + (a0[1] + j)) * arena_size + (a0[2] + k2);
+            PREC W = w[0][i] * w[1][j] * w[2][k2];
+            PREC xixp[3] = {i * dx - local_pos[0], j * dx - local_pos[1], k2 * dx - local_pos[2]};
+            PREC vi[3] = {g2p[0][a], g2p[1][a], g2p[2][a]};
+            for (int d = 0; d < 3; ++d) vel[d] += vi[d] * W;
+            for (int c = 0; c < 3; ++c)
+              for (int r = 0; r < 3; ++r) C[c * 3 + r] += W * vi[r] * xixp[c];
+          }
+      for (int d = 0; d < 3; ++d) pos[d] += vel[d] * step_dt;
+
+      PREC contrib[9];
+      if (m.material == material_e::JFluid) {
+        PREC &J = m.val(m.bins, slot, 3);
+        J = (1 + (C[0] + C[4] + C[8]) * step_dt * Dp_inv) * J;
+        PREC voln = J * m.volume;
+        PREC pressure = (m.bulk / m.gamma) * (std::pow(J, -m.gamma) - 1.);
+        for (int c = 0; c < 3; ++c)
+          for (int r = 0; r < 3; ++r)
+            contrib[c * 3 + r] = ((C[c * 3 + r] + C[r * 3 + c]) * Dp_inv * m.visco - (r == c ? pressure : 0.)) * voln;
+      } else {
+        PREC F[9], dF[9], Fn[9], U[9], S[3], V[9];
+        for (int d = 0; d < 9; ++d) F[d] = m.val(m.bins, slot, 3 + d), dF[d] = C[d] * step_dt * Dp_inv + ((d & 0x3) ? 0. : 1.);
+        for (int c = 0; c < 3; ++c)
+          for (int r = 0; r < 3; ++r) Fn[c * 3 + r] = dF[r] * F[c * 3] + dF[3 + r] * F[c * 3 + 1] + dF[6 + r] * F[c * 3 + 2];
+        for (int d = 0; d < 9; ++d) m.val(m.bins, slot, 3 + d) = Fn[d];
+        math::svd_host(Fn, U, S, V);
+        stress_fixedcorotated(m, Fn, U, S, V, contrib);
+      }
+      for (int d = 0; d < 9; ++d) contrib[d] = (C[d] * m.mass - contrib[d] * newDt) * Dp_inv;
+      PREC p[3] = {config::stored_particle_position(pos[0]), config::stored_particle_position(pos[1]),
+                   config::stored_particle_position(pos[2])}; //< As particle bins store them
+      for (int d = 0; d < 3; ++d) m.val(m.bins, slot, d) = p[d], m.val(m.bins, slot, m.ch_vel() + d) = vel[d];
+      m.keys[slot] = particle_key(p);
+
+      // P2G at the advected position, into the same arena (particles move less than a cell per step)
+      bool moved = false;
+      for (int d = 0; d < 3; ++d) {
+        int nb = base_cell(pos[d]);
+        if (nb < base[d] - 1 || nb > base[d] + 1) nb = std::min(std::max(nb, base[d] - 1), base[d] + 1), moved = true;
+        local_pos[d] = pos[d] - nb * dx;
+        weights(std::min(std::max(local_pos[d], 0.5 * dx), 1.5 * dx), w[d]);
+        a0[d] = nb - b[d] * config::g_blocksize;
+      }
+      clamped += moved;
+      for (int i = 0; i < 3; ++i)
+        for (int j = 0; j < 3; ++j)
+          for (int k2 = 0; k2 < 3; ++k2) {
+            int a = ((a0[0] + i) * arena_size + (a0[1] + j)) * arena_size + (a0[2] + k2);
+            PREC W = w[0][i] * w[1][j] * w[2][k2];
+            PREC xixp[3] = {i * dx - local_pos[0], j * dx - local_pos[1], k2 * dx - local_pos[2]};
+            PREC wm = m.mass * W;
+            p2g[a] += (PREC_G)wm;
+            for (int d = 0; d < 3; ++d)
+              p2g[(1 + d) * arena_volume + a] +=
+                  (PREC_G)(wm * vel[d] + (contrib[d] * xixp[0] + contrib[3 + d] * xixp[1] + contrib[6 + d] * xixp[2]) * W);
+          }
+    }
+    return clamped;
+  }
+
+  /// @brief g2p2g of one particle block, simd::lanes particles per batch. Returns particles clamped to the arena.
+  std::size_t g2p2g_lanes(Model &m, int blk, const PREC_G (&g2p)[3][arena_volume], PREC_G *p2g, double step_dt, double newDt) {
+    static_assert(std::is_same<PREC_G, float>::value && arena_volume == simd::arena_volume, "Arena layout of transfer_simd.h");
+    static_assert(config::g_bin_capacity % simd::lanes == 0, "Particle batches must not straddle bins");
+    constexpr int L = simd::lanes;
+    const PREC Dp_inv = 4. * dxInv * dxInv; //< Quad. B-spline, D_p^-1 = 4 / dx^2
+    thread_local std::vector<float> lane_arena(4 * arena_volume * L, 0.f); //< Cleared by reduce_lanes
+    ivec3 b = block_coord(m.block_keys[blk]);
+    const double origin[3] = {(double)b[0] * config::g_blocksize, (double)b[1] * config::g_blocksize, (double)b[2] * config::g_blocksize};
+    std::size_t clamped = 0;
+    for (int k0 = 0; k0 < m.ppbs[blk]; k0 += L) {
+      const int active = std::min(L, m.ppbs[blk] - k0); //< Idle lanes repeat lane 0 with zero mass
+      const std::size_t slot0 = (std::size_t)m.binsts[blk] * config::g_bin_capacity + k0;
+      alignas(64) double buf[3][L], Cs[9][L], contrib[9][L], mass[L];
+      simd::pd pos[3], vel[3], C[9];
+      simd::stencil_1d s[3], n[3];
+      for (int d = 0; d < 3; ++d) {
+        const PREC *x = &m.val(m.bins, slot0, d);
+        for (int l = 0; l < L; ++l) buf[d][l] = x[l < active ? l : 0];
+        pos[d] = simd::load(buf[d]);
+        s[d] = simd::bspline_weights(pos[d], dx, dxInv);
+      }
+      simd::g2p_gather(&g2p[0][0], simd::arena_corner(s, origin), s, dx, vel, C);
+      for (int d = 0; d < 3; ++d) pos[d] = simd::fmadd(vel[d], simd::set1(step_dt), pos[d]);
+      for (int d = 0; d < 9; ++d) simd::store(Cs[d], C[d]);
+
+      for (int l = 0; l < L; ++l) {
+        mass[l] = l < active ? m.mass : 0.;
+        for (int d = 0; d < 9; ++d) contrib[d][l] = 0.;
+      }
+      alignas(64) PREC stress[9][L];
+      if (m.material == material_e::JFluid) {
+        for (int l = 0; l < active; ++l) {
+          PREC &J = m.val(m.bins, slot0 + l, 3);
+          J = (1 + (Cs[0][l] + Cs[4][l] + Cs[8][l]) * step_dt * Dp_inv) * J;
+          PREC voln = J * m.volume;
+          PREC pressure = (m.bulk / m.gamma) * (std::pow(J, -m.gamma) - 1.);
+          for (int col = 0; col < 3; ++col)
+            for (int r = 0; r < 3; ++r)
+              stress[col * 3 + r][l] = ((Cs[col * 3 + r][l] + Cs[r * 3 + col][l]) * Dp_inv * m.visco - (r == col ? pressure : 0.)) * voln;
+        }
+      } else {
+        // F = (I + dt Dp^-1 C) F per particle, then one batched SVD for all lanes
+        alignas(64) PREC Fs[9][L], Us[9][L], Ss[3][L], Vs[9][L];
+        for (int l = 0; l < L; ++l) {
+          if (l >= active) {
+            for (int d = 0; d < 9; ++d) Fs[d][l] = (d & 0x3) ? 0. : 1.;
+            continue;
+          }
+          PREC F[9], dF[9];
+          for (int d = 0; d < 9; ++d) F[d] = m.val(m.bins, slot0 + l, 3 + d), dF[d] = Cs[d][l] * step_dt * Dp_inv + ((d & 0x3) ? 0. : 1.);
+          for (int col = 0; col < 3; ++col)
+            for (int r = 0; r < 3; ++r) Fs[col * 3 + r][l] = dF[r] * F[col * 3] + dF[3 + r] * F[col * 3 + 1] + dF[6 + r] * F[col * 3 + 2];
+          for (int d = 0; d < 9; ++d) m.val(m.bins, slot0 + l, 3 + d) = Fs[d][l];
+        }
+        math::svd_host_batch<L>(&Fs[0][0], &Us[0][0], &Ss[0][0], &Vs[0][0]);
+        for (int l = 0; l < active; ++l) {
+          PREC F[9], U[9], S[3], V[9], c[9];
+          for (int d = 0; d < 9; ++d) F[d] = Fs[d][l], U[d] = Us[d][l], V[d] = Vs[d][l];
+          for (int d = 0; d < 3; ++d) S[d] = Ss[d][l];
+          stress_fixedcorotated(m, F, U, S, V, c);
+          for (int d = 0; d < 9; ++d) stress[d][l] = c[d];
+        }
+      }
+      for (int l = 0; l < active; ++l)
+        for (int d = 0; d < 9; ++d) contrib[d][l] = (Cs[d][l] * m.mass - stress[d][l] * newDt) * Dp_inv;
+
+      // P2G at the advected position, into the same arena (particles move less than a cell per step)
+      alignas(64) double nbase[3][L], cbase[3][L];
+      for (int d = 0; d < 3; ++d) {
+        n[d] = simd::bspline_weights(pos[d], dx, dxInv);
+        simd::store(nbase[d], n[d].base);
+        n[d].base = simd::min(simd::max(n[d].base, s[d].base - simd::set1(1.)), s[d].base + simd::set1(1.));
+        simd::store(cbase[d], n[d].base);
+        n[d].local = pos[d] - n[d].base * simd::set1(dx);
+        simd::bspline_weights_at(n[d], dxInv);
+      }
+      for (int l = 0; l < active; ++l)
+        if (nbase[0][l] != cbase[0][l] || nbase[1][l] != cbase[1][l] || nbase[2][l] != cbase[2][l]) ++clamped;
+      simd::pd contrib_v[9];
+      for (int d = 0; d < 9; ++d) contrib_v[d] = simd::load(contrib[d]);
+      simd::p2g_scatter(lane_arena.data(), simd::arena_corner(n, origin), n, dx, simd::load(mass), vel, contrib_v);
+
+      alignas(64) double np[3][L], nv[3][L];
+      for (int d = 0; d < 3; ++d) simd::store(np[d], pos[d]), simd::store(nv[d], vel[d]);
+      for (int l = 0; l < active; ++l) {
+        const std::size_t slot = slot0 + l;
+        PREC p[3] = {config::stored_particle_position(np[0][l]), config::stored_particle_position(np[1][l]),
+                     config::stored_particle_position(np[2][l])}; //< As particle bins store them
+        for (int d = 0; d < 3; ++d) m.val(m.bins, slot, d) = p[d], m.val(m.bins, slot, m.ch_vel() + d) = nv[d][l];
+        m.keys[slot] = particle_key(p);
+      }
+    }
+    simd::reduce_lanes(lane_arena.data(), p2g, 4);
+    return clamped;
+  }
+
+  /// Kirchhoff stress times volume (P F^T V) from F = U S V^T, as compute_stress_fixedcorotated
+  static void stress_fixedcorotated(const Model &m, const PREC *F, const PREC *U, const PREC *S, const PREC *V, PREC *PF) {
+    PREC J = S[0] * S[1] * S[2];
+    PREC scaled_mu = 2.0 * m.mu, scaled_lambda = m.lambda * (J - 1.0);
+    PREC P_hat[3] = {scaled_mu * (S[0] - 1.0) + scaled_lambda * (S[1] * S[2]),
+                     scaled_mu * (S[1] - 1.0) + scaled_lambda * (S[0] * S[2]),
+                     scaled_mu * (S[2] - 1.0) + scaled_lambda * (S[0] * S[1])};
+    PREC P[9];
+    for (int c = 0; c < 3; ++c)
+      for (int r = 0; r < 3; ++r)
+        P[c * 3 + r] = P_hat[0] * U[r] * V[c] + P_hat[1] * U[3 + r] * V[3 + c] + P_hat[2] * U[6 + r] * V[6 + c];
+    for (int c = 0; c < 3; ++c)
+      for (int r = 0; r < 3; ++r)
+        PF[c * 3 + r] = (P[r] * F[c] + P[3 + r] * F[3 + c] + P[6 + r] * F[6 + c]) * m.volume;
+  }
+
+  /// Positions with J and velocity per particle, in input (ID) order, as model[m]_dev[0]_frame[f]
+  void output_particles() {
+    static const std::vector<std::string> labels{"J", "Velocity_X", "Velocity_Y", "Velocity_Z"};
+    for (int mid = 0; mid < getModelCnt(); ++mid) {
+      Model &m = models[mid];
+      std::vector<std::array<PREC, 3>> positions(m.count);
+      std::vector<PREC> attribs(m.count * labels.size());
+      std::size_t p = 0;
+      for (std::size_t b = 0; b < m.ppbs.size(); ++b)
+        for (int k = 0; k < m.ppbs[b]; ++k, ++p) {
+          std::size_t slot = (std::size_t)m.binsts[b] * config::g_bin_capacity + k;
+          std::size_t id = static_cast<std::size_t>(m.val(m.bins, slot, m.ch_id()));
+          PREC J = 1.;
+          if (m.strain_channels == 1) J = m.val(m.bins, slot, 3);
+          else {
+            PREC F[9];
+            for (int d = 0; d < 9; ++d) F[d] = m.val(m.bins, slot, 3 + d);
+            J = F[0] * (F[4] * F[8] - F[7] * F[5]) - F[3] * (F[1] * F[8] - F[7] * F[2]) + F[6] * (F[1] * F[5] - F[4] * F[2]);
+          }
+          for (int d = 0; d < 3; ++d) positions[id][d] = m.val(m.bins, slot, d);
+          attribs[id * labels.size()] = J;
+          for (int d = 0; d < 3; ++d) attribs[id * labels.size() + 1 + d] = m.val(m.bins, slot, m.ch_vel() + d);
+        }
+      std::string fn = std::string{"model["} + std::to_string(mid) + "]_dev[0]_frame[" + std::to_string(curFrame) + "]" + save_suffix;
+      IO::insert_job([fn, positions = std::move(positions), attribs = std::move(attribs)]() {
+        write_partio_particles<PREC>(fn, positions, attribs, labels);
+      });
+    }
+  }
+
+  static constexpr int g_log_level = config::g_log_level;
+  PREC dx, dxInv;
+  double dtDefault, initTime, curTime, nextTime = 0., dt = 0.;
+  int fps, nframes, curFrame = 0;
+  uint64_t curStep = 0;
+  pvec3 grav;
+  std::string save_suffix;
+  thread_pool pool;
+  std::vector<Model> models;
+  std::vector<config::GridBoundaryConfigs> gridBoundaries;
+  std::vector<GridBlock> grid, next_grid;
+  std::unordered_map<key_t, int> grid_table, next_grid_table;
+  std::vector<key_t> next_grid_keys;
+};
+
+} // namespace mn
+
+#endif
@@ -1,41 +1,18 @@
 #ifndef __GRID_BUFFER_CUH_
 #define __GRID_BUFFER_CUH_
 #include "mgmpm_kernels.cuh"
+#include "buffer_layouts.h"
 #include "settings.cuh"
 #include <MnSystem/Cuda/HostUtils.hpp>
 #include <MnBase/Meta/Polymorphism.h>
+#include <MnBase/Object/StructuralSerializer.h>
 
 namespace mn {
 
-using BlockDomain = compact_domain<char, config::g_blocksize,
-                                   config::g_blocksize, config::g_blocksize>;
-using GridDomain = compact_domain<int, config::g_grid_size_x, config::g_grid_size_y,
-                                  config::g_grid_size_z>;
 using GridBufferDomain = compact_domain<int, config::g_max_active_block>;
 using GridArrayDomain = compact_domain<int, config::g_max_active_block>;
 using GridTargetDomain = compact_domain<int, config::g_grid_target_cells>;
 
-#if (DEBUG_COUPLED_UP)
-using grid_block_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               BlockDomain, attrib_layout::soa, fg_, fg_, fg_, fg_,
-               fg_, fg_, fg_, fg_, fg_, fg_, fg_>; //< mass, vel + dt*fint, 
-                                              //< vel, 
-                                              //< Vol, J
-                                              //< mass_water, pressure_water
-#else
-using grid_block_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               BlockDomain, attrib_layout::soa, fg_, fg_, fg_, fg_,
-               fg_, fg_, fg_, fg_, fg_>; //< mass, vel + dt*fint, 
-                                              //< vel, 
-                                              //< Vol, J
-#endif
-
 using grid_ =
     structural<structural_type::dense,
                decorator<structural_allocation_policy::full_allocation,
@@ -75,7 +52,13 @@ struct GridBuffer : Instance<grid_buffer_> {
       : base_t{spawn<grid_buffer_, orphan_signature>(allocator)} {
         std::cout << "Constructing GridBuffer." << std::endl;
       }
-  
+  // Run-time capacity in grid-blocks (SimCapacity::max_active_block)
+  template <typename Allocator>
+  GridBuffer(Allocator allocator, std::size_t capacity)
+      : base_t{spawn<grid_buffer_, orphan_signature>(allocator, capacity)} {
+        std::cout << "Constructing GridBuffer with capacity " << capacity << " blocks." << std::endl;
+      }
+
   // Check capacity, resize if necessary
   template <typename Allocator>
   void checkCapacity(Allocator allocator, std::size_t capacity) {
@@ -97,6 +80,21 @@ struct GridBuffer : Instance<grid_buffer_> {
     using namespace placeholder;
     cuDev.compute_launch({blockCnt, config::g_blockvolume}, clear_grid_FBar, *this);
   }
+
+  /// Copy functor of device Instances for StructuralSerializer.h, synchronous
+  struct device_copy {
+    void operator()(void *dst, const void *src, std::size_t bytes) const {
+      checkCudaErrors(cudaMemcpy(dst, src, bytes, cudaMemcpyDefault));
+    }
+  };
+  /// Write the first blockCnt grid-blocks as a self-describing blob (schema of grid_block_ + raw blocks)
+  bool save(std::ostream &os, std::size_t blockCnt) const {
+    return save_structural(os, *this, blockCnt, device_copy{});
+  }
+  /// Read back a blob of save(), converted if grid_block_ changed since (e.g. PREC_G, attributes). Returns blocks loaded.
+  std::size_t load(const structural_blob &blob) {
+    return load_structural(blob, *this, _capacity, device_copy{});
+  }
 };
 
 /// 1D GridArray structure for device instantiation (JB)
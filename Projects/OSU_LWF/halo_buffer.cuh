@@ -2,38 +2,13 @@
 #define __HALO_BUFFER_CUH_
 #include "grid_buffer.cuh"
 #include "particle_buffer.cuh"
+#include "buffer_layouts.h"
 #include "settings.cuh"
 #include <MnBase/Meta/Polymorphism.h>
 //#include <cub/device/device_scan.cuh>
 
 namespace mn {
 
-using HaloGridBlocksDomain = compact_domain<int, config::g_max_halo_block>;
-using halo_grid_blocks_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               HaloGridBlocksDomain, attrib_layout::soa, grid_block_>;
-#if (DEBUG_COUPLED_UP)
-using grid_block_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               BlockDomain, attrib_layout::soa, fg_, fg_, fg_, fg_,
-              fg_, fg_, fg_, 
-              fg_, fg_,
-              fg_, fg_>; // mass, m(vel + dt*fint) (MLS), mvel (ASFLIP), 
-                         // Vol, JBar
-                         // mass_water, pressure_water
-#else
-using grid_block_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               BlockDomain, attrib_layout::soa, fg_, fg_, fg_, fg_,
-              fg_, fg_, fg_, 
-              fg_, fg_>; // mass, m(vel + dt*fint) (MLS), mvel (ASFLIP), Vol, JBar
-#endif
 /// Halo Grid-Block structure
 struct HaloGridBlocks {
   // Nest a structure holding HaloGridBlocksDomain and a pointer to device mem for blockids 3D coordinates
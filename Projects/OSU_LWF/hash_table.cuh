@@ -1,15 +1,18 @@
 #ifndef __HASH_TABLE_CUH_
 #define __HASH_TABLE_CUH_
 #include "mgmpm_kernels.cuh"
+#include "buffer_layouts.h"
 #include "settings.cuh"
 // #include "grid_buffer.cuh"
 #include "utility_funcs.hpp"
 #include <MnSystem/Cuda/HostUtils.hpp>
 
+#include <MnBase/DataStructure/Hash/Hash.cuh>
 #include <MnBase/Object/Structural.h>
 #include <MnBase/Object/StructuralDeclaration.h>
 #include <fmt/color.h>
 #include <fmt/core.h>
+#include <algorithm>
 
 namespace mn {
 
@@ -98,29 +101,31 @@ template <> struct HaloPartition<1> {
   ivec3 *_haloBlocks; //< 3D IDs of Halo Blocks
 };
 
-
-// Basic data-structure for Partitions
-using block_partition_ =
-    structural<structural_type::hash,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               GridDomain, attrib_layout::aos, empty_>; // GridDomain in grid_buffer.cuh
-
 /// @brief Template for Partitions (organizes interaction of Particles and Grids). 
-/// Uses a ton of memory for large DOMAIN_BITS. Inherits from Halo Partition (organizes Multi-GPU interaction). Can hold particle buckets when only one model per GPU is used.
+/// Dense _indexTable uses a ton of memory for large DOMAIN_BITS, set g_partition_block_hash to use a compact block_hash instead. Inherits from Halo Partition (organizes Multi-GPU interaction). Can hold particle buckets when only one model per GPU is used.
+/// Dense _indexTable is strided by the run-time _gridExtent (blocks per axis, from scene domain) instead of the compiled cubic GridDomain, so it is sized to the actual box.
 template <int Opt = 1>
 struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
   using base_t = Instance<block_partition_>;
   using halo_base_t = HaloPartition<Opt>;
   using block_partition_::key_t;
   using block_partition_::value_t;
+  using block_hash_t = block_hash<value_t>;
+  using key_hash_t = typename block_hash_t::key_t;
   static_assert(sentinel_v == (value_t)(-1), "sentinel value not full 1s\n");
 
   template <typename Allocator>
   Partition(Allocator allocator, int maxBlockCnt)
       : halo_base_t{allocator, maxBlockCnt} {
+    _gridExtent = ivec3{config::g_grid_size_x, config::g_grid_size_y, config::g_grid_size_z};
     _runtimeExtent = domain::extent;
-    allocate_table(allocator, maxBlockCnt);
+    if (config::g_partition_block_hash) {
+      _runtimeExtent = 1; //< Dense _indexTable unused
+      allocate_table(allocator, maxBlockCnt, _runtimeExtent);
+      _blockHash.allocate_hash(allocator, maxBlockCnt);
+      fmt::print("Allocated partition _blockHash bytes[{}].\n", (sizeof(key_hash_t) + sizeof(value_t)) * _blockHash.size());
+    } else
+      allocate_table(allocator, maxBlockCnt);
     // allocate_handle(allocator);
     if (!mn::config::g_buckets_on_particle_buffer) {
       _ppcs = (int *)allocator.allocate(sizeof(int) * maxBlockCnt *
@@ -144,13 +149,20 @@ struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
     /// init
     reset();
   }
+  /// @brief Partition over a run-time box of gridExtent grid-blocks per axis, each at most g_grid_size_x/y/z
   template <typename Allocator>
-  Partition(Allocator allocator, int maxBlockCnt, int runtimeExtent)
+  Partition(Allocator allocator, int maxBlockCnt, ivec3 gridExtent)
       : halo_base_t{allocator, maxBlockCnt} {
-    _runtimeExtent = runtimeExtent;
+    const ivec3 maxExtent{config::g_grid_size_x, config::g_grid_size_y, config::g_grid_size_z};
+    for (int d = 0; d < 3; ++d) _gridExtent[d] = std::min(std::max(1, gridExtent[d]), maxExtent[d]);
+    _runtimeExtent = config::g_partition_block_hash ? 1 : _gridExtent[0] * _gridExtent[1] * _gridExtent[2]; //< Dense _indexTable unused with block_hash
     fmt::print("Partition compiled domain::extent[{}]\n", domain::extent);
-    fmt::print("Partition _runtimeExtent[{}]\n", _runtimeExtent);
-    allocate_table(allocator, maxBlockCnt, runtimeExtent);
+    fmt::print("Partition _gridExtent[{}, {}, {}] blocks, _runtimeExtent[{}]\n", _gridExtent[0], _gridExtent[1], _gridExtent[2], _runtimeExtent);
+    allocate_table(allocator, maxBlockCnt, _runtimeExtent);
+    if (config::g_partition_block_hash) {
+      _blockHash.allocate_hash(allocator, maxBlockCnt);
+      fmt::print("Allocated partition _blockHash bytes[{}].\n", (sizeof(key_hash_t) + sizeof(value_t)) * _blockHash.size());
+    }
     if (!mn::config::g_buckets_on_particle_buffer){
       _ppcs = (int *)allocator.allocate(sizeof(int) * maxBlockCnt *
                                         config::g_blockvolume);
@@ -214,6 +226,11 @@ struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
       _binsts = (int *)allocator.allocate(sizeof(int) * capacity);
     }
     resize_table(allocator, capacity);
+    if (config::g_partition_block_hash) { //< Table is reset and rebuilt from _activeKeys by update_partition
+      _blockHash.deallocate_hash(allocator);
+      _blockHash.allocate_hash(allocator, capacity);
+      clearBlockHash(cudaStreamDefault);
+    }
     fmt::print("Resized partitions hash-table capacity to [{}] blocks.\n", capacity);
   }
   ~Partition() {}
@@ -227,6 +244,7 @@ struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
                                                         _runtimeExtent));
     fmt::print("Reset partitions _cnt values to [{}].\n", 0);
     fmt::print("Reset partitions _indextable values to [{}].\n", 0xff);
+    if (config::g_partition_block_hash) clearBlockHash(cudaStreamDefault);
     if (!mn::config::g_buckets_on_particle_buffer) {
       checkCudaErrors(cudaMemset( this->_ppcs, 0, sizeof(int) * this->_capacity 
                                                               * config::g_blockvolume));
@@ -240,11 +258,18 @@ struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
     checkCudaErrors(cudaMemsetAsync(this->_indexTable, 0xff,
                                     sizeof(value_t) * _runtimeExtent, stream));
     if (g_log_level >= 3) fmt::print("Reset partitions _indexTable values to [{}] over [{}] bytes\n", 0xff, sizeof(value_t) * _runtimeExtent);
+    if (config::g_partition_block_hash) clearBlockHash(stream);
+  }
+  /// Fill _blockHash keys and values with 0xff, i.e. sentinels
+  void clearBlockHash(cudaStream_t stream) {
+    checkCudaErrors(cudaMemsetAsync(_blockHash._keys, 0xff, sizeof(key_hash_t) * _blockHash.size(), stream));
+    checkCudaErrors(cudaMemsetAsync(_blockHash._values, 0xff, sizeof(value_t) * _blockHash.size(), stream));
   }
 
   template <typename Allocator>
   void deallocate_partition(Allocator allocator) {
     deallocate_buckets(allocator);
+    if (config::g_partition_block_hash) _blockHash.deallocate_hash(allocator);
     halo_base_t::deallocate_partition(allocator, this->_capacity); // Deallocate halo_base_t
     base_t::deallocate(allocator, this->_runtimeExtent);
   }
@@ -286,6 +311,13 @@ struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
                                     sizeof(value_t) * _runtimeExtent,
                                     cudaMemcpyDefault, stream));
     fmt::print("Copied _indexTable bytes[{}] to other.\n", sizeof(value_t) * _runtimeExtent);
+    if (config::g_partition_block_hash) {
+      if (other._blockHash.size() == _blockHash.size()) {
+        checkCudaErrors(cudaMemcpyAsync(other._blockHash._keys, _blockHash._keys, sizeof(key_hash_t) * _blockHash.size(), cudaMemcpyDefault, stream));
+        checkCudaErrors(cudaMemcpyAsync(other._blockHash._values, _blockHash._values, sizeof(value_t) * _blockHash.size(), cudaMemcpyDefault, stream));
+      } else
+        fmt::print(fg(fmt::color::red), "ERROR: Partition copy_to with _blockHash of [{}] slots into [{}] slots. Not copied.\n", _blockHash.size(), other._blockHash.size());
+    }
     if (mn::config::g_buckets_on_particle_buffer == false) {
       checkCudaErrors(cudaMemcpyAsync(other._ppbs, this->_ppbs,
                                       sizeof(int) * blockCnt, cudaMemcpyDefault,
@@ -297,16 +329,31 @@ struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
       fmt::print("Copied _binsts bytes[{}] to other.\n", sizeof(int) * blockCnt);
     }
   }
+  /// @brief Check if Block lies inside the run-time domain box
+  __forceinline__ __host__ __device__ bool in_domain(const key_t &key) const noexcept {
+    return key[0] >= 0 && key[1] >= 0 && key[2] >= 0 &&
+           key[0] < _gridExtent[0] && key[1] < _gridExtent[1] && key[2] < _gridExtent[2];
+  }
+  /// @brief Entry of Block in dense _indexTable, x outermost as GridDomain but strided by _gridExtent. Key must be in_domain.
+  __forceinline__ __device__ value_t &entry(const key_t &key) const noexcept {
+    return this->_indexTable[((key[0] * _gridExtent[1]) + key[1]) * _gridExtent[2] + key[2]];
+  }
   /// @brief Insert new key for Block in Partition Index-Table
   /// @param key 3D coordinates of Block to insert
-  /// @return New 1D index for inserted key. Returns -1 if error occurs.
+  /// @return New 1D index for inserted key. Returns -1 if error occurs or key is outside run-time domain.
   __forceinline__ __device__ value_t insert(key_t key) noexcept {
+    if (!in_domain(key)) return -1;
+    if (config::g_partition_block_hash) {
+      value_t idx = _blockHash.insert(block_hash_t::block_key(key[0], key[1], key[2]), this->_cnt);
+      if (idx != sentinel_v) this->_activeKeys[idx] = key;
+      return idx;
+    }
     // Set &this->index(key) = 0 if (&this->index(key) == sentinel_v), sentinel_v = -1 basically 
     // Return old value of this->index(key) as tag
-    value_t tag = atomicCAS(&this->index(key), sentinel_v, 0); 
+    value_t tag = atomicCAS(&entry(key), sentinel_v, 0); 
     if (tag == sentinel_v) { // If above CAS evaluated true (i.e. valid block insert)
       value_t idx = atomicAdd(this->_cnt, 1); // +1 to Partition's Block count
-      this->index(key) = idx; //< Index of inserted key set by incremented Block count
+      entry(key) = idx; //< Index of inserted key set by incremented Block count
       this->_activeKeys[idx] = key; ///< Created record of inserted key in Partition active keys
       return idx; //< Return new index for inserted key
     }
@@ -314,14 +361,21 @@ struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
   }
   /// @brief Query index of block in Partition Index-Table.
   /// @param key 3D index of block to query
-  /// @return 1D index of key in partition's _indexTable.
+  /// @return 1D index of key in partition's _indexTable, -1 if absent or outside run-time domain.
   __forceinline__ __device__ value_t query(key_t key) const noexcept {
-    return this->index(key);
+    if (!in_domain(key)) return -1;
+    if (config::g_partition_block_hash) return _blockHash.query(block_hash_t::block_key(key[0], key[1], key[2]));
+    return entry(key);
   }
   /// @brief Reinsert key of Block 1D index in Partition Hash-Table
   /// @param index 1D Index of block to rehash with a key 
   __forceinline__ __device__ void reinsert(value_t index) {
-    this->index(this->_activeKeys[index]) = index;
+    if (config::g_partition_block_hash) {
+      key_t key = this->_activeKeys[index];
+      _blockHash.insert(block_hash_t::block_key(key[0], key[1], key[2]), index);
+      return;
+    }
+    entry(this->_activeKeys[index]) = index;
   }
   /// @brief Advect particle ID in a Block to a new Cell in Partition. Done because particles move during Grid-to-Particle-to-Grid. Writes to _cellbuckets.
   /// @param cellid Grid-cell 3D ID in block
@@ -356,7 +410,9 @@ struct Partition : Instance<block_partition_>, HaloPartition<Opt> {
   int *_ppcs, *_ppbs;
   int *_cellbuckets, *_blockbuckets;
   int *_binsts;
-  int _runtimeExtent;
+  int _runtimeExtent; //< Entries in dense _indexTable
+  ivec3 _gridExtent; //< Run-time grid-blocks per axis, <= g_grid_size_x/y/z
+  block_hash_t _blockHash; //< Block index when g_partition_block_hash, replaces _indexTable
 };
 
 } // namespace mn
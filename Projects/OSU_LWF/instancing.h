@@ -0,0 +1,83 @@
+#ifndef __INSTANCING_H_
+#define __INSTANCING_H_
+#include <MnBase/Concurrency/Concurrency.h>
+#include <MnBase/Math/Matrix/MatrixUtils.h>
+#include <MnBase/Math/Vec.cuh>
+
+#include <algorithm>
+#include <array>
+#include <future>
+#include <thread>
+#include <vector>
+
+namespace mn {
+
+/// @brief Host-side replication of geometry "array" instances from one sampled prototype.
+/// Instance n is prototype + shift[n], clipped to the GPU partition, then rotated about the fulcrum.
+/// This is the order make_box etc. use, so each instance matches resampling it at its own offset.
+
+/// @brief Prototype particles kept by one instance, in prototype order.
+struct GeometryInstance {
+  std::size_t begin = 0; //< Index of first particle of this instance in fields
+  std::vector<int> kept; //< Prototype indices, ascending
+};
+
+/// @brief Append all instances of prototype to fields, each shifted, clipped and rotated. Runs instances on threads.
+/// @param clip Clip to [partition_start, partition_end) and rotate. False only translates (e.g. Partio files).
+/// @return Per-instance record of where its particles start and which prototype particles it kept.
+template <typename T>
+std::vector<GeometryInstance> replicate_instances(std::vector<std::array<T, 3>> &fields,
+                                                  const std::vector<std::array<T, 3>> &prototype,
+                                                  const std::vector<vec<T, 3>> &shifts, bool clip,
+                                                  vec<T, 3> partition_start, vec<T, 3> partition_end,
+                                                  const vec<T, 3, 3> &rotation, const vec<T, 3> &fulcrum) {
+  const int num_instances = static_cast<int>(shifts.size());
+  std::vector<GeometryInstance> instances(num_instances);
+  std::vector<std::vector<std::array<T, 3>>> positions(num_instances);
+  auto replicate = [&](int n) {
+    positions[n].reserve(prototype.size());
+    instances[n].kept.reserve(prototype.size());
+    for (int p = 0; p < (int)prototype.size(); ++p) {
+      std::array<T, 3> arr;
+      for (int d = 0; d < 3; ++d) arr[d] = prototype[p][d] + shifts[n][d];
+      if (clip) {
+        bool inside = true;
+        for (int d = 0; d < 3; ++d) inside = inside && arr[d] >= partition_start[d] && arr[d] < partition_end[d];
+        if (!inside) continue;
+        std::array<T, 3> tmp;
+        for (int d = 0; d < 3; ++d) tmp[d] = arr[d] - fulcrum[d];
+        matrixVectorMultiplication3d(rotation.data(), tmp.data(), arr.data());
+        for (int d = 0; d < 3; ++d) arr[d] += fulcrum[d];
+      }
+      positions[n].push_back(arr);
+      instances[n].kept.push_back(p);
+    }
+  };
+  unsigned num_threads = std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), num_instances));
+  std::vector<std::future<void>> jobs;
+  for (unsigned t = 0; t < num_threads; ++t)
+    jobs.emplace_back(reallyAsync([&, t]() {
+      for (int n = t; n < num_instances; n += num_threads) replicate(n); }));
+  for (auto &job : jobs) job.get();
+
+  std::size_t total = fields.size();
+  for (auto &pos : positions) total += pos.size();
+  fields.reserve(total);
+  for (int n = 0; n < num_instances; ++n) {
+    instances[n].begin = fields.size();
+    fields.insert(fields.end(), positions[n].begin(), positions[n].end());
+    std::vector<std::array<T, 3>>().swap(positions[n]);
+  }
+  return instances;
+}
+
+/// @brief Index in fields of prototype particle p within an instance, or -1 if that instance clipped it.
+inline long long instance_particle_index(const GeometryInstance &instance, int p) {
+  auto it = std::lower_bound(instance.kept.begin(), instance.kept.end(), p);
+  if (it == instance.kept.end() || *it != p) return -1;
+  return static_cast<long long>(instance.begin + (it - instance.kept.begin()));
+}
+
+} // namespace mn
+
+#endif
@@ -0,0 +1,244 @@
+#ifndef __MEMORY_PLANNER_H_
+#define __MEMORY_PLANNER_H_
+#include "buffer_layouts.h"
+#include "partitioner.h"
+#include "settings.cuh"
+#include <MnBase/DataStructure/Hash/Hash.cuh>
+#include <MnBase/Math/Bit/Bits.h>
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mn {
+
+/// @brief Host-side dry-run sizing of device memory for a scene (osu_lwf --plan).
+/// Mirrors the allocations of mgsp_benchmark (initParticles, initModel, init*Attribs) using only structural sizes, so no GPU is needed.
+/// Active grid-blocks follow register_exterior_blocks (3x3x3 around each particle block), halo blocks are those active on two devices.
+
+/// @brief Particle material of a body from its constitutive law and algorithm flags. Mirrors parse_scene. False if not supported.
+inline bool plan_material(const std::string &constitutive, bool use_ASFLIP, bool use_FBAR, material_e &mt) {
+  auto is = [&](std::initializer_list<const char *> names) {
+    for (auto n : names) if (constitutive == n) return true;
+    return false;
+  };
+  auto pick = [&](material_e none, material_e asflip, material_e fbar, material_e both) {
+    mt = use_ASFLIP ? (use_FBAR ? both : asflip) : (use_FBAR ? fbar : none);
+    return true;
+  };
+  if (is({"JFluid", "J-Fluid", "J_Fluid", "J Fluid", "jfluid", "j-fluid", "j_fluid", "j fluid", "Fluid", "fluid", "Water", "Liquid"}))
+    return pick(material_e::JFluid, material_e::JFluid_ASFLIP, material_e::JFluid_FBAR, material_e::JBarFluid);
+  if (is({"FixedCorotated", "Fixed_Corotated", "Fixed-Corotated", "Fixed Corotated", "fixedcorotated", "fixed_corotated", "fixed-corotated", "fixed corotated"}))
+    return pick(material_e::FixedCorotated, material_e::FixedCorotated_ASFLIP, material_e::FixedCorotated_FBAR, material_e::FixedCorotated_ASFLIP_FBAR);
+  if (is({"NeoHookean", "neohookean", "Neo-Hookean", "neo-hookean"}))
+    return pick(material_e::NeoHookean, material_e::NeoHookean_ASFLIP, material_e::NeoHookean_FBAR, material_e::NeoHookean_ASFLIP_FBAR);
+  if (is({"Sand", "sand", "DruckerPrager", "Drucker_Prager", "Drucker-Prager", "Drucker Prager"}))
+    return pick(material_e::Sand, material_e::Sand_ASFLIP, material_e::Sand_FBAR, material_e::Sand_ASFLIP_FBAR);
+  if (is({"NACC", "nacc", "CamClay", "Cam_Clay", "Cam-Clay", "Cam Clay"}))
+    return pick(material_e::NACC, material_e::NACC_ASFLIP, material_e::NACC_FBAR, material_e::NACC_ASFLIP_FBAR);
+  if (is({"VonMises", "Von_Mises", "Von-Mises", "Von Mises", "vonmises", "von_mises", "von-mises", "von mises"})) {
+    mt = material_e::VonMises;
+    return !use_ASFLIP && !use_FBAR;
+  }
+  if (is({"CoupledUP", "coupled", "up", "UP", "coupledup"})) {
+    mt = material_e::CoupledUP;
+    return use_ASFLIP && use_FBAR;
+  }
+  return false;
+}
+
+namespace detail {
+template <std::size_t... Is>
+std::size_t particle_bin_bytes(material_e mt, std::index_sequence<Is...>) {
+  constexpr std::size_t bytes[] = {particle_buffer_<particle_bin_<static_cast<material_e>(Is)>>::element_storage_size...};
+  return bytes[static_cast<std::size_t>(mt)];
+}
+} // namespace detail
+
+/// @brief Bytes of one particle bin (g_bin_capacity particles) of a material.
+inline std::size_t particle_bin_bytes(material_e mt) {
+  return detail::particle_bin_bytes(mt, std::make_index_sequence<static_cast<std::size_t>(material_e::Total)>{});
+}
+
+/// @brief Particle bins reserved per copy by mgsp_benchmark::initModel for a model of n particles.
+inline std::size_t planned_particle_bins(std::size_t n, std::size_t max_active_block) {
+  const float extra_particle_bins_ratio = 1.20f; //< Same as initModel
+  return std::max<std::size_t>((std::size_t)std::ceil(extra_particle_bins_ratio * (float)n / (float)config::g_bin_capacity), max_active_block);
+}
+
+struct ScenePlan {
+  struct Body {
+    int body_id = 0, gpu_id = 0, model_id = 0;
+    std::string constitutive;
+    material_e mt = material_e::JFluid;
+    bool supported = true; //< Material + algorithm combination exists
+    std::size_t particles = 0;
+    unsigned input_attribs = 1, output_attribs = 1;
+    std::size_t particle_blocks = 0; //< Grid-blocks holding particles
+    std::size_t occupied_bins = 0; //< Particle bins actually filled at start
+    int max_ppc = 0; //< Most particles in one cell
+    std::size_t max_ppb = 0; //< Most particles in one grid-block
+  };
+  uint64_t domain_cell_cnt = (uint64_t)config::g_grid_size_x * config::g_grid_size_y * config::g_grid_size_z; //< Partition _indexTable extent
+  config::SimCapacity capacity; //< Run-time capacity of scene, simulation:capacity
+  std::vector<Body> bodies;
+  std::unordered_set<uint64_t> particle_blocks[config::g_device_cnt]; //< Packed particle block keys per device
+
+  /// @brief Record a body of particles (1x1x1 domain positions) on its device.
+  template <typename T>
+  void add_body(Body body, const std::vector<std::array<T, 3>> &positions) {
+    std::unordered_map<uint64_t, int> cells;
+    std::unordered_map<uint64_t, std::size_t> blocks;
+    cells.reserve(positions.size() / 4 + 1);
+    for (auto &pos : positions) {
+      block_key_t cell;
+      for (int d = 0; d < 3; ++d) cell[d] = static_cast<int>(std::lround(pos[d] * config::g_dx_inv_d)) - 2;
+      auto &ppc = cells[pack_block_key(cell)];
+      body.max_ppc = std::max(body.max_ppc, ++ppc);
+      auto block = pack_block_key(particle_block_key(pos));
+      auto &ppb = blocks[block];
+      body.max_ppb = std::max(body.max_ppb, ++ppb);
+      particle_blocks[body.gpu_id].insert(block);
+    }
+    body.particles = positions.size();
+    body.particle_blocks = blocks.size();
+    for (auto &kv : blocks) body.occupied_bins += (kv.second + config::g_bin_capacity - 1) / config::g_bin_capacity;
+    bodies.push_back(std::move(body));
+  }
+
+  /// @brief Active grid-blocks of a device after register_exterior_blocks.
+  std::unordered_set<uint64_t> active_blocks(int did) const {
+    std::unordered_set<uint64_t> active;
+    active.reserve(particle_blocks[did].size() * 4);
+    for (auto key : particle_blocks[did]) {
+      auto b = unpack_block_key(key);
+      for (int i = -1; i < 2; ++i)
+        for (int j = -1; j < 2; ++j)
+          for (int k = -1; k < 2; ++k)
+            active.insert(pack_block_key(block_key_t{b[0] + i, b[1] + j, b[2] + k}));
+    }
+    return active;
+  }
+
+  /// @brief Print per-device estimates, buffer bytes, recommended settings.h values and overflows.
+  /// @return True if the scene fits the compiled capacities.
+  bool report() const {
+    using namespace config;
+    auto MB = [](std::size_t bytes) { return (double)bytes / 1000. / 1000.; };
+    auto line = [&](const char *name, std::size_t bytes, std::size_t recommended) {
+      fmt::print("  {:<28} {:>12.2f} MB {:>12.2f} MB\n", name, MB(bytes), MB(recommended));
+    };
+    bool fits = true;
+    auto overflow = [&](const std::string &msg) {
+      fits = false;
+      fmt::print(fg(fmt::color::red), "  OVERFLOW: {}", msg);
+    };
+
+    std::vector<std::unordered_set<uint64_t>> active(g_device_cnt);
+    for (int did = 0; did < g_device_cnt; ++did) active[did] = active_blocks(did);
+    std::size_t halo[g_device_cnt][g_device_cnt] = {};
+    std::size_t max_halo = 0, max_active = 0, max_particles = 0;
+    int max_ppc = 0;
+    for (int did = 0; did < g_device_cnt; ++did)
+      for (int other = did + 1; other < g_device_cnt; ++other) {
+        for (auto key : active[did]) halo[did][other] += active[other].count(key);
+        halo[other][did] = halo[did][other];
+        max_halo = std::max(max_halo, halo[did][other]);
+      }
+    for (int did = 0; did < g_device_cnt; ++did) max_active = std::max(max_active, active[did].size());
+    for (auto &body : bodies) max_particles = std::max(max_particles, body.particles), max_ppc = std::max(max_ppc, body.max_ppc);
+
+    // * Recommended capacities: 25% head-room for motion, rounded up
+    auto round_up = [](std::size_t v, std::size_t to) { return ((v + to - 1) / to) * to; };
+    const std::size_t rec_active_block = std::max<std::size_t>(1000, round_up(max_active * 5 / 4, 1000));
+    const std::size_t rec_halo_block = std::max<std::size_t>(1024, round_up(max_halo * 5 / 4, 1024));
+    const std::size_t rec_particle_num = round_up(std::max<std::size_t>(1, max_particles * 5 / 4), 100000);
+    const int rec_max_ppc = (int)next_power_of_two((uint32_t)std::max(2 * max_ppc, 1)); //< Room for compression
+
+    auto bucket_bytes = [](std::size_t max_active_block, std::size_t max_ppc) {
+      return sizeof(int) * max_active_block * (g_blockvolume + 1 + g_blockvolume * max_ppc + max_ppc * g_blockvolume + 1);
+    };
+    auto partition_bytes = [&](std::size_t max_active_block) {
+      std::size_t bytes = sizeof(block_partition_::value_t) + sizeof(block_partition_::key_t) * max_active_block; //< _cnt, _activeKeys
+      if (g_partition_block_hash) //< _blockHash
+        bytes += (sizeof(uint64_t) + sizeof(block_partition_::value_t)) * block_hash<block_partition_::value_t>::table_size(max_active_block);
+      else
+        bytes += sizeof(block_partition_::value_t) * domain_cell_cnt; //< _indexTable
+      bytes += sizeof(int) + (sizeof(char) + sizeof(int) + sizeof(ivec3)) * max_active_block; //< HaloPartition<1>
+      if (!g_buckets_on_particle_buffer) bytes += bucket_bytes(max_active_block, g_max_ppc);
+      return bytes;
+    };
+
+    fmt::print(fmt::emphasis::bold, "================================================================\n");
+    fmt::print(fmt::emphasis::bold, "Memory plan (dry-run, no device allocation)\n");
+    fmt::print("Compiled: g_device_cnt[{}] g_models_per_gpu[{}] g_max_halo_block[{}] DOMAIN_BITS[{}] MAX_PPC[{}] g_bin_capacity[{}] domain cells[{}]\n",
+               g_device_cnt, g_models_per_gpu, g_max_halo_block, g_domain_bits, g_max_ppc, g_bin_capacity, domain_cell_cnt);
+    fmt::print("Capacity: max_active_block[{}] max_particle_num[{}] devices[{}] models_per_gpu[{}]\n",
+               capacity.max_active_block, capacity.max_particle_num, capacity.device_cnt, capacity.models_per_gpu);
+    std::size_t total = 0, total_rec = 0;
+    for (int did = 0; did < g_device_cnt; ++did) {
+      fmt::print(fmt::emphasis::bold, "----------------------------------------------------------------\n");
+      std::size_t halo_sum = 0;
+      for (int other = 0; other < g_device_cnt; ++other) halo_sum += halo[did][other];
+      fmt::print(fg(fmt::color::cyan), "GPU[{}] particle blocks[{}] active grid-blocks[{}] halo grid-blocks[{}]\n",
+                 did, particle_blocks[did].size(), active[did].size(), halo_sum);
+      if (active[did].size() > capacity.max_active_block) overflow(fmt::format("GPU[{}] active grid-blocks[{}] > max_active_block[{}]\n", did, active[did].size(), capacity.max_active_block));
+      for (int other = 0; other < g_device_cnt; ++other)
+        if (halo[did][other] > g_max_halo_block) overflow(fmt::format("GPU[{}]-GPU[{}] halo grid-blocks[{}] > g_max_halo_block[{}]\n", did, other, halo[did][other], g_max_halo_block));
+
+      fmt::print("  {:<28} {:>15} {:>15}\n", "Buffer", "Capacity", "Recommended");
+      std::size_t dev = 0, dev_rec = 0;
+      auto add = [&](const char *name, std::size_t bytes, std::size_t recommended) {
+        line(name, bytes, recommended);
+        dev += bytes, dev_rec += recommended;
+      };
+      add("grid_block_ x2", 2 * grid_block_::size * capacity.max_active_block, 2 * grid_block_::size * rec_active_block);
+      add("Partition x2", 2 * partition_bytes(capacity.max_active_block), 2 * partition_bytes(rec_active_block));
+      add("Halo grid-blocks (in+out)", 2 * halo_sum * (halo_grid_blocks_::element_storage_size + sizeof(ivec3)),
+          2 * halo_sum * (halo_grid_blocks_::element_storage_size + sizeof(ivec3)));
+      add("Intermediates", sizeof(int) * (capacity.max_active_block * 5 + 6), sizeof(int) * (rec_active_block * 5 + 6));
+      int models_on_device = 0;
+      for (auto &body : bodies) {
+        if (body.gpu_id != did) continue;
+        ++models_on_device;
+        fmt::print(fg(fmt::color::cyan), "  MODEL[{}] body[{}] constitutive[{}] particles[{}] particle blocks[{}] bins filled[{}] max particles per cell[{}] per block[{}]\n",
+                   body.model_id, body.body_id, body.constitutive, body.particles, body.particle_blocks, body.occupied_bins, body.max_ppc, body.max_ppb);
+        if (!body.supported) overflow(fmt::format("MODEL[{}] constitutive[{}] with given use_ASFLIP/use_FBAR is not supported\n", body.model_id, body.constitutive));
+        if (body.particles > capacity.max_particle_num) overflow(fmt::format("MODEL[{}] particles[{}] > max_particle_num[{}]\n", body.model_id, body.particles, capacity.max_particle_num));
+        if (body.max_ppc > g_max_ppc) overflow(fmt::format("MODEL[{}] particles per cell[{}] > MAX_PPC[{}], extra particles are deleted\n", body.model_id, body.max_ppc, g_max_ppc));
+        const std::size_t bin = particle_bin_bytes(body.mt);
+        add("  particle_bin* x2", 2 * bin * planned_particle_bins(body.particles, capacity.max_active_block),
+            2 * bin * planned_particle_bins(body.particles, rec_active_block));
+        if (g_buckets_on_particle_buffer)
+          add("  particle buckets x2", 2 * bucket_bytes(capacity.max_active_block, g_max_ppc), 2 * bucket_bytes(rec_active_block, rec_max_ppc));
+        add("  ParticleArray", particle_array_::element_storage_size * body.particles, particle_array_::element_storage_size * body.particles);
+        add("  ParticleAttrib (in+out)", sizeof(PREC) * body.particles * (body.input_attribs + body.output_attribs),
+            sizeof(PREC) * body.particles * (body.input_attribs + body.output_attribs));
+      }
+      if (models_on_device > capacity.models_per_gpu) overflow(fmt::format("GPU[{}] models[{}] > models_per_gpu[{}]\n", did, models_on_device, capacity.models_per_gpu));
+      fmt::print(fmt::emphasis::bold, "  {:<28} {:>12.2f} MB {:>12.2f} MB\n", "Total", MB(dev), MB(dev_rec));
+      total += dev, total_rec += dev_rec;
+    }
+    fmt::print(fmt::emphasis::bold, "----------------------------------------------------------------\n");
+    fmt::print(fmt::emphasis::bold, "All GPUs: [{:.2f}] MB capacity, [{:.2f}] MB recommended. Excludes CUDA context, cub temp storage, FEM meshes, targets.\n", MB(total), MB(total_rec));
+    fmt::print(fg(fmt::color::yellow), "Recommended scene simulation:capacity: {{\"max_active_block\": {}, \"max_particle_num\": {}}}\n",
+               rec_active_block, rec_particle_num);
+    fmt::print(fg(fmt::color::yellow), "Recommended settings.h: g_max_halo_block = {};{}\n", rec_halo_block,
+               rec_max_ppc > g_max_ppc ? fmt::format(" MAX_PPC = {}; (or a build preset with -DMAX_PPC={})", rec_max_ppc, rec_max_ppc) : std::string{});
+    if (fits) fmt::print(fg(fmt::color::green), "Scene fits capacities.\n");
+    else fmt::print(fg(fmt::color::red), "Scene exceeds capacities. Raise simulation:capacity, or change settings.h and recompile.\n");
+    fmt::print(fmt::emphasis::bold, "================================================================\n");
+    return fits;
+  }
+};
+
+} // namespace mn
+
+#endif
@@ -290,9 +290,9 @@ __global__ void rasterize(uint32_t particleCount, const ParticleBuffer pbuffer,
 }
 
 
-template <typename ParticleBuffer, typename ParticleArray, num_attribs_e N, typename Grid, typename Partition>
+template <typename ParticleBuffer, typename ParticleArray, typename Grid, typename Partition>
 __global__ void rasterize(uint32_t particleCount, const ParticleBuffer pbuffer,
-                          const ParticleArray parray, const ParticleAttrib<N> pattrib,
+                          const ParticleArray parray, const ParticleAttrib pattrib,
                           Grid grid, const Partition partition, double dt, pvec3 vel0, PREC grav) {
   uint32_t parid = blockIdx.x * blockDim.x + threadIdx.x;
   if (parid >= particleCount) return;
@@ -400,10 +400,10 @@ __global__ void rasterize(uint32_t particleCount, const ParticleBuffer pbuffer,
 }
 
 // Specialize particle-to-grid rasterize for materials with initial input attributes
-template <typename ParticleArray, num_attribs_e N, typename Grid, typename Partition>
+template <typename ParticleArray, typename Grid, typename Partition>
 __global__ void rasterize(uint32_t particleCount, 
                           const ParticleBuffer<material_e::JBarFluid> pbuffer,
-                          const ParticleArray parray, const ParticleAttrib<N> pattrib,
+                          const ParticleArray parray, const ParticleAttrib pattrib,
                           Grid grid, const Partition partition, double dt, pvec3 vel0, PREC grav) {
   uint32_t parid = blockIdx.x * blockDim.x + threadIdx.x;
   if (parid >= particleCount)
@@ -547,10 +547,10 @@ __global__ void rasterize(uint32_t particleCount,
 
 
 // Specialize particle-to-grid rasterize for materials with initial input attributes
-template <typename ParticleArray, num_attribs_e N, typename Grid, typename Partition>
+template <typename ParticleArray, typename Grid, typename Partition>
 __global__ void rasterize(uint32_t particleCount, 
                           const ParticleBuffer<material_e::JFluid_FBAR> pbuffer,
-                          const ParticleArray parray, const ParticleAttrib<N> pattrib,
+                          const ParticleArray parray, const ParticleAttrib pattrib,
                           Grid grid, const Partition partition, double dt, pvec3 vel0, PREC grav) {
   uint32_t parid = blockIdx.x * blockDim.x + threadIdx.x;
   if (parid >= particleCount)
@@ -914,7 +914,7 @@ __global__ void array_to_buffer(ParticleArray parray,
 
 
 template <typename ParticleArray, typename Partition>
-__global__ void array_to_buffer(ParticleArray parray, ParticleAttrib<num_attribs_e::Six> pattribs,
+__global__ void array_to_buffer(ParticleArray parray, ParticleAttrib pattribs,
                                 ParticleBuffer<material_e::JFluid_ASFLIP> pbuffer,
                                 Partition partition, vec<PREC, 3> vel) {
   uint32_t blockno = blockIdx.x;
@@ -933,12 +933,17 @@ __global__ void array_to_buffer(ParticleArray parray, ParticleAttrib<num_attribs
     pbin.val(_0, pidib % g_bin_capacity) = parray.val(_0, parid);
     pbin.val(_1, pidib % g_bin_capacity) = parray.val(_1, parid);
     pbin.val(_2, pidib % g_bin_capacity) = parray.val(_2, parid);
+    // Attribs layout (sJ, Velocity_X, Velocity_Y, Velocity_Z, ...), defaults kept if not held
+    PREC sJ = 0.0;
+    pvec3 v{vel[0], vel[1], vel[2]};
+    getParticleAttrib(pattribs, 0, parid, sJ);
+    for (int d = 0; d < 3; ++d) getParticleAttrib(pattribs, d + 1, parid, v[d]);
     /// J
-    pbin.val(_3, pidib % g_bin_capacity) = pattribs.val(_0, parid); //< 1 - J , 1 - V/Vo, 
+    pbin.val(_3, pidib % g_bin_capacity) = sJ; //< 1 - J , 1 - V/Vo, 
     /// vel
-    pbin.val(_4, pidib % g_bin_capacity) = pattribs.val(_1, parid); //< Vel_x m/s
-    pbin.val(_5, pidib % g_bin_capacity) = pattribs.val(_2, parid); //< Vel_y m/s
-    pbin.val(_6, pidib % g_bin_capacity) = pattribs.val(_3, parid); //< Vel_z m/s 
+    pbin.val(_4, pidib % g_bin_capacity) = v[0]; //< Vel_x m/s
+    pbin.val(_5, pidib % g_bin_capacity) = v[1]; //< Vel_y m/s
+    pbin.val(_6, pidib % g_bin_capacity) = v[2]; //< Vel_z m/s 
   }
 }
 
@@ -971,7 +976,7 @@ __global__ void array_to_buffer(ParticleArray parray,
 
 
 template <typename ParticleArray, typename Partition>
-__global__ void array_to_buffer(ParticleArray parray, ParticleAttrib<num_attribs_e::Six> pattribs,
+__global__ void array_to_buffer(ParticleArray parray, ParticleAttrib pattribs,
                                 ParticleBuffer<material_e::JFluid_FBAR> pbuffer,
                                 Partition partition, vec<PREC, 3> vel) {
   uint32_t blockno = blockIdx.x;
@@ -991,9 +996,13 @@ __global__ void array_to_buffer(ParticleArray parray, ParticleAttrib<num_attribs
     pbin.val(_1, pidib % g_bin_capacity) = parray.val(_1, parid); // y
     pbin.val(_2, pidib % g_bin_capacity) = parray.val(_2, parid); // z
     // Uses same attribs layout as JBarFluid (sJ, Velocity_X, Velocity_Y, Velocity_Z, sJBar, ID)
-    pbin.val(_3, pidib % g_bin_capacity) = pattribs.val(_0, parid); //< (1 - J) = (1 - V/Vo)
-    pbin.val(_4, pidib % g_bin_capacity) = pattribs.val(_4, parid); //< (1 -JBar) : Simple FBAR 
-    pbin.val(_5, pidib % g_bin_capacity) = pattribs.val(_5, parid); //< ID
+    PREC sJ = 0.0, sJBar = 0.0, ID = (PREC)parid;
+    getParticleAttrib(pattribs, 0, parid, sJ);
+    getParticleAttrib(pattribs, 4, parid, sJBar);
+    getParticleAttrib(pattribs, 5, parid, ID);
+    pbin.val(_3, pidib % g_bin_capacity) = sJ; //< (1 - J) = (1 - V/Vo)
+    pbin.val(_4, pidib % g_bin_capacity) = sJBar; //< (1 -JBar) : Simple FBAR 
+    pbin.val(_5, pidib % g_bin_capacity) = ID; //< ID
   }
 }
 
@@ -1031,7 +1040,7 @@ __global__ void array_to_buffer(ParticleArray parray,
 
 
 template <typename ParticleArray, typename Partition>
-__global__ void array_to_buffer(ParticleArray parray, ParticleAttrib<num_attribs_e::Six> pattribs,
+__global__ void array_to_buffer(ParticleArray parray, ParticleAttrib pattribs,
                                 ParticleBuffer<material_e::JBarFluid> pbuffer,
                                 Partition partition, vec<PREC, 3> vel) {
   uint32_t blockno = blockIdx.x;
@@ -1050,16 +1059,23 @@ __global__ void array_to_buffer(ParticleArray parray, ParticleAttrib<num_attribs
     pbin.val(_0, pidib % g_bin_capacity) = parray.val(_0, parid);
     pbin.val(_1, pidib % g_bin_capacity) = parray.val(_1, parid);
     pbin.val(_2, pidib % g_bin_capacity) = parray.val(_2, parid);
+    // Attribs layout (sJ, Velocity_X, Velocity_Y, Velocity_Z, sJBar, ID), defaults kept if not held
+    PREC sJ = 0.0, sJBar = 0.0, ID = (PREC)parid;
+    pvec3 v{vel[0], vel[1], vel[2]};
+    getParticleAttrib(pattribs, 0, parid, sJ);
+    for (int d = 0; d < 3; ++d) getParticleAttrib(pattribs, d + 1, parid, v[d]);
+    getParticleAttrib(pattribs, 4, parid, sJBar);
+    getParticleAttrib(pattribs, 5, parid, ID);
     /// 1 - J
-    pbin.val(_3, pidib % g_bin_capacity) = pattribs.val(_0, parid); //< (1 - J) = (1 - V/Vo)
+    pbin.val(_3, pidib % g_bin_capacity) = sJ; //< (1 - J) = (1 - V/Vo)
     /// vel (ASFLIP)
-    pbin.val(_4, pidib % g_bin_capacity) = pattribs.val(_1, parid); //< Vel_x m/s
-    pbin.val(_5, pidib % g_bin_capacity) = pattribs.val(_2, parid); //< Vel_y m/s
-    pbin.val(_6, pidib % g_bin_capacity) = pattribs.val(_3, parid); //< Vel_z m/s
+    pbin.val(_4, pidib % g_bin_capacity) = v[0]; //< Vel_x m/s
+    pbin.val(_5, pidib % g_bin_capacity) = v[1]; //< Vel_y m/s
+    pbin.val(_6, pidib % g_bin_capacity) = v[2]; //< Vel_z m/s
     /// 1 - JBar (Simple FBar)
-    pbin.val(_7, pidib % g_bin_capacity) = pattribs.val(_4, parid); //< 1 - JBar
+    pbin.val(_7, pidib % g_bin_capacity) = sJBar; //< 1 - JBar
 
-    pbin.val(_8, pidib % g_bin_capacity) = pattribs.val(_5, parid); //< ID
+    pbin.val(_8, pidib % g_bin_capacity) = ID; //< ID
   }
 }
 
@@ -1843,7 +1859,7 @@ __global__ void update_grid_velocity_query_max(uint32_t blockCount, Grid grid,
                                                float *maxVel, double curTime, pvec3 grav, 
                                                vec<vec7, boundary_cnt> boundary_array,
                                                struct GridBoundaryConfigs * gridBoundary_array, 
-                                               vec3 boundary_motion, PREC length, double fr_scale) {
+                                               vec<MotionState, g_max_grid_boundaries> boundary_motion, PREC length, double fr_scale) {
   constexpr int bc = g_bc;
   constexpr int numWarps =
       g_num_grid_blocks_per_cuda_block * g_num_warps_per_grid_block; // Num. warps per block
@@ -1862,9 +1878,9 @@ __global__ void update_grid_velocity_query_max(uint32_t blockCount, Grid grid,
   if (blockno < blockCount) 
   {
     auto blockid = partition._activeKeys[blockno];
-    int isInBuffer = ((blockid[0] < bc || blockid[0] >= g_grid_size_x - bc) << 2) |
-                     ((blockid[1] < bc || blockid[1] >= g_grid_size_y - bc) << 1) |
-                     ((blockid[2] < bc || blockid[2] >= g_grid_size_z - bc));
+    int isInBuffer = ((blockid[0] < bc || blockid[0] >= partition._gridExtent[0] - bc) << 2) |
+                     ((blockid[1] < bc || blockid[1] >= partition._gridExtent[1] - bc) << 1) |
+                     ((blockid[2] < bc || blockid[2] >= partition._gridExtent[2] - bc));
     auto grid_block = grid.ch(_0, blockno);
     PREC_G velSqr = 0.f;
 
@@ -2292,6 +2308,7 @@ __global__ void update_grid_velocity_query_max(uint32_t blockCount, Grid grid,
 
           // Read grid boundary data
           auto gb = gridBoundary_array[g];
+          const auto &motion = boundary_motion[g]; // Motion of this grid-boundary at curTime (motion_table.h)
 
           // Check if boundary is active
           if ((curTime < gb._time[0]) || (curTime > gb._time[1])) continue;
@@ -2522,12 +2539,12 @@ __global__ void update_grid_velocity_query_max(uint32_t blockCount, Grid grid,
             //PREC_G wave_maker_neutral = (1.915f); // Streamwise offset from origin (m)
             // TODO: Run-time wave_maker_neutral X position
             PREC_G wave_maker_neutral = gb._domain_end[0] - o; // Streamwise offset from origin (m), already froude scaled
-            if (xc <= ((boundary_motion[1]) / l + (wave_maker_neutral)) + o) {
+            if (xc <= ((motion[(int)motion_e::DispX]) / l + (wave_maker_neutral)) + o) {
               // TODO: Add reflection and/or decay layer?
               if (gb._contact == boundary_contact_t::Separable) {
-                  if (vel[0] < boundary_motion[2] / l) vel[0] = boundary_motion[2] / l; 
+                  if (vel[0] < motion[(int)motion_e::VelX] / l) vel[0] = motion[(int)motion_e::VelX] / l; 
               } else if (gb._contact == boundary_contact_t::Slip) {
-                  vel[0] = boundary_motion[2] / l; 
+                  vel[0] = motion[(int)motion_e::VelX] / l; 
               }
               // if (vel[1] < boundary_motion.vy / l) vel[1] = boundary_motion.vy / l;
               // if (vel[2] < boundary_motion.vz / l) vel[2] = boundary_motion.vz / l;
@@ -2537,14 +2554,14 @@ __global__ void update_grid_velocity_query_max(uint32_t blockCount, Grid grid,
             // OSU Wave-Maker - CSV Controlled
             // TODO: Run-time wave_maker_neutral X position
             PREC_G wave_maker_neutral = -0.f * fr_scale; // Streamwise offset from origin (m)
-            if (xc <= (boundary_motion[1] - wave_maker_neutral) / l + o) {
+            if (xc <= (motion[(int)motion_e::DispX] - wave_maker_neutral) / l + o) {
               // TODO: Add reflection and/or decay layer?
 #if 1 // Slip vel. (YES seperable)
-              if (vel[0] < boundary_motion[2] / l) vel[0] = boundary_motion[2] / l; 
+              if (vel[0] < motion[(int)motion_e::VelX] / l) vel[0] = motion[(int)motion_e::VelX] / l; 
               // if (vel[1] < boundary_motion.vy / l) vel[1] = boundary_motion.vy / l;
               // if (vel[2] < boundary_motion.vz / l) vel[2] = boundary_motion.vz / l;
 #else // Slip vel. (NO seperable) 
-              vel[0] = (boundary_motion[2] / l); // Slip vel. (NO seperable)
+              vel[0] = (motion[(int)motion_e::VelX] / l); // Slip vel. (NO seperable)
 #endif
             }
           } else if (gb._object == boundary_object_t::OSU_TWB_RAMP && (gb._num_bathymetry_points == 0)) {
@@ -3072,9 +3089,9 @@ __global__ void update_grid_velocity_query_max(uint32_t blockCount, Grid grid,
   {
 
     auto blockid = partition._activeKeys[blockno];
-    int isInBound = ((blockid[0] < bc || blockid[0] >= g_grid_size_x - bc) << 2) |
-                    ((blockid[1] < bc || blockid[1] >= g_grid_size_y - bc) << 1) |
-                     (blockid[2] < bc || blockid[2] >= g_grid_size_z - bc);
+    int isInBound = ((blockid[0] < bc || blockid[0] >= partition._gridExtent[0] - bc) << 2) |
+                    ((blockid[1] < bc || blockid[1] >= partition._gridExtent[1] - bc) << 1) |
+                     (blockid[2] < bc || blockid[2] >= partition._gridExtent[2] - bc);
 
     /// within-warp computations
     auto grid_block = grid.ch(_0, blockno);
@@ -3186,7 +3203,7 @@ __global__ void query_energy_grid(uint32_t blockCount, Grid grid, Partition part
                                   PREC_G *sumKinetic, PREC_G *sumGravity, 
                                   double curTime, pvec3 grav, 
                                   vec<vec7, g_max_grid_boundaries> boundary_array, 
-                                  vec3 boundary_motion, PREC length) {
+                                  vec<MotionState, g_max_grid_boundaries> boundary_motion, PREC length) {
   constexpr int numWarps =
       g_num_grid_blocks_per_cuda_block * g_num_warps_per_grid_block;
   constexpr unsigned activeMask = 0xffffffff;
@@ -17945,374 +17962,20 @@ __global__ void check_partition_domain(uint32_t blockCount, int did,
 }
 
 
-template<num_attribs_e N, typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<N> pattrib, I i, T parid, PREC val)
-{ }
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Zero> pattrib, I i, T parid, PREC val) { }
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::One> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-}
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Two> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-  else if (i == 1) pattrib.val(_1, parid) = val; 
-}
-
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Three> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-  else if (i == 1) pattrib.val(_1, parid) = val; 
-  else if (i == 2) pattrib.val(_2, parid) = val; 
-}
-
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Four> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-  else if (i == 1) pattrib.val(_1, parid) = val; 
-  else if (i == 2) pattrib.val(_2, parid) = val; 
-  else if (i == 3) pattrib.val(_3, parid) = val; 
-}
-
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Five> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-  else if (i == 1) pattrib.val(_1, parid) = val; 
-  else if (i == 2) pattrib.val(_2, parid) = val; 
-  else if (i == 3) pattrib.val(_3, parid) = val; 
-  else if (i == 4) pattrib.val(_4, parid) = val; 
-}
-
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Six> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-  else if (i == 1) pattrib.val(_1, parid) = val; 
-  else if (i == 2) pattrib.val(_2, parid) = val; 
-  else if (i == 3) pattrib.val(_3, parid) = val; 
-  else if (i == 4) pattrib.val(_4, parid) = val; 
-  else if (i == 5) pattrib.val(_5, parid) = val; 
-}
-
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Seven> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-  else if (i == 1) pattrib.val(_1, parid) = val; 
-  else if (i == 2) pattrib.val(_2, parid) = val; 
-  else if (i == 3) pattrib.val(_3, parid) = val; 
-  else if (i == 4) pattrib.val(_4, parid) = val; 
-  else if (i == 5) pattrib.val(_5, parid) = val; 
-  else if (i == 6) pattrib.val(_6, parid) = val; 
-}
-
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Eight> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-  else if (i == 1) pattrib.val(_1, parid) = val; 
-  else if (i == 2) pattrib.val(_2, parid) = val; 
-  else if (i == 3) pattrib.val(_3, parid) = val; 
-  else if (i == 4) pattrib.val(_4, parid) = val; 
-  else if (i == 5) pattrib.val(_5, parid) = val; 
-  else if (i == 6) pattrib.val(_6, parid) = val; 
-  else if (i == 7) pattrib.val(_7, parid) = val; 
-}
-
-
-template<typename I, typename T>
-__device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Nine> pattrib, I i, T parid, PREC val)
-{
-  if      (i == 0) pattrib.val(_0, parid) = val; 
-  else if (i == 1) pattrib.val(_1, parid) = val; 
-  else if (i == 2) pattrib.val(_2, parid) = val; 
-  else if (i == 3) pattrib.val(_3, parid) = val; 
-  else if (i == 4) pattrib.val(_4, parid) = val; 
-  else if (i == 5) pattrib.val(_5, parid) = val; 
-  else if (i == 6) pattrib.val(_6, parid) = val; 
-  else if (i == 7) pattrib.val(_7, parid) = val; 
-  else if (i == 8) pattrib.val(_8, parid) = val; 
-}
-
-
-// template<typename I, typename T>
-// __device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Ten> pattrib, I i, T parid, PREC val)
-// {
-//   if      (i == 0) pattrib.val(_0, parid) = val; 
-//   else if (i == 1) pattrib.val(_1, parid) = val; 
-//   else if (i == 2) pattrib.val(_2, parid) = val; 
-//   else if (i == 3) pattrib.val(_3, parid) = val; 
-//   else if (i == 4) pattrib.val(_4, parid) = val; 
-//   else if (i == 5) pattrib.val(_5, parid) = val; 
-//   else if (i == 6) pattrib.val(_6, parid) = val; 
-//   else if (i == 7) pattrib.val(_7, parid) = val; 
-//   else if (i == 8) pattrib.val(_8, parid) = val; 
-//   else if (i == 9) pattrib.val(_9, parid) = val; 
-// }
-
-// template<typename I, typename T>
-// __device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Eleven> pattrib, I i, T parid, PREC val)
-// {
-//   if      (i == 0) pattrib.val(_0, parid) = val; 
-//   else if (i == 1) pattrib.val(_1, parid) = val; 
-//   else if (i == 2) pattrib.val(_2, parid) = val; 
-//   else if (i == 3) pattrib.val(_3, parid) = val; 
-//   else if (i == 4) pattrib.val(_4, parid) = val; 
-//   else if (i == 5) pattrib.val(_5, parid) = val; 
-//   else if (i == 6) pattrib.val(_6, parid) = val; 
-//   else if (i == 7) pattrib.val(_7, parid) = val; 
-//   else if (i == 8) pattrib.val(_8, parid) = val; 
-//   else if (i == 9) pattrib.val(_9, parid) = val; 
-//   else if (i == 11) pattrib.val(_10, parid) = val; 
-// }
-
-// template<typename I, typename T>
-// __device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Twelve> pattrib, I i, T parid, PREC val)
-// {
-//   if      (i == 0) pattrib.val(_0, parid) = val; 
-//   else if (i == 1) pattrib.val(_1, parid) = val; 
-//   else if (i == 2) pattrib.val(_2, parid) = val; 
-//   else if (i == 3) pattrib.val(_3, parid) = val; 
-//   else if (i == 4) pattrib.val(_4, parid) = val; 
-//   else if (i == 5) pattrib.val(_5, parid) = val; 
-//   else if (i == 6) pattrib.val(_6, parid) = val; 
-//   else if (i == 7) pattrib.val(_7, parid) = val; 
-//   else if (i == 8) pattrib.val(_8, parid) = val; 
-//   else if (i == 9) pattrib.val(_9, parid) = val; 
-//   else if (i == 10) pattrib.val(_10, parid) = val; 
-//   else if (i == 11) pattrib.val(_11, parid) = val; 
-// }
-// template<typename I, typename T>
-// __device__ void setParticleAttrib(ParticleAttrib<num_attribs_e::Thirteen> pattrib, I i, T parid, PREC val)
-// {
-//   if      (i == 0) pattrib.val(_0, parid) = val; 
-//   else if (i == 1) pattrib.val(_1, parid) = val; 
-//   else if (i == 2) pattrib.val(_2, parid) = val; 
-//   else if (i == 3) pattrib.val(_3, parid) = val; 
-//   else if (i == 4) pattrib.val(_4, parid) = val; 
-//   else if (i == 5) pattrib.val(_5, parid) = val; 
-//   else if (i == 6) pattrib.val(_6, parid) = val; 
-//   else if (i == 7) pattrib.val(_7, parid) = val; 
-//   else if (i == 8) pattrib.val(_8, parid) = val; 
-//   else if (i == 9) pattrib.val(_9, parid) = val; 
-//   else if (i == 10) pattrib.val(_10, parid) = val; 
-//   else if (i == 11) pattrib.val(_11, parid) = val; 
-//   else if (i == 12) pattrib.val(_12, parid) = val; 
-// }
-// template<typename I, typename T>
-// __device__ void setParticleAttrib(ParticleAttrib<15> pattrib, I i, T parid, PREC val)
-// {
-//   if      (i == 0) pattrib.val(_0, parid) = val; 
-//   else if (i == 1) pattrib.val(_1, parid) = val; 
-//   else if (i == 2) pattrib.val(_2, parid) = val; 
-//   else if (i == 3) pattrib.val(_3, parid) = val; 
-//   else if (i == 4) pattrib.val(_4, parid) = val; 
-//   else if (i == 5) pattrib.val(_5, parid) = val; 
-//   else if (i == 6) pattrib.val(_6, parid) = val; 
-//   else if (i == 7) pattrib.val(_7, parid) = val; 
-//   else if (i == 8) pattrib.val(_8, parid) = val; 
-//   else if (i == 9) pattrib.val(_9, parid) = val; 
-//   else if (i == 10) pattrib.val(_10, parid) = val; 
-//   else if (i == 11) pattrib.val(_11, parid) = val; 
-//   else if (i == 12) pattrib.val(_12, parid) = val; 
-//   else if (i == 13) pattrib.val(_13, parid) = val; 
-//   else if (i == 14) pattrib.val(_14, parid) = val; 
-// }
-// template<typename I, typename T>
-// __device__ void setParticleAttrib(ParticleAttrib<24> pattrib, I i, T parid, PREC val)
-// {
-//   if      (i == 0) pattrib.val(_0, parid) = val; 
-//   else if (i == 1) pattrib.val(_1, parid) = val; 
-//   else if (i == 2) pattrib.val(_2, parid) = val; 
-//   else if (i == 3) pattrib.val(_3, parid) = val; 
-//   else if (i == 4) pattrib.val(_4, parid) = val; 
-//   else if (i == 5) pattrib.val(_5, parid) = val; 
-//   else if (i == 6) pattrib.val(_6, parid) = val; 
-//   else if (i == 7) pattrib.val(_7, parid) = val; 
-//   else if (i == 8) pattrib.val(_8, parid) = val; 
-//   else if (i == 9) pattrib.val(_9, parid) = val; 
-//   else if (i == 10) pattrib.val(_10, parid) = val; 
-//   else if (i == 11) pattrib.val(_11, parid) = val; 
-//   else if (i == 12) pattrib.val(_12, parid) = val; 
-//   else if (i == 13) pattrib.val(_13, parid) = val; 
-//   else if (i == 14) pattrib.val(_14, parid) = val; 
-//   else if (i == 15) pattrib.val(_15, parid) = val; 
-//   else if (i == 16) pattrib.val(_16, parid) = val; 
-//   else if (i == 17) pattrib.val(_17, parid) = val; 
-//   else if (i == 18) pattrib.val(_18, parid) = val; 
-//   else if (i == 19) pattrib.val(_19, parid) = val; 
-//   else if (i == 20) pattrib.val(_20, parid) = val; 
-//   else if (i == 21) pattrib.val(_21, parid) = val; 
-//   else if (i == 22) pattrib.val(_22, parid) = val; 
-//   else if (i == 23) pattrib.val(_23, parid) = val; 
-// }
-
-
-template<num_attribs_e N, typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<N> pattrib, I i, T parid, PREC& val)
-{ }
-template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Zero> pattrib, I i, T parid, PREC&val) { }
-template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::One> pattrib, I i, T parid, PREC&val)
-{
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-}
-template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Two> pattrib, I i, T parid, PREC&val)
-{
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-  else if (i == 1) val = pattrib.val(_1, parid) ; 
-}
-template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Three> pattrib, I i, T parid, PREC&val)
-{
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-  else if (i == 1) val = pattrib.val(_1, parid) ; 
-  else if (i == 2) val = pattrib.val(_2, parid) ; 
-}
-
-template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Four> pattrib, I i, T parid, PREC&val)
-{
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-  else if (i == 1) val = pattrib.val(_1, parid) ; 
-  else if (i == 2) val = pattrib.val(_2, parid) ; 
-  else if (i == 3) val = pattrib.val(_3, parid) ; 
-}
-
-template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Five> pattrib, I i, T parid, PREC&val)
-{
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-  else if (i == 1) val = pattrib.val(_1, parid) ; 
-  else if (i == 2) val = pattrib.val(_2, parid) ; 
-  else if (i == 3) val = pattrib.val(_3, parid) ; 
-  else if (i == 4) val = pattrib.val(_4, parid) ; 
-}
-
+/// Write attribute i of particle parid. No-op if the buffer does not hold attribute i.
 template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Six> pattrib, I i, T parid, PREC& val)
+__device__ void setParticleAttrib(ParticleAttrib pattrib, I i, T parid, PREC val)
 {
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-  else if (i == 1) val = pattrib.val(_1, parid) ; 
-  else if (i == 2) val = pattrib.val(_2, parid) ; 
-  else if (i == 3) val = pattrib.val(_3, parid) ; 
-  else if (i == 4) val = pattrib.val(_4, parid) ; 
-  else if (i == 5) val = pattrib.val(_5, parid) ; 
+  if (static_cast<unsigned>(i) < pattrib.numAttributes) pattrib.val(i, parid) = val;
 }
 
+/// Read attribute i of particle parid. Leaves val unchanged if the buffer does not hold attribute i.
 template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Seven> pattrib, I i, T parid, PREC& val)
+__device__ void getParticleAttrib(ParticleAttrib pattrib, I i, T parid, PREC& val)
 {
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-  else if (i == 1) val = pattrib.val(_1, parid) ; 
-  else if (i == 2) val = pattrib.val(_2, parid) ; 
-  else if (i == 3) val = pattrib.val(_3, parid) ; 
-  else if (i == 4) val = pattrib.val(_4, parid) ; 
-  else if (i == 5) val = pattrib.val(_5, parid) ; 
-  else if (i == 6) val = pattrib.val(_6, parid) ; 
+  if (static_cast<unsigned>(i) < pattrib.numAttributes) val = pattrib.val(i, parid);
 }
 
-template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Eight> pattrib, I i, T parid, PREC& val)
-{
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-  else if (i == 1) val = pattrib.val(_1, parid) ; 
-  else if (i == 2) val = pattrib.val(_2, parid) ; 
-  else if (i == 3) val = pattrib.val(_3, parid) ; 
-  else if (i == 4) val = pattrib.val(_4, parid) ; 
-  else if (i == 5) val = pattrib.val(_5, parid) ; 
-  else if (i == 6) val = pattrib.val(_6, parid) ; 
-  else if (i == 7) val = pattrib.val(_7, parid) ; 
-}
-
-template<typename I, typename T>
-__device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Nine> pattrib, I i, T parid, PREC& val)
-{
-  if      (i == 0) val = pattrib.val(_0, parid) ; 
-  else if (i == 1) val = pattrib.val(_1, parid) ; 
-  else if (i == 2) val = pattrib.val(_2, parid) ; 
-  else if (i == 3) val = pattrib.val(_3, parid) ; 
-  else if (i == 4) val = pattrib.val(_4, parid) ; 
-  else if (i == 5) val = pattrib.val(_5, parid) ; 
-  else if (i == 6) val = pattrib.val(_6, parid) ; 
-  else if (i == 7) val = pattrib.val(_7, parid) ; 
-  else if (i == 8) val = pattrib.val(_8, parid) ; 
-}
-
-// template<typename I, typename T>
-// __device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Ten> pattrib, I i, T parid, PREC& val)
-// {
-//   if      (i == 0) val = pattrib.val(_0, parid) ; 
-//   else if (i == 1) val = pattrib.val(_1, parid) ; 
-//   else if (i == 2) val = pattrib.val(_2, parid) ; 
-//   else if (i == 3) val = pattrib.val(_3, parid) ; 
-//   else if (i == 4) val = pattrib.val(_4, parid) ; 
-//   else if (i == 5) val = pattrib.val(_5, parid) ; 
-//   else if (i == 6) val = pattrib.val(_6, parid) ; 
-//   else if (i == 7) val = pattrib.val(_7, parid) ; 
-//   else if (i == 8) val = pattrib.val(_8, parid) ; 
-//   else if (i == 9) val = pattrib.val(_9, parid) ; 
-// }
-
-// template<typename I, typename T>
-// __device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Eleven> pattrib, I i, T parid, PREC& val)
-// {
-//   if      (i == 0) val = pattrib.val(_0, parid) ; 
-//   else if (i == 1) val = pattrib.val(_1, parid) ; 
-//   else if (i == 2) val = pattrib.val(_2, parid) ; 
-//   else if (i == 3) val = pattrib.val(_3, parid) ; 
-//   else if (i == 4) val = pattrib.val(_4, parid) ; 
-//   else if (i == 5) val = pattrib.val(_5, parid) ; 
-//   else if (i == 6) val = pattrib.val(_6, parid) ; 
-//   else if (i == 7) val = pattrib.val(_7, parid) ; 
-//   else if (i == 8) val = pattrib.val(_8, parid) ; 
-//   else if (i == 9) val = pattrib.val(_9, parid) ; 
-//   else if (i == 10) val = pattrib.val(_10, parid) ; 
-// }
-
-// template<typename I, typename T>
-// __device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Twelve> pattrib, I i, T parid, PREC& val)
-// {
-//   if      (i == 0) val = pattrib.val(_0, parid) ; 
-//   else if (i == 1) val = pattrib.val(_1, parid) ; 
-//   else if (i == 2) val = pattrib.val(_2, parid) ; 
-//   else if (i == 3) val = pattrib.val(_3, parid) ; 
-//   else if (i == 4) val = pattrib.val(_4, parid) ; 
-//   else if (i == 5) val = pattrib.val(_5, parid) ; 
-//   else if (i == 6) val = pattrib.val(_6, parid) ; 
-//   else if (i == 7) val = pattrib.val(_7, parid) ; 
-//   else if (i == 8) val = pattrib.val(_8, parid) ; 
-//   else if (i == 9) val = pattrib.val(_9, parid) ; 
-//   else if (i == 10) val = pattrib.val(_10, parid) ; 
-//   else if (i == 11) val = pattrib.val(_11, parid) ; 
-// }
-
-// template<typename I, typename T>
-// __device__ void getParticleAttrib(ParticleAttrib<num_attribs_e::Thirteen> pattrib, I i, T parid, PREC& val)
-// {
-//   if      (i == 0) val = pattrib.val(_0, parid) ; 
-//   else if (i == 1) val = pattrib.val(_1, parid) ; 
-//   else if (i == 2) val = pattrib.val(_2, parid) ; 
-//   else if (i == 3) val = pattrib.val(_3, parid) ; 
-//   else if (i == 4) val = pattrib.val(_4, parid) ; 
-//   else if (i == 5) val = pattrib.val(_5, parid) ;
-//   else if (i == 6) val = pattrib.val(_6, parid) ; 
-//   else if (i == 7) val = pattrib.val(_7, parid) ; 
-//   else if (i == 8) val = pattrib.val(_8, parid) ; 
-//   else if (i == 9) val = pattrib.val(_9, parid) ; 
-//   else if (i == 10) val = pattrib.val(_10, parid) ; 
-//   else if (i == 11) val = pattrib.val(_11, parid) ; 
-//   else if (i == 12) val = pattrib.val(_12, parid) ; 
-// }
-
 template <typename ParticleBuffer, typename T, typename I>
 __device__ void caseSwitch_ParticleAttrib(ParticleBuffer pbuffer, T _source_bin, T _source_pidib, I idx, PREC& val) { }
 
@@ -18527,13 +18190,13 @@ __global__ void retrieve_particle_buffer(Partition partition, Partition prev_par
   }
 }
 
-template <typename Partition, typename ParticleBuffer, typename ParticleArray, num_attribs_e N, typename ParticleTarget>
+template <typename Partition, typename ParticleBuffer, typename ParticleArray, typename ParticleTarget>
 __global__ void
 retrieve_particle_buffer_attributes_general(Partition partition,
                                         Partition prev_partition,
                                         ParticleBuffer pbuffer, ParticleBuffer next_pbuffer,
                                         ParticleArray parray, 
-                                        ParticleAttrib<N> pattrib,
+                                        ParticleAttrib pattrib,
                                         PREC *trackVal, 
                                         int *_parcnt, 
                                         ParticleTarget particleTarget,
@@ -18543,13 +18206,13 @@ retrieve_particle_buffer_attributes_general(Partition partition,
 
 }
 
-template <typename Partition, material_e mt, typename ParticleArray, num_attribs_e N, typename ParticleTarget>
+template <typename Partition, material_e mt, typename ParticleArray, typename ParticleTarget>
 __global__ void
 retrieve_particle_buffer_attributes_general(Partition partition,
                                         Partition prev_partition,
                                         ParticleBuffer<mt> pbuffer, ParticleBuffer<mt> next_pbuffer,
                                         ParticleArray parray, 
-                                        ParticleAttrib<N> pattrib,
+                                        ParticleAttrib pattrib,
                                         PREC *trackVal, 
                                         int *_parcnt, 
                                         ParticleTarget particleTarget,
@@ -18623,12 +18286,9 @@ retrieve_particle_buffer_attributes_general(Partition partition,
     auto global_particle_ID = pbuffer.getAttribute<attribs_e_::ID>(_source_bin, _source_pidib);
 
     if (!output_pt) {
-      vec<int,static_cast<int>(N)> output_attribs; // =  pbuffer.output_attribs;
-      for (int j = 0; j < static_cast<int>(N);j++) output_attribs[j]= pbuffer.output_attribs_dyn[j];
-      for (unsigned i=0; i < static_cast<unsigned>(N); i++ ) {
-        const unsigned I = i;
-        if (I < sizeof(pbuffer.output_attribs_dyn) / sizeof(int)) {
-          output_e_ idx = static_cast<output_e_>(output_attribs[i]); //< Map index for output 
+      for (unsigned i=0; i < pattrib.numAttributes; i++ ) {
+        if (i < sizeof(pbuffer.output_attribs_dyn) / sizeof(int)) {
+          output_e_ idx = static_cast<output_e_>(pbuffer.output_attribs_dyn[i]); //< Map index for output 
           PREC val;
           caseSwitch_ParticleAttrib<mt>(pbuffer, _source_bin, _source_pidib, idx, val);
           setParticleAttrib(pattrib, i, parid, val);
@@ -18819,13 +18479,13 @@ retrieve_particle_target_attributes_general(Partition partition,
 /// @brief Functions to retrieve particle attributes.
 /// Copies from particle buffer to particle arrays (device --> device)
 /// Depends on material model, copy/paste/modify function for new materials
-template <typename Partition, typename ParticleBuffer, typename ParticleArray, num_attribs_e N, typename ParticleTarget>
+template <typename Partition, typename ParticleBuffer, typename ParticleArray, typename ParticleTarget>
 __global__ void
 retrieve_particle_buffer_attributes(Partition partition,
                                         Partition prev_partition,
                                         ParticleBuffer pbuffer,
                                         ParticleArray parray, 
-                                        ParticleAttrib<N> pattrib,
+                                        ParticleAttrib pattrib,
                                         PREC *trackVal, 
                                         int *_parcnt, 
                                         ParticleTarget particleTarget,
@@ -18834,13 +18494,13 @@ retrieve_particle_buffer_attributes(Partition partition,
                                         int *_targetcnt, bool output_pt=false) { }
 
 // TODO: Refactor all the Meshed outputs
-template <typename Partition, typename ParticleArray, num_attribs_e N, typename ParticleTarget>
+template <typename Partition, typename ParticleArray, typename ParticleTarget>
 __global__ void
 retrieve_particle_buffer_attributes(Partition partition,
                                          Partition prev_partition,
                                          ParticleBuffer<material_e::Meshed> pbuffer,
                                          ParticleArray parray, 
-                                         ParticleAttrib<N> pattrib,
+                                         ParticleAttrib pattrib,
                                          PREC *trackVal, 
                                          int *_parcnt, 
                                          ParticleTarget particleTarget,
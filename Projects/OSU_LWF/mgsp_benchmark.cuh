@@ -7,6 +7,7 @@
 #include "grid_buffer.cuh"
 #include "fem_buffer.cuh"
 #include "mgmpm_kernels.cuh"
+#include "motion_table.h"
 #include "particle_buffer.cuh"
 #include "settings.cuh"
 #include <MnBase/Concurrency/Concurrency.h>
@@ -20,6 +21,7 @@
 #include <fmt/color.h>
 #include <fmt/core.h>
 #include <array>
+#include <fstream>
 #include <vector>
 #include <numeric>
 
@@ -38,15 +40,21 @@ struct mgsp_benchmark {
     int device_alloc_cnt = 0;
     void *allocate(std::size_t bytes) {
       void *ret;
-      checkCudaErrors(cudaMalloc(&ret, bytes));
+      if (g_device_memory_pool) ret = pooled_device_memory_resource::instance().allocate(bytes); //< Cached size classes, see settings.h
+      else checkCudaErrors(cudaMalloc(&ret, bytes));
       device_alloc_cnt++;
-      fmt::print("device_allocator: cudaMalloc [{}] megabytes to ptr[{}]. Depth [{}]\n", (float)bytes / 1000 / 1000, ret, device_alloc_cnt);
+      fmt::print("device_allocator: {} [{}] megabytes to ptr[{}]. Depth [{}]\n", g_device_memory_pool ? "pool" : "cudaMalloc", (float)bytes / 1000 / 1000, ret, device_alloc_cnt);
       return ret;
     }
-    void deallocate(void *p, std::size_t) { 
+    void deallocate(void *p, std::size_t bytes) { 
       if (p) { 
-        fmt::print("cudaFree device_allocator ptr[{}]\n", p);
-        checkCudaErrors(cudaFree(p));
+        fmt::print("{} device_allocator ptr[{}]\n", g_device_memory_pool ? "Pool release" : "cudaFree", p);
+        if (g_device_memory_pool) {
+          int dev;
+          checkCudaErrors(cudaGetDevice(&dev));
+          //< Kernels of a GPU all run on its compute stream, so the block is free once that stream passes this point
+          pooled_device_memory_resource::instance().deallocate_async(p, bytes, Cuda::ref_cuda_context(dev).stream_compute());
+        } else checkCudaErrors(cudaFree(p));
         //if (p) { p = nullptr;  fmt::print("Set pointer to nullptr.\n"); }
       }
       device_alloc_cnt--;
@@ -76,14 +84,14 @@ struct mgsp_benchmark {
     auto &cuDev = Cuda::ref_cuda_context(GPU_ID); // Reference CUDA context of GPU_ID
     cuDev.setContext(); // Set CUDA context of host thread. Host thread-to-GPU is 1:1
     // NOTE: The following code is executed on the host thread of GPU_ID, but the CUDA context is of GPU_ID. It is what organizes device memory allocation, etc. Device memory deallocation MUST use the same thread and CUDA context or the program will not close/undefined behavior.
-    tmps[GPU_ID].alloc(g_max_active_block); // Temporary memory array on GPU
+    tmps[GPU_ID].alloc(capacity.max_active_block); // Temporary memory array on GPU
     for (int copyid = 0; copyid < 2; copyid++) {
       fmt::print("Allocating gridBlocks[{}][{}].\n", copyid, GPU_ID);
-      gridBlocks[copyid].emplace_back(device_allocator{});
+      gridBlocks[copyid].emplace_back(device_allocator{}, capacity.max_active_block);
       printDiv();
 
       fmt::print("Allocating partitions[{}][{}].\n", copyid, GPU_ID);
-      partitions[copyid].emplace_back(device_allocator{}, g_max_active_block, domainCellCnt);
+      partitions[copyid].emplace_back(device_allocator{}, capacity.max_active_block, domainBlocks);
       printDiv();
     }
     cuDev.syncStream<streamIdx::Compute>();
@@ -128,10 +136,10 @@ struct mgsp_benchmark {
     vertice_cnt[GPU_ID] = g_max_fem_vertice_num; //< Number of vertices
     checkedCnts[GPU_ID][0] = 0; //< Init. flag for checked grid block count
     checkedCnts[GPU_ID][1] = 0; //< Init. flag for checked particle bin count
-    curNumActiveBlocks[GPU_ID] = g_max_active_block; //< Number of active grid blocks
+    curNumActiveBlocks[GPU_ID] = capacity.max_active_block; //< Number of active grid blocks
     for (int MODEL_ID=0; MODEL_ID<getModelCnt(GPU_ID); MODEL_ID++){
       checkedBinCnts[GPU_ID][MODEL_ID] = 0;
-      curNumActiveBins[GPU_ID][MODEL_ID] = g_max_particle_bin; //< Number of active particle bins
+      curNumActiveBins[GPU_ID][MODEL_ID] = capacity.max_particle_bin(); //< Number of active particle bins
     }
     // "if constexpr" is a C++ 17 feature. Change if not compiling.
     // Loop and initialize each device/CUDA context.
@@ -139,8 +147,8 @@ struct mgsp_benchmark {
   }
 
   // Constructor of the simulator object. Does some basic initialization for memory.
-  mgsp_benchmark(PREC l = g_length, uint64_t dCC = (g_grid_size_x*g_grid_size_y*g_grid_size_z), double dt = 1e-4, double t0 = 0.0, uint64_t fp = 24, uint64_t frames = 60, mn::pvec3 g = mn::pvec3{0., -9.81, 0.}, double fr_scale = 1.0, std::string suffix = ".bgeo", bool output_exterior_only = false)
-      : length(l), domainCellCnt(dCC), dtDefault(dt), initTime(t0), curTime(0.0), rollid(0), curFrame(0), curStep{0}, fps(fp), nframes(frames), grav(g), save_suffix(suffix), froude_scaling{fr_scale}, particles_output_exterior_only{output_exterior_only}, bRunning(true) {
+  mgsp_benchmark(PREC l = g_length, ivec3 dBlocks = ivec3{g_grid_size_x, g_grid_size_y, g_grid_size_z}, double dt = 1e-4, double t0 = 0.0, uint64_t fp = 24, uint64_t frames = 60, mn::pvec3 g = mn::pvec3{0., -9.81, 0.}, double fr_scale = 1.0, std::string suffix = ".bgeo", bool output_exterior_only = false, config::SimCapacity cap = config::SimCapacity{})
+      : length(l), domainBlocks(dBlocks), dtDefault(dt), initTime(t0), curTime(0.0), rollid(0), curFrame(0), curStep{0}, fps(fp), nframes(frames), grav(g), save_suffix(suffix), froude_scaling{fr_scale}, particles_output_exterior_only{output_exterior_only}, capacity{cap}, bRunning(true) {
     printDiv();
     fmt::print(fg(fmt::color::white),"Entered simulator. Start GPU set-up...\n");
     curTime = initTime; // Set current simulation time to given initial time, seconds
@@ -208,8 +216,10 @@ struct mgsp_benchmark {
   }
 
   // Set time step for sim. min() sets to smallest step needed for a material in sim.
+  // Locked, bodies may be initialized on concurrent host threads.
   template <typename T = double>
   void set_time_step(T input_dt) { 
+    std::lock_guard<std::mutex> lk{mut_dt};
     dtDefault = std::min(dtDefault, (double) input_dt); 
   }
 
@@ -221,18 +231,35 @@ struct mgsp_benchmark {
   template <material_e m>
   void initModel(int GPU_ID, int MODEL_ID, const std::vector<std::array<PREC, 3>> &model,
                   const vec<PREC, 3> &v0, const std::vector<int> &trackIDs, const std::vector<std::string> &trackAttribs) {
+    initModel<m>(GPU_ID, MODEL_ID, model.size(), v0, trackIDs, trackAttribs);
+    uploadParticles(GPU_ID, MODEL_ID, 0, model.data(), model.size());
+    fmt::print(fg(fmt::color::green), "NODE[{}] GPU[{}] MODEL[{}] Initialized device array with [{}] particles.\n", rank, GPU_ID, MODEL_ID, pcnt[GPU_ID][MODEL_ID]);
+    printDiv();
+
+    // Output initial particle model
+    std::string fn = std::string{"model["} + std::to_string(MODEL_ID) + "]"  "_dev[" + std::to_string(GPU_ID + rank * mn::config::g_device_cnt) +
+                     "]_frame[-1]" + save_suffix;
+    IO::insert_job([fn, &model]() { write_partio<PREC, 3>(fn, model); }); //< Not copied, flush() waits for the write
+    IO::flush();
+  }
+
+  /// @brief Allocate a particle model of count particles on device, without positions.
+  /// @brief Positions follow through uploadParticles, whole or in chunks (streamed initialization).
+  template <material_e m>
+  void initModel(int GPU_ID, int MODEL_ID, std::size_t count,
+                  const vec<PREC, 3> &v0, const std::vector<int> &trackIDs, const std::vector<std::string> &trackAttribs) {
     auto &cuDev = Cuda::ref_cuda_context(GPU_ID);
     cuDev.setContext();
 
     // Check for valid particle model size
-    if (model.size() > config::g_max_particle_num)
-      throw std::runtime_error("ERROR: Particle count of model exceeds max particles g_max_particle_num in settings.h.");
-    if (model.size() == 0)
+    if (count > capacity.max_particle_num)
+      throw std::runtime_error("ERROR: Particle count of model exceeds max particles of simulation capacity (max_particle_num).");
+    if (count == 0)
       throw std::runtime_error("ERROR: Model has zero particles. Not allowed. Likely an input script error regarding partition_start, partition_end, domain_start, domain_end, offset, span, ppc, etc... .");
 
-    pcnt[GPU_ID][MODEL_ID] = model.size(); // Initial particle count
+    pcnt[GPU_ID][MODEL_ID] = count; // Initial particle count
     const float extra_particle_bins_ratio = 1.20f; // Extra particle bins ratio to account for particle movement which may increase bin usage
-    std::size_t max_particle_bin_for_model = (std::size_t) std::max(ceil(extra_particle_bins_ratio * (float)pcnt[GPU_ID][MODEL_ID] / (float) mn::config::g_bin_capacity), (float)g_max_active_block); // Max number of particle bins for this models size. Must be atleast big enough to have one bin per max compiled active block to avoid a bunch of resizing.
+    std::size_t max_particle_bin_for_model = (std::size_t) std::max(ceil(extra_particle_bins_ratio * (float)pcnt[GPU_ID][MODEL_ID] / (float) mn::config::g_bin_capacity), (float)capacity.max_active_block); // Max number of particle bins for this models size. Must be atleast big enough to have one bin per max active block to avoid a bunch of resizing.
     // std::size_t max_particle_bin_for_model = g_max_particle_bin;
 
     h_model_cnt[GPU_ID] += 1; // Increment model count on GPU
@@ -245,9 +272,9 @@ struct mgsp_benchmark {
 
       if (g_buckets_on_particle_buffer) {
         // Reserve memory for cell / block ID buckets, particles per cell / block counts
-        fmt::print("NODE[{}] GPU[{}] MODEL[{}] COPY[{}] Allocating ParticleBins[{}][{}][{}].reserveBuckets() with g_max_active_block[{}].\n", rank, GPU_ID, MODEL_ID, copyid, copyid, GPU_ID, MODEL_ID, g_max_active_block);
+        fmt::print("NODE[{}] GPU[{}] MODEL[{}] COPY[{}] Allocating ParticleBins[{}][{}][{}].reserveBuckets() with max_active_block[{}].\n", rank, GPU_ID, MODEL_ID, copyid, copyid, GPU_ID, MODEL_ID, capacity.max_active_block);
         match(particleBins[copyid][GPU_ID][MODEL_ID])([&](auto &pb) {
-          pb.reserveBuckets(device_allocator{}, config::g_max_active_block);
+          pb.reserveBuckets(device_allocator{}, capacity.max_active_block);
         });
       }
       printDiv();
@@ -261,18 +288,12 @@ struct mgsp_benchmark {
     // particles[GPU_ID].emplace_back(spawn<particle_array_, orphan_signature>(device_allocator {}, sizeof(PREC_P) * num_dimensions * model.size()));
     // particles[GPU_ID][MODEL_ID] = static_cast<ParticleArray>(spawn<particle_array_, orphan_signature>(device_allocator {}));
     // curNumActiveBins[GPU_ID][MODEL_ID] = config::g_max_particle_bin;
-    particles[GPU_ID].emplace_back(spawn<particle_array_, orphan_signature>(device_allocator {}, model.size()));
+    particles[GPU_ID].emplace_back(spawn<particle_array_, orphan_signature>(device_allocator {}, count));
     bincnt[GPU_ID][MODEL_ID] = 0;
     checkedBinCnts[GPU_ID][MODEL_ID] = 0;
     curNumActiveBins[GPU_ID][MODEL_ID] = max_particle_bin_for_model;
-    cudaMemcpyAsync((void *)&particles[GPU_ID][MODEL_ID].val_1d(_0, 0), model.data(),
-                    sizeof(std::array<PREC, 3>) * pcnt[GPU_ID][MODEL_ID],
-                    cudaMemcpyDefault, cuDev.stream_compute());
     cuDev.syncStream<streamIdx::Compute>();
 
-    fmt::print(fg(fmt::color::green), "NODE[{}] GPU[{}] MODEL[{}] Initialized device array with [{}] particles.\n", rank, GPU_ID, MODEL_ID, pcnt[GPU_ID][MODEL_ID]);
-    printDiv();
-
     fmt::print("NODE[{}] GPU[{}] MODEL[{}] ParticleBins[0] and [1]: size [{}] and [{}] megabytes.\n", rank, GPU_ID, MODEL_ID,
                (float)match(particleBins[0][GPU_ID][MODEL_ID])([&](auto &pb) {return pb.size;})/1000/1000,
                (float)match(particleBins[1][GPU_ID][MODEL_ID])([&](auto &pb) {return pb.size;})/1000/1000);    
@@ -294,93 +315,128 @@ struct mgsp_benchmark {
     particleTrackFile[GPU_ID][MODEL_ID] << "\n";
     particleTrackFile[GPU_ID][MODEL_ID].close();
     printDiv();
-    // Output initial particle model
-    std::string fn = std::string{"model["} + std::to_string(MODEL_ID) + "]"  "_dev[" + std::to_string(GPU_ID + rank * mn::config::g_device_cnt) +
-                     "]_frame[-1]" + save_suffix;
-    IO::insert_job([fn, model]() { write_partio<PREC, 3>(fn, model); });
-    IO::flush();
+  }
+
+  /// @brief Copy count host positions into particles [offset, offset + count) of an allocated model. Host memory may be released on return.
+  void uploadParticles(int GPU_ID, int MODEL_ID, std::size_t offset, const std::array<PREC, 3> *positions, std::size_t count) {
+    auto &cuDev = Cuda::ref_cuda_context(GPU_ID);
+    cuDev.setContext();
+    if (offset + count > pcnt[GPU_ID][MODEL_ID])
+      throw std::runtime_error("ERROR: Uploaded particles exceed the particle count the model was allocated with.");
+    if (!count) return;
+    cudaMemcpyAsync((void *)&particles[GPU_ID][MODEL_ID].val_1d(_0, offset), positions,
+                    sizeof(std::array<PREC, 3>) * count,
+                    cudaMemcpyDefault, cuDev.stream_compute());
+    cuDev.syncStream<streamIdx::Compute>();
   }
   
-  /// @brief Initialize particle attributes on host and device. Allow for varied material and outputs. Number of attributes is restricted to numbers defined in enumerator num_attribs_e
+  /// @brief Set ID remap of a model reordered on host before upload (e.g. space-filling-curve sort).
+  /// @param remap remap[original_id] = uploaded_id. Empty if particles were uploaded in original order.
+  void setParticleIDRemap(int GPU_ID, int MODEL_ID, std::vector<int> remap) {
+    particleIDRemap[GPU_ID][MODEL_ID] = std::move(remap);
+  }
+
+  /// @brief Map user-facing (original) particle IDs to IDs of particles as uploaded to device. Out-of-range IDs are kept.
+  std::vector<int> uploadedParticleIDs(int did, int mid, const std::vector<int> &IDs) const {
+    const auto &remap = particleIDRemap[did][mid];
+    std::vector<int> uploaded(IDs);
+    for (auto &ID : uploaded) 
+      if (ID >= 0 && ID < (int)remap.size()) ID = remap[ID];
+    return uploaded;
+  }
+
+  /// @brief Flatten per-particle attribute rows into a strided [parid * n + attrib] array. Rows are zero-padded or truncated to n.
+  std::vector<PREC> flattenAttribs(const std::vector<std::vector<PREC>>& model_attribs, unsigned n) const {
+    std::vector<PREC> flattened(static_cast<std::size_t>(n) * model_attribs.size(), (PREC)0);
+    for (std::size_t i=0; i<model_attribs.size(); ++i) {
+      const std::vector<PREC> & v = model_attribs[i];
+      std::copy_n(v.begin(), std::min<std::size_t>(n, v.size()), flattened.begin() + i * n);
+    }
+    return flattened;
+  }
+
+  /// @brief Initialize particle attributes on host and device. Allow for varied material and outputs. Number of attributes is a run-time stride.
   /// @param GPU_ID Unique ID for GPU device, particle attributes will be initialized per GPU.
   /// @param  model_attribs Initial attributes (e.g. Velocity) for each particle.
+  /// @param num_attribs Number of attributes per particle (stride).
   /// @param has_init_attribs True if initial attributes given, false if not (defaults will be used).
-  template <num_attribs_e N>
-  void initInitialAttribs(int GPU_ID, int MODEL_ID, const std::vector<std::vector<PREC>>& model_attribs, const bool has_init_attribs) {
+  void initInitialAttribs(int GPU_ID, int MODEL_ID, const std::vector<std::vector<PREC>>& model_attribs, unsigned num_attribs, const bool has_init_attribs) {
     auto &cuDev = Cuda::ref_cuda_context(GPU_ID);
     if (MODEL_ID >= getModelCnt(GPU_ID)) throw std::runtime_error("ERROR: Exceeds particle models for all GPUs. Increase g_models_per_gpu.\n");
 
     cuDev.setContext();
-    constexpr int n = static_cast<int>(N);
+    const unsigned n = num_attribs;
     flag_pi[GPU_ID][MODEL_ID] = has_init_attribs;
     fmt::print("GPU[{}] MODEL[{}] Allocating ParticleAttribs.\n", GPU_ID, MODEL_ID);
-    pattribs_init[GPU_ID].emplace_back(ParticleAttrib<N>(device_allocator {}, model_attribs.size())); // Manual allocation
-    // pattribs_init[GPU_ID].emplace_back(ParticleAttrib<N>(device_allocator{})); // Default allocation size (big) 
-    // pattribs_init[GPU_ID].emplace_back(ParticleAttrib<N>(device_allocator {}, sizeof(PREC) * n * model_attribs.size())); // Manual allocation
-    
+    pattribs_init[GPU_ID].emplace_back(ParticleAttrib(device_allocator {}, model_attribs.size(), n)); // Manual allocation
     cuDev.syncStream<streamIdx::Compute>();
     printDiv();
 
-    std::vector<PREC> flattened;
-    flattened.reserve(n * model_attribs.size());
-    size_t reserve_size = 0;
-    for (int i=0; i<model_attribs.size(); ++i)
-      reserve_size += model_attribs[i].size();
-    flattened.reserve(reserve_size);
-    for (int i=0; i<model_attribs.size(); ++i) {
-      const std::vector<PREC> & v = model_attribs[i];
-      flattened.insert( flattened.end() , v.begin() , v.end() );
-    }
-    match(pattribs_init[GPU_ID][MODEL_ID])([&](auto &pa) {
-      checkCudaErrors(cudaMemcpyAsync((void *)&get<typename std::decay_t<decltype(pa)>>(
-                          pattribs_init[GPU_ID][MODEL_ID]).val_1d(_0, 0), flattened.data(),
-                      sizeof(PREC) * n * model_attribs.size(),
-                      cudaMemcpyDefault, cuDev.stream_compute()));
+    std::vector<PREC> flattened = flattenAttribs(model_attribs, n);
+    auto &pa = pattribs_init[GPU_ID][MODEL_ID];
+    if (pa.bytes()) {
+      checkCudaErrors(cudaMemcpyAsync((void *)pa.data(), flattened.data(),
+                      pa.bytes(), cudaMemcpyDefault, cuDev.stream_compute()));
       cuDev.syncStream<streamIdx::Compute>();
-    });
+    }
 
-    fmt::print(fg(fmt::color::green), "GPU[{}] MODEL[{}] Initialized input device attribute vector of vectors with [{}] particles and [{}] attributes.\n", GPU_ID, MODEL_ID, flattened.size()/n, n);
+    fmt::print(fg(fmt::color::green), "GPU[{}] MODEL[{}] Initialized input device attribute vector of vectors with [{}] particles and [{}] attributes.\n", GPU_ID, MODEL_ID, model_attribs.size(), n);
     printDiv();
   }
 
-  /// @brief Initialize particle attributes on host and device. Allow for varied material and outputs. Number of attributes is restricted to numbers defined in enumerator num_attribs_e
+  /// @brief Initialize particle attributes on host and device. Allow for varied material and outputs. Number of attributes is a run-time stride.
   /// @param GPU_ID Unique ID for GPU device, particle attributes will be initialized per GPU.
   /// @param  model_attribs Initial attributes (e.g. Velocity) for each particle.
-  /// @param has_init_attribs True if initial attributes given, false if not (defaults will be used).
-  template <num_attribs_e N>
-  void initOutputAttribs(int GPU_ID, int MODEL_ID, const std::vector<std::vector<PREC>>& model_attribs) {
+  /// @param num_attribs Number of output attributes per particle (stride).
+  void initOutputAttribs(int GPU_ID, int MODEL_ID, const std::vector<std::vector<PREC>>& model_attribs, unsigned num_attribs) {
     auto &cuDev = Cuda::ref_cuda_context(GPU_ID);
     cuDev.setContext();
-    constexpr int n = static_cast<int>(N);
+    const unsigned n = num_attribs;
     fmt::print("GPU[{}] MODEL[{}] Allocating ParticleAttribs.\n", GPU_ID, MODEL_ID);
-    // pattribs[GPU_ID].emplace_back(ParticleAttrib<N>(device_allocator{}));
-    // pattribs[GPU_ID].emplace_back(ParticleAttrib<N>(device_allocator {}, sizeof(PREC) * n * model_attribs.size())); // Manual allocation
-    pattribs[GPU_ID].emplace_back(ParticleAttrib<N>(device_allocator {}, model_attribs.size())); // Manual allocation
-    //pattribs[GPU_ID] = spawn<particle_attrib_<N>, orphan_signature>(device_allocator{});
+    pattribs[GPU_ID].emplace_back(ParticleAttrib(device_allocator {}, model_attribs.size(), n)); // Manual allocation
     cuDev.syncStream<streamIdx::Compute>();
     printDiv();
 
-    std::vector<PREC> flattened;
-    flattened.reserve(n * model_attribs.size());
-    size_t reserve_size = 0;
-    for (int i=0; i<model_attribs.size(); ++i)
-      reserve_size += model_attribs[i].size();
-    flattened.reserve(reserve_size);
-    for (int i=0; i<model_attribs.size(); ++i){
-      const std::vector<PREC> & v = model_attribs[i]; 
-      flattened.insert( flattened.end() , v.begin() , v.end() );
+    std::vector<PREC> flattened = flattenAttribs(model_attribs, n);
+    auto &pa = pattribs[GPU_ID][MODEL_ID];
+    if (pa.bytes()) {
+      checkCudaErrors(cudaMemcpyAsync((void *)pa.data(), flattened.data(),
+                      pa.bytes(), cudaMemcpyDefault, cuDev.stream_compute()));
+      cuDev.syncStream<streamIdx::Compute>();
     }
+    fmt::print(fg(fmt::color::green), "GPU[{}] MODEL[{}] Initialized output device attribute vector of vectors with [{}] particles and [{}] attributes.\n", GPU_ID, MODEL_ID, model_attribs.size(), n);
+    printDiv();
+  }
 
-    match(pattribs[GPU_ID][MODEL_ID])([&](auto &pa) {
-      checkCudaErrors(cudaMemcpyAsync((void *)&pa.val_1d(_0, 0), flattened.data(),
-                      sizeof(PREC) * n * model_attribs.size(),
-                      cudaMemcpyDefault, cuDev.stream_compute()));
-      cuDev.syncStream<streamIdx::Compute>();
-    });
-    fmt::print(fg(fmt::color::green), "GPU[{}] MODEL[{}] Initialized output device attribute vector of vectors with [{}] particles and [{}] attributes.\n", GPU_ID, MODEL_ID, model_attribs.size(), model_attribs[0].size());
+
+  /// @brief Zero initial attributes for count particles, set on device without host rows (defaults are used, as has_init_attribs = false).
+  void initInitialAttribs(int GPU_ID, int MODEL_ID, std::size_t count, unsigned num_attribs) {
+    auto &cuDev = Cuda::ref_cuda_context(GPU_ID);
+    if (MODEL_ID >= getModelCnt(GPU_ID)) throw std::runtime_error("ERROR: Exceeds particle models for all GPUs. Increase g_models_per_gpu.\n");
+
+    cuDev.setContext();
+    flag_pi[GPU_ID][MODEL_ID] = false;
+    fmt::print("GPU[{}] MODEL[{}] Allocating ParticleAttribs.\n", GPU_ID, MODEL_ID);
+    pattribs_init[GPU_ID].emplace_back(ParticleAttrib(device_allocator {}, count, num_attribs));
+    auto &pa = pattribs_init[GPU_ID][MODEL_ID];
+    if (pa.bytes()) checkCudaErrors(cudaMemsetAsync((void *)pa.data(), 0, pa.bytes(), cuDev.stream_compute()));
+    cuDev.syncStream<streamIdx::Compute>();
+    fmt::print(fg(fmt::color::green), "GPU[{}] MODEL[{}] Initialized input device attributes to zero with [{}] particles and [{}] attributes.\n", GPU_ID, MODEL_ID, count, num_attribs);
     printDiv();
   }
 
+  /// @brief Zero output attributes for count particles, set on device without host rows.
+  void initOutputAttribs(int GPU_ID, int MODEL_ID, std::size_t count, unsigned num_attribs) {
+    auto &cuDev = Cuda::ref_cuda_context(GPU_ID);
+    cuDev.setContext();
+    fmt::print("GPU[{}] MODEL[{}] Allocating ParticleAttribs.\n", GPU_ID, MODEL_ID);
+    pattribs[GPU_ID].emplace_back(ParticleAttrib(device_allocator {}, count, num_attribs));
+    auto &pa = pattribs[GPU_ID][MODEL_ID];
+    if (pa.bytes()) checkCudaErrors(cudaMemsetAsync((void *)pa.data(), 0, pa.bytes(), cuDev.stream_compute()));
+    cuDev.syncStream<streamIdx::Compute>();
+    fmt::print(fg(fmt::color::green), "GPU[{}] MODEL[{}] Initialized output device attributes to zero with [{}] particles and [{}] attributes.\n", GPU_ID, MODEL_ID, count, num_attribs);
+    printDiv();
+  }
 
   // Initialize FEM vertices and elements
   template<fem_e f>
@@ -579,34 +635,29 @@ struct mgsp_benchmark {
 
   }
 
-  /// Init Motion-Paths on device (device_motionPath) from host (&host_motionPath) (JB)
-  void initMotionPath(int GPU_ID,
-                     const std::vector<std::array<PREC_G, 3>> &motionPath, 
-                     float frequency) {
-    auto &cuDev = Cuda::ref_cuda_context(GPU_ID);
-    cuDev.setContext();
-    fmt::print("Entered initMotionPath. \n");
+  /// Init motion table of a grid-boundary (JB). Evaluated every time-step into d_motion[boundary_ID].
+  void initMotionTable(int boundary_ID, const MotionTable &table) {
+    if (boundary_ID < 0 || boundary_ID >= g_max_grid_boundaries) {
+      fmt::print(fg(fmt::color::red), "ERROR: Motion table for grid-boundary[{}] exceeds g_max_grid_boundaries[{}].\n", boundary_ID, g_max_grid_boundaries);
+      return;
+    }
     flag_mp = true; // Enable motion-path flag
-    host_mp_freq = frequency; // Frequency of motion file rows, 1 / time-step
-    host_motionPath = motionPath; // TODO: Recheck, also consider L1 cache on GPU
-    /// Populate Motion-Path (device) with data from Motion-Path (host) (JB)
-    for (int d = 0; d < 3; d++) d_motionPath[d] = (PREC_G)host_motionPath[0][d]; //< Set vals
-    fmt::print("Init motionPath with time[{} s], disp_x[{} m], vel_x[{} m/s] \n", d_motionPath[0], d_motionPath[1], d_motionPath[2]);
+    host_motionTables[boundary_ID] = table;
+    host_motionTables[boundary_ID].evaluate(0.0, d_motion[boundary_ID].data());
+    fmt::print("Init motion table of grid-boundary[{}] with [{}] rows over time[{}, {}] s ({}), disp_x[{} m], vel_x[{} m/s] at time[0 s].\n", boundary_ID, table.rows(), table.time.front(), table.time.back(), table.uniform ? "uniform" : "non-uniform",
+               d_motion[boundary_ID][(int)motion_e::DispX], d_motion[boundary_ID][(int)motion_e::VelX]);
   }  
   
-  /// Set a Motion-Path for time-step (JB)
-  // TODO : Revamp motion path to not rely on only X displacement/velocity, should be general
-  void setMotionPath(std::vector<std::array<PREC_G, 3>> &host_motionPath, double curTime) {
-    if (flag_mp) { // Set-up d_motionPath values if enabled
-      double check_point_time = 0.0; // initTime; // TODO : Time of check-point 
-      int step = (int)((curTime + check_point_time) * host_mp_freq); //< Index for time
-      if (step >= host_motionPath.size()) step = (int)(host_motionPath.size() - 1); //< Index-limit
-      else if (step < 0) step = 0;
-      for (int d = 0; d < 3; d++) d_motionPath[d] = (PREC_G)host_motionPath[step][d]; //< Set vals
-      if (g_log_level >= (int)log_e::Info) fmt::print("Set motionPath with step[{}], dt[{} s], time[{} s], disp_x[{} m], vel_y[{} m/s]\n", step, (1.0/host_mp_freq), d_motionPath[0], d_motionPath[1], d_motionPath[2]);
-    } else {
-      for (int d = 0; d < 3; d++) d_motionPath[d] = 0.f; // Zero-out d_motionPath if not enabled
+  /// Evaluate motion of every grid-boundary at the step time (JB). O(1) per boundary, sent to grid kernels as one small block.
+  void setMotion(double curTime) {
+    double check_point_time = 0.0; // initTime; // TODO : Time of check-point 
+    for (int b = 0; b < g_max_grid_boundaries; ++b) {
+      if (flag_mp && !host_motionTables[b].empty()) host_motionTables[b].evaluate(curTime + check_point_time, d_motion[b].data());
+      else d_motion[b].set(0.f); // Zero-out if no motion table
     }
+    if (flag_mp && g_log_level >= (int)log_e::Info) 
+      for (int b = 0; b < g_max_grid_boundaries; ++b)
+        if (!host_motionTables[b].empty()) fmt::print("Set motion of grid-boundary[{}] at time[{} s], disp_x[{} m], vel_x[{} m/s]\n", b, curTime, d_motion[b][(int)motion_e::DispX], d_motion[b][(int)motion_e::VelX]);
   }
 
   template<material_e mt>
@@ -625,7 +676,7 @@ struct mgsp_benchmark {
           [&](ParticleBuffer<mt> &pb) {
             pb.updateParameters(length, materialConfigs, algoConfigs);
             pb.updateOutputs(names);
-            pb.updateTrack(trackNames, trackIDs);
+            pb.updateTrack(trackNames, uploadedParticleIDs(did, mid, trackIDs));
             pb.updateTargets(targetNames);
           });
     }
@@ -794,7 +845,7 @@ struct mgsp_benchmark {
     for (curFrame = 1; curFrame <= nframes; ++curFrame) {
       int step_cnt = 0;
       for (; curTime < nextTime; curTime += dt, curStep++) {
-        setMotionPath(host_motionPath, curTime); //< Update motion-paths for this time-step
+        setMotion(curTime); //< Update boundary motions for this time-step
         issue([this](int did) {
           auto &cuDev = Cuda::ref_cuda_context(did);
           //cuDev.setContext(); // JB, maybe remove?
@@ -828,7 +879,7 @@ struct mgsp_benchmark {
                      g_num_grid_blocks_per_cuda_block,
                  g_num_warps_per_cuda_block * 32, g_num_warps_per_cuda_block * sizeof(PREC_G)},
                 update_grid_velocity_query_max, (uint32_t)nbcnt[did],
-                gridBlocks[0][did], partitions[rollid][did], dt, d_maxVel, curTime, grav, gridBoundary, d_gridBoundaryConfigs, d_motionPath, length, froude_scaling);
+                gridBlocks[0][did], partitions[rollid][did], dt, d_maxVel, curTime, grav, gridBoundary, d_gridBoundaryConfigs, d_motion, length, froude_scaling);
             
             // if (flag_ge && (fmod(curTime, (double)1.0/host_ge_freq) < dt || curTime + dt > nextTime)) {
             if (check_flag_and_frequency(flag_ge, host_ge_freq, dt, curTime, nextTime)) {
@@ -836,7 +887,7 @@ struct mgsp_benchmark {
               cuDev.compute_launch(
                   {(nbcnt[did] + g_num_grid_blocks_per_cuda_block - 1) / g_num_grid_blocks_per_cuda_block, g_num_warps_per_cuda_block * 32, g_num_warps_per_cuda_block * sizeof(PREC_G)},
                   query_energy_grid, (uint32_t)nbcnt[did],
-                  gridBlocks[0][did], partitions[rollid][did], dt, d_kinetic_energy_grid, d_gravity_energy_grid, curTime, grav, gridBoundary, d_motionPath, length);
+                  gridBlocks[0][did], partitions[rollid][did], dt, d_kinetic_energy_grid, d_gravity_energy_grid, curTime, grav, gridBoundary, d_motion, length);
             }
           }
           cuDev.syncStream<streamIdx::Compute>();
@@ -1694,16 +1745,28 @@ struct mgsp_benchmark {
       });
       sync();
 
+      // Dump grid-blocks
+      if (g_grid_block_dump) {
+        issue([this](int did) { output_grid_blocks(did); });
+        sync();
+      }
+
       
       for (int did=0; did < g_device_cnt; ++did) {
         fmt::print(fmt::emphasis::bold | fg(fmt::color::yellow),
-                    "GPU[{}] frame[{}] curTime[{}], Block Info: Particle Blocks[{}], Neighbor Blocks[{}], Exterior Blocks[{}], Allocated Blocks[{}], Compiled Max Blocks[{}]\n",
-                    did, curFrame, curTime, pbcnt[did], nbcnt[did], ebcnt[did], curNumActiveBlocks[did], g_max_active_block);
+                    "GPU[{}] frame[{}] curTime[{}], Block Info: Particle Blocks[{}], Neighbor Blocks[{}], Exterior Blocks[{}], Allocated Blocks[{}], Capacity Max Blocks[{}]\n",
+                    did, curFrame, curTime, pbcnt[did], nbcnt[did], ebcnt[did], curNumActiveBlocks[did], capacity.max_active_block);
         for (int mid=0; mid < getModelCnt(did); mid++) {
           fmt::print(fmt::emphasis::bold | fg(fmt::color::yellow),
-                    "GPU[{}] MODEL[{}] frame[{}] curTime[{}], Bin Info: Particle Count[{}],  Particle Bins[{}], Allocated Bins[{}], Compiled Max Bins[{}]\n",
-                    did, mid, curFrame, curTime, pcnt[did][mid], bincnt[did][mid], curNumActiveBins[did][mid], g_max_particle_bin);
+                    "GPU[{}] MODEL[{}] frame[{}] curTime[{}], Bin Info: Particle Count[{}],  Particle Bins[{}], Allocated Bins[{}], Capacity Max Bins[{}]\n",
+                    did, mid, curFrame, curTime, pcnt[did][mid], bincnt[did][mid], curNumActiveBins[did][mid], capacity.max_particle_bin());
         }
+        // Borrowed temp memory, high-water is per frame. The stack itself is reset every step in halo_tagging()
+        auto &cuDev = Cuda::ref_cuda_context(did);
+        fmt::print(fmt::emphasis::bold | fg(fmt::color::yellow),
+                    "GPU[{}] frame[{}] curTime[{}], Temp Memory Info: High-Water[{}] MB, In Use[{}] MB, Pre-Allocated[{}] MB\n",
+                    did, curFrame, curTime, cuDev.memHighWater() / 1e6, cuDev.memUsed() / 1e6, cuDev.memCapacity() / 1e6);
+        cuDev.resetMemHighWater();
       }
 
       //nextTime = (double)(1.0*( (curFrame + 1) / fps ) + initTime); // Next frame end time
@@ -1757,10 +1820,8 @@ struct mgsp_benchmark {
         fmt::print("Deallocating particles[{}][{}]\n", did, MODEL_ID);
         particles[did][MODEL_ID].deallocate(device_allocator{}); // Deallocate particles
         fmt::print("Deallocating pattribs[{}][{}] and pattribs_init[{}][{}]\n", did, MODEL_ID, did, MODEL_ID);
-        match(pattribs[did][MODEL_ID], pattribs_init[did][MODEL_ID])([&](auto &pa, auto &pi) {
-          pa.deallocate(device_allocator{}); // Deallocate particle attributes
-          pi.deallocate(device_allocator{}); // Deallocate particle attributes initial
-        });
+        pattribs[did][MODEL_ID].deallocate(device_allocator{}); // Deallocate particle attributes
+        pattribs_init[did][MODEL_ID].deallocate(device_allocator{}); // Deallocate particle attributes initial
       }
       fmt::print("Deallocating inputHaloGridBlocks[{}]\n", did);
       inputHaloGridBlocks[did].deallocate(device_allocator{}); // Deallocate input halo blocks
@@ -1861,6 +1922,7 @@ struct mgsp_benchmark {
     CudaTimer timer{cuDev.stream_compute()};
     if (g_log_level >= 2) timer.tick();
 
+    auto scratch = cuDev.borrowScope(); //< Borrowed memory below is returned on exit
     int parcnt, *d_parcnt = (int *)cuDev.borrow(sizeof(int));
     PREC trackVal[g_max_particle_trackers * g_max_particle_tracker_attribs], *d_trackVal = (PREC *)cuDev.borrow(g_max_particle_trackers * g_max_particle_tracker_attribs * sizeof(PREC));
     int particle_target_cnt, *d_particle_target_cnt = (int *)cuDev.borrow(sizeof(int));
@@ -1890,11 +1952,10 @@ struct mgsp_benchmark {
       cuDev.syncStream<streamIdx::Compute>();
 
       fmt::print(fg(fmt::color::red), "GPU[{}] Launch retrieve_particle_buffer_attributes\n", did);
-      match(particleBins[rollid][did][mid], pattribs[did][mid])([&](const auto &pb, auto &pa) {
+      match(particleBins[rollid][did][mid])([&](const auto &pb) {
         cuDev.compute_launch({pbcnt[did], 128}, retrieve_particle_buffer_attributes_general,
                             partitions[rollid][did], partitions[rollid ^ 1][did],
-                            pb, get<typename std::decay_t<decltype(pb)>>(particleBins[rollid ^ 1][did][mid]), particles[did][mid],  get<typename std::decay_t<decltype(pa)>>(
-                          pattribs[did][mid]), d_trackVal, d_parcnt,
+                            pb, get<typename std::decay_t<decltype(pb)>>(particleBins[rollid ^ 1][did][mid]), particles[did][mid], pattribs[did][mid], d_trackVal, d_parcnt,
                             d_particleTarget[did], d_valAgg, d_particle_target[i],d_particle_target_cnt, false, particles_output_exterior_only);
       });
       // Copy device to host
@@ -1938,10 +1999,11 @@ struct mgsp_benchmark {
 
       // * Write full particle files
       {
-        match(particleBins[rollid][did][mid], pattribs[did][mid])([&](const auto &pb, const auto &pa) {
+        const auto &pa = pattribs[did][mid];
+        match(particleBins[rollid][did][mid])([&](const auto &pb) {
           attribs[did][mid].resize(pa.numAttributes*parcnt);
           if (pa.numAttributes){
-            checkCudaErrors(cudaMemcpyAsync(attribs[did][mid].data(), (void *)&pa.val_1d(_0, 0),
+            checkCudaErrors(cudaMemcpyAsync(attribs[did][mid].data(), (void *)pa.data(),
                                             sizeof(PREC) * (pa.numAttributes) * (parcnt),
                                             cudaMemcpyDefault, cuDev.stream_compute()));
             cuDev.syncStream<streamIdx::Compute>();
@@ -1970,6 +2032,7 @@ struct mgsp_benchmark {
     timer.tick();
     
 
+    auto scratch = cuDev.borrowScope(); //< Borrowed memory below is returned on exit
     int elcnt, *d_elcnt = (int *)cuDev.borrow(sizeof(int));
     checkCudaErrors(
         cudaMemsetAsync(d_elcnt, 0, sizeof(int), cuDev.stream_compute()));
@@ -2032,6 +2095,27 @@ struct mgsp_benchmark {
   }
 
   /// Output data from grid blocks (mass, momentum) to *.bgeo (JB)
+  /// @brief Write gridBlocks[0] of the current partition: GridBuffer::save blob of ebcnt blocks, then uint64 ebcnt and
+  /// the ivec3 block coordinates from partitions[rollid]._activeKeys in the same order.
+  void output_grid_blocks(int did) {
+    auto &cuDev = Cuda::ref_cuda_context(did);
+    cuDev.setContext();
+    cuDev.syncStream<streamIdx::Compute>();
+    std::string fn = std::string{"grid_dev["} + std::to_string(did + rank * g_device_cnt) + "]_frame[" +
+                     std::to_string(curFrame) + "].mnsb";
+    const std::size_t blockCnt = ebcnt[did];
+    std::vector<ivec3> keys(blockCnt);
+    if (blockCnt)
+      checkCudaErrors(cudaMemcpy(keys.data(), partitions[rollid][did]._activeKeys, sizeof(ivec3) * blockCnt, cudaMemcpyDefault));
+    std::ofstream out(fn, std::ios::binary);
+    const uint64_t cnt = blockCnt;
+    if (!gridBlocks[0][did].save(out, blockCnt) || !out.write((const char *)&cnt, sizeof(cnt)) ||
+        !out.write((const char *)keys.data(), sizeof(ivec3) * blockCnt))
+      fmt::print(fg(fmt::color::red), "GPU[{}] ERROR: Could not write grid-blocks to [{}].\n", did, fn);
+    else if (g_log_level >= (int)log_e::Info)
+      fmt::print("GPU[{}] Wrote [{}] grid-blocks to [{}].\n", did, blockCnt, fn);
+  }
+
   void output_gridcell_target(int did) {
     auto &cuDev = Cuda::ref_cuda_context(did);
     cuDev.setContext();
@@ -2041,6 +2125,7 @@ struct mgsp_benchmark {
 
     for (int i = 0; i < number_of_grid_targets; i++)
     {
+      auto scratch = cuDev.borrowScope(); //< Borrowed memory of this target is returned per iteration
       // * IO::flush();    // Clear IO
       int gridID = 0;
       if (curTime == initTime){
@@ -2153,7 +2238,8 @@ struct mgsp_benchmark {
     CudaTimer timer{cuDev.stream_compute()};
     timer.tick();
 
-    // Borrow monotonic GPU memory for temporary variables
+    // Borrow monotonic GPU memory for temporary variables, returned on exit
+    auto scratch = cuDev.borrowScope();
     // int parcnt, *d_parcnt = (int *)cuDev.borrow(sizeof(int));
     // PREC trackVal, *d_trackVal = (PREC *)cuDev.borrow(sizeof(PREC));
     int *d_parcnt = (int *)cuDev.borrow(sizeof(int));
@@ -2333,7 +2419,8 @@ struct mgsp_benchmark {
         int *binpbs = tmps[did].binpbs;
         if (g_buckets_on_particle_buffer) {
           for (int mid=0; mid < getModelCnt(did); mid++) {
-            match(particleBins[rollid][did][mid], pattribs_init[did][mid])([&](auto &pb, const auto &pi) {
+            const auto &pi = pattribs_init[did][mid];
+            match(particleBins[rollid][did][mid])([&](auto &pb) {
               cuDev.compute_launch({(pbcnt[did] + 1 + 127) / 128, 128},
                               compute_bin_capacity, pbcnt[did] + 1,
                               (const int *)pb._ppbs,
@@ -2373,7 +2460,8 @@ struct mgsp_benchmark {
       }
       if (g_buckets_on_particle_buffer == false) {
         int mid = 0;  
-        match(particleBins[rollid][did][mid], pattribs_init[did][mid])([&](const auto &pb, const auto &pi) {
+        const auto &pi = pattribs_init[did][mid];
+        match(particleBins[rollid][did][mid])([&](const auto &pb) {
           if (flag_pi[did][mid]) {
               fmt::print("GPU[{}] MODEL[{}] array_to_buffer with initial attributes.\n", did, mid);
               cuDev.compute_launch({pbcnt[did], 128}, array_to_buffer, particles[did][mid], 
@@ -2437,7 +2525,7 @@ struct mgsp_benchmark {
       if (g_buckets_on_particle_buffer) {
         for (int mid=0; mid<getModelCnt(did); mid++) {
           fmt::print(fmt::emphasis::bold | fg(fmt::color::yellow),
-                    "GPU[{}] MODEL[{}] Block Info: Particle Blocks[{}], Neighbor Blocks[{}], Exterior Blocks[{}], Allocated Blocks[{}], Compiled Max Blocks[{}]; Bin Info: Particle Bins[{}], Allocated Bins[{}], Compiled Max Bins[{}]\n", did, mid, pbcnt[did], nbcnt[did], ebcnt[did], curNumActiveBlocks[did], g_max_active_block, bincnt[did][mid], curNumActiveBins[did][mid], g_max_particle_bin);
+                    "GPU[{}] MODEL[{}] Block Info: Particle Blocks[{}], Neighbor Blocks[{}], Exterior Blocks[{}], Allocated Blocks[{}], Capacity Max Blocks[{}]; Bin Info: Particle Bins[{}], Allocated Bins[{}], Capacity Max Bins[{}]\n", did, mid, pbcnt[did], nbcnt[did], ebcnt[did], curNumActiveBlocks[did], capacity.max_active_block, bincnt[did][mid], curNumActiveBins[did][mid], capacity.max_particle_bin());
           if (ebcnt[did] > curNumActiveBlocks[did]){
             fmt::print(fmt::emphasis::bold | fg(fmt::color::red),
                       "GPU[{}] MODEL[{}] ERROR: Exterior Blocks[{}] > Allocated Blocks[{}]\n", did, mid, ebcnt[did], curNumActiveBlocks[did]);
@@ -2454,13 +2542,13 @@ struct mgsp_benchmark {
             fmt::print(fmt::emphasis::bold | fg(fmt::color::red),
                       "GPU[{}] MODEL[{}] ERROR: Particle Blocks[{}] > Neighbor Blocks[{}]\n", did, mid, pbcnt[did], nbcnt[did]);
           }
-          if (curNumActiveBlocks[did] > g_max_active_block){
+          if (curNumActiveBlocks[did] > capacity.max_active_block){
             fmt::print(fmt::emphasis::bold | fg(fmt::color::red),
-                      "GPU[{}] MODEL[{}] ERROR: Allocated Blocks[{}] > Compiled Max Blocks[{}]\n", did, mid, curNumActiveBlocks[did], g_max_active_block);
+                      "GPU[{}] MODEL[{}] ERROR: Allocated Blocks[{}] > Capacity Max Blocks[{}]\n", did, mid, curNumActiveBlocks[did], capacity.max_active_block);
           }
-          if (curNumActiveBins[did][mid] > g_max_particle_bin){
+          if (curNumActiveBins[did][mid] > capacity.max_particle_bin()){
             fmt::print(fmt::emphasis::bold | fg(fmt::color::red),
-                      "GPU[{}] MODEL[{}] ERROR: Allocated Bins[{}] > Compiled Max Bins[{}]\n", did, mid, curNumActiveBins[did][mid], g_max_particle_bin);
+                      "GPU[{}] MODEL[{}] ERROR: Allocated Bins[{}] > Capacity Max Bins[{}]\n", did, mid, curNumActiveBins[did][mid], capacity.max_particle_bin());
           }
         }
       }
@@ -2511,7 +2599,8 @@ struct mgsp_benchmark {
       if (g_buckets_on_particle_buffer) {
         for (int mid=0; mid<getModelCnt(did); mid++) {
           // TODO : Need to retrofit for init attribs and pbuffer usage for vars
-          match(particleBins[rollid][did][mid], pattribs_init[did][mid])([&](auto &pb, auto &pi) {
+          const auto &pi = pattribs_init[did][mid];
+          match(particleBins[rollid][did][mid])([&](auto &pb) {
             if (flag_pi[did][mid]) {
               cuDev.compute_launch({(pcnt[did][mid] + 255) / 256, 256}, rasterize, pcnt[did][mid],
                                   pb, particles[did][mid],  pi, gridBlocks[0][did],
@@ -2531,7 +2620,8 @@ struct mgsp_benchmark {
         }
       } else { 
         int mid = 0;
-        match(particleBins[rollid][did][mid], pattribs_init[did][mid])([&](auto &pb, auto &pi) {
+        const auto &pi = pattribs_init[did][mid];
+        match(particleBins[rollid][did][mid])([&](auto &pb) {
           if (flag_pi[did][mid]) {
               cuDev.compute_launch({(pcnt[did][mid] + 255) / 256, 256}, rasterize, pcnt[did][mid],
                                   pb, particles[did][mid],  pi, gridBlocks[0][did],
@@ -2775,7 +2865,7 @@ struct mgsp_benchmark {
 
   // * Declare Simulation basic run-time settings
   PREC length; ///< Max length of domain, [m]
-  uint64_t domainCellCnt; ///< Max number of cells in domain
+  ivec3 domainBlocks; ///< Run-time grid-blocks per axis of domain, sizes Partition _indexTable
   double dt, nextDt, dtDefault; // time-step, next time-step, def. time-step [sec]
   double  curTime, nextTime; // Current time, next time [sec]
   PREC_G maxVel; // Max velocity on the MPM grid [m/s]
@@ -2785,6 +2875,7 @@ struct mgsp_benchmark {
   double initTime = 0.0; ///< Start time of sim, [sec]
   double froude_scaling = 1.0; ///< Length scaling factor for Froude similarity
   bool particles_output_exterior_only = false; ///< Output to disk particles only on exterior blocks
+  config::SimCapacity capacity; ///< Run-time capacity (preallocated blocks, max particles) from scene, see settings.h
   // * Data-structures on GPUs or cast by kernels
   std::vector<Partition<1>> partitions[2]; ///< Organizes partition + halo info, halo_buffer.cuh
   std::vector<GridBuffer> gridBlocks[2]; //< Organizes grid data in blocks
@@ -2804,7 +2895,7 @@ struct mgsp_benchmark {
   GridBoundaryConfigs * d_gridBoundaryConfigs; ///< Grid boundaries
 
   vec<vec7, g_max_grid_boundaries> gridBoundary; ///< Grid boundaries
-  vec3 d_motionPath; ///< Motion path info (time, disp, vel) to send to device kernels
+  vec<MotionState, g_max_grid_boundaries> d_motion; ///< Motion of each grid-boundary at the current step, sent to device kernels
 
   // Labels for attribute I/O
   std::vector<std::string> output_attribs[g_device_cnt][g_models_per_gpu];
@@ -2895,6 +2986,7 @@ struct mgsp_benchmark {
   std::vector<float> durations[g_device_cnt + 1]; // should this be floats...?
   std::vector<std::array<PREC, 3>> models[g_device_cnt][g_models_per_gpu];
   std::vector<PREC> attribs[g_device_cnt][g_models_per_gpu];
+  std::vector<int> particleIDRemap[g_device_cnt][g_models_per_gpu]; ///< Original to uploaded particle ID, empty if not reordered
 
   int number_of_grid_targets = 0;
   int number_of_particle_targets = 0;
@@ -2907,7 +2999,7 @@ struct mgsp_benchmark {
   std::vector<std::array<PREC, 13>> host_vertices[g_device_cnt];
   std::vector<std::array<int, 4>> host_element_IDs[g_device_cnt];
   std::vector<std::array<PREC, 6>> host_element_attribs[g_device_cnt];
-  std::vector<std::array<PREC_G, 3>> host_motionPath; ///< Motion-Path (time, disp, vel) on host (JB)
+  MotionTable host_motionTables[g_max_grid_boundaries]; ///< Motion tables of grid-boundaries on host (JB)
 
   std::array<bool, g_device_cnt> any_FBAR_fused_models_on_gpu = {false}; // Check if any models on this GPU are using FBAR with fused kernels
   std::array<bool, g_device_cnt> flag_fem = {false}; // Toggle finite elements
@@ -2925,7 +3017,6 @@ struct mgsp_benchmark {
   PREC_G host_ge_freq = 60.f; // Frequency of grid-energy output
   PREC_G host_gt_freq = 60.f; // Frequency of grid-target output
   PREC_G host_gb_freq = 60.f; // Frequency of grid-boundary output
-  PREC_G host_mp_freq = 60.f; // Frequency of motion path sampling
 
   std::ofstream particleEnergyFile;
   std::ofstream particleTargetFile[g_device_cnt][g_models_per_gpu];
@@ -2942,6 +3033,7 @@ struct mgsp_benchmark {
   threadsafe_queue<std::function<void(int)>> jobs[g_device_cnt];
   std::thread ths[g_device_cnt]; ///< thread is not trivial
   std::mutex mut_slave, mut_ctrl;
+  std::mutex mut_dt; //< Guards dtDefault during concurrent body initialization
   std::condition_variable cv_slave, cv_ctrl;
   std::atomic_uint idleCnt{0};
 
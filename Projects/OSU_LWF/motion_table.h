@@ -0,0 +1,192 @@
+#ifndef __MOTION_TABLE_H_
+#define __MOTION_TABLE_H_
+#include "settings.cuh"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace mn {
+
+/// @brief Prescribed motion of a grid-boundary over time (e.g. wave-maker paddle, gate), all config::motion_e channels per row.
+/// Parsed once from CSV, then cached in binary next to it ("<file>.mtc"). Evaluated by linear interpolation at the step time.
+struct MotionTable {
+  std::vector<double> time;   //< Row times [s], increasing
+  std::vector<PREC_G> values; //< Row-major, g_motion_channels per row
+  bool uniform = false;       //< Constant row spacing, rows are indexed directly
+  double t0 = 0., inv_dt = 0.;
+
+  int rows() const noexcept { return static_cast<int>(time.size()); }
+  bool empty() const noexcept { return time.empty(); }
+  const PREC_G *row(int r) const noexcept { return values.data() + static_cast<std::size_t>(r) * config::g_motion_channels; }
+
+  /// Detect uniform row spacing. Call after filling time.
+  void finalize() {
+    uniform = false;
+    if (rows() < 2) return;
+    double dt = (time.back() - time.front()) / (rows() - 1);
+    if (dt <= 0.) return;
+    for (int r = 1; r < rows(); ++r)
+      if (std::abs((time[r] - time[r - 1]) - dt) > 1e-3 * dt) return; //< Tolerates rounded CSV times
+    uniform = true, t0 = time.front(), inv_dt = 1. / dt;
+  }
+
+  /// @brief All channels at time t into out[g_motion_channels]. Linear between neighbouring rows, first/last row held outside.
+  /// O(1) for uniform rows, O(1) amortized for increasing t otherwise.
+  void evaluate(double t, PREC_G *out) const {
+    constexpr int C = config::g_motion_channels;
+    const int n = rows();
+    if (n == 0) { std::fill(out, out + C, (PREC_G)0); return; }
+    if (n == 1 || t <= time.front()) { std::copy(row(0), row(0) + C, out); return; }
+    if (t >= time.back()) { std::copy(row(n - 1), row(n - 1) + C, out); return; }
+    int r = uniform ? static_cast<int>((t - t0) * inv_dt) : _cursor;
+    r = std::min(std::max(r, 0), n - 2);
+    if (!(time[r] <= t && t < time[r + 1])) {
+      if (r + 2 < n && time[r + 1] <= t && t < time[r + 2]) ++r; //< Next row, usual for increasing t
+      else if (r > 0 && time[r - 1] <= t && t < time[r]) --r; //< Rounding at a uniform row edge
+      else r = static_cast<int>(std::upper_bound(time.begin(), time.end(), t) - time.begin()) - 1;
+    }
+    _cursor = r;
+    double w = (t - time[r]) / (time[r + 1] - time[r]);
+    const PREC_G *a = row(r), *b = row(r + 1);
+    for (int c = 0; c < C; ++c) out[c] = (PREC_G)((1. - w) * a[c] + w * b[c]);
+  }
+
+private:
+  mutable int _cursor = 0; //< Last row found, host evaluation is single-threaded
+};
+
+/// @brief Channel of a CSV column name, e.g. "disp_x", "rot_z", "vel_y", "omega_x". -1 if unknown.
+inline int motion_channel(const std::string &name) {
+  static const char *names[config::g_motion_channels] = {"disp_x", "disp_y", "disp_z", "rot_x", "rot_y", "rot_z",
+                                                         "vel_x", "vel_y", "vel_z", "omega_x", "omega_y", "omega_z"};
+  for (int c = 0; c < config::g_motion_channels; ++c)
+    if (name == names[c]) return c;
+  return -1;
+}
+
+namespace detail {
+inline uint64_t fnv1a(const void *data, std::size_t bytes, uint64_t hash = 1469598103934665603ull) {
+  auto p = static_cast<const unsigned char *>(data);
+  for (std::size_t i = 0; i < bytes; ++i) hash = (hash ^ p[i]) * 1099511628211ull;
+  return hash;
+}
+/// Froude scaling of a channel: lengths by fr, velocities by sqrt(fr), angular velocities by 1/sqrt(fr), angles unchanged
+inline double motion_scale(int c, double fr_scale) {
+  if (c < (int)config::motion_e::RotX) return fr_scale;
+  if (c < (int)config::motion_e::VelX) return 1.;
+  if (c < (int)config::motion_e::OmegaX) return std::sqrt(fr_scale);
+  return 1. / std::sqrt(fr_scale);
+}
+} // namespace detail
+
+/// @brief Parse CSV text: time, then one column per entry of columns (channel index, -1 skips). Rows not starting with a number are skipped.
+/// Times are used if strictly increasing, else row r is at r / row_frequency (unscaled). Velocity channels not given are
+/// central differences of the matching displacement or rotation.
+inline bool parse_motion_csv(const std::string &text, const std::vector<int> &columns, double fr_scale, double row_frequency,
+                             MotionTable &table) {
+  constexpr int C = config::g_motion_channels;
+  table = MotionTable{};
+  bool given[C] = {};
+  for (int c : columns) if (c >= 0 && c < C) given[c] = true;
+  bool increasing = true;
+  const char *p = text.c_str(), *end = p + text.size();
+  while (p < end) {
+    const char *eol = static_cast<const char *>(std::memchr(p, '\n', end - p));
+    if (!eol) eol = end;
+    char *q = nullptr;
+    double t = std::strtod(p, &q);
+    if (q != p && q <= eol) {
+      table.values.resize(table.values.size() + C, (PREC_G)0);
+      PREC_G *row = table.values.data() + table.values.size() - C;
+      for (int c : columns) {
+        while (q < eol && (*q == ',' || *q == ' ' || *q == '\t' || *q == ';')) ++q;
+        const char *field = q;
+        double v = std::strtod(field, &q);
+        if (q == field || q > eol) break;
+        if (c >= 0 && c < C) row[c] = (PREC_G)(v * detail::motion_scale(c, fr_scale));
+      }
+      if (!table.time.empty() && t <= table.time.back()) increasing = false;
+      table.time.push_back(t);
+    }
+    p = eol + 1;
+  }
+  if (table.empty()) return false;
+  for (int r = 0; r < table.rows(); ++r)
+    table.time[r] = increasing ? table.time[r] * std::sqrt(fr_scale) : r / row_frequency;
+  const int n = table.rows();
+  for (int c = 0; c < (int)config::motion_e::VelX; ++c) {
+    int v = c + (int)config::motion_e::VelX;
+    if (given[v] || !given[c] || n < 2) continue;
+    for (int r = 0; r < n; ++r) {
+      int a = std::max(r - 1, 0), b = std::min(r + 1, n - 1);
+      table.values[(std::size_t)r * C + v] = (PREC_G)((table.row(b)[c] - table.row(a)[c]) / (table.time[b] - table.time[a]));
+    }
+  }
+  table.finalize();
+  return true;
+}
+
+/// @brief Load a motion table from CSV file fn. Uses the binary cache "<fn>.mtc" if it was made from the same CSV bytes,
+/// columns and scaling, else parses the CSV and rewrites the cache.
+inline bool load_motion_table(const std::string &fn, const std::vector<int> &columns, double fr_scale, double row_frequency,
+                              MotionTable &table, bool *from_cache = nullptr) {
+  constexpr int C = config::g_motion_channels;
+  if (from_cache) *from_cache = false;
+  std::ifstream csv(fn, std::ios::binary);
+  if (!csv) return false;
+  std::string text{std::istreambuf_iterator<char>(csv), std::istreambuf_iterator<char>()};
+  uint64_t key = detail::fnv1a(text.data(), text.size());
+  key = detail::fnv1a(columns.data(), columns.size() * sizeof(int), key);
+  key = detail::fnv1a(&fr_scale, sizeof(fr_scale), key);
+  key = detail::fnv1a(&row_frequency, sizeof(row_frequency), key);
+  const int32_t value_bytes = sizeof(PREC_G), channels = C;
+
+  const std::string cache_fn = fn + ".mtc";
+  {
+    std::ifstream in(cache_fn, std::ios::binary);
+    char magic[4] = {};
+    uint64_t cached_key = 0;
+    int32_t rows = 0, cached_channels = 0, cached_bytes = 0;
+    in.read(magic, 4);
+    in.read(reinterpret_cast<char *>(&cached_key), sizeof(cached_key));
+    in.read(reinterpret_cast<char *>(&cached_channels), sizeof(cached_channels));
+    in.read(reinterpret_cast<char *>(&cached_bytes), sizeof(cached_bytes));
+    in.read(reinterpret_cast<char *>(&rows), sizeof(rows));
+    if (in && std::memcmp(magic, "MTC1", 4) == 0 && cached_key == key && cached_channels == C && cached_bytes == value_bytes && rows > 0) {
+      table = MotionTable{};
+      table.time.resize(rows);
+      table.values.resize((std::size_t)rows * C);
+      in.read(reinterpret_cast<char *>(table.time.data()), rows * sizeof(double));
+      in.read(reinterpret_cast<char *>(table.values.data()), table.values.size() * sizeof(PREC_G));
+      if (in) {
+        table.finalize();
+        if (from_cache) *from_cache = true;
+        return true;
+      }
+    }
+  }
+
+  if (!parse_motion_csv(text, columns, fr_scale, row_frequency, table)) return false;
+  std::ofstream out(cache_fn, std::ios::binary | std::ios::trunc);
+  if (out) { //< Cache is optional, e.g. read-only input directory
+    int32_t rows = table.rows();
+    out.write("MTC1", 4);
+    out.write(reinterpret_cast<const char *>(&key), sizeof(key));
+    out.write(reinterpret_cast<const char *>(&channels), sizeof(channels));
+    out.write(reinterpret_cast<const char *>(&value_bytes), sizeof(value_bytes));
+    out.write(reinterpret_cast<const char *>(&rows), sizeof(rows));
+    out.write(reinterpret_cast<const char *>(table.time.data()), rows * sizeof(double));
+    out.write(reinterpret_cast<const char *>(table.values.data()), table.values.size() * sizeof(PREC_G));
+  }
+  return true;
+}
+
+} // namespace mn
+
+#endif
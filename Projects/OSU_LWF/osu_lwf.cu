@@ -1,5 +1,6 @@
 #include "mgsp_benchmark.cuh"
 #include "read_scene_input.h"
+#include "read_scene_input_cpu.h"
 #include "partition_domain.h"
 
 #include <MnBase/Geometry/GeometrySampler.h>
@@ -72,16 +73,47 @@ int main(int argc, char *argv[]) {
 
   // IO;
 
-  Cuda::startup(); //< Start CUDA GPUs if available.
-  {
   // ---------------- Read JSON input file for simulation ---------------- 
   cxxopts::Options options("Scene_Loader", "Read simulation scene");
   options.add_options()("f,file", "Scene Configuration File",
-      cxxopts::value<std::string>()->default_value("scene.json")); //< scene.json is default
+      cxxopts::value<std::string>()->default_value("scene.json")) //< scene.json is default
+      ("p,plan", "Dry-run: estimate device memory for the scene and recommend simulation:capacity values. No GPU needed.",
+      cxxopts::value<bool>()->default_value("false"))
+      ("b,backend", "Simulation backend, [gpu] or [cpu] (multi-threaded host). Scene can also set simulation:backend.",
+      cxxopts::value<std::string>()->default_value("gpu"))
+      ("t,threads", "CPU backend threads, 0 for all hardware threads.",
+      cxxopts::value<int>()->default_value("0"));
   auto results = options.parse(argc, argv);
   auto fn = results["file"].as<std::string>();
   fmt::print(fg(fmt::color::green),"Find scene file from command-line option --file={}\n", fn);
-  
+
+  // ---------------- Dry-run memory plan, host only
+  if (results["plan"].as<bool>()) {
+    fmt::print(fg(fmt::color::cyan),"Planning memory for scene file[{}] without device allocation...\n", fn);
+    std::unique_ptr<mn::mgsp_benchmark> simulator; //< Stays empty
+    std::vector<std::array<PREC, 3>> models[g_model_cnt];
+    ScenePlan plan;
+    parse_scene(fn, simulator, models, nullptr, &plan);
+    bool fits = plan.report();
+#if CLUSTER_COMM_STYLE == 1
+    MPI_Finalize();
+#endif
+    return fits ? 0 : 1;
+  }
+
+  // ---------------- CPU backend, no GPU needed
+  if (results["backend"].as<std::string>() == "cpu" || cpu_scene::scene_requests_cpu_backend(fn)) {
+    fmt::print(fg(fmt::color::cyan),"Running scene file[{}] on the CPU backend...\n", fn);
+    int code = cpu_scene::run(fn, results["threads"].as<int>());
+    IO::flush();
+#if CLUSTER_COMM_STYLE == 1
+    MPI_Finalize();
+#endif
+    return code;
+  }
+
+  Cuda::startup(); //< Start CUDA GPUs if available.
+  {
   // ---------------- Initialize the simulation ---------------- 
   std::unique_ptr<mn::mgsp_benchmark> simulator; //< Simulation object pointer
   std::vector<std::array<PREC, 3>> models[g_model_cnt]; //< Initial particle positions
@@ -104,6 +136,11 @@ int main(int argc, char *argv[]) {
   //if(simulator == nullptr) fmt::print(fg(fmt::color::green),"Simulation nullptr after reset.\n");
   }
   // ---------------- Shutdown GPU / CUDA
+  if (g_device_memory_pool) {
+    auto stats = pooled_device_memory_resource::instance().stats();
+    fmt::print(fg(fmt::color::green),"Device memory pool (current GPU): requests[{}], cache hits[{}], cudaMalloc[{}], peak in use[{}] MB, peak reserved[{}] MB.\n", stats.requests, stats.cache_hits, stats.upstream_allocs, stats.peak_bytes_in_use / 1e6, stats.peak_bytes_reserved / 1e6);
+    pooled_device_memory_resource::instance().release(); //< Cached blocks back to CUDA before shut-down
+  }
   Cuda::shutdown();
   fmt::print(fg(fmt::color::green),"Shut-down CUDA GPU communication.\n");
   cudaDeviceReset();
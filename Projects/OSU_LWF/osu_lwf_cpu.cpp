@@ -0,0 +1,42 @@
+#include "read_scene_input_cpu.h"
+
+#include <MnSystem/IO/IO.h>
+
+#include <cxxopts.hpp>
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+#include <string>
+
+/// @brief Host-only osu_lwf for machines without CUDA. Runs the scene on the multi-threaded CPU backend (cpu_benchmark.h).
+/// @param argv For an executable [osu_lwf] with scene file [scene.json], use Command-line: ./osu_lwf --file=scene.json --threads=8. Size device memory for the GPU build with --plan
+int main(int argc, char *argv[]) {
+  using namespace mn;
+
+  cxxopts::Options options("Scene_Loader", "Read simulation scene");
+  options.add_options()("f,file", "Scene Configuration File",
+      cxxopts::value<std::string>()->default_value("scene.json")) //< scene.json is default
+      ("b,backend", "Simulation backend. Only [cpu] in builds without CUDA.",
+      cxxopts::value<std::string>()->default_value("cpu"))
+      ("t,threads", "CPU backend threads, 0 for all hardware threads.",
+      cxxopts::value<int>()->default_value("0"))
+      ("p,plan", "Dry-run: estimate device memory of the scene for the GPU build, print recommended settings and exit. No GPU needed.",
+      cxxopts::value<bool>()->default_value("false"));
+  auto results = options.parse(argc, argv);
+  auto fn = results["file"].as<std::string>();
+  fmt::print(fg(fmt::color::green),"Find scene file from command-line option --file={}\n", fn);
+  if (results["plan"].as<bool>()) {
+    int code = cpu_scene::plan(fn);
+    IO::flush();
+    return code;
+  }
+  if (results["backend"].as<std::string>() != "cpu") {
+    fmt::print(fg(fmt::color::red), "ERROR: Backend [{}] not available, osu_lwf was built without CUDA. Use --backend=cpu.\n", results["backend"].as<std::string>());
+    return 1;
+  }
+
+  int code = cpu_scene::run(fn, results["threads"].as<int>());
+  IO::flush();
+  fmt::print(fg(fmt::color::green), code ? "Application failed.\n" : "Application finished.\n");
+  return code;
+}
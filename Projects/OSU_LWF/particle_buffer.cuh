@@ -1,5 +1,6 @@
 #ifndef __PARTICLE_BUFFER_CUH_
 #define __PARTICLE_BUFFER_CUH_
+#include "buffer_layouts.h"
 #include "settings.cuh"
 #include "constitutive_models.cuh"
 #include "utility_funcs.hpp"
@@ -11,13 +12,6 @@
 
 namespace mn {
 
-using ParticleBinDomain = aligned_domain<char, config::g_bin_capacity>;
-using ParticleBufferDomain = compact_domain<int, config::g_max_particle_bin>;
-using ParticleArrayDomain = compact_domain<int, config::g_max_particle_num>;
-using ParticleArrayHalfDomain = compact_domain<int, config::g_max_particle_num / 2>;
-using ParticleArrayEigthDomain = compact_domain<int, config::g_max_particle_num / 8>;
-using ParticleTargetDomain = compact_domain<int, config::g_max_particle_target_nodes>;
-
 // * All  particle attributes available for ouput.
 // * Not all materials will support every output.
 enum class particle_output_attribs_e : int {
@@ -64,142 +58,6 @@ enum class particle_output_attribs_e : int {
         ExampleDeprecatedVariable //< Will give INVALID_CT output of -2
 };
 
-using particle_bin4_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_,
-               f_>; ///< pos, J
-using particle_bin6_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_,
-               f_, f_, f_>; ///< pos, J, JBar, ID
-using particle_bin7_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_,
-               f_, f_, f_, f_>; ///< pos, J / ID, vel
-using particle_bin9_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, f_, 
-               f_, f_, f_, 
-               f_, f_>; ///< pos, J, vel, vol JBar
-using particle_bin11_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_,
-               f_, f_, f_, f_, f_,
-               f_, f_, f_>; ///< pos, ID, forces, restVolume, normals
-using particle_bin12_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_>; ///< pos, F
-using particle_bin13_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, f_,
-               f_, f_, f_, f_, f_, f_, f_, f_,
-               f_>; ///< pos, F, logJp
-using particle_bin14_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, f_,
-               f_, f_, f_, f_, f_, f_, f_, f_,
-               f_, f_>; ///< pos, F, logJp, vel               
-using particle_bin15_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, f_,
-               f_, f_, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_>; ///< pos, F, vel
-using particle_bin16_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, f_,
-               f_, f_, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_>; ///< pos, F, logJp, vel
-using particle_bin17_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_,
-               f_, 
-               f_>; ///< pos, F, vel, J_Bar, ID
-using particle_bin18_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_,
-               f_, f_,
-               f_>; ///< pos, F, vel, vol_Bar, J_Bar, ID
-using particle_bin19_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_,
-               f_, f_,
-               f_,
-               f_>; ///< pos, F, vel, vol_Bar, J_Bar, etc, ID
-using particle_bin20_f_ =
-    structural<structural_type::dense,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::sum_pow2_align>,
-               ParticleBinDomain, attrib_layout::soa, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_,
-               f_, f_,
-               f_, f_,
-               f_>; ///< pos, F, vel, vol_Bar, J_Bar, mass_water, rho_water, ID
-
-template <material_e mt> struct particle_bin_;
-template <> struct particle_bin_<material_e::JFluid> : particle_bin4_f_ {}; // No ID
-template <> struct particle_bin_<material_e::JFluid_ASFLIP> : particle_bin7_f_ {}; // No ID
-template <> struct particle_bin_<material_e::JFluid_FBAR> : particle_bin6_f_ {};
-template <> struct particle_bin_<material_e::JBarFluid> : particle_bin9_f_ {};
-template <> struct particle_bin_<material_e::FixedCorotated> : particle_bin13_f_ {};
-template <> struct particle_bin_<material_e::FixedCorotated_ASFLIP> : particle_bin16_f_ {};
-template <> struct particle_bin_<material_e::FixedCorotated_FBAR> : particle_bin14_f_ {};
-template <> struct particle_bin_<material_e::FixedCorotated_ASFLIP_FBAR> : particle_bin17_f_ {};
-template <> struct particle_bin_<material_e::NeoHookean> : particle_bin13_f_ {};
-template <> struct particle_bin_<material_e::NeoHookean_ASFLIP> : particle_bin16_f_ {};
-template <> struct particle_bin_<material_e::NeoHookean_FBAR> : particle_bin14_f_ {};
-template <> struct particle_bin_<material_e::NeoHookean_ASFLIP_FBAR> : particle_bin17_f_ {};
-template <> struct particle_bin_<material_e::Sand> : particle_bin14_f_ {};
-template <> struct particle_bin_<material_e::Sand_ASFLIP> : particle_bin17_f_ {};
-template <> struct particle_bin_<material_e::Sand_FBAR> : particle_bin15_f_ {};
-template <> struct particle_bin_<material_e::Sand_ASFLIP_FBAR> : particle_bin18_f_ {};
-template <> struct particle_bin_<material_e::NACC> : particle_bin14_f_ {};
-template <> struct particle_bin_<material_e::NACC_ASFLIP> : particle_bin17_f_ {};
-template <> struct particle_bin_<material_e::NACC_FBAR> : particle_bin15_f_ {};
-template <> struct particle_bin_<material_e::NACC_ASFLIP_FBAR> : particle_bin18_f_ {};
-template <> struct particle_bin_<material_e::CoupledUP> : particle_bin20_f_ {}; //< Changed to bin20 (JB)
-template <> struct particle_bin_<material_e::Meshed> : particle_bin11_f_ {};
-template <> struct particle_bin_<material_e::VonMises> : particle_bin13_f_ {};
-
-template <typename ParticleBin>
-using particle_buffer_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleBufferDomain, attrib_layout::aos, ParticleBin>;
 
 template <material_e mt>
 struct ParticleBufferImpl : Instance<particle_buffer_<particle_bin_<mt>>> {
@@ -3613,125 +3471,6 @@ using particle_buffer_t =
             ParticleBuffer<material_e::Meshed>,
             ParticleBuffer<material_e::VonMises>>;
 
-using particle_array_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_>;
-using particle_array_0_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, empty_>;
-using particle_array_1_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_>;
-using particle_array_2_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_>;
-using particle_array_3_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_>;
-using particle_array_4_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_>;
-using particle_array_5_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_>;
-using particle_array_6_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_>;
-using particle_array_7_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_8_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_9_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_10_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_>;
-using particle_array_11_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_>;
-using particle_array_12_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_>;
-using particle_array_13_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_14_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_15_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_16_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_18_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_24_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_,
-               f_, f_, f_, f_, f_, f_, f_, f_, f_>;
-using particle_array_32_ =
-    structural<structural_type::dynamic,
-               decorator<structural_allocation_policy::full_allocation,
-                         structural_padding_policy::compact>,
-               ParticleArrayDomain, attrib_layout::aos, f_, f_, f_, f_, f_, f_, 
-               f_, f_, f_, f_, f_, f_, f_, f_, f_,
-               f_, f_, f_, f_, f_, f_, f_, f_, f_,
-               f_, f_, f_, f_, f_, f_, f_, f_, f_>;
-
 struct ParticleArray : Instance<particle_array_> {
   using base_t = Instance<particle_array_>;
 	ParticleArray() = default;
@@ -3744,114 +3483,46 @@ struct ParticleArray : Instance<particle_array_> {
   //ParticleArray(base_t &&instance) { static_cast<base_t &>(*this) = instance; }
 };
 
-template <num_attribs_e N> struct particle_attrib_;
-template <> struct particle_attrib_<num_attribs_e::Zero> : particle_array_0_ {};
-template <> struct particle_attrib_<num_attribs_e::One> : particle_array_1_ {};
-template <> struct particle_attrib_<num_attribs_e::Two> : particle_array_2_ {};
-template <> struct particle_attrib_<num_attribs_e::Three> : particle_array_3_ {};
-template <> struct particle_attrib_<num_attribs_e::Four> : particle_array_4_ {}; //
-template <> struct particle_attrib_<num_attribs_e::Five> : particle_array_5_ {}; //
-template <> struct particle_attrib_<num_attribs_e::Six> : particle_array_6_ {};
-template <> struct particle_attrib_<num_attribs_e::Seven> : particle_array_7_ {}; //
-template <> struct particle_attrib_<num_attribs_e::Eight> : particle_array_8_ {}; //
-template <> struct particle_attrib_<num_attribs_e::Nine> : particle_array_9_ {};
-// template <> struct particle_attrib_<num_attribs_e::Ten> : particle_array_10_ {}; //
-// template <> struct particle_attrib_<num_attribs_e::Eleven> : particle_array_11_ {}; //
-// template <> struct particle_attrib_<num_attribs_e::Twelve> : particle_array_12_ {};
-// template <> struct particle_attrib_<num_attribs_e::Thirteen> : particle_array_13_ {};
-// template <> struct particle_attrib_<num_attribs_e::Fourteen> : particle_array_14_ {};
-// template <> struct particle_attrib_<num_attribs_e::Fifteen> : particle_array_15_ {};
-// template <> struct particle_attrib_<num_attribs_e::Sixteen> : particle_array_16_ {};
-// template <> struct particle_attrib_<num_attribs_e::Eighteen> : particle_array_18_ {};
-// template <> struct particle_attrib_<num_attribs_e::Twentyfour> : particle_array_24_ {};
-// template <> struct particle_attrib_<num_attribs_e::Thirtytwo> : particle_array_32_ {};
-
-template<num_attribs_e N=num_attribs_e::Three>
-struct ParticleAttrib: Instance<particle_attrib_<N>> {
-  static constexpr unsigned numAttributes = static_cast<unsigned>(N);
-  using base_t = Instance<particle_attrib_<N>>;
-  
-	// ParticleAttrib() = default;
-	// explicit ParticleAttrib(base_t&& instance)//NOLINT(cppcoreguidelines-rvalue-reference-param-not-moved) Clang say, that std::move has no effect here
-	// 	: base_t(instance) {}
+/// @brief Per-particle attributes (input or output) in a strided AoS layout, i.e. [parid * numAttributes + attrib].
+/// Attribute count is a run-time stride so kernels are not instantiated per count.
+struct ParticleAttrib {
+  PREC *_attribs = nullptr; //< Device array, numAttributes * _count elements
+  unsigned numAttributes = 0; //< Run-time stride (attributes per particle)
+  std::size_t _count = 0; //< Particle capacity
 
-  // // Default constructor
-  // template <typename Allocator>
-  // ParticleAttrib(Allocator allocator) : base_t{spawn<particle_attrib_<N>, orphan_signature>(allocator)} { 
-  //     std::cout << "ParticleAttrib constructor with an allocator." << "\n";
-  // }
+  ParticleAttrib() = default;
 
-  // Default constructor
   template <typename Allocator>
-  ParticleAttrib(Allocator allocator, std::size_t count) : base_t{spawn<particle_attrib_<N>, orphan_signature>(allocator, count)} { 
-      std::cout << "ParticleAttrib constructor with an allocator." << "\n";
+  ParticleAttrib(Allocator allocator, std::size_t count, unsigned num_attribs)
+      : numAttributes{num_attribs}, _count{count} {
+    if (numAttributes && _count)
+      _attribs = static_cast<PREC *>(allocator.allocate(bytes()));
   }
 
+  template <typename Allocator> void deallocate(Allocator allocator) {
+    if (_attribs) allocator.deallocate(_attribs, bytes());
+    _attribs = nullptr;
+    numAttributes = 0, _count = 0;
+  }
 
-  // // Move assignment operator
-  // ParticleAttrib &operator=(base_t &&instance) {
-  //   std::cout << "ParticleAttrib move assignment operator called." << "\n";
-  //   static_cast<base_t &>(*this) = instance;
-  //   return *this;
-  // }
-  // // Move constructor
-  // ParticleAttrib(base_t &&instance) { 
-  //   std::cout << "ParticleAttrib move constructor called." << "\n";
-  //   static_cast<base_t &>(*this) = instance; 
-  // }
-
-  // // Move assignment operator
-  // ParticleAttrib &operator=(ParticleAttrib &&instance) {
-  //   std::cout << "ParticleAttrib move assignment operator called." << "\n";
-  //   static_cast<base_t &>(*this) = instance;
-  //   return *this;
-  // }
+  std::size_t bytes() const noexcept { return sizeof(PREC) * numAttributes * _count; }
+  __forceinline__ __host__ __device__ PREC *data() const noexcept { return _attribs; }
 
+  /// @brief Unchecked access, attrib < numAttributes is assumed.
+  template <typename I, typename T>
+  __forceinline__ __device__ PREC &val(I attrib, T parid) const {
+    return _attribs[static_cast<std::size_t>(parid) * numAttributes + static_cast<unsigned>(attrib)];
+  }
 
-  template <num_attribs_e ATTRIBUTE, typename T>
-   __device__ PREC
-  getAttribute(T parid){
-    if (ATTRIBUTE >= N) return (PREC)-1;
-    else return this->val(std::integral_constant<unsigned, std::min(static_cast<unsigned>(ATTRIBUTE), static_cast<unsigned>(N))>{}, parid);
-  }
-  template <num_attribs_e ATTRIBUTE, typename T>
-   __device__ void
-  getAttribute(T parid, PREC & val){
-    if (ATTRIBUTE >= N) val = (PREC)-1;
-    else return this->val(std::integral_constant<unsigned, std::min(static_cast<unsigned>(ATTRIBUTE), static_cast<unsigned>(N))>{}, parid);
-  }
-  // template <num_attribs_e ATTRIBUTE, typename T>
-  //  __device__ constexpr void
-  // setAttribute(const T parid, const PREC val){
-  //   if (ATTRIBUTE >= this.numAttributes) return;
-  //   else{
-  //     this->val(std::integral_constant<unsigned, std::min(ATTRIBUTE, this.numAttributes)>{}, parid) = val;
-  //     return;
-  //   }
-  // }
+  /// @brief Checked access, returns (PREC)-1 if attribute is not held.
+  template <typename I, typename T>
+  __forceinline__ __device__ PREC getAttribute(I attrib, T parid) const {
+    if (static_cast<unsigned>(attrib) >= numAttributes) return (PREC)-1;
+    return val(attrib, parid);
+  }
 };
 
-using particle_attrib_t =
-    variant<ParticleAttrib<num_attribs_e::One>,
-            ParticleAttrib<num_attribs_e::Two>,
-            ParticleAttrib<num_attribs_e::Three>,
-            ParticleAttrib<num_attribs_e::Four>,
-            ParticleAttrib<num_attribs_e::Five>,
-            ParticleAttrib<num_attribs_e::Six>,
-            ParticleAttrib<num_attribs_e::Seven>,
-            ParticleAttrib<num_attribs_e::Eight>,
-            ParticleAttrib<num_attribs_e::Nine>,
-            // ParticleAttrib<num_attribs_e::Ten>,
-            // ParticleAttrib<num_attribs_e::Eleven>,
-            // ParticleAttrib<num_attribs_e::Twelve>,
-            // ParticleAttrib<num_attribs_e::Thirteen>
-            // ParticleAttrib<num_attribs_e::Fourteen>,
-            // ParticleAttrib<num_attribs_e::Fifteen>,
-            // ParticleAttrib<num_attribs_e::Sixteen>,
-            // ParticleAttrib<num_attribs_e::Eighteen>,
-            // ParticleAttrib<num_attribs_e::Twentyfour>,
-            // ParticleAttrib<num_attribs_e::Thirtytwo>
-            >;
+using particle_attrib_t = ParticleAttrib;
 
 
 using particle_target_ =
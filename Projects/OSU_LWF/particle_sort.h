@@ -0,0 +1,97 @@
+#ifndef __PARTICLE_SORT_H_
+#define __PARTICLE_SORT_H_
+#include "settings.cuh"
+#include <MnBase/Concurrency/Concurrency.h>
+#include <MnBase/Math/Bit/Bits.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace mn {
+
+/// @brief Host-side space-filling-curve ordering of particles before upload.
+/// Particles sharing a grid-block become contiguous, so binning and P2G/G2P touch fewer blocks per warp.
+/// Keys are curve codes of the particle's cell. Blocks are aligned 2^k cubes, so both curves keep each block contiguous.
+
+enum class curve_e { None, Morton, Hilbert };
+
+inline curve_e parse_curve(const std::string &name) {
+  if (name == "Morton" || name == "morton" || name == "Z" || name == "z-order") return curve_e::Morton;
+  if (name == "Hilbert" || name == "hilbert") return curve_e::Hilbert;
+  return curve_e::None;
+}
+
+/// @brief Curve key of a particle position in the 1x1x1 simulation domain. Cell matches activate_blocks kernel.
+template <typename T>
+inline uint64_t particle_curve_key(const std::array<T, 3> &pos, curve_e curve) {
+  uint32_t cell[3];
+  for (int d = 0; d < 3; ++d)
+    cell[d] = static_cast<uint32_t>(std::max(0L, std::lround(pos[d] * config::g_dx_inv_d) - 2L));
+  if (curve == curve_e::Hilbert) return hilbert_encode_3d(cell[0], cell[1], cell[2]);
+  return morton_encode_3d(cell[0], cell[1], cell[2]);
+}
+
+/// @brief Parallel stable sort of particle indices by curve key. Chunks are sorted on threads, then merged pairwise.
+/// @return order[sorted_id] = original_id
+template <typename T>
+std::vector<int> curve_order(const std::vector<std::array<T, 3>> &positions, curve_e curve,
+                             unsigned num_threads = std::thread::hardware_concurrency()) {
+  const std::size_t n = positions.size();
+  std::vector<int> order(n);
+  if (curve == curve_e::None || n == 0) {
+    for (std::size_t i = 0; i < n; ++i) order[i] = static_cast<int>(i);
+    return order;
+  }
+  num_threads = std::max(1u, std::min<unsigned>(num_threads, (n + 4095) / 4096)); //< No threads for tiny bodies
+  const std::size_t chunk = (n + num_threads - 1) / num_threads;
+
+  std::vector<std::pair<uint64_t, int>> keys(n);
+  std::vector<std::future<void>> jobs;
+  for (unsigned t = 0; t < num_threads; ++t) {
+    std::size_t begin = std::min(n, t * chunk), end = std::min(n, begin + chunk);
+    jobs.emplace_back(reallyAsync([&, begin, end]() {
+      for (std::size_t i = begin; i < end; ++i) keys[i] = {particle_curve_key(positions[i], curve), static_cast<int>(i)};
+      std::sort(keys.begin() + begin, keys.begin() + end); //< (key, id) pairs, so ties keep original order
+    }));
+  }
+  for (auto &job : jobs) job.get();
+
+  for (std::size_t width = chunk; width < n; width *= 2) {
+    jobs.clear();
+    for (std::size_t begin = 0; begin + width < n; begin += 2 * width) {
+      std::size_t mid = begin + width, end = std::min(n, begin + 2 * width);
+      jobs.emplace_back(reallyAsync([&, begin, mid, end]() {
+        std::inplace_merge(keys.begin() + begin, keys.begin() + mid, keys.begin() + end); }));
+    }
+    for (auto &job : jobs) job.get();
+  }
+  for (std::size_t i = 0; i < n; ++i) order[i] = keys[i].second;
+  return order;
+}
+
+/// @brief Reorder values in place so values[sorted_id] = old values[order[sorted_id]].
+template <typename V>
+void apply_order(std::vector<V> &values, const std::vector<int> &order) {
+  if (values.size() != order.size()) return; //< e.g. no per-particle attributes
+  std::vector<V> sorted;
+  sorted.reserve(values.size());
+  for (int id : order) sorted.push_back(std::move(values[id]));
+  values = std::move(sorted);
+}
+
+/// @brief Inverse of order, i.e. remap[original_id] = sorted_id.
+inline std::vector<int> invert_order(const std::vector<int> &order) {
+  std::vector<int> remap(order.size());
+  for (std::size_t i = 0; i < order.size(); ++i) remap[order[i]] = static_cast<int>(i);
+  return remap;
+}
+
+} // namespace mn
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef __PARTICLE_STREAM_H_
+#define __PARTICLE_STREAM_H_
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+namespace mn {
+
+/// @brief Streaming particle initialization. Samplers write to a ParticleStream as they would to a std::vector,
+/// and the stream hands fixed-size chunks of positions to a sink that uploads and releases them.
+/// Host memory then holds one chunk per body rather than the whole model.
+
+/// @brief Receives positions in emission order. offset is the model index of chunk[0].
+template <typename T>
+struct ParticleSink {
+  virtual ~ParticleSink() = default;
+  virtual void consume(std::size_t offset, const std::array<T, 3> *chunk, std::size_t count) = 0;
+};
+
+/// @brief Keeps every chunk in host memory, same result as sampling into a vector. Checks streamed samplers without a GPU.
+template <typename T>
+struct HostParticleSink : ParticleSink<T> {
+  std::vector<std::array<T, 3>> particles;
+  std::size_t chunks = 0;
+  void consume(std::size_t offset, const std::array<T, 3> *chunk, std::size_t count) override {
+    if (particles.size() < offset + count) particles.resize(offset + count); //< Written at offset, as uploadParticles
+    std::copy(chunk, chunk + count, particles.begin() + offset);
+    ++chunks;
+  }
+};
+
+/// @brief Uploads chunks into a model already allocated on device with its final count (see mgsp_benchmark::initModel).
+template <typename T, typename Simulator>
+struct DeviceParticleSink : ParticleSink<T> {
+  Simulator &sim;
+  int gpu_id, model_id;
+  DeviceParticleSink(Simulator &sim, int gpu_id, int model_id) : sim{sim}, gpu_id{gpu_id}, model_id{model_id} {}
+  void consume(std::size_t offset, const std::array<T, 3> *chunk, std::size_t count) override {
+    sim.uploadParticles(gpu_id, model_id, offset, chunk, count);
+  }
+};
+
+/// @brief Vector-like sampler output (push_back, size) buffering at most chunk_size positions before handing them to the sink.
+/// Without a sink it only counts, e.g. to size device buffers before the streaming pass.
+template <typename T>
+class ParticleStream {
+public:
+  using value_type = std::array<T, 3>;
+  explicit ParticleStream(std::size_t chunk_size = 0, ParticleSink<T> *sink = nullptr)
+      : _chunk{chunk_size ? chunk_size : 1}, _sink{sink} {
+    if (_sink) _buffer.reserve(_chunk);
+  }
+
+  void push_back(const value_type &particle) {
+    ++_count;
+    if (!_sink) return;
+    _buffer.push_back(particle);
+    if (_buffer.size() >= _chunk) flush();
+  }
+  /// Particles emitted so far, flushed or not. Matches vector size() for tracker offsets.
+  std::size_t size() const noexcept { return _count; }
+  std::size_t chunks() const noexcept { return _chunks; }
+  std::size_t buffer_bytes() const noexcept { return _buffer.capacity() * sizeof(value_type); }
+
+  /// Hand buffered positions to the sink. Call once sampling is done.
+  void flush() {
+    if (!_sink || _buffer.empty()) return;
+    _sink->consume(_count - _buffer.size(), _buffer.data(), _buffer.size());
+    _buffer.clear();
+    ++_chunks;
+  }
+
+private:
+  std::size_t _chunk;
+  ParticleSink<T> *_sink;
+  std::vector<value_type> _buffer;
+  std::size_t _count = 0, _chunks = 0;
+};
+
+} // namespace mn
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef __PARTITIONER_H_
+#define __PARTITIONER_H_
+#include "settings.cuh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mn {
+
+/// @brief Host-side load-balancing of particle bodies across devices.
+/// Recursive coordinate bisection (RCB) on grid-block keys, weighted by particle count * material cost.
+/// Cuts are made only on grid-block boundaries, so each device owns whole blocks.
+
+using block_key_t = std::array<int, 3>;
+
+/// @brief Grid-block of a particle position in the 1x1x1 simulation domain. Matches activate_blocks kernel.
+template <typename T>
+inline block_key_t particle_block_key(const std::array<T, 3> &pos) {
+  block_key_t key;
+  for (int d = 0; d < 3; ++d) {
+    int cell = static_cast<int>(std::lround(pos[d] * config::g_dx_inv_d)) - 2;
+    key[d] = (cell >= 0) ? cell / config::g_blocksize
+                         : -((-cell + config::g_blocksize - 1) / config::g_blocksize);
+  }
+  return key;
+}
+
+/// @brief Pack a signed 3D block (or cell) key into 64 bits, 21 bits per axis. For host-side hashing.
+inline uint64_t pack_block_key(const block_key_t &b) noexcept {
+  constexpr int bits = 21, bias = 1 << (bits - 1);
+  constexpr uint64_t mask = (uint64_t{1} << bits) - 1;
+  return ((uint64_t)(b[0] + bias) & mask) << (2 * bits) |
+         ((uint64_t)(b[1] + bias) & mask) << bits |
+         ((uint64_t)(b[2] + bias) & mask);
+}
+inline block_key_t unpack_block_key(uint64_t k) noexcept {
+  constexpr int bits = 21, bias = 1 << (bits - 1);
+  constexpr uint64_t mask = (uint64_t{1} << bits) - 1;
+  return block_key_t{(int)((k >> (2 * bits)) & mask) - bias,
+                     (int)((k >> bits) & mask) - bias,
+                     (int)(k & mask) - bias};
+}
+
+/// @brief Position (1x1x1 domain) of the lower face of grid-block b, i.e. first position that maps into block b.
+inline double block_face_position(int b) {
+  return (static_cast<double>(b) * config::g_blocksize + 1.5) * config::g_dx_d;
+}
+
+/// @brief Relative per-particle cost of a constitutive law in the G2P2G pipeline. JFluid = 1.
+inline double material_cost(const std::string &constitutive) {
+  auto is = [&](std::initializer_list<const char *> names) {
+    for (auto n : names) if (constitutive == n) return true;
+    return false;
+  };
+  if (is({"FixedCorotated", "Fixed_Corotated", "Fixed-Corotated", "Fixed Corotated", "fixedcorotated", "fixed_corotated", "fixed-corotated", "fixed corotated"})) return 1.6; //< SVD
+  if (is({"NeoHookean", "neohookean", "Neo-Hookean", "neo-hookean"})) return 1.6; //< SVD
+  if (is({"VonMises", "Von_Mises", "Von-Mises", "Von Mises", "vonmises", "von_mises", "von-mises", "von mises"})) return 2.0; //< SVD + return mapping
+  if (is({"Sand", "sand", "DruckerPrager", "Drucker_Prager", "Drucker-Prager", "Drucker Prager"})) return 2.0; //< SVD + return mapping
+  if (is({"NACC", "nacc", "CamClay", "Cam_Clay", "Cam-Clay", "Cam Clay"})) return 2.2; //< SVD + return mapping + hardening
+  if (is({"CoupledUP", "coupled", "up", "UP", "coupledup", "undrained"})) return 2.5; //< Extra pore-pressure transfer
+  return 1.0; //< JFluid variants and unknowns
+}
+
+/// @brief Weighted grid-block loads accumulated over all particle bodies to be partitioned.
+struct BlockLoads {
+  /// Add particles of a body, each weighing cost.
+  template <typename T>
+  void add(const std::vector<std::array<T, 3>> &positions, double cost) {
+    for (auto &pos : positions) {
+      auto &entry = _loads[pack(particle_block_key(pos))];
+      entry.first += cost;
+      entry.second += 1;
+    }
+  }
+  std::size_t size() const noexcept { return _loads.size(); }
+
+  struct Load {
+    block_key_t blockid;
+    double weight;
+    std::size_t count; //< Particle count
+  };
+  std::vector<Load> loads() const {
+    std::vector<Load> ret;
+    ret.reserve(_loads.size());
+    for (auto &kv : _loads) ret.push_back(Load{unpack(kv.first), kv.second.first, kv.second.second});
+    return ret;
+  }
+
+private:
+  static uint64_t pack(const block_key_t &b) noexcept { return pack_block_key(b); }
+  static block_key_t unpack(uint64_t k) noexcept { return unpack_block_key(k); }
+  std::unordered_map<uint64_t, std::pair<double, std::size_t>> _loads;
+};
+
+/// @brief Axis-aligned box of grid-blocks [lo, hi) owned by one device.
+struct PartitionBox {
+  block_key_t lo, hi;
+  double weight = 0.;
+  std::size_t count = 0; //< Particle count
+  std::size_t blocks = 0; //< Active grid-block count
+};
+
+namespace detail {
+using load_iter = std::vector<BlockLoads::Load>::iterator;
+
+inline void rcb_bisect(load_iter begin, load_iter end, block_key_t lo, block_key_t hi,
+                       int num_parts, std::vector<PartitionBox> &parts) {
+  if (num_parts <= 1) {
+    PartitionBox box{lo, hi};
+    for (auto it = begin; it != end; ++it) box.weight += it->weight, box.count += it->count;
+    box.blocks = static_cast<std::size_t>(end - begin);
+    parts.push_back(box);
+    return;
+  }
+  double total = 0.;
+  for (auto it = begin; it != end; ++it) total += it->weight;
+  const int left_parts = num_parts / 2;
+  const double target = total * left_parts / num_parts;
+
+  // Best cut per axis. Cut c puts blocks with blockid[axis] < c on the left.
+  // Halo cost of a cut ~ active blocks touching the cut plane on either side.
+  struct Cut { int axis = -1; int c = 0; double imbalance = 0.; std::size_t halo = 0; };
+  Cut best_cut[3];
+  for (int axis = 0; axis < 3; ++axis) {
+    std::sort(begin, end, [axis](const BlockLoads::Load &a, const BlockLoads::Load &b) {
+      return a.blockid[axis] < b.blockid[axis]; });
+    if (begin == end || begin->blockid[axis] == (end - 1)->blockid[axis]) continue; //< Single plane, cannot cut
+    double left = 0.;
+    Cut cut;
+    for (auto it = begin; it != end;) {
+      int c = it->blockid[axis];
+      auto plane_end = it;
+      double plane_weight = 0.;
+      while (plane_end != end && plane_end->blockid[axis] == c) plane_weight += (plane_end++)->weight;
+      if (it != begin) { //< Cut at lower face of plane c
+        double imbalance = std::abs(left - target);
+        if (cut.axis < 0 || imbalance < cut.imbalance) cut = Cut{axis, c, imbalance, 0};
+      }
+      left += plane_weight;
+      it = plane_end;
+    }
+    for (auto it = begin; it != end; ++it)
+      if (it->blockid[axis] == cut.c || it->blockid[axis] == cut.c - 1) cut.halo++;
+    best_cut[axis] = cut;
+  }
+
+  // Most balanced cut, preferring fewer halo blocks among near-balanced cuts
+  Cut chosen;
+  for (auto &cut : best_cut)
+    if (cut.axis >= 0 && (chosen.axis < 0 || cut.imbalance < chosen.imbalance)) chosen = cut;
+  if (chosen.axis < 0) { //< All blocks on one plane in every axis (single block), nothing to split
+    rcb_bisect(begin, end, lo, hi, 1, parts);
+    for (int p = 1; p < num_parts; ++p) parts.push_back(PartitionBox{hi, hi});
+    return;
+  }
+  const double tolerance = 0.02 * total;
+  for (auto &cut : best_cut)
+    if (cut.axis >= 0 && cut.imbalance <= chosen.imbalance + tolerance && cut.halo < chosen.halo) chosen = cut;
+
+  const int axis = chosen.axis;
+  auto mid = std::partition(begin, end, [&](const BlockLoads::Load &l) { return l.blockid[axis] < chosen.c; });
+  block_key_t left_hi = hi, right_lo = lo;
+  left_hi[axis] = right_lo[axis] = chosen.c;
+  rcb_bisect(begin, mid, lo, left_hi, left_parts, parts);
+  rcb_bisect(mid, end, right_lo, hi, num_parts - left_parts, parts);
+}
+} // namespace detail
+
+/// @brief Split weighted grid-blocks into num_parts boxes of near-equal weight by recursive coordinate bisection.
+/// @param lo Lower grid-block bound of the domain (inclusive).
+/// @param hi Upper grid-block bound of the domain (exclusive).
+/// @return Boxes tiling [lo, hi), one per part, in device order.
+inline std::vector<PartitionBox> rcb_partition(const BlockLoads &block_loads, int num_parts,
+                                               block_key_t lo, block_key_t hi) {
+  std::vector<PartitionBox> parts;
+  if (num_parts < 1) return parts;
+  auto loads = block_loads.loads();
+  detail::rcb_bisect(loads.begin(), loads.end(), lo, hi, num_parts, parts);
+  return parts;
+}
+
+} // namespace mn
+
+#endif
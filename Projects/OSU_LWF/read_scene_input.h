@@ -2,9 +2,18 @@
 #define __READ_SCENE_INPUT_H_
 #include "mgsp_benchmark.cuh"
 #include "partition_domain.h"
+#include "partitioner.h"
+#include "particle_sort.h"
+#include "memory_planner.h"
+#include "motion_table.h"
+#include "instancing.h"
+#include "body_pipeline.h"
+#include "particle_stream.h"
 #include <MnBase/Math/Vec.cuh>
 #include <MnBase/Geometry/GeometrySampler.h>
+#include <MnBase/Geometry/MeshVoxelizer.h>
 #include <MnSystem/IO/IO.h>
+#include <MnSystem/IO/MeshIO.hpp>
 #include <MnSystem/IO/ParticleIO.hpp>
 
 #include <cxxopts.hpp>
@@ -17,7 +26,13 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <functional>
+#include <future>
+#include <limits>
+#include <thread>
+#include <tuple>
 
 #if CLUSTER_COMM_STYLE == 1
 #include <mpi.h>
@@ -67,6 +82,7 @@ namespace fs = std::filesystem;
 // #endif
 
 #include <rapidjson/document.h>
+#include <rapidjson/prettywriter.h>
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 namespace rj = rapidjson;
@@ -84,7 +100,6 @@ typedef std::vector<std::array<PREC, 3>> PositionHolder;
 typedef std::vector<std::array<PREC, 13>> VerticeHolder;
 typedef std::vector<std::array<int, 4>> ElementHolder;
 typedef std::vector<std::array<PREC, 6>> ElementAttribsHolder;
-typedef std::vector<std::array<PREC_G, 3>> MotionHolder;
 
 PREC o = mn::config::g_offset; //< Grid-cell buffer size (see off-by-2, Xinlei Wang)
 PREC l = mn::config::g_length; //< Domain max length default
@@ -438,13 +453,14 @@ void load_csv_particles(const std::string& filename, char sep,
 
 /// @brief Make box as particles, write to fields as [x,y,z] data.
 /// @brief Assume span, offset, radius, partition_start/end are already scaled to 1x1x1 domain. 
-/// @param fields Vector of arrays to write particle position [x,y,z] data into
+/// @param fields Vector of arrays (or mn::ParticleStream) to write particle position [x,y,z] data into
 /// @param span Sets max span to look in (for efficiency). Erases particles if too low.
 /// @param offset Offsets starting corner of particle object from origin. Assume simulation's grid buffer is already included (offset += g_offset, e.g. 8*g_dx).
 /// @param ppc Particle-per-cell, number of particles to sample per 3D grid-cell (e.g. 8).
 /// @param partition_start Start corner of particle GPU partition, cut out everything before.
 /// @param partition_end End corner of particle GPU partition, cut out everything beyond.
-void make_box(std::vector<std::array<PREC, 3>>& fields, 
+template <typename Fields>
+void make_box(Fields& fields, 
                         mn::vec<PREC, 3> span, mn::vec<PREC, 3> offset, PREC ppc, mn::vec<PREC,3> partition_start, mn::vec<PREC,3> partition_end, mn::vec<PREC, 3, 3>& rotation, mn::vec<PREC, 3>& fulcrum) {
   // Make a rectangular prism of particles, write to fields
   // Span sets dimensions, offset is starting corner, ppc is particles-per-cell
@@ -512,7 +528,7 @@ void make_box(std::vector<std::array<PREC, 3>>& fields,
 }
 /// @brief Make cylinder as particles, write to fields as [x,y,z] data.
 /// @brief Assume span, offset, radius, partition_start/end are already scaled to 1x1x1 domain. 
-/// @param fields Vector of arrays to write particle position [x,y,z] data into
+/// @param fields Vector of arrays (or mn::ParticleStream) to write particle position [x,y,z] data into
 /// @param span Sets max span to look in (for efficiency). Erases particles if too low.
 /// @param offset Offsets starting corner of particle object from origin. Assume simulation's grid buffer is already included (offset += g_offset, e.g. 8*g_dx).
 /// @param ppc Particle-per-cell, number of particles to sample per 3D grid-cell (e.g. 8).
@@ -520,7 +536,8 @@ void make_box(std::vector<std::array<PREC, 3>>& fields,
 /// @param axis Longitudinal axis of cylinder, e.g. std::string{"X"} for X oriented cylinder.
 /// @param partition_start Start corner of particle GPU partition, cut out everything before.
 /// @param partition_end End corner of particle GPU partition, cut out everything beyond.
-void make_cylinder(std::vector<std::array<PREC, 3>>& fields, 
+template <typename Fields>
+void make_cylinder(Fields& fields, 
                         mn::vec<PREC, 3> span, mn::vec<PREC, 3> offset,
                         PREC ppc, PREC radius, std::string axis, mn::vec<PREC,3> partition_start, mn::vec<PREC,3> partition_end, mn::vec<PREC, 3, 3>& rotation, mn::vec<PREC, 3>& fulcrum) {
   PREC ppl_dx = dx / cbrt(ppc); // Linear spacing of particles [1x1x1]
@@ -567,14 +584,15 @@ void make_cylinder(std::vector<std::array<PREC, 3>>& fields,
 }
 /// @brief Make sphere as particles, write to fields as [x,y,z] data.
 /// @brief Assume span, offset, radius, partition_start/end are already scaled to 1x1x1 domain. 
-/// @param fields Vector of arrays to write particle position [x,y,z] data into
+/// @param fields Vector of arrays (or mn::ParticleStream) to write particle position [x,y,z] data into
 /// @param span Sets max span to look in (for efficiency). Erases particles if too low.
 /// @param offset Offsets starting corner of particle object from origin. Assume simulation's grid buffer is already included (offset += g_offset, e.g. 8*g_dx).
 /// @param ppc Particle-per-cell, number of particles to sample per 3D grid-cell (e.g. 8).
 /// @param radius Radius of cylinder.
 /// @param partition_start Start corner of particle GPU partition, cut out everything before.
 /// @param partition_end End corner of particle GPU partition, cut out everything beyond.
-void make_sphere(std::vector<std::array<PREC, 3>>& fields, 
+template <typename Fields>
+void make_sphere(Fields& fields, 
                         mn::vec<PREC, 3> span, mn::vec<PREC, 3> offset,
                         PREC ppc, PREC radius, mn::vec<PREC,3> partition_start, mn::vec<PREC,3> partition_end, mn::vec<PREC, 3, 3>& rotation, mn::vec<PREC, 3>& fulcrum) {
   PREC ppl_dx = dx / cbrt(ppc); // Linear spacing of particles [1x1x1]
@@ -610,6 +628,38 @@ void make_sphere(std::vector<std::array<PREC, 3>>& fields,
   } 
 }
 
+/// @brief Make closed triangle mesh (OBJ/STL) as particles, write to fields as [x,y,z] data. No SDF intermediate.
+/// @brief Assume offset, partition_start/end are already scaled to 1x1x1 domain.
+/// @param fields Vector of arrays to write particle position [x,y,z] data into
+/// @param mesh Triangle mesh in file units. Must be closed (watertight) for inside/outside parity.
+/// @param scale Multiplier from file units to 1x1x1 domain, e.g. scaling_factor * froude_scaling / l.
+/// @param offset Offsets starting corner of the mesh bounding box from origin. Assume simulation's grid buffer is already included.
+/// @param ppc Particle-per-cell, number of particles to sample per 3D grid-cell (e.g. 8).
+/// @param partition_start Start corner of particle GPU partition, cut out everything before.
+/// @param partition_end End corner of particle GPU partition, cut out everything beyond.
+void make_mesh(std::vector<std::array<PREC, 3>>& fields, const mn::TriangleMesh& mesh, PREC scale,
+                        mn::vec<PREC, 3> offset, PREC ppc, mn::vec<PREC,3> partition_start, mn::vec<PREC,3> partition_end, mn::vec<PREC, 3, 3>& rotation, mn::vec<PREC, 3>& fulcrum) {
+  PREC ppl_dx = dx / cbrt(ppc); // Linear spacing of particles [1x1x1]
+  std::array<double, 3> mesh_lo, mesh_hi;
+  mesh.bounds(mesh_lo, mesh_hi);
+  std::vector<std::array<double, 3>> vertices(mesh.vertices.size());
+  for (std::size_t v = 0; v < vertices.size(); ++v)
+    for (int d = 0; d < 3; ++d) vertices[v][d] = (mesh.vertices[v][d] - mesh_lo[d]) * scale + offset[d];
+  // Lattice covers the scaled mesh bounds, clipped to the GPU partition before rotation (as for other objects)
+  std::array<PREC, 3> lo, hi;
+  for (int d = 0; d < 3; ++d) {
+    lo[d] = offset[d];
+    hi[d] = (mesh_hi[d] - mesh_lo[d]) * scale + offset[d];
+  }
+  auto particles = mn::voxelize_mesh<PREC>(vertices, mesh.triangles, ppl_dx, lo, hi);
+  fields.reserve(fields.size() + particles.size());
+  for (auto& arr : particles)
+    if (inside_partition(arr, partition_start, partition_end)) {
+      translate_rotate_translate_point(fulcrum, rotation, arr);
+      fields.push_back(arr);
+    }
+}
+
 
 /// @brief Make bathymetry flume fluid as particles, write to fields as [x,y,z] data.
 /// @brief Assume span, offset, radius, partition_start/end are already scaled to 1x1x1 domain. 
@@ -999,40 +1049,6 @@ void load_FEM_Elements(const std::string& filename, char sep,
 }
 
 
-void load_motionPath(const std::string& filename, char sep, MotionHolder& fields, int rate=1, double fr_scale = 1.0){
-  std::ifstream in((filename).c_str());
-  if (in) {
-      int iter = 0;
-      std::string line;
-      while (getline(in, line)) {
-          std::stringstream sep(line);
-          std::string field;
-          int col = 0;
-          std::array<float, 3> arr;
-          while (getline(sep, field, ',')) {
-              if (col >= 3) break;
-              if ((iter % rate) == 0) {
-		arr[col] = stof(field);
-		if (col == 0) arr[col] *= sqrt(fr_scale); // Adjust time for froude scaling
-		else if (col == 1) arr[col] *= fr_scale; // Adjust X position for froude scaling
-		else if (col == 2) arr[col] *= sqrt(fr_scale); // Adjust X velocity for froude scaling
-	      }
-	      col++;
-          }
-          if ((iter % rate) == 0) fields.push_back(arr);
-          iter++;
-      }
-  }
-  if (verbose) {
-    for (auto row : fields) {
-      for (auto field : row) std::cout << field << ' '; 
-      std::cout << '\n';
-    }
-    std::cout << '\n';
-  }
-}
-
-
 /// @brief Check if JSON value at 'key' is (i) in JSON script and (ii) is a string.
 /// Return retrieved string from JSON or return backup value if not found/is not a string.
 std::string CheckString(rapidjson::Value &object, const std::string &key, std::string backup) {
@@ -1409,13 +1425,201 @@ uint64_t CheckUint64(rapidjson::Value &object, const std::string &key, uint64_t
   return backup;
 }
 
+/// @brief Run-time SimCapacity from scene "simulation": {"capacity": {...}}. Keys left out keep compiled defaults (settings.h).
+/// Exits if capacity needs a bigger compiled preset (g_device_cnt, g_models_per_gpu) or sets a compiled-only key (domain_bits, max_ppc).
+mn::config::SimCapacity CheckCapacity(rapidjson::Value &sim) {
+  mn::config::SimCapacity cap{};
+  auto it = sim.FindMember("capacity");
+  if (it == sim.MemberEnd() || !it->value.IsObject()) return cap;
+  auto &object = it->value;
+  auto has = [&](const char *key) { return object.HasMember(key); };
+  for (auto [key, preset, compiled] : {std::make_tuple("domain_bits", "DOMAIN_BITS", mn::config::g_domain_bits),
+                                       std::make_tuple("max_ppc", "MAX_PPC", mn::config::g_max_ppc)}) {
+    if (!has(key)) continue;
+    fmt::print(fg(red), "ERROR: simulation:capacity:{} is not a run-time setting, this build has {}[{}].\n", key, preset, compiled);
+    fmt::print(fg(yellow), "TIP: Remove [{}] from the scene and run a build of the preset -D{}={}. Press Enter to continue...\n", key, preset,
+               object[key].IsInt() ? object[key].GetInt() : compiled);
+    if (mn::config::g_log_level >= 3) getchar();
+    std::exit(EXIT_FAILURE);
+  }
+  if (has("max_active_block")) cap.max_active_block = CheckUint64(object, "max_active_block", cap.max_active_block);
+  if (has("max_particle_num")) cap.max_particle_num = CheckUint64(object, "max_particle_num", cap.max_particle_num);
+  if (has("devices")) cap.device_cnt = CheckInt(object, "devices", cap.device_cnt);
+  if (has("models_per_gpu")) cap.models_per_gpu = CheckInt(object, "models_per_gpu", cap.models_per_gpu);
+  fmt::print(fg(cyan), "Simulation capacity: max_active_block[{}], max_particle_num[{}], devices[{}], models_per_gpu[{}]\n",
+             cap.max_active_block, cap.max_particle_num, cap.device_cnt, cap.models_per_gpu);
+  if (!cap.fits_preset()) {
+    fmt::print(fg(red), "ERROR: Simulation capacity exceeds compiled preset: g_device_cnt[{}], g_models_per_gpu[{}].\n",
+               mn::config::g_device_cnt, mn::config::g_models_per_gpu);
+    fmt::print(fg(yellow), "TIP: Raise g_device_cnt / g_models_per_gpu in settings.h and recompile, or lower the capacity. Press Enter to continue...\n");
+    if (mn::config::g_log_level >= 3) getchar();
+    std::exit(EXIT_FAILURE);
+  }
+  return cap;
+}
+
+/// @brief Particle loads of bodies with "auto_partition" : true, gathered by a sampling pass of parse_scene.
+struct AutoPartitionSampling {
+  mn::BlockLoads block_loads; //< Combined loads of all auto-partitioned bodies
+  std::vector<std::pair<int, mn::BlockLoads>> bodies; //< Index in scene "bodies" array, loads of body
+};
+
+/// @brief True if a scene body asks to be split across devices automatically.
+bool is_auto_partitioned(const rapidjson::Value &body) {
+  auto check = body.FindMember("auto_partition");
+  return check != body.MemberEnd() && check->value.IsBool() && check->value.GetBool();
+}
+
+/// @brief True if any scene body asks to be split across devices automatically.
+bool scene_has_auto_partition(const rj::Document &doc) {
+  auto it = doc.FindMember("bodies");
+  if (it == doc.MemberEnd() || !it->value.IsArray()) return false;
+  for (auto &body : it->value.GetArray())
+    if (is_auto_partitioned(body)) return true;
+  return false;
+}
+
+/// @brief Balance auto-partitioned bodies across devices by recursive coordinate bisection on grid-blocks.
+/// Each such body is replaced by one body per device with explicit gpu, partition_start, and partition_end.
+/// The resolved scene is written next to the input as <name>_resolved.json for reproducibility.
+/// Assumes l, o already set by a sampling pass of parse_scene.
+/// @param fn Filename of input JSON script.
+/// @param doc Parsed input JSON script. Bodies array is replaced in-place.
+/// @param sampling Particle loads of auto-partitioned bodies.
+/// @return Filename of resolved JSON script.
+std::string resolve_auto_partition(const std::string &fn, rj::Document &doc, const AutoPartitionSampling &sampling) {
+  int rank = 0, num_ranks = 1;
+#if CLUSTER_COMM_STYLE == 1
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+#endif
+  int num_parts = mn::config::g_device_cnt * num_ranks;
+  double froude_scaling = 1.0;
+  auto sim = doc.FindMember("simulation");
+  if (sim != doc.MemberEnd() && sim->value.IsObject()) {
+    auto check = sim->value.FindMember("froude_scaling");
+    if (check != sim->value.MemberEnd() && check->value.IsNumber()) froude_scaling = check->value.GetDouble();
+    check = sim->value.FindMember("partition_devices");
+    if (check != sim->value.MemberEnd() && check->value.IsInt()) num_parts = check->value.GetInt();
+  }
+  if (num_parts < 1 || num_parts > mn::config::g_device_cnt * num_ranks) {
+    fmt::print(fg(red), "ERROR: partition_devices[{}] must be in [1, {}] (g_device_cnt * MPI ranks). Using [{}].\n", num_parts, mn::config::g_device_cnt * num_ranks, mn::config::g_device_cnt * num_ranks);
+    if (mn::config::g_log_level >= 3) getchar();
+    num_parts = mn::config::g_device_cnt * num_ranks;
+  }
+
+  const mn::block_key_t grid_lo{0, 0, 0};
+  const mn::block_key_t grid_hi{mn::config::g_grid_size_x, mn::config::g_grid_size_y, mn::config::g_grid_size_z};
+  auto parts = mn::rcb_partition(sampling.block_loads, num_parts, grid_lo, grid_hi);
+
+  double total_weight = 0.;
+  for (auto &part : parts) total_weight += part.weight;
+  for (int part = 0; part < (int)parts.size(); ++part) {
+    auto &box = parts[part];
+    fmt::print(fg(cyan), "Auto-partition GPU[{}]: blocks [{}, {}, {}] to [{}, {}, {}), active blocks[{}], particles[{}], load[{:.1f}%].\n", part, box.lo[0], box.lo[1], box.lo[2], box.hi[0], box.hi[1], box.hi[2], box.blocks, box.count, total_weight > 0. ? 100. * box.weight / total_weight : 0.);
+    if (box.count > mn::config::g_max_particle_num)
+      fmt::print(fg(red), "ERROR: Auto-partition GPU[{}] particle count [{}] exceeds g_max_particle_num in settings.h! Increase and recompile, or add devices.\n", part, box.count);
+  }
+
+  // Partition faces in input units, outer faces extend to the full grid
+  auto face = [&](int b, int d, bool upper) -> double {
+    double x;
+    if (!upper && b <= grid_lo[d]) x = 0.;
+    else if (upper && b >= grid_hi[d]) x = grid_hi[d] * mn::config::g_blocksize * mn::config::g_dx_d;
+    else x = mn::block_face_position(b);
+    return (x - o) * l / froude_scaling;
+  };
+  auto inside_box = [&](const mn::block_key_t &b, const mn::PartitionBox &box) {
+    for (int d = 0; d < 3; ++d) {
+      if (box.lo[d] > grid_lo[d] && b[d] < box.lo[d]) return false;
+      if (box.hi[d] < grid_hi[d] && b[d] >= box.hi[d]) return false;
+    }
+    return true;
+  };
+  auto &allocator = doc.GetAllocator();
+  auto set_member = [&](rj::Value &object, const char *key, rj::Value value) {
+    if (object.HasMember(key)) object.RemoveMember(key);
+    object.AddMember(rj::Value(key, allocator), value, allocator);
+  };
+
+  auto &bodies = doc["bodies"];
+  rj::Value resolved(rj::kArrayType);
+  for (int b = 0; b < (int)bodies.Size(); ++b) {
+    if (!is_auto_partitioned(bodies[b])) {
+      resolved.PushBack(rj::Value(bodies[b], allocator), allocator);
+      continue;
+    }
+    auto found = std::find_if(sampling.bodies.begin(), sampling.bodies.end(), [&](auto &sample) { return sample.first == b; });
+    auto loads = (found != sampling.bodies.end()) ? found->second.loads() : std::vector<mn::BlockLoads::Load>{};
+    for (int part = 0; part < (int)parts.size(); ++part) {
+      std::size_t count = 0;
+      for (auto &load : loads) if (inside_box(load.blockid, parts[part])) count += load.count;
+      if (count == 0) continue; //< Body has no particles on this device
+      rj::Value body(bodies[b], allocator);
+      body.RemoveMember("auto_partition");
+      set_member(body, "gpu", rj::Value(part));
+      rj::Value start(rj::kArrayType), end(rj::kArrayType);
+      for (int d = 0; d < 3; ++d) {
+        start.PushBack(face(parts[part].lo[d], d, false), allocator);
+        end.PushBack(face(parts[part].hi[d], d, true), allocator);
+      }
+      set_member(body, "partition_start", std::move(start));
+      set_member(body, "partition_end", std::move(end));
+      fmt::print(fg(green), "Auto-partition body[{}] on GPU[{}] with [{}] particles.\n", b, part, count);
+      resolved.PushBack(body, allocator);
+    }
+  }
+  bodies = resolved;
+
+  fs::path p{fn};
+  std::string resolved_fn = (p.parent_path() / (p.stem().string() + "_resolved.json")).string();
+  if (rank == 0) {
+    rj::StringBuffer buffer;
+    rj::PrettyWriter<rj::StringBuffer> writer(buffer);
+    doc.Accept(writer);
+    std::ofstream ostrm(resolved_fn);
+    if (!ostrm.is_open()) fmt::print(fg(red), "ERROR: Cannot open file[{}]\n", resolved_fn);
+    else ostrm << buffer.GetString() << '\n';
+    fmt::print(fg(green), "Wrote auto-partitioned scene file[{}].\n", resolved_fn);
+  }
+#if CLUSTER_COMM_STYLE == 1
+  MPI_Barrier(MPI_COMM_WORLD);
+#endif
+  return resolved_fn;
+}
+
+/// @brief True if a body can be streamed to device in chunks: every geometry adds a lattice-sampled Box, Cylinder or Sphere, and no sort is asked.
+/// Streamed samplers are replayed after counting, so operations needing the whole body (Subtract, files, sorting) are excluded.
+bool is_streamable(const rapidjson::Value &body) {
+  auto string_or = [](const rapidjson::Value &object, const char *key, const char *backup) {
+    auto check = object.FindMember(key);
+    return std::string{(check != object.MemberEnd() && check->value.IsString()) ? check->value.GetString() : backup};
+  };
+  std::string sort = string_or(body, "sort_particles", "None");
+  if (sort != "None" && sort != "none") return false;
+  auto geo = body.FindMember("geometry");
+  if (geo == body.MemberEnd() || !geo->value.IsArray() || geo->value.Empty()) return false;
+  for (auto &geometry : geo->value.GetArray()) {
+    std::string operation = string_or(geometry, "operation", "add");
+    std::string type = string_or(geometry, "object", "box");
+    if (operation != "Add" && operation != "add") return false;
+    if (type != "Box" && type != "box" && type != "Cylinder" && type != "cylinder" && type != "Sphere" && type != "sphere") return false;
+  }
+  return true;
+}
+
 /// @brief Parses an input JSON script to set-up a Multi-GPU simulation.
+/// Bodies with "auto_partition" : true are first sampled, balanced across devices, and the resolved script is parsed instead.
 /// @param fn Filename of input JSON script. Default: scene.json in current working directory
 /// @param benchmark Simulation object to initalize. Calls GPU/Host functions and manages memory.
 /// @param models Contains initial particle positions for simulation. One per GPU.
+/// @param sampling If set, only sample particles of auto-partitioned bodies into it (no simulation set-up).
+/// @param plan If set, dry-run: record particle bodies per device into it for memory planning (no simulation set-up, no GPU needed).
 void parse_scene(std::string fn,
                  std::unique_ptr<mn::mgsp_benchmark> &benchmark,
-                 std::vector<std::array<PREC, 3>> models[mn::config::g_model_cnt]) {
+                 std::vector<std::array<PREC, 3>> models[mn::config::g_model_cnt],
+                 AutoPartitionSampling *sampling = nullptr,
+                 mn::ScenePlan *plan = nullptr) {
   fs::path p{fn};
   if (p.empty()) fmt::print(fg(red), "ERROR: Input file[{}] does not exist.\n", fn);
   else {
@@ -1439,8 +1643,16 @@ void parse_scene(std::string fn,
       fmt::print("Scene member {} is type {}. \n", itr->name.GetString(),
                  kTypeNames[itr->value.GetType()]);
     }
+    if (!sampling && scene_has_auto_partition(doc)) {
+      fmt::print(fg(cyan), "Scene file[{}] has auto_partition bodies. Sampling particles to balance devices...\n", fn);
+      AutoPartitionSampling samples;
+      parse_scene(fn, benchmark, models, &samples);
+      parse_scene(resolve_auto_partition(fn, doc, samples), benchmark, models, nullptr, plan);
+      return;
+    }
     mn::vec<PREC, 3> domain; // Domain size [meters] for whole 3D simulation
     mn::vec<double, 2> time; // Time range [seconds] for simulation
+    mn::config::SimCapacity capacity; // Run-time capacity, compiled defaults unless scene sets simulation:capacity
 
     double froude_scaling = 1.0; // Froude length scaling to apply. Keeps Fr = U / sqrt(gL) constant while increasing lengths.
 
@@ -1468,6 +1680,7 @@ void parse_scene(std::string fn,
           std::string save_suffix = CheckString(sim, "save_suffix", std::string{".bgeo"});
           
           bool particles_output_exterior_only = CheckBool(sim, "particles_output_exterior_only", mn::config::g_particles_output_exterior_only);
+          capacity = CheckCapacity(sim);
 
           l = sim_default_dx * mn::config::g_dx_inv_d; 
           double lx = l * mn::config::g_grid_ratio_x;
@@ -1479,18 +1692,22 @@ void parse_scene(std::string fn,
             if (mn::config::g_log_level >= 3) getchar();
             std::exit(EXIT_FAILURE);
           } 
-          // Only saves memory when reducing X domain size currently, Y and Z only reduce if X is already smaller than they are. Fix later 
-          uint64_t domainBlockCnt = static_cast<uint64_t>(std::ceil((domain[0] + mn::config::g_bc * mn::config::g_blocksize * sim_default_dx)  / lx * (mn::config::g_grid_size_x))) * static_cast<uint64_t>(std::ceil( (mn::config::g_grid_size_y))) * static_cast<uint64_t>(std::ceil( (mn::config::g_grid_size_z)));
-          double reduction = 100. * ( 1. - domainBlockCnt / (mn::config::g_grid_size_x * mn::config::g_grid_size_y * mn::config::g_grid_size_z));
-          domainBlockCnt = (mn::config::g_grid_size_x * mn::config::g_grid_size_y * mn::config::g_grid_size_z); // Force full domain, fix later
-          fmt::print(fg(yellow),"Partitions _indexTable data-structure: Saved [{}] percent memory of preallocated partition _indexTable by reducing domainBlockCnt from [{}] to run-time of [{}] using domain input relative to DOMAIN_BITS and default_dx.\n", reduction, mn::config::g_grid_size_x * mn::config::g_grid_size_y * mn::config::g_grid_size_z, domainBlockCnt);
+          // Run-time grid-blocks per axis: domain plus g_offset buffer on both sides, sizes Partition _indexTable to the actual box
+          const mn::ivec3 maxBlocks{mn::config::g_grid_size_x, mn::config::g_grid_size_y, mn::config::g_grid_size_z};
+          mn::ivec3 domainBlocks;
+          for (int d = 0; d < 3; ++d)
+            domainBlocks[d] = std::min(maxBlocks[d], static_cast<int>(std::ceil(domain[d] / (mn::config::g_blocksize * sim_default_dx) - 1e-6)) + 2 * static_cast<int>(mn::config::g_bc));
+          uint64_t domainBlockCnt = (uint64_t)domainBlocks[0] * domainBlocks[1] * domainBlocks[2];
+          uint64_t maxBlockCnt = (uint64_t)maxBlocks[0] * maxBlocks[1] * maxBlocks[2];
+          fmt::print(fg(yellow),"Partitions _indexTable data-structure: Sized to run-time domain of [{}, {}, {}] grid-blocks, [{}] instead of compiled [{}] entries ([{:.1f}]x less memory).\n", domainBlocks[0], domainBlocks[1], domainBlocks[2], domainBlockCnt, maxBlockCnt, (double)maxBlockCnt / domainBlockCnt);
           fmt::print(fg(cyan),
               "Scene simulation parameters: Domain Length [{}], domainBlockCnt [{}], default_dx[{}], default_dt[{}], init_time[{}], fps[{}], frames[{}], gravity[{}, {}, {}], save_suffix[{}], froude_scaling[{}], particles_output_exterior_only[{}]\n", 
               l, domainBlockCnt, sim_default_dx, sim_default_dt, time[0],
               sim_fps, sim_frames, sim_gravity[0], sim_gravity[1], sim_gravity[2], save_suffix, froude_scaling, particles_output_exterior_only);
-          benchmark = std::make_unique<mn::mgsp_benchmark>(
-              l, domainBlockCnt, sim_default_dt, time[0],
-              sim_fps, sim_frames, sim_gravity, froude_scaling, save_suffix, particles_output_exterior_only); //< Initialize simulation object
+          if (plan) plan->domain_cell_cnt = domainBlockCnt, plan->capacity = capacity;
+          if (!sampling && !plan) benchmark = std::make_unique<mn::mgsp_benchmark>(
+              l, domainBlocks, sim_default_dt, time[0],
+              sim_fps, sim_frames, sim_gravity, froude_scaling, save_suffix, particles_output_exterior_only, capacity); //< Initialize simulation object
           fmt::print(fmt::emphasis::bold,
               "-----------------------------------------------------------"
               "-----\n");
@@ -1499,7 +1716,8 @@ void parse_scene(std::string fn,
     } ///< End basic simulation scene parsing
     {
       auto it = doc.FindMember("meshes");
-      if (it != doc.MemberEnd()) {
+      if (it != doc.MemberEnd() && plan) fmt::print(fg(orange), "WARNING: Finite Element meshes are not included in memory plan.\n");
+      if (it != doc.MemberEnd() && !sampling && !plan) {
         if (it->value.IsArray()) {
           fmt::print(fg(cyan),"Scene file has [{}] Finite Element meshes.\n", it->value.Size());
           for (auto &model : it->value.GetArray()) {
@@ -1648,28 +1866,35 @@ void parse_scene(std::string fn,
       if (it != doc.MemberEnd()) {
         if (it->value.IsArray()) {
           fmt::print(fg(cyan), "Scene file has [{}] material bodies. \n", it->value.Size());
-          for (auto &model : it->value.GetArray()) {
-            int gpu_id = CheckInt(model, "gpu", 0);
+          auto &bodies = it->value;
+          const int num_bodies = static_cast<int>(bodies.Size());
+          mn::BodyPipeline pipeline(num_bodies);
+          auto init_body = [&](rapidjson::Value &model, int body_id) {
+            mn::BodyPipeline::Ticket ticket{pipeline, body_id};
+            if (sampling && !is_auto_partitioned(model)) return; //< Only sample bodies to balance
+            int gpu_id = sampling ? 0 : CheckInt(model, "gpu", 0);
             if (gpu_id >= rank * mn::config::g_device_cnt && gpu_id < (rank + 1) * mn::config::g_device_cnt)
               gpu_id = gpu_id % mn::config::g_device_cnt;
             int model_id = CheckInt(model, "model", 0);
             int total_id = model_id + gpu_id * mn::config::g_models_per_gpu;
             int node_id = rank;
             fmt::print(fg(cyan), "NODE[{}] GPU[{}] MODEL[{}] Begin reading...\n", node_id, gpu_id, model_id);
-            if (gpu_id >= mn::config::g_device_cnt) {
-              fmt::print(fg(red), "ERROR! Particle model[{}] on gpu[{}] exceeds GPUs reserved by g_device_cnt[{}] (settings.h)! Skipping model. Increase g_device_cnt and recompile. \n", model_id, gpu_id, mn::config::g_device_cnt);
-              continue;
+            if (gpu_id >= capacity.device_cnt) {
+              fmt::print(fg(red), "ERROR! Particle model[{}] on gpu[{}] exceeds GPUs reserved by capacity devices[{}] (g_device_cnt[{}] in settings.h)! Skipping model. Raise capacity, or increase g_device_cnt and recompile. \n", model_id, gpu_id, capacity.device_cnt, mn::config::g_device_cnt);
+              return;
             } else if (gpu_id < 0) {
               fmt::print(fg(red), "ERROR! GPU[{}] MODEL[{}] GPU ID cannot be negative. \n", gpu_id, model_id);
-              if (mn::config::g_log_level >= 3) { fmt::print(fg(red), "Press ENTER to continue..."); getchar(); } continue;
+              if (mn::config::g_log_level >= 3) { fmt::print(fg(red), "Press ENTER to continue..."); getchar(); } return;
             } 
-            if (model_id >= mn::config::g_models_per_gpu) {
-              fmt::print(fg(red), "ERROR! Particle model[{}] on gpu[{}] exceeds models reserved by g_models_per_gpu[{}] (settings.h)! Skipping model. Increase g_models_per_gpu and recompile. \n", model_id, gpu_id, mn::config::g_models_per_gpu);
-              continue;
+            if (model_id >= capacity.models_per_gpu) {
+              fmt::print(fg(red), "ERROR! Particle model[{}] on gpu[{}] exceeds models reserved by capacity models_per_gpu[{}] (g_models_per_gpu[{}] in settings.h)! Skipping model. Raise capacity, or increase g_models_per_gpu and recompile. \n", model_id, gpu_id, capacity.models_per_gpu, mn::config::g_models_per_gpu);
+              return;
             } else if (model_id < 0) {
               fmt::print(fg(red), "ERROR! GPU[{}] MODEL[{}] Model ID cannot be negative. \n", gpu_id, model_id);
-              if (mn::config::g_log_level >= 3) { fmt::print(fg(red), "Press ENTER to continue..."); getchar(); } continue;
+              if (mn::config::g_log_level >= 3) { fmt::print(fg(red), "Press ENTER to continue..."); getchar(); } return;
             }
+            pipeline.assign(body_id, gpu_id, model_id);
+            pipeline.wait_for_model(body_id); //< Earlier bodies on this GPU and model append to the same models[total_id]
 
             const bool use_HydroUQ_interface = true; //< temporary flag to switch between new HydroUQ and ClaymoreUW legacy user-interface
 
@@ -2209,6 +2434,12 @@ void parse_scene(std::string fn,
                 std::exit(EXIT_FAILURE);
               }
             }
+            if (sampling) { //< Sample whole body, device partitions are chosen afterwards
+              for (int d = 0; d < 3; ++d) {
+                partition_start[d] = std::numeric_limits<PREC>::lowest();
+                partition_end[d] = std::numeric_limits<PREC>::max();
+              }
+            }
             output_attribs = CheckStringArray(model, "output_attribs", std::vector<std::string> {{"ID"}});
             track_attribs = CheckStringArray(model, "track_attribs", std::vector<std::string> {{"Position_Y"}});
             track_particle_ids = CheckIntArray(model, "track_particle_id", std::vector<int>{0});
@@ -2225,6 +2456,22 @@ void parse_scene(std::string fn,
               fmt::print("GPU[{}] Track attribute count[{}] on particle count[{}].\n", gpu_id, track_attribs.size(), track_particle_ids.size());
             if (target_attribs.size() > 1) { fmt::print(fg(red), "ERROR: GPU[{}] Only [1] target_attribs value supported currently.\n", gpu_id); }
 
+            // * Optionally stream the body to device in chunks, so host never holds all of its positions
+            // * Samplers run once to count (allocation size), then are replayed into chunks at upload
+            std::size_t stream_chunk = 0; //< Particles per chunk, 0 samples whole body into models[total_id]
+            if (model.HasMember("stream_chunk")) stream_chunk = (std::size_t)std::max(0, CheckInt(model, "stream_chunk", 0));
+            const bool stream_body = stream_chunk > 0 && !sampling && !plan && models[total_id].empty() && is_streamable(model);
+            if (stream_chunk > 0 && !stream_body)
+              fmt::print(fg(orange), "WARNING: GPU[{}] MODEL[{}] stream_chunk needs only Add Box/Cylinder/Sphere geometry, no sort_particles, and its own model slot. Sampling whole body instead.\n", gpu_id, model_id);
+            std::vector<std::function<void(mn::ParticleStream<PREC> &)>> stream_samplers;
+            std::size_t stream_count = 0; //< Particles counted by stream_samplers
+            auto defer_sampler = [&](std::function<void(mn::ParticleStream<PREC> &)> sampler) {
+              mn::ParticleStream<PREC> counter; //< No sink, counts only
+              sampler(counter);
+              stream_count += counter.size();
+              stream_samplers.push_back(std::move(sampler));
+            };
+
             // * Begin particle geometry construction 
             auto geo = model.FindMember("geometry");
             // auto geos = model.FindMember("geometries"); // TODO: Use this instead or have schema accept either (but not both?)
@@ -2262,23 +2509,41 @@ void parse_scene(std::string fn,
                   for (int i=0;i<3;i++) {for (int j=0;j<3;j++) fmt::print("{} ", rotation_matrix(i,j)); fmt::print("\n");}
 
 
+                  // * Arrays of translation-invariant objects sample one unclipped, unrotated prototype at the first offset.
+                  // * Instances are then shifted, clipped and rotated copies (see instancing.h), so files are read once.
+                  bool geometry_is_file = (type == "File" || type == "file");
+                  std::string geometry_extension = geometry_is_file ? fs::path{CheckString(geometry, "file", std::string{})}.extension().string() : std::string{};
+                  bool geometry_is_partio = geometry_is_file && (geometry_extension == ".bgeo" || geometry_extension == ".geo" || geometry_extension == ".pdb" || geometry_extension == ".ptc");
+                  bool replicate_array = !stream_body && (operation == "Add" || operation == "add") && geometry_array[0] * geometry_array[1] * geometry_array[2] > 1 &&
+                      (type == "Box" || type == "box" || type == "Cylinder" || type == "cylinder" || type == "Sphere" || type == "sphere" || type == "Mesh" || type == "mesh" ||
+                       (geometry_is_file && (geometry_extension == ".sdf" || geometry_extension == ".csv" || geometry_is_partio)));
+                  mn::vec<PREC, 3> sample_start = partition_start, sample_end = partition_end; //< Clipping used by samplers
+                  mn::pvec3x3 sample_rotation = rotation_matrix; //< Rotation used by samplers
+                  if (replicate_array) {
+                    sample_start.set(std::numeric_limits<PREC>::lowest());
+                    sample_end.set(std::numeric_limits<PREC>::max());
+                    sample_rotation.set(0.0);
+                    sample_rotation(0,0) = sample_rotation(1,1) = sample_rotation(2,2) = 1;
+                  }
+                  std::size_t prototype_begin = models[total_id].size();
+
                   int keep_track_of_array = 0; // Current index in array operation
                   int keep_track_of_particles = 0; // Particles per single array operation
                   mn::vec<PREC, 3> geometry_offset_updated;
                   geometry_offset_updated[0] = geometry_offset[0];
-                  for (int i = 0; i < geometry_array[0]; i++)
+                  for (int i = 0; i < (replicate_array ? 1 : geometry_array[0]); i++)
                   {
                   geometry_offset_updated[1] = geometry_offset[1];
-                  for (int j = 0; j < geometry_array[1]; j++)
+                  for (int j = 0; j < (replicate_array ? 1 : geometry_array[1]); j++)
                   {
                   geometry_offset_updated[2] = geometry_offset[2];
-                  for (int k = 0; k < geometry_array[2]; k++)
+                  for (int k = 0; k < (replicate_array ? 1 : geometry_array[2]); k++)
                   {
                   std::vector<int> geo_track_particle_ids; //< Particle IDs to track for this geometry instance
                   geo_track_particle_ids = CheckIntArray(geometry, "track_particle_id", std::vector<int>{});
                   // * Shift geometry local particle IDs to track global IDs
                   if (keep_track_of_array == 1)
-                    keep_track_of_particles = models[total_id].size();
+                    keep_track_of_particles = stream_body ? stream_count : models[total_id].size();
                   // int shift_idx = keep_track_of_particles * keep_track_of_array;
 
                   for (int geo_idx = 0; geo_idx < geo_track_particle_ids.size(); ++geo_idx) {
@@ -2290,8 +2555,11 @@ void parse_scene(std::string fn,
 
                   if (type == "Box" || type == "box")
                   {
-                    if (operation == "Add" || operation == "add") {
-                      make_box(models[total_id], geometry_span, geometry_offset_updated, materialConfigs.ppc, partition_start, partition_end, rotation_matrix, geometry_fulcrum); }
+                    if (stream_body) {
+                      defer_sampler([=, ppc = materialConfigs.ppc](auto &out) mutable {
+                        make_box(out, geometry_span, geometry_offset_updated, ppc, sample_start, sample_end, sample_rotation, geometry_fulcrum); }); }
+                    else if (operation == "Add" || operation == "add") {
+                      make_box(models[total_id], geometry_span, geometry_offset_updated, materialConfigs.ppc, sample_start, sample_end, sample_rotation, geometry_fulcrum); }
                     else if (operation == "Subtract" || operation == "subtract") {
                       subtract_box(models[total_id], geometry_span, geometry_offset_updated); }
                     else if (operation == "Union" || operation == "union") { fmt::print(fg(red),"Operation not implemented...\n");}
@@ -2306,16 +2574,22 @@ void parse_scene(std::string fn,
                     PREC geometry_radius = CheckDouble(geometry, "radius", 0.) * froude_scaling;
                     std::string geometry_axis = CheckString(geometry, "axis", std::string{"X"});
 
-                    if (operation == "Add" || operation == "add") {
-                      make_cylinder(models[total_id], geometry_span, geometry_offset_updated, materialConfigs.ppc, geometry_radius, geometry_axis, partition_start, partition_end, rotation_matrix, geometry_fulcrum); }
+                    if (stream_body) {
+                      defer_sampler([=, ppc = materialConfigs.ppc](auto &out) mutable {
+                        make_cylinder(out, geometry_span, geometry_offset_updated, ppc, geometry_radius, geometry_axis, sample_start, sample_end, sample_rotation, geometry_fulcrum); }); }
+                    else if (operation == "Add" || operation == "add") {
+                      make_cylinder(models[total_id], geometry_span, geometry_offset_updated, materialConfigs.ppc, geometry_radius, geometry_axis, sample_start, sample_end, sample_rotation, geometry_fulcrum); }
                     else if (operation == "Subtract" || operation == "subtract") {             subtract_cylinder(models[total_id], geometry_radius, geometry_axis, geometry_span, geometry_offset_updated); }
                     else { fmt::print(fg(red), "ERROR: GPU[{}] geometry operation[{}] invalid! \n", gpu_id, operation); if (mn::config::g_log_level >= 3) getchar(); }
                   }
                   else if (type == "Sphere" || type == "sphere")
                   {
                     PREC geometry_radius = CheckDouble(geometry, "radius", 0.) * froude_scaling;
-                    if (operation == "Add" || operation == "add") {
-                      make_sphere(models[total_id], geometry_span, geometry_offset_updated, materialConfigs.ppc, geometry_radius, partition_start, partition_end, rotation_matrix, geometry_fulcrum); }
+                    if (stream_body) {
+                      defer_sampler([=, ppc = materialConfigs.ppc](auto &out) mutable {
+                        make_sphere(out, geometry_span, geometry_offset_updated, ppc, geometry_radius, sample_start, sample_end, sample_rotation, geometry_fulcrum); }); }
+                    else if (operation == "Add" || operation == "add") {
+                      make_sphere(models[total_id], geometry_span, geometry_offset_updated, materialConfigs.ppc, geometry_radius, sample_start, sample_end, sample_rotation, geometry_fulcrum); }
                     else if (operation == "Subtract" || operation == "subtract") {
                       subtract_sphere(models[total_id], geometry_radius, geometry_offset_updated); }
                     else {  fmt::print(fg(red), "ERROR: GPU[{}] geometry operation[{}] invalid! \n", gpu_id, operation); if (mn::config::g_log_level >= 3) getchar(); }
@@ -2425,6 +2699,28 @@ void parse_scene(std::string fn,
                       fmt::print(fg(red),"ERROR: GPU[{}] No custom bathymetry points set!\n", gpu_id);
                     }
                   }
+                  else if (type == "Mesh" || type == "mesh")
+                  {
+                    // * Closed OBJ/STL mesh voxelized straight onto the particle lattice. Offset places the mesh's bounding-box corner.
+                    std::string geometry_file = CheckString(geometry, "file", std::string{"MpmParticles/mesh.obj"});
+                    std::string geometry_fn = std::string("./") + geometry_file;
+                    PREC geometry_scaling_factor = CheckDouble(geometry, "scaling_factor", 1) * froude_scaling;
+                    if (geometry_scaling_factor <= 0) {
+                      fmt::print(fg(red), "ERROR: [scaling_factor] must be greater than [0] for mesh load (e.g. [2] doubles size, [0] erases size). Fix and Retry.\n"); if (mn::config::g_log_level >= 3) getchar(); }
+                    if (operation == "Add" || operation == "add") {
+                      mn::TriangleMesh mesh;
+                      if (!mn::read_triangle_mesh(geometry_fn, mesh)) {
+                        fmt::print(fg(red), "ERROR: GPU[{}] Cannot read triangles from mesh file[{}]. Use a closed *.obj or *.stl.\n", gpu_id, geometry_fn); if (mn::config::g_log_level >= 3) getchar(); }
+                      else {
+                        fmt::print(fg(white), "GPU[{}] MODEL[{}] Voxelizing mesh[{}] with [{}] vertices and [{}] triangles.\n", gpu_id, model_id, geometry_fn, mesh.vertices.size(), mesh.triangles.size());
+                        std::size_t previous_count = models[total_id].size();
+                        make_mesh(models[total_id], mesh, geometry_scaling_factor / l, geometry_offset_updated, materialConfigs.ppc, sample_start, sample_end, sample_rotation, geometry_fulcrum);
+                        fmt::print(fg(white), "GPU[{}] MODEL[{}] Mesh added [{}] particles.\n", gpu_id, model_id, models[total_id].size() - previous_count);
+                      }
+                    }
+                    else if (operation == "Subtract" || operation == "subtract") { fmt::print(fg(red),"Operation not implemented yet...\n"); }
+                    else { fmt::print(fg(red), "ERROR: GPU[{}] geometry operation[{}] invalid! \n", gpu_id, operation); if (mn::config::g_log_level >= 3) getchar(); }
+                  }
                   else if (type == "File" || type == "file") 
                   {
                     // * NOTE : Assumes geometry "file" specified by scene.json is in  AssetDirPath/, e.g. for AssetDirPath = ~/claymore/Data/, then use ~/claymore/Data/file
@@ -2449,13 +2745,13 @@ void parse_scene(std::string fn,
                           fmt::print(fg(red), "ERROR: Signed-Distance-Field (.sdf) files require [padding] of atleast [1] (padding is empty exterior cells on sides of model, allows surface definition). Fix and Retry.");fmt::print(fg(yellow), "TIP: Use open-source SDFGen to create *.sdf from *.obj files.\n"); if (mn::config::g_log_level >= 3) getchar();}
                         mn::read_sdf(geometry_fn, models[total_id], materialConfigs.ppc,
                             (PREC)dx, mn::config::g_domain_size, geometry_offset_updated, l,
-                            partition_start, partition_end, rotation_matrix, geometry_fulcrum, geometry_scaling_factor, geometry_padding);
+                            sample_start, sample_end, sample_rotation, geometry_fulcrum, geometry_scaling_factor, geometry_padding);
                       }
                       else if (geometry_file_path.extension() == ".csv") 
                       {
                         load_csv_particles(geometry_fn, ',', 
                                             models[total_id], geometry_offset_updated, 
-                                            partition_start, partition_end, rotation_matrix, geometry_fulcrum);
+                                            sample_start, sample_end, sample_rotation, geometry_fulcrum);
                       }
                       else if (geometry_file_path.extension() == ".bgeo" ||
                           geometry_file_path.extension() == ".geo" ||
@@ -2537,6 +2833,42 @@ void parse_scene(std::string fn,
                   } 
                   geometry_offset_updated[0] += geometry_spacing[0];
                   }
+
+                  if (replicate_array) {
+                    std::vector<std::array<PREC, 3>> prototype(models[total_id].begin() + prototype_begin, models[total_id].end());
+                    models[total_id].resize(prototype_begin);
+                    std::vector<mn::vec<PREC, 3>> shifts; //< Same i, j, k order as the array loops
+                    for (int i = 0; i < geometry_array[0]; i++)
+                      for (int j = 0; j < geometry_array[1]; j++)
+                        for (int k = 0; k < geometry_array[2]; k++)
+                          shifts.push_back(mn::vec<PREC, 3>{i * geometry_spacing[0], j * geometry_spacing[1], k * geometry_spacing[2]});
+                    // Partio files are neither clipped nor rotated when loaded, keep that for their instances
+                    auto instances = mn::replicate_instances(models[total_id], prototype, shifts, !geometry_is_partio,
+                                                             partition_start, partition_end, rotation_matrix, geometry_fulcrum);
+                    // Per-particle attributes follow their prototype particle
+                    if (geometry_is_partio && attributes.size() == prototype.size()) {
+                      auto prototype_attributes = std::move(attributes);
+                      attributes.clear();
+                      attributes.reserve(models[total_id].size() - prototype_begin);
+                      for (auto& instance : instances)
+                        for (int p : instance.kept) attributes.push_back(prototype_attributes[p]);
+                    } else if (geometry_is_partio && has_attributes) {
+                      fmt::print(fg(orange), "WARNING: GPU[{}] MODEL[{}] Initial attribute count[{}] != prototype particle count[{}]. Attributes not replicated.\n", gpu_id, model_id, attributes.size(), prototype.size());
+                    }
+                    // Track IDs index the first instance. Track the same prototype particle in every other instance.
+                    std::vector<int> geo_track_particle_ids = CheckIntArray(geometry, "track_particle_id", std::vector<int>{});
+                    for (int id : geo_track_particle_ids) {
+                      long long first_local = (long long)id - (long long)prototype_begin;
+                      if (first_local < 0 || first_local >= (long long)instances[0].kept.size()) continue;
+                      int p = instances[0].kept[first_local];
+                      for (std::size_t n = 1; n < instances.size(); ++n) {
+                        long long idx = mn::instance_particle_index(instances[n], p);
+                        if (idx >= 0) track_particle_ids.push_back((int)idx);
+                      }
+                    }
+                    if (track_particle_ids.size() > mn::config::g_max_particle_trackers) { fmt::print(fg(red), "ERROR: Only [{}] track_particle_id value supported currently.\n", mn::config::g_max_particle_trackers); }
+                    fmt::print(fg(white), "GPU[{}] MODEL[{}] Replicated [{}] array instances from [{}] prototype particles, [{}] particles kept.\n", gpu_id, model_id, instances.size(), prototype.size(), models[total_id].size() - prototype_begin);
+                  }
                 }
               }
             } //< End geometry
@@ -2545,106 +2877,125 @@ void parse_scene(std::string fn,
               fmt::print(fg(red), "Press enter to continue...\n"); if (mn::config::g_log_level >= 3) getchar();
             }
               
-            auto positions = models[total_id];
-            mn::IO::insert_job([&]() {
-              mn::write_partio<PREC,3>(std::string{p.stem()} + save_suffix,positions); });              
-            mn::IO::flush();
-            fmt::print(fg(green), "NODE[{}] GPU[{}] MODEL[{}] Saved particles to [{}].\n", node_id, gpu_id, model_id, std::string{p.stem()} + save_suffix);
+            if (sampling) {
+              double cost = CheckDouble(model, "partition_cost", mn::material_cost(constitutive)); //< Relative cost per particle
+              mn::BlockLoads body_loads;
+              body_loads.add(models[total_id], cost);
+              sampling->block_loads.add(models[total_id], cost);
+              sampling->bodies.emplace_back(body_id, std::move(body_loads));
+              fmt::print(fg(green), "Sampled auto_partition body[{}] with [{}] particles over [{}] grid-blocks.\n", body_id, models[total_id].size(), sampling->bodies.back().second.size());
+              models[total_id].clear();
+              return;
+            }
+            if (plan) {
+              mn::ScenePlan::Body body;
+              body.body_id = body_id, body.gpu_id = gpu_id, body.model_id = model_id;
+              body.constitutive = constitutive;
+              body.supported = mn::plan_material(constitutive, algoConfigs.use_ASFLIP, algoConfigs.use_FBAR, body.mt) && !algoConfigs.use_FEM;
+              body.input_attribs = std::max<std::size_t>(1, input_attribs.size());
+              body.output_attribs = std::min<std::size_t>(std::max<std::size_t>(1, output_attribs.size()), mn::config::g_max_particle_attribs);
+              plan->add_body(std::move(body), models[total_id]);
+              fmt::print(fg(green), "Planned body[{}] on GPU[{}] MODEL[{}] with [{}] particles.\n", body_id, gpu_id, model_id, models[total_id].size());
+              models[total_id].clear();
+              return;
+            }
+
+            // * Optionally reorder particles along a space-filling curve of grid-blocks before upload
+            // * Trackers keep original IDs, benchmark maps them to uploaded IDs
+            mn::curve_e sort_curve = mn::parse_curve(CheckString(model, "sort_particles", std::string{"None"}));
+            if (sort_curve != mn::curve_e::None) {
+              auto order = mn::curve_order(models[total_id], sort_curve);
+              mn::apply_order(models[total_id], order);
+              if (has_attributes) {
+                if (attributes.size() == order.size()) mn::apply_order(attributes, order);
+                else fmt::print(fg(orange), "WARNING: GPU[{}] MODEL[{}] Initial attribute count[{}] != particle count[{}]. Attributes not reordered.\n", gpu_id, model_id, attributes.size(), order.size());
+              }
+              benchmark->setParticleIDRemap(gpu_id, model_id, mn::invert_order(order));
+              fmt::print(fg(green), "GPU[{}] MODEL[{}] Sorted [{}] particles along {} curve.\n", gpu_id, model_id, order.size(), sort_curve == mn::curve_e::Hilbert ? "Hilbert" : "Morton");
+            }
+
+            pipeline.wait_for_device(body_id); //< Upload in scene order per GPU, particle buffers are appended per model
+
+            const auto &positions = models[total_id]; //< Not copied, host already holds it once
+            std::size_t particle_count = stream_body ? stream_count : positions.size();
+            if (!stream_body) {
+              // File name by value. positions by reference, flush() returns only once the write has finished.
+              // Later bodies on this GPU and model append to positions after this body finishes (wait_for_model), never while it is written.
+              const std::size_t written_count = positions.size();
+              mn::IO::insert_job([fn = std::string{p.stem()} + save_suffix, &positions]() {
+                mn::write_partio<PREC,3>(fn, positions); });
+              mn::IO::flush();
+              if (positions.size() != written_count) {
+                fmt::print(fg(red), "ERROR: NODE[{}] GPU[{}] MODEL[{}] Particles appended [{} -> {}] while their output job was pending! Bodies on one model must append in scene order.\n", node_id, gpu_id, model_id, written_count, positions.size());
+                std::exit(EXIT_FAILURE);
+              }
+              fmt::print(fg(green), "NODE[{}] GPU[{}] MODEL[{}] Saved particles to [{}].\n", node_id, gpu_id, model_id, std::string{p.stem()} + save_suffix);
+            }
             
-            if (positions.size() > mn::config::g_max_particle_num) {
-              fmt::print(fg(red), "ERROR: NODE[{}] GPU[{}] MODEL[{}] Particle count [{}] exceeds g_max_particle_num in settings.h! Increase and recompile to avoid problems. \n", node_id, gpu_id, model_id, positions.size());
+            if (particle_count > capacity.max_particle_num) {
+              fmt::print(fg(red), "ERROR: NODE[{}] GPU[{}] MODEL[{}] Particle count [{}] exceeds capacity max_particle_num[{}]! Raise simulation:capacity:max_particle_num to avoid problems. \n", node_id, gpu_id, model_id, particle_count, capacity.max_particle_num);
               fmt::print(fg(red), "Press ENTER to continue anyways... \n");
               if (mn::config::g_log_level >= 3) getchar();
             }
 
             // * Initialize particle positions in simulator and on GPU
-            initModel(positions, velocity);
-
-            // ! Hard-coded available attribute count per particle for input, output
-            // ! Better optimized run-time binding for GPU Taichi-esque data-structures, but could definitely be improved using Thrust data-structures, etc. 
-
-            // * Initialize particle attributes in simulator and on GPU
-            if (!has_attributes) attributes = std::vector<std::vector<PREC> >(positions.size(), std::vector<PREC>(input_attribs.size(), 0.)); //< Zero initial attribs if none
-            if (input_attribs.size() == 1){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(1);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() == 2){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(2);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() == 3){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(3);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() == 4){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(4);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() == 5){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(5);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() == 6){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(6);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() == 7){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(7);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() == 8){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(8);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() == 9){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(9);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
-            } else if (input_attribs.size() > mn::config::g_max_particle_attribs){
-              fmt::print("More than [{}] input_attribs not implemented. You requested [{}].", mn::config::g_max_particle_attribs, input_attribs.size());
-              if (mn::config::g_log_level >= 3) getchar();
+            if (stream_body) {
+              // * Allocate for the counted particles, then replay samplers into chunks uploaded as they fill
+              initModel(particle_count, velocity);
+              mn::DeviceParticleSink<PREC, mn::mgsp_benchmark> sink{*benchmark, gpu_id, model_id};
+              mn::ParticleStream<PREC> stream(stream_chunk, &sink);
+              for (auto &sampler : stream_samplers) sampler(stream);
+              stream.flush();
+              if (stream.size() != particle_count)
+                fmt::print(fg(red), "ERROR: GPU[{}] MODEL[{}] Streamed [{}] particles, but [{}] were counted.\n", gpu_id, model_id, stream.size(), particle_count);
+              fmt::print(fg(green), "NODE[{}] GPU[{}] MODEL[{}] Streamed [{}] particles in [{}] chunks, host buffer [{}] megabytes. Partio file of initial body not written.\n", node_id, gpu_id, model_id, stream.size(), stream.chunks(), (float)stream.buffer_bytes() / 1000 / 1000);
             } else {
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(1);
-              benchmark->initInitialAttribs<N>(gpu_id, model_id, attributes, has_attributes); 
+              initModel(positions, velocity);
             }
+
+            // * Attribute counts are run-time strides of the attribute buffers (no per-count template instantiation)
+            // * Initialize particle attributes in simulator and on GPU. Zero attributes are set on device, without host rows
+            unsigned num_input_attribs = std::max<std::size_t>(1, input_attribs.size()); //< At least one element, as before
+            if (has_attributes) benchmark->initInitialAttribs(gpu_id, model_id, attributes, num_input_attribs, has_attributes); 
+            else benchmark->initInitialAttribs(gpu_id, model_id, particle_count, num_input_attribs);
+            std::vector<std::vector<PREC>>().swap(attributes);
             
             // * Initialize output particle attributes in simulator and on GPU
-            attributes = std::vector<std::vector<PREC> >(positions.size(), std::vector<PREC>(output_attribs.size(), 0.));
-            if (output_attribs.size() == 1){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(1);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() == 2){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(2);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() == 3){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(3);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() == 4){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(4);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() == 5){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(5);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() == 6){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(6);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() == 7){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(7);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() == 8){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(8);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() == 9){
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(9);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else if (output_attribs.size() > mn::config::g_max_particle_attribs){
+            unsigned num_output_attribs = output_attribs.size();
+            if (output_attribs.size() > mn::config::g_max_particle_attribs){
               fmt::print(fg(red), "ERROR: GPU[{}] MODEL[{}] More than [{}] output_attribs not valid. Requested: [{}]. Truncating...", gpu_id, model_id, mn::config::g_max_particle_attribs, output_attribs.size()); 
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(mn::config::g_max_particle_attribs);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
-            } else {
+              num_output_attribs = mn::config::g_max_particle_attribs;
+            } else if (output_attribs.size() == 0) {
               fmt::print(fg(orange), "WARNING: GPU[{}] MODEL[{}] output_attribs not found. Using [1] element default", gpu_id, model_id );
-              constexpr mn::num_attribs_e N = static_cast<mn::num_attribs_e>(1);
-              benchmark->initOutputAttribs<N>(gpu_id, model_id, attributes); 
+              num_output_attribs = 1;
             }
+            benchmark->initOutputAttribs(gpu_id, model_id, particle_count, num_output_attribs); 
             fmt::print(fmt::emphasis::bold,
                       "-----------------------------------------------------------"
                       "-----\n");
+          }; ///< end init_body
+
+          // * Bodies are parsed and sampled concurrently on host threads, taken in scene order
+          // * Each uploads to its GPU once earlier bodies on that GPU have, while later bodies keep sampling
+          // * Sequential when balancing or planning (shared accumulators) or when errors wait for ENTER
+          // * Safe only because IO::flush() waits for the output job in flight, so a body's write ends before later bodies on its model append
+          const bool concurrent_bodies = !sampling && !plan && mn::config::g_log_level < 3;
+          unsigned num_body_threads = concurrent_bodies ? std::max(1u, std::min<unsigned>(std::thread::hardware_concurrency(), num_bodies)) : 1;
+          if (num_body_threads == 1) {
+            for (int b = 0; b < num_bodies; ++b) init_body(bodies[b], b);
+          } else {
+            fmt::print(fg(cyan), "Initializing [{}] bodies on [{}] host threads. Output of bodies may interleave.\n", num_bodies, num_body_threads);
+            std::atomic<int> next_body{0};
+            std::vector<std::future<void>> body_threads;
+            for (unsigned t = 0; t < num_body_threads; ++t)
+              body_threads.emplace_back(mn::reallyAsync([&]() {
+                for (int b = next_body++; b < num_bodies; b = next_body++) init_body(bodies[b], b); }));
+            for (auto &body_thread : body_threads) body_thread.get();
           }
         }
       }
     } ///< end models parsing
+    if (sampling || plan) return; //< Sensors and boundaries not needed to balance bodies or plan memory
     {
       auto it = doc.FindMember("grid-sensors");
       if (it != doc.MemberEnd()) {
@@ -3012,7 +3363,6 @@ void parse_scene(std::string fn,
             if (motion_file != model.MemberEnd() && motion_velocity == model.MemberEnd()) 
             {
               fmt::print(fg(cyan),"Found motion file for grid-boundary[{}]. Loading... \n", boundary_ID);
-              MotionHolder motionPath;
               // std::string motion_fn = std::string(AssetDirPath) + model["file"].GetString();
               std::string motion_fn = std::string("./") + model["file"].GetString();
               fs::path motion_file_path{motion_fn};
@@ -3024,14 +3374,25 @@ void parse_scene(std::string fn,
               }
 
 
-              PREC_G mp_freq = CheckFloat(model, "output_frequency", 1.0);
+              PREC_G mp_freq = CheckFloat(model, "output_frequency", 1.0); //< Row rate, used if the time column is not increasing
               mp_freq *= 1 / sqrt(froude_scaling);
 
-              load_motionPath(motion_fn, ',', motionPath,  1, froude_scaling);
-
-              for (int did = 0; did < mn::config::g_device_cnt; ++did) {
-                benchmark->initMotionPath(did, motionPath, mp_freq);
-                fmt::print(fg(green),"GPU[{}] gridBoundary[{}] motion file[{}] initialized with frequency[{}].\n", did, boundary_ID, model["file"].GetString(), mp_freq);
+              // * CSV columns after time. Default is a paddle file (time, disp_x, vel_x), 6-DOF adds disp_y/z, rot_x/y/z, vel_*, omega_*
+              // * Parsed once into "<file>.mtc", later runs read the binary cache
+              std::vector<std::string> motion_columns = CheckStringArray(model, "motion_columns", std::vector<std::string> {{"disp_x"}, {"vel_x"}});
+              std::vector<int> motion_channels;
+              for (auto &column : motion_columns) {
+                motion_channels.push_back(mn::motion_channel(column));
+                if (motion_channels.back() < 0) fmt::print(fg(orange), "WARNING: gridBoundary[{}] motion column[{}] unknown, skipped. Use disp_, rot_, vel_ or omega_ with x, y or z.\n", boundary_ID, column);
+              }
+              mn::MotionTable motion_table;
+              bool from_cache = false;
+              if (mn::load_motion_table(motion_fn, motion_channels, froude_scaling, mp_freq, motion_table, &from_cache)) {
+                benchmark->initMotionTable(boundary_ID, motion_table);
+                fmt::print(fg(green),"gridBoundary[{}] motion file[{}] initialized with [{}] rows ({}).\n", boundary_ID, model["file"].GetString(), motion_table.rows(), from_cache ? "binary cache" : "parsed CSV");
+              } else {
+                fmt::print(fg(red), "ERROR: gridBoundary[{}] cannot read motion table from file[{}].\n", boundary_ID, motion_fn);
+                if (mn::config::g_log_level >= 3) getchar();
               }
             }
             // TODO : Fully implement constant velocity grid boundaries
@@ -0,0 +1,333 @@
+#ifndef __READ_SCENE_INPUT_CPU_H_
+#define __READ_SCENE_INPUT_CPU_H_
+#include "cpu_benchmark.h"
+#include "memory_planner.h"
+#include <MnBase/Math/Vec.cuh>
+
+#include <fmt/color.h>
+#include <fmt/core.h>
+#include <rapidjson/document.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/// Scene reader for the CPU backend (cpu_benchmark). Same scene.json as read_scene_input.h, in meters without the 1x1x1
+/// domain normalization, for the subset the CPU backend supports: JFluid / FixedCorotated bodies of Box, Sphere and
+/// Cylinder geometry, "Walls" and "Box" boundaries. Host-only, so osu_lwf also builds without CUDA.
+/// Also fills a ScenePlan (osu_lwf --plan) for the GPU build from the same bodies, so device memory can be sized here.
+namespace cpu_scene {
+
+namespace rj = rapidjson;
+
+inline double number(const rj::Value &object, const char *key, double backup) {
+  auto check = object.FindMember(key);
+  if (check == object.MemberEnd()) return backup;
+  if (!check->value.IsNumber()) {
+    fmt::print(fg(fmt::color::red), "ERROR: Input [{}] not a number! Using default value [{}].\n", key, backup);
+    return backup;
+  }
+  return check->value.GetDouble();
+}
+inline std::string string(const rj::Value &object, const char *key, std::string backup) {
+  auto check = object.FindMember(key);
+  if (check == object.MemberEnd() || !check->value.IsString()) return backup;
+  return check->value.GetString();
+}
+inline mn::pvec3 vec3(const rj::Value &object, const char *key, mn::pvec3 backup) {
+  auto check = object.FindMember(key);
+  if (check == object.MemberEnd()) return backup;
+  if (!check->value.IsArray()) {
+    fmt::print(fg(fmt::color::red), "ERROR: Input [{}] not an array! Using default value.\n", key);
+    return backup;
+  }
+  for (rj::SizeType d = 0; d < check->value.Size() && d < 3; ++d) //< Shorter arrays keep trailing defaults, e.g. "time"
+    if (check->value[d].IsNumber()) backup[d] = check->value[d].GetDouble();
+  return backup;
+}
+inline bool flag(const rj::Value &object, const char *key, bool backup) {
+  auto check = object.FindMember(key);
+  if (check == object.MemberEnd() || !check->value.IsBool()) return backup;
+  return check->value.GetBool();
+}
+inline bool one_of(const std::string &s, std::initializer_list<const char *> names) {
+  for (auto n : names) if (s == n) return true;
+  return false;
+}
+
+inline bool read_document(const std::string &fn, rj::Document &doc) {
+  std::ifstream is(fn, std::ios::binary);
+  if (!is) {
+    fmt::print(fg(fmt::color::red), "ERROR: Cannot open scene file [{}].\n", fn);
+    return false;
+  }
+  std::string configs{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
+  doc.Parse(configs.data());
+  if (doc.HasParseError() || !doc.IsObject()) {
+    fmt::print(fg(fmt::color::red), "ERROR: Scene file [{}] is not a valid JSON object.\n", fn);
+    return false;
+  }
+  return true;
+}
+
+/// Lattice of particles spaced dx / cbrt(ppc) inside span from offset, as make_box
+inline void sample_lattice(std::vector<std::array<PREC, 3>> &out, mn::pvec3 span, mn::pvec3 offset, PREC spacing,
+                           const std::string &object, PREC radius, int axis) {
+  int lim[3];
+  for (int d = 0; d < 3; ++d) lim[d] = (int)(span[d] / spacing + 1.0);
+  mn::pvec3 center;
+  for (int d = 0; d < 3; ++d) center[d] = offset[d] + (object == "Box" ? span[d] * 0.5 : radius);
+  for (int i = 0; i < lim[0]; ++i)
+    for (int j = 0; j < lim[1]; ++j)
+      for (int k = 0; k < lim[2]; ++k) {
+        std::array<PREC, 3> p{(i + 0.5) * spacing + offset[0], (j + 0.5) * spacing + offset[1], (k + 0.5) * spacing + offset[2]};
+        bool inside = true;
+        for (int d = 0; d < 3; ++d) inside = inside && p[d] < span[d] + offset[d];
+        if (!inside) continue;
+        PREC r2 = 0.;
+        for (int d = 0; d < 3; ++d)
+          if (object == "Sphere" || d != axis) r2 += (p[d] - center[d]) * (p[d] - center[d]);
+        if (object != "Box" && r2 > radius * radius) continue;
+        out.push_back(p);
+      }
+}
+/// Erase particles inside a Box, Sphere or Cylinder, as subtract_box / subtract_sphere / subtract_cylinder
+inline void subtract(std::vector<std::array<PREC, 3>> &out, mn::pvec3 span, mn::pvec3 offset, const std::string &object,
+                     PREC radius, int axis) {
+  mn::pvec3 center;
+  for (int d = 0; d < 3; ++d) center[d] = offset[d] + radius;
+  out.erase(std::remove_if(out.begin(), out.end(), [&](const std::array<PREC, 3> &p) {
+    if (object == "Box") {
+      for (int d = 0; d < 3; ++d) if (p[d] < offset[d] || p[d] > offset[d] + span[d]) return false;
+      return true;
+    }
+    PREC r2 = 0.;
+    for (int d = 0; d < 3; ++d) {
+      if (object == "Cylinder" && d == axis) {
+        if (p[d] < offset[d] || p[d] > offset[d] + span[d]) return false;
+        continue;
+      }
+      r2 += (p[d] - center[d]) * (p[d] - center[d]);
+    }
+    return r2 <= radius * radius;
+  }), out.end());
+}
+
+/// @brief Run-time capacity of scene, "simulation": {"capacity": {...}}, as CheckCapacity. False if it needs another compiled preset.
+inline bool capacity(const rj::Value &sim, mn::config::SimCapacity &cap) {
+  auto it = sim.FindMember("capacity");
+  if (it == sim.MemberEnd() || !it->value.IsObject()) return true;
+  auto &object = it->value;
+  for (auto [key, preset, compiled] : {std::make_tuple("domain_bits", "DOMAIN_BITS", mn::config::g_domain_bits),
+                                       std::make_tuple("max_ppc", "MAX_PPC", mn::config::g_max_ppc)}) {
+    if (!object.HasMember(key)) continue;
+    fmt::print(fg(fmt::color::red), "ERROR: simulation:capacity:{} is not a run-time setting, this build has {}[{}]. Remove it and build the preset -D{}={}.\n",
+               key, preset, compiled, preset, (int)number(object, key, compiled));
+    return false;
+  }
+  cap.max_active_block = (std::size_t)number(object, "max_active_block", (double)cap.max_active_block);
+  cap.max_particle_num = (std::size_t)number(object, "max_particle_num", (double)cap.max_particle_num);
+  cap.device_cnt = (int)number(object, "devices", cap.device_cnt);
+  cap.models_per_gpu = (int)number(object, "models_per_gpu", cap.models_per_gpu);
+  if (cap.fits_preset()) return true;
+  fmt::print(fg(fmt::color::red), "ERROR: Simulation capacity exceeds compiled preset: g_device_cnt[{}], g_models_per_gpu[{}].\n",
+             mn::config::g_device_cnt, mn::config::g_models_per_gpu);
+  return false;
+}
+
+/// @brief True if the scene asks for the CPU backend, "simulation": {"backend": "cpu"}
+inline bool scene_requests_cpu_backend(const std::string &fn) {
+  rj::Document doc;
+  if (!read_document(fn, doc)) return false;
+  auto sim = doc.FindMember("simulation");
+  if (sim == doc.MemberEnd() || !sim->value.IsObject()) return false;
+  std::string backend = string(sim->value, "backend", "gpu");
+  return one_of(backend, {"cpu", "CPU", "host", "Host"});
+}
+
+/// @brief Parse scene.json into a CPU benchmark. Returns false if the scene has no usable simulation or bodies.
+/// @param plan If set, only record bodies in plan (GPU build units and materials) and leave benchmark empty.
+inline bool parse_scene(const std::string &fn, std::unique_ptr<mn::cpu_benchmark> &benchmark, int num_threads,
+                        mn::ScenePlan *plan = nullptr) {
+  rj::Document doc;
+  if (!read_document(fn, doc)) return false;
+  auto it = doc.FindMember("simulation");
+  if (it == doc.MemberEnd() || !it->value.IsObject()) {
+    fmt::print(fg(fmt::color::red), "ERROR: Scene file [{}] has no \"simulation\" object.\n", fn);
+    return false;
+  }
+  auto &sim = it->value;
+  double froude_scaling = number(sim, "froude_scaling", 1.0);
+  PREC dx = number(sim, "default_dx", 0.1) * froude_scaling;
+  double dt = number(sim, "default_dt", dx / 100.) * std::sqrt(froude_scaling);
+  int fps = (int)number(sim, "fps", 60);
+  int frames = (int)std::ceil(number(sim, "frames", 60) * std::sqrt(froude_scaling));
+  double t0 = number(sim, "time", 0.0) * std::sqrt(froude_scaling);
+  mn::pvec3 gravity = vec3(sim, "gravity", mn::pvec3{0., -9.81, 0.});
+  std::string save_suffix = string(sim, "save_suffix", ".bgeo");
+  fmt::print(fg(fmt::color::cyan), "CPU scene: default_dx[{}], default_dt[{}], init_time[{}], fps[{}], frames[{}], gravity[{}, {}, {}], save_suffix[{}], froude_scaling[{}]\n",
+             dx, dt, t0, fps, frames, gravity[0], gravity[1], gravity[2], save_suffix, froude_scaling);
+  const PREC l = dx * mn::config::g_dx_inv_d; //< GPU build normalizes to a 1x1x1 domain of length l, see read_scene_input.h
+  if (plan) {
+    mn::pvec3 domain = vec3(sim, "domain", mn::pvec3{1., 1., 1.});
+    const int maxBlocks[3] = {mn::config::g_grid_size_x, mn::config::g_grid_size_y, mn::config::g_grid_size_z};
+    plan->domain_cell_cnt = 1;
+    for (int d = 0; d < 3; ++d)
+      plan->domain_cell_cnt *= std::min(maxBlocks[d], static_cast<int>(std::ceil(domain[d] * froude_scaling / (mn::config::g_blocksize * dx) - 1e-6)) + 2 * static_cast<int>(mn::config::g_bc));
+    if (!capacity(sim, plan->capacity)) return false;
+  } else
+    benchmark = std::make_unique<mn::cpu_benchmark>(dx, dt, t0, fps, frames, gravity, save_suffix, num_threads);
+
+  it = doc.FindMember("bodies");
+  if (it != doc.MemberEnd() && it->value.IsArray()) {
+    for (rj::SizeType b = 0; b < it->value.Size(); ++b) {
+      auto &body = it->value[b];
+      std::string constitutive = "JFluid";
+      const rj::Value *mat = &body;
+      auto findMat = body.FindMember("material");
+      if (findMat != body.MemberEnd() && findMat->value.IsObject()) mat = &findMat->value;
+      constitutive = string(*mat, "constitutive", constitutive);
+      bool fluid = one_of(constitutive, {"JFluid", "J-Fluid", "J_Fluid", "J Fluid", "jfluid", "j-fluid", "j_fluid", "j fluid", "Fluid", "fluid", "Water", "Liquid"});
+      bool fcr = one_of(constitutive, {"FixedCorotated", "Fixed_Corotated", "Fixed-Corotated", "Fixed Corotated", "fixedcorotated", "fixed_corotated", "fixed-corotated", "fixed corotated"});
+      if (!plan && !fluid && !fcr) {
+        fmt::print(fg(fmt::color::red), "ERROR: Body[{}] constitutive[{}] not supported by the CPU backend (JFluid, FixedCorotated). Skipping body.\n", b, constitutive);
+        if (mn::config::g_log_level >= 3) getchar();
+        continue;
+      }
+      auto findAlgo = body.FindMember("algorithm");
+      PREC ppc = number(body, "ppc", 8.0);
+      bool use_ASFLIP = true, use_FBAR = true, use_FEM = false; //< GPU build defaults
+      if (findAlgo != body.MemberEnd() && findAlgo->value.IsObject()) {
+        ppc = number(findAlgo->value, "ppc", ppc);
+        use_ASFLIP = flag(findAlgo->value, "use_ASFLIP", use_ASFLIP);
+        use_FBAR = flag(findAlgo->value, "use_FBAR", use_FBAR);
+        use_FEM = flag(findAlgo->value, "use_FEM", use_FEM);
+        if (!plan && (flag(findAlgo->value, "use_ASFLIP", false) || flag(findAlgo->value, "use_FBAR", false)))
+          fmt::print(fg(fmt::color::orange), "WARNING: Body[{}] ASFLIP / FBAR not available on the CPU backend, using APIC.\n", b);
+      }
+      PREC rho = number(*mat, "rho", 1e3);
+      mn::pvec3 velocity = vec3(body, "velocity", mn::pvec3{0., 0., 0.});
+      for (int d = 0; d < 3; ++d) velocity[d] *= std::sqrt(froude_scaling);
+      const PREC spacing = dx / std::cbrt(ppc);
+
+      std::vector<std::array<PREC, 3>> positions;
+      auto findGeo = body.FindMember("geometry");
+      if (findGeo != body.MemberEnd() && findGeo->value.IsArray()) {
+        for (auto &geometry : findGeo->value.GetArray()) {
+          std::string object = string(geometry, "object", "Box");
+          std::string operation = string(geometry, "operation", "add");
+          if (!one_of(object, {"Box", "Sphere", "Cylinder"})) {
+            fmt::print(fg(fmt::color::red), "ERROR: Body[{}] geometry object[{}] not supported by the CPU backend (Box, Sphere, Cylinder).\n", b, object);
+            continue;
+          }
+          if (geometry.HasMember("rotate"))
+            fmt::print(fg(fmt::color::orange), "WARNING: Body[{}] geometry rotation is ignored by the CPU backend.\n", b);
+          mn::pvec3 span = vec3(geometry, "span", mn::pvec3{1., 1., 1.});
+          mn::pvec3 offset = vec3(geometry, "offset", mn::pvec3{0., 0., 0.});
+          mn::pvec3 spacing_array = vec3(geometry, "spacing", mn::pvec3{0., 0., 0.});
+          mn::pvec3 array = vec3(geometry, "array", mn::pvec3{1., 1., 1.});
+          PREC radius = number(geometry, "radius", 0.) * froude_scaling;
+          std::string axis_name = string(geometry, "axis", "X");
+          int axis = (axis_name == "Y" || axis_name == "y") ? 1 : (axis_name == "Z" || axis_name == "z") ? 2 : 0;
+          for (int d = 0; d < 3; ++d) span[d] *= froude_scaling, offset[d] *= froude_scaling, spacing_array[d] *= froude_scaling;
+          for (int i = 0; i < (int)array[0]; ++i)
+            for (int j = 0; j < (int)array[1]; ++j)
+              for (int k = 0; k < (int)array[2]; ++k) {
+                mn::pvec3 o{offset[0] + i * spacing_array[0], offset[1] + j * spacing_array[1], offset[2] + k * spacing_array[2]};
+                if (operation == "subtract" || operation == "Subtract") subtract(positions, span, o, object, radius, axis);
+                else sample_lattice(positions, span, o, spacing, object, radius, axis);
+              }
+        }
+      }
+      if (positions.empty()) {
+        fmt::print(fg(fmt::color::red), "ERROR: Body[{}] has no particles. Skipping body.\n", b);
+        continue;
+      }
+      if (plan) {
+        mn::ScenePlan::Body planned;
+        planned.body_id = (int)b, planned.gpu_id = (int)number(body, "gpu", 0), planned.model_id = (int)number(body, "model", 0);
+        if (planned.gpu_id < 0 || planned.gpu_id >= plan->capacity.device_cnt || planned.model_id < 0 || planned.model_id >= plan->capacity.models_per_gpu) {
+          fmt::print(fg(fmt::color::red), "ERROR: Body[{}] GPU[{}] MODEL[{}] outside capacity devices[{}] models_per_gpu[{}]. Skipping body.\n",
+                     b, planned.gpu_id, planned.model_id, plan->capacity.device_cnt, plan->capacity.models_per_gpu);
+          continue;
+        }
+        planned.constitutive = constitutive;
+        planned.supported = mn::plan_material(constitutive, use_ASFLIP, use_FBAR, planned.mt) && !use_FEM;
+        auto findOutput = body.FindMember("output_attribs");
+        if (findOutput != body.MemberEnd() && findOutput->value.IsArray())
+          planned.output_attribs = std::min<unsigned>(std::max<unsigned>(1, findOutput->value.Size()), mn::config::g_max_particle_attribs);
+        for (auto &p : positions)
+          for (int d = 0; d < 3; ++d) p[d] = p[d] / l + mn::config::g_offset;
+        plan->add_body(std::move(planned), positions);
+        fmt::print(fg(fmt::color::green), "Planned body[{}] on GPU[{}] MODEL[{}] with [{}] particles.\n", b, plan->bodies.back().gpu_id, plan->bodies.back().model_id, positions.size());
+      } else if (fluid)
+        benchmark->initJFluid(positions, velocity, rho, ppc, number(*mat, "bulk_modulus", 2e7), number(*mat, "gamma", 7.1), number(*mat, "viscosity", 0.001));
+      else
+        benchmark->initFixedCorotated(positions, velocity, rho, ppc, number(*mat, "youngs_modulus", 1e7), number(*mat, "poisson_ratio", 0.2));
+    }
+  }
+  if (plan) {
+    if (plan->bodies.empty()) fmt::print(fg(fmt::color::red), "ERROR: Scene file [{}] has no bodies to plan.\n", fn);
+    return !plan->bodies.empty(); //< Boundaries not needed to plan memory
+  }
+  if (benchmark->getModelCnt() == 0) {
+    fmt::print(fg(fmt::color::red), "ERROR: Scene file [{}] has no bodies the CPU backend can run.\n", fn);
+    return false;
+  }
+
+  it = doc.FindMember("boundaries");
+  if (it == doc.MemberEnd()) it = doc.FindMember("grid-boundaries");
+  if (it != doc.MemberEnd() && it->value.IsArray()) {
+    for (auto &model : it->value.GetArray()) {
+      std::string object = string(model, "object", "Walls");
+      std::string contact = string(model, "contact", "Sticky");
+      mn::config::GridBoundaryConfigs gb;
+      if (one_of(object, {"Wall", "Walls", "wall", "walls"})) gb._object = mn::config::boundary_object_t::Walls;
+      else if (one_of(object, {"Box", "box"})) gb._object = mn::config::boundary_object_t::Box;
+      else {
+        fmt::print(fg(fmt::color::orange), "WARNING: Boundary object[{}] not supported by the CPU backend (Walls, Box). Skipping boundary.\n", object);
+        continue;
+      }
+      if (one_of(contact, {"Sticky", "sticky", "Stick", "stick", "NoSlip", "No-Slip", "no-slip"})) gb._contact = mn::config::boundary_contact_t::Sticky;
+      else if (one_of(contact, {"Slip", "slip"})) gb._contact = mn::config::boundary_contact_t::Slip;
+      else gb._contact = mn::config::boundary_contact_t::Separable;
+      mn::pvec3 lo = vec3(model, "domain_start", mn::pvec3{0., 0., 0.}), hi = vec3(model, "domain_end", mn::pvec3{1., 1., 1.});
+      mn::pvec3 time = vec3(model, "time", mn::pvec3{0., 1e10, 0.});
+      for (int d = 0; d < 3; ++d) {
+        gb._domain_start[d] = (PREC_G)(lo[d] * froude_scaling);
+        gb._domain_end[d] = (PREC_G)(hi[d] * froude_scaling);
+        gb._time[d] = (PREC_G)(time[d] * std::sqrt(froude_scaling));
+      }
+      benchmark->initGridBoundary(gb);
+    }
+  }
+  return true;
+}
+
+/// @brief Dry-run memory plan of scene fn for the GPU build, no device or simulation needed. Returns the process exit code.
+inline int plan(const std::string &fn) {
+  std::unique_ptr<mn::cpu_benchmark> benchmark;
+  mn::ScenePlan scene_plan;
+  if (!parse_scene(fn, benchmark, 0, &scene_plan)) return 1;
+  return scene_plan.report() ? 0 : 1;
+}
+
+/// @brief Run scene fn on the CPU backend. Returns the process exit code.
+inline int run(const std::string &fn, int num_threads) {
+  std::unique_ptr<mn::cpu_benchmark> benchmark;
+  if (!parse_scene(fn, benchmark, num_threads)) return 1;
+  benchmark->main_loop();
+  return 0;
+}
+
+} // namespace cpu_scene
+
+#endif
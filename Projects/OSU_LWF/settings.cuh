@@ -1,6 +1,7 @@
 #ifndef __SETTINGS_H_
 #define __SETTINGS_H_
 #include "partition_domain.h"
+#include <MnBase/Math/FixedPoint.h>
 #include <MnBase/Math/Vec.cuh>
 #include <MnBase/Object/Structural.h>
 #include <string>
@@ -69,16 +70,7 @@ enum class fem_e {  Tetrahedron, Tetrahedron_FBar,
                     Total };
 
 
-/// * For convenience, binds I/O sizes to compile-time variable names
-/// * Guarantees someone avoids unimplemented sizes (e.g. -1, 10004)
-/// TODO : Make this run-time to avoid lengthy compilitation of templates
-enum class num_attribs_e : int { Zero = 0, One = 1, Two = 2, Three = 3,
-                                 Four = 4, Five = 5, Six = 6, Seven = 7,
-                                 Eight = 8, Nine = 9 //, Ten = 10, 
-                                 // Eleven = 11, Twelve = 12 , Thirteen = 13
-                                //  Fourteen = 14, Fifteen = 15, Sixteen = 16, 
-                                //  Eighteen = 18, Twentyfour = 24, Thirtytwo = 32 
-                                 };
+/// * Particle I/O attribute counts are run-time (see ParticleAttrib), bounded for outputs by g_max_particle_attribs
 // Coupled-UP Soil Configs (Work-in-progress, model by Javier). Set to false if not a developer.
 #define DEBUG_COUPLED_UP false //< Debugging flag for CoupleUP model. False = Don't reserve grid memory for debugging. True = Reserve grid memory for debugging.
 constexpr bool g_debug_CoupledUP = DEBUG_COUPLED_UP; //< Debugging flag for CoupleUP
@@ -104,10 +96,13 @@ enum class log_e : int { None, Errors, Warn, Info, Tips };
 constexpr int g_log_level = (int)log_e::Warn; //< 0 = Print Nothing, 1 = + Errors, 2 = + Warnings, 3 = + Info, 4 = + Tips.
 constexpr int g_info_rate = 10; //< How often to print to stdout extra info messages of grid/particle memory use, etc. 1 = every frame, 2 = every other frame, etc.
 constexpr bool g_particles_output_exterior_only = false; // Default if not set in input script. Output only particles in exteriors blocks per frame, reduces memory usage on disk. Turn off for FULL particle output. 
+constexpr bool g_grid_block_dump = false; //< ADVANCED. Default false. Dump each GPU's grid-blocks at the end of every frame to grid_dev[i]_frame[n].mnsb (GridBuffer::save, self-describing binary with the block coordinates). For debugging and restarts, large: g_blockvolume cells of all grid attributes per active block.
 constexpr int g_exterior_particles_cutoff = 128; // Number of particles minimum in an exterior block to qualify for output. Avoid false positives when particle block is practically empty visually (e.g. 2 particles may as well be 0 cause you can see through it when visualizing)
 
 // * Grid set-up
+#ifndef DOMAIN_BITS //< Build presets may pass -DDOMAIN_BITS=..., see SimCapacity
 #define DOMAIN_BITS 11 //< Domain resolution. 8 -> (2^8)^3 grid-nodes. Increase = finer grids.
+#endif
 #define BLOCK_BITS 2 //< Block resolution. 2 -> (2^2)^3 grid-nodes. Set for Quadratic B-Spline.
 #define ARENA_BITS 1 //< Arena resolution. 1 -> (2^1)^3 grid-blocks. Set for Quadratic B-Spline Shared Mem with Off-by-2.
 #define DXINV (1.f * (1 << DOMAIN_BITS)) // Max grid-nodes in a direction, inverse of grid-spacing.
@@ -165,7 +160,9 @@ constexpr int g_num_warps_per_cuda_block = g_num_warps_per_grid_block * g_num_gr
 constexpr int g_max_active_block = 20000; //< Max active blocks in gridBlocks. Preallocated, can resize. Lower = less memory used.
 
 // * Particles
+#ifndef MAX_PPC //< Build presets may pass -DMAX_PPC=..., see SimCapacity
 #define MAX_PPC 128 //< VERY important. Max particles-per-cell. Must be a power of two, e.g. 16, 32, 64. Substantially effects memory/performance. Exceeding MAX_PPC deletes particles. Generally, use MAX_PPC = 8*(Actual PPC) to account for compression, if nearly incompressible materials this isn't as neccesary. 64 is usually reliable as default.
+#endif
 constexpr int g_max_ppc = MAX_PPC; //< Max particles per cell
 constexpr bool is_powerof2(int val) {
     return val && ((val & (val - 1)) == 0);
@@ -185,6 +182,28 @@ constexpr std::size_t calc_particle_bin_count(std::size_t numActiveBlocks) noexc
 constexpr int g_particle_attribs = 3; //< No. attribute values to output per particle 
 constexpr int g_max_particle_attribs = 9; //< No. attribute values to output per particle 
 constexpr bool g_buckets_on_particle_buffer = true; //< ADVANCED. Default true. Controls if particle cell/block buckets, etc. are on partition (false) or particle-buffer (true). Used for compatability with original Multi-GPU and Single-GPU data-structure setup. Having them on particle buffer required if multiiple models per GPU. - JB
+constexpr bool g_partition_block_hash = false; //< ADVANCED. Default false. Index partition blocks with the compact block hash (MnBase/DataStructure/Hash/Hash.cuh) instead of the dense _indexTable, for sparse domains at large DOMAIN_BITS
+constexpr bool g_device_memory_pool = false; //< ADVANCED. Default false. Route device_allocator through the caching pool (pooled_device_memory_resource, MnSystem/Cuda/Allocators.cuh) instead of cudaMalloc/cudaFree per call
+constexpr bool g_particle_fixed_point = false; //< EXPERIMENTAL. Default false. Store particle bin positions as fixed_point<int32_t, 31> (MnBase/Math/FixedPoint.h) instead of PREC
+using particle_pos_fixed_t = fixed_point<int32_t, 31, PREC>; //< Particle bin position storage if g_particle_fixed_point
+/// Particle position as read back from a particle bin, host reference of the device storage
+__forceinline__ __host__ __device__ PREC stored_particle_position(PREC x) noexcept {
+  return g_particle_fixed_point ? particle_pos_fixed_t::quantize_stochastic(x) : x;
+}
+
+// * Run-time capacity, set per scene in JSON "simulation": {"capacity": {...}} without recompiling. Defaults are the compiled values above.
+// * Preallocated sizes (max_active_block, max_particle_num) are free at run-time. device_cnt and models_per_gpu are upper bounds set by the compiled preset. DOMAIN_BITS and MAX_PPC are compiled only, scenes that set them are rejected; build another preset instead, e.g. -DDOMAIN_BITS=12 -DMAX_PPC=64.
+struct SimCapacity {
+  std::size_t max_active_block = g_max_active_block; //< Preallocated grid-blocks per GPU, can still resize
+  std::size_t max_particle_num = g_max_particle_num; //< Max particles per model
+  int device_cnt = g_device_cnt; //< <= g_device_cnt
+  int models_per_gpu = g_models_per_gpu; //< <= g_models_per_gpu
+  std::size_t max_particle_bin() const noexcept { return max_particle_num / g_bin_capacity; } //< As g_max_particle_bin
+  /// True if the compiled preset can run this capacity
+  bool fits_preset() const noexcept {
+    return device_cnt <= g_device_cnt && models_per_gpu <= g_models_per_gpu;
+  }
+};
 
 // * Particle-Trackers
 constexpr int g_track_ID = 0; //< ID of particle to track, [0, g_max_fem_vertice_num)
@@ -318,6 +337,11 @@ struct GridBoundaryConfigs {
   int _num_bathymetry_points; //< Number of bathymetry points
   vec<PREC_G, 2> _bathymetry_points[static_cast<int>(g_max_bathymetry_points)]; //< Bathymetry points
 };
+
+// * Boundary motion channels, evaluated per time-step from motion tables (motion_table.h)
+enum class motion_e : int { DispX, DispY, DispZ, RotX, RotY, RotZ, VelX, VelY, VelZ, OmegaX, OmegaY, OmegaZ, Count };
+constexpr int g_motion_channels = static_cast<int>(motion_e::Count);
+using MotionState = vec<PREC_G, g_motion_channels>; //< Motion of one grid-boundary at a time-step, sent to grid kernels
 // Deprecated structure for holding grid-target configs
 // TODO: Undeprecate
 struct GridTargetConfigs {
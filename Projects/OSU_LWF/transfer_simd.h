@@ -0,0 +1,204 @@
+#ifndef __TRANSFER_SIMD_H_
+#define __TRANSFER_SIMD_H_
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace mn {
+
+/// @brief Batched host kernels of the quadratic B-spline transfers, 8 particles per call, for the CPU backend.
+/// Same math as bspline_weight (utility_funcs.hpp) and the g2p2g gather / scatter, with one SIMD lane per particle:
+/// AVX-512 (8 doubles), AVX2 + FMA (2 x 4 doubles) or a scalar loop, picked at compile time (e.g. -march=native, cmake -DOSU_LWF_MARCH_NATIVE=ON).
+/// The scalar lanes are slower than one particle at a time, so cpu_benchmark only batches if batched (a SIMD ISA) is set.
+/// Grid arenas are the 8x8x8 float arenas of cpu_benchmark, cell (x, y, z) at (x * 8 + y) * 8 + z.
+namespace simd {
+
+constexpr int lanes = 8;
+constexpr int arena_size = 8;
+constexpr int arena_volume = arena_size * arena_size * arena_size;
+
+#if defined(__AVX512F__)
+constexpr const char *isa = "AVX-512";
+constexpr bool batched = true;
+struct pd { __m512d v; };
+struct pi { __m256i v; };
+inline pd set1(double a) noexcept { return {_mm512_set1_pd(a)}; }
+inline pd load(const double *p) noexcept { return {_mm512_loadu_pd(p)}; }
+inline void store(double *p, pd a) noexcept { _mm512_storeu_pd(p, a.v); }
+inline pd operator+(pd a, pd b) noexcept { return {_mm512_add_pd(a.v, b.v)}; }
+inline pd operator-(pd a, pd b) noexcept { return {_mm512_sub_pd(a.v, b.v)}; }
+inline pd operator*(pd a, pd b) noexcept { return {_mm512_mul_pd(a.v, b.v)}; }
+inline pd fmadd(pd a, pd b, pd c) noexcept { return {_mm512_fmadd_pd(a.v, b.v, c.v)}; }
+inline pd floor(pd a) noexcept { return {_mm512_roundscale_pd(a.v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC)}; }
+inline pd min(pd a, pd b) noexcept { return {_mm512_min_pd(a.v, b.v)}; }
+inline pd max(pd a, pd b) noexcept { return {_mm512_max_pd(a.v, b.v)}; }
+inline pi to_int(pd a) noexcept { return {_mm512_cvttpd_epi32(a.v)}; }
+inline pi operator+(pi a, int b) noexcept { return {_mm256_add_epi32(a.v, _mm256_set1_epi32(b))}; }
+inline pd gather(const float *base, pi idx) noexcept { return {_mm512_cvtps_pd(_mm256_i32gather_ps(base, idx.v, 4))}; }
+/// base[idx * lanes + lane] += a. Lanes write disjoint addresses, no conflicts.
+inline void scatter_add_lanes(float *base, pi idx, pd a) noexcept {
+  __m256i li = _mm256_add_epi32(_mm256_slli_epi32(idx.v, 3), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  __m256 sum = _mm256_add_ps(_mm256_i32gather_ps(base, li, 4), _mm512_cvtpd_ps(a.v));
+  _mm512_mask_i32scatter_ps(base, (__mmask16)0xFF, _mm512_castsi256_si512(li), _mm512_castps256_ps512(sum), 4);
+}
+#elif defined(__AVX2__) && defined(__FMA__)
+constexpr const char *isa = "AVX2";
+constexpr bool batched = true;
+struct pd { __m256d lo, hi; };
+struct pi { __m256i v; };
+inline pd set1(double a) noexcept { return {_mm256_set1_pd(a), _mm256_set1_pd(a)}; }
+inline pd load(const double *p) noexcept { return {_mm256_loadu_pd(p), _mm256_loadu_pd(p + 4)}; }
+inline void store(double *p, pd a) noexcept { _mm256_storeu_pd(p, a.lo), _mm256_storeu_pd(p + 4, a.hi); }
+inline pd operator+(pd a, pd b) noexcept { return {_mm256_add_pd(a.lo, b.lo), _mm256_add_pd(a.hi, b.hi)}; }
+inline pd operator-(pd a, pd b) noexcept { return {_mm256_sub_pd(a.lo, b.lo), _mm256_sub_pd(a.hi, b.hi)}; }
+inline pd operator*(pd a, pd b) noexcept { return {_mm256_mul_pd(a.lo, b.lo), _mm256_mul_pd(a.hi, b.hi)}; }
+inline pd fmadd(pd a, pd b, pd c) noexcept { return {_mm256_fmadd_pd(a.lo, b.lo, c.lo), _mm256_fmadd_pd(a.hi, b.hi, c.hi)}; }
+inline pd floor(pd a) noexcept { return {_mm256_floor_pd(a.lo), _mm256_floor_pd(a.hi)}; }
+inline pd min(pd a, pd b) noexcept { return {_mm256_min_pd(a.lo, b.lo), _mm256_min_pd(a.hi, b.hi)}; }
+inline pd max(pd a, pd b) noexcept { return {_mm256_max_pd(a.lo, b.lo), _mm256_max_pd(a.hi, b.hi)}; }
+inline pi to_int(pd a) noexcept { return {_mm256_set_m128i(_mm256_cvttpd_epi32(a.hi), _mm256_cvttpd_epi32(a.lo))}; }
+inline pi operator+(pi a, int b) noexcept { return {_mm256_add_epi32(a.v, _mm256_set1_epi32(b))}; }
+inline pd gather(const float *base, pi idx) noexcept {
+  __m256 g = _mm256_i32gather_ps(base, idx.v, 4);
+  return {_mm256_cvtps_pd(_mm256_castps256_ps128(g)), _mm256_cvtps_pd(_mm256_extractf128_ps(g, 1))};
+}
+/// base[idx * lanes + lane] += a. Lanes write disjoint addresses, no conflicts. No AVX2 scatter, so lane by lane.
+inline void scatter_add_lanes(float *base, pi idx, pd a) noexcept {
+  alignas(32) int32_t i[lanes];
+  alignas(32) float v[lanes];
+  _mm256_store_si256(reinterpret_cast<__m256i *>(i), idx.v);
+  _mm_store_ps(v, _mm256_cvtpd_ps(a.lo)), _mm_store_ps(v + 4, _mm256_cvtpd_ps(a.hi));
+  for (int l = 0; l < lanes; ++l) base[i[l] * lanes + l] += v[l];
+}
+#else
+constexpr const char *isa = "scalar";
+constexpr bool batched = false; //< Reference for the SIMD paths and bench_transfer_simd
+struct pd { double v[lanes]; };
+struct pi { int32_t v[lanes]; };
+#define MN_SIMD_LANEWISE(expr) pd r; for (int l = 0; l < lanes; ++l) r.v[l] = (expr); return r
+inline pd set1(double a) noexcept { MN_SIMD_LANEWISE(a); }
+inline pd load(const double *p) noexcept { MN_SIMD_LANEWISE(p[l]); }
+inline void store(double *p, pd a) noexcept { for (int l = 0; l < lanes; ++l) p[l] = a.v[l]; }
+inline pd operator+(pd a, pd b) noexcept { MN_SIMD_LANEWISE(a.v[l] + b.v[l]); }
+inline pd operator-(pd a, pd b) noexcept { MN_SIMD_LANEWISE(a.v[l] - b.v[l]); }
+inline pd operator*(pd a, pd b) noexcept { MN_SIMD_LANEWISE(a.v[l] * b.v[l]); }
+inline pd fmadd(pd a, pd b, pd c) noexcept { MN_SIMD_LANEWISE(a.v[l] * b.v[l] + c.v[l]); }
+inline pd floor(pd a) noexcept { MN_SIMD_LANEWISE(std::floor(a.v[l])); }
+inline pd min(pd a, pd b) noexcept { MN_SIMD_LANEWISE(a.v[l] < b.v[l] ? a.v[l] : b.v[l]); }
+inline pd max(pd a, pd b) noexcept { MN_SIMD_LANEWISE(a.v[l] > b.v[l] ? a.v[l] : b.v[l]); }
+inline pd gather(const float *base, pi idx) noexcept { MN_SIMD_LANEWISE(base[idx.v[l]]); }
+#undef MN_SIMD_LANEWISE
+inline pi to_int(pd a) noexcept { pi r; for (int l = 0; l < lanes; ++l) r.v[l] = static_cast<int32_t>(a.v[l]); return r; }
+inline pi operator+(pi a, int b) noexcept { for (int l = 0; l < lanes; ++l) a.v[l] += b; return a; }
+/// base[idx * lanes + lane] += a. Lanes write disjoint addresses, no conflicts.
+inline void scatter_add_lanes(float *base, pi idx, pd a) noexcept {
+  for (int l = 0; l < lanes; ++l) base[idx.v[l] * lanes + l] += static_cast<float>(a.v[l]);
+}
+#endif
+
+/// @brief Stencil of 8 particles along one axis: base cell, position from base cell, quadratic B-spline weights.
+/// As bspline_weight with base = floor(x / dx + 0.5) - 1.
+struct stencil_1d {
+  pd base, local, w[3];
+};
+inline stencil_1d bspline_weights(pd x, double dx, double dx_inv) noexcept {
+  stencil_1d s;
+  s.base = floor(fmadd(x, set1(dx_inv), set1(0.5))) - set1(1.0);
+  s.local = x - s.base * set1(dx);
+  pd d = s.local * set1(dx_inv);
+  pd t = set1(1.5) - d;
+  s.w[0] = set1(0.5) * t * t;
+  t = d - set1(1.0);
+  s.w[1] = set1(0.75) - t * t;
+  t = d - set1(0.5);
+  s.w[2] = set1(0.5) * t * t;
+  return s;
+}
+/// Weights at local position clamped to [0.5, 1.5] dx, inside the 3-node stencil of base (used after clamping base)
+inline void bspline_weights_at(stencil_1d &s, double dx_inv) noexcept {
+  pd d = min(max(s.local * set1(dx_inv), set1(0.5)), set1(1.5));
+  pd t = set1(1.5) - d;
+  s.w[0] = set1(0.5) * t * t;
+  t = d - set1(1.0);
+  s.w[1] = set1(0.75) - t * t;
+  t = d - set1(0.5);
+  s.w[2] = set1(0.5) * t * t;
+}
+
+/// Arena cell of each lane's stencil corner, given the arena origin cell (block b * g_blocksize) per axis
+inline pi arena_corner(const stencil_1d s[3], const double origin[3]) noexcept {
+  pd a = (s[0].base - set1(origin[0])) * set1(arena_size * arena_size) + (s[1].base - set1(origin[1])) * set1(arena_size) +
+         (s[2].base - set1(origin[2]));
+  return to_int(a);
+}
+
+/// @brief APIC G2P of 8 particles. vel: [3][arena_volume] arena velocities. Outputs velocity and
+/// C = sum W v (x_i - x_p)^T, column-major as g2p2g (Dp^-1 applied by the caller).
+inline void g2p_gather(const float *vel, pi corner, const stencil_1d s[3], double dx, pd v[3], pd C[9]) noexcept {
+  for (int d = 0; d < 3; ++d) v[d] = set1(0.);
+  for (int d = 0; d < 9; ++d) C[d] = set1(0.);
+  for (int i = 0; i < 3; ++i) {
+    pd xi = set1(i * dx) - s[0].local;
+    for (int j = 0; j < 3; ++j) {
+      pd yj = set1(j * dx) - s[1].local;
+      pd wij = s[0].w[i] * s[1].w[j];
+      for (int k = 0; k < 3; ++k) {
+        pd zk = set1(k * dx) - s[2].local;
+        pd W = wij * s[2].w[k];
+        pi idx = corner + ((i * arena_size + j) * arena_size + k);
+        pd vi[3] = {gather(vel, idx), gather(vel + arena_volume, idx), gather(vel + 2 * arena_volume, idx)};
+        for (int r = 0; r < 3; ++r) {
+          pd Wv = W * vi[r];
+          v[r] = fmadd(W, vi[r], v[r]);
+          C[r] = fmadd(Wv, xi, C[r]);
+          C[3 + r] = fmadd(Wv, yj, C[3 + r]);
+          C[6 + r] = fmadd(Wv, zk, C[6 + r]);
+        }
+      }
+    }
+  }
+}
+
+/// @brief P2G of 8 particles into a lane-private arena lane_arena[4][arena_volume][lanes]: mass and momentum
+/// m v + contrib (x_i - x_p), contrib column-major. Zero mass lanes add nothing. Fold with reduce_lanes.
+inline void p2g_scatter(float *lane_arena, pi corner, const stencil_1d s[3], double dx, pd mass, const pd v[3],
+                        const pd contrib[9]) noexcept {
+  pd mv[3] = {mass * v[0], mass * v[1], mass * v[2]};
+  for (int i = 0; i < 3; ++i) {
+    pd xi = set1(i * dx) - s[0].local;
+    for (int j = 0; j < 3; ++j) {
+      pd yj = set1(j * dx) - s[1].local;
+      pd wij = s[0].w[i] * s[1].w[j];
+      for (int k = 0; k < 3; ++k) {
+        pd zk = set1(k * dx) - s[2].local;
+        pd W = wij * s[2].w[k];
+        pi idx = corner + ((i * arena_size + j) * arena_size + k);
+        scatter_add_lanes(lane_arena, idx, W * mass);
+        for (int r = 0; r < 3; ++r) {
+          pd affine = fmadd(contrib[r], xi, fmadd(contrib[3 + r], yj, contrib[6 + r] * zk));
+          scatter_add_lanes(lane_arena + (1 + r) * arena_volume * lanes, idx, W * (mv[r] + affine));
+        }
+      }
+    }
+  }
+}
+
+/// @brief arena[ch][cell] += sum of lanes of lane_arena[ch][cell][lanes], then clears lane_arena
+inline void reduce_lanes(float *lane_arena, float *arena, int channels) noexcept {
+  for (int c = 0; c < channels * arena_volume; ++c) {
+    float *l = lane_arena + static_cast<std::size_t>(c) * lanes;
+    float sum = ((l[0] + l[1]) + (l[2] + l[3])) + ((l[4] + l[5]) + (l[6] + l[7]));
+    arena[c] += sum;
+    for (int k = 0; k < lanes; ++k) l[k] = 0.f;
+  }
+}
+
+} // namespace simd
+
+} // namespace mn
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef __MN_TEST_CHECK_H_
+#define __MN_TEST_CHECK_H_
+#include <fmt/core.h>
+
+/// @brief Minimal checks for the host tests: failures are printed and counted, the test keeps going.
+namespace mn_test {
+inline int failures = 0;
+/// Print the summary line and return the exit code of main()
+inline int result(const char *name) {
+  fmt::print("{}: {}\n", name, failures ? "FAILED" : "passed");
+  return failures ? 1 : 0;
+}
+} // namespace mn_test
+
+#define MN_CHECK(cond, ...)                                                                                            \
+  do {                                                                                                                 \
+    if (!(cond)) {                                                                                                     \
+      fmt::print(__VA_ARGS__);                                                                                         \
+      ++mn_test::failures;                                                                                             \
+    }                                                                                                                  \
+  } while (0)
+
+#endif
@@ -0,0 +1,84 @@
+#include "check.h"
+#include <MnBase/DataStructure/Hash/Hash.cuh>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// host_block_hash runs the same probing code as the device block_hash (Partition with g_partition_block_hash).
+// Against std::unordered_map: every distinct block gets exactly one index in [0, count), duplicates return sentinel_v,
+// queries find every inserted block and nothing else, serial and on a thread_pool, and a full table fails cleanly.
+namespace {
+using hash_t = mn::host_block_hash<int>;
+using table_t = hash_t::table_t;
+
+/// Active blocks of a flume: nx x ny x nz blocks at an offset in the domain, each key listed dup times in random order
+std::vector<uint64_t> flume_keys(int nx, int ny, int nz, int dup, std::mt19937 &rng) {
+  std::vector<uint64_t> keys;
+  for (int x = 0; x < nx; ++x)
+    for (int y = 0; y < ny; ++y)
+      for (int z = 0; z < nz; ++z)
+        for (int d = 0; d < dup; ++d) keys.push_back(table_t::block_key(x + 100, y + 7, z + 300));
+  std::shuffle(keys.begin(), keys.end(), rng);
+  return keys;
+}
+
+void check_table(hash_t &hash, const std::vector<uint64_t> &keys, const std::vector<int> &inserted, const char *what) {
+  std::unordered_map<uint64_t, int> reference;
+  std::size_t new_indices = 0;
+  std::vector<char> index_used(keys.size(), 0);
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (inserted[i] == table_t::sentinel_v) continue;
+    ++new_indices;
+    MN_CHECK(reference.emplace(keys[i], inserted[i]).second, "{}: key {} got a second index\n", what, keys[i]);
+    MN_CHECK(inserted[i] >= 0 && inserted[i] < (int)keys.size() && !index_used[inserted[i]], "{}: index {} reused or out of range\n",
+             what, inserted[i]);
+    if (inserted[i] >= 0 && inserted[i] < (int)keys.size()) index_used[inserted[i]] = 1;
+  }
+  MN_CHECK((int)new_indices == hash.count(), "{}: {} new indices, count() {}\n", what, new_indices, hash.count());
+  for (uint64_t key : keys) MN_CHECK(reference.count(key), "{}: key {} never inserted\n", what, key);
+  for (auto &kv : reference) MN_CHECK(hash.query(kv.first) == kv.second, "{}: query of {} != inserted index\n", what, kv.first);
+  std::mt19937 rng(5);
+  for (int i = 0; i < 10000; ++i) { //< Absent blocks, outside the flume
+    uint64_t key = table_t::block_key(rng() % 90, rng() % 1000, rng() % 1000);
+    MN_CHECK(hash.query(key) == table_t::sentinel_v, "{}: absent key {} found\n", what, key);
+  }
+}
+} // namespace
+
+int main() {
+  std::mt19937 rng(1);
+  for (int threads : {1, 4}) {
+    mn::thread_pool pool(threads);
+    for (int dup : {1, 3}) {
+      auto keys = flume_keys(64, 8, 16, dup, rng);
+      const std::size_t blocks = keys.size() / dup;
+      hash_t hash(blocks);
+      MN_CHECK(hash.port().size() >= 2 * blocks, "table of {} slots for {} blocks, load factor over 0.5\n", hash.port().size(), blocks);
+      // Serial inserts
+      std::vector<int> inserted(keys.size());
+      for (std::size_t i = 0; i < keys.size(); ++i) inserted[i] = hash.insert(keys[i]);
+      check_table(hash, keys, inserted, "serial insert");
+      // Bulk insert and query on the pool, after clear()
+      hash.clear();
+      hash.insert_bulk(pool, keys.size(), keys.data(), inserted.data());
+      check_table(hash, keys, inserted, threads > 1 ? "bulk insert, 4 threads" : "bulk insert");
+      std::vector<int> queried(keys.size());
+      hash.query_bulk(pool, keys.size(), keys.data(), queried.data());
+      for (std::size_t i = 0; i < keys.size(); ++i)
+        MN_CHECK(queried[i] == hash.query(keys[i]) && queried[i] != table_t::sentinel_v, "bulk query of {} wrong\n", keys[i]);
+      // Reinsert with known indices, as Partition::reinsert rebuilds the table
+      hash_t rebuilt(blocks);
+      for (std::size_t i = 0; i < keys.size(); ++i)
+        if (inserted[i] != table_t::sentinel_v) MN_CHECK(rebuilt.port().insert(keys[i], inserted[i]), "reinsert of {} failed\n", keys[i]);
+      for (uint64_t key : keys) MN_CHECK(rebuilt.query(key) == hash.query(key), "reinserted {} differs\n", key);
+    }
+  }
+  // Full table: inserts past the slot count fail with sentinel_v, queries still terminate
+  hash_t tiny(0);
+  const std::size_t slots = tiny.port().size();
+  std::size_t ok = 0;
+  for (std::size_t i = 0; i < slots + 10; ++i) ok += tiny.insert(table_t::block_key((int)i, 0, 0)) != table_t::sentinel_v;
+  MN_CHECK(ok == slots, "full table took {} of {} keys\n", ok, slots);
+  MN_CHECK(tiny.query(table_t::block_key(1, 1, 1)) == table_t::sentinel_v, "absent key found in full table\n");
+  return mn_test::result("test_block_hash");
+}
@@ -0,0 +1,66 @@
+#include "body_pipeline.h"
+#include "check.h"
+#include <MnSystem/IO/IO.h>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Concurrent body initialization as in read_scene_input: bodies on one GPU and model append to a shared vector
+// in scene order, and each body's output job reads that vector by reference until IO::flush() returns.
+// No append may land while an output job is pending, and every output holds exactly the bodies before it.
+int main() {
+  constexpr int num_gpus = 2, models_per_gpu = 2, num_bodies = 24, particles_per_body = 100;
+  for (int round = 0; round < 20; ++round) {
+    std::mt19937 rng(round);
+    std::vector<int> gpu(num_bodies), model(num_bodies);
+    for (int b = 0; b < num_bodies; ++b) gpu[b] = rng() % num_gpus, model[b] = rng() % models_per_gpu;
+    std::vector<std::vector<int>> models(num_gpus * models_per_gpu); //< Particle i of body b stored as b
+    std::vector<std::vector<int>> written(num_bodies);              //< What each body's output job saw
+    std::vector<std::vector<int>> uploads(num_gpus);                 //< Upload order per GPU
+    std::vector<std::size_t> appended_while_pending(num_bodies, 0);
+
+    mn::BodyPipeline pipeline(num_bodies);
+    auto init_body = [&](int b) {
+      mn::BodyPipeline::Ticket ticket{pipeline, b};
+      std::this_thread::sleep_for(std::chrono::microseconds(50 * ((b * 7 + round) % 5))); //< Parsing takes a while
+      const int total_id = model[b] + gpu[b] * models_per_gpu;
+      pipeline.assign(b, gpu[b], model[b]);
+      pipeline.wait_for_model(b);
+      for (int i = 0; i < particles_per_body; ++i) models[total_id].push_back(b);
+      pipeline.wait_for_device(b);
+      uploads[gpu[b]].push_back(b);
+      const auto &positions = models[total_id];
+      const std::size_t written_count = positions.size();
+      mn::IO::insert_job([&positions, &out = written[b]]() {
+        std::this_thread::sleep_for(std::chrono::microseconds(300)); //< Slow write, later bodies keep sampling
+        out = positions;
+      });
+      mn::IO::flush();
+      appended_while_pending[b] = positions.size() - written_count;
+    };
+    std::atomic<int> next_body{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 6; ++t)
+      threads.emplace_back([&]() {
+        for (int b = next_body++; b < num_bodies; b = next_body++) init_body(b);
+      });
+    for (auto &thread : threads) thread.join();
+
+    for (int b = 0; b < num_bodies; ++b) {
+      MN_CHECK(appended_while_pending[b] == 0, "round {} body {}: {} particles appended while its output was pending\n",
+               round, b, appended_while_pending[b]);
+      std::vector<int> expected; //< Bodies up to b on the same GPU and model, in scene order
+      for (int e = 0; e <= b; ++e)
+        if (gpu[e] == gpu[b] && model[e] == model[b]) expected.insert(expected.end(), particles_per_body, e);
+      MN_CHECK(written[b] == expected, "round {} body {}: output holds {} particles, expected {} in scene order\n", round,
+               b, written[b].size(), expected.size());
+    }
+    for (int g = 0; g < num_gpus; ++g)
+      for (std::size_t n = 1; n < uploads[g].size(); ++n)
+        MN_CHECK(uploads[g][n - 1] < uploads[g][n], "round {} GPU {}: body {} uploaded before body {}\n", round, g,
+                 uploads[g][n], uploads[g][n - 1]);
+  }
+  return mn_test::result("test_body_pipeline");
+}
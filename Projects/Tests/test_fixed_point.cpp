@@ -0,0 +1,96 @@
+#include "check.h"
+#include <MnBase/Math/FixedPoint.h>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+// fixed_point<int32_t, 31> as particle positions are stored with g_particle_fixed_point. Round trips and saturation,
+// then 1e4 steps of x += v*dt written back through operator= as g2p2g does: error against the double path must stay a
+// random walk (unbiased), and particles moving less than half a step per time-step must still advance.
+namespace {
+using fixed_t = mn::fixed_point<int32_t, 31, double>;
+constexpr double cells_per_unit = 2048.; //< DOMAIN_BITS 11, 4-cell blocks
+const double step = fixed_t::resolution();
+
+struct drift_t {
+  double mean_cells, rms_cells, max_cells;
+};
+/// Particles at constant velocity v = frac_of_step * step per time-step (random fractions if frac_of_step < 0)
+drift_t constant_velocity(int particles, int steps, double frac_of_step, bool nearest, double *moved = nullptr) {
+  std::mt19937_64 rng(5);
+  std::uniform_real_distribution<double> uni(0., 1.);
+  double sum = 0., sum2 = 0., worst = 0., advanced = 0.;
+  for (int p = 0; p < particles; ++p) {
+    const double x0 = 0.25 + 0.5 * uni(rng);
+    const double v = (frac_of_step < 0 ? 20. * uni(rng) - 10. : frac_of_step) * step;
+    fixed_t x;
+    x = x0;
+    const double start = x;
+    for (int s = 0; s < steps; ++s) {
+      if (nearest)
+        x._v = fixed_t::encode(x + v);
+      else
+        x = x + v;
+    }
+    const double err = ((double)x - (start + steps * v)) * cells_per_unit;
+    sum += err, sum2 += err * err, worst = std::max(worst, std::abs(err));
+    advanced += ((double)x - start) / (steps * v);
+  }
+  if (moved) *moved = advanced / particles;
+  return {sum / particles, std::sqrt(sum2 / particles), worst};
+}
+} // namespace
+
+int main() {
+  // Values on the grid are exact, including after a copy through operator=
+  std::mt19937 rng(6);
+  for (int i = 0; i < 100000; ++i) {
+    const int32_t raw = (int32_t)rng();
+    fixed_t a, b;
+    a = fixed_t::decode(raw);
+    b = (double)a;
+    MN_CHECK(a._v == raw && b._v == raw, "grid value {} not stored exactly\n", raw);
+  }
+  // Any value within one step, round to nearest within half a step
+  std::uniform_real_distribution<double> uni(-1., 1.);
+  for (int i = 0; i < 100000; ++i) {
+    const double x = uni(rng) * 0.999;
+    fixed_t a;
+    a = x;
+    MN_CHECK(std::abs((double)a - x) < step && std::abs(fixed_t::quantize(x) - x) <= 0.5 * step, "{} stored as {}\n", x,
+             (double)a);
+  }
+  fixed_t s;
+  s = 2.;
+  MN_CHECK(s._v == std::numeric_limits<int32_t>::max(), "no saturation above max()\n");
+  s = -2.;
+  MN_CHECK(s._v == std::numeric_limits<int32_t>::min(), "no saturation below min()\n");
+  s = std::numeric_limits<double>::quiet_NaN();
+  MN_CHECK(s._v == std::numeric_limits<int32_t>::min(), "NaN not saturated\n");
+
+  // Stochastic rounding is unbiased: mean of many writes of x is x
+  const double x = 0.3 + 0.3 * step;
+  double mean = 0.;
+  for (int i = 0; i < 200000; ++i) mean += fixed_t::quantize_stochastic(x);
+  mean /= 200000;
+  MN_CHECK(std::abs(mean - x) < 0.01 * step, "mean of stochastic writes off by {} steps\n", (mean - x) / step);
+
+  // 1e4 steps at constant velocity, against round-to-nearest
+  const int particles = 2000, steps = 10000;
+  for (double frac : {0.3, -1.}) {
+    const drift_t n = constant_velocity(particles, steps, frac, true), r = constant_velocity(particles, steps, frac, false);
+    fmt::print("v*dt = {}: nearest drift mean {:.2e} / max {:.2e} cells, stochastic mean {:.2e} / rms {:.2e} / max {:.2e} cells\n",
+               frac < 0 ? "random in [-10, 10) steps" : "0.3 steps", n.mean_cells, n.max_cells, r.mean_cells, r.rms_cells,
+               r.max_cells);
+    MN_CHECK(r.rms_cells < 1e-4 && std::abs(r.mean_cells) < 1e-5, "stochastic rounding drifts: mean {}, rms {} cells\n",
+             r.mean_cells, r.rms_cells);
+  }
+  // Slower than half a step: round-to-nearest never moves, stochastic rounding moves at the right speed on average
+  double moved_nearest, moved;
+  constant_velocity(200, steps, 0.1, true, &moved_nearest);
+  constant_velocity(200, steps, 0.1, false, &moved);
+  fmt::print("v*dt = 0.1 steps: nearest moved {:.3f}, stochastic {:.3f} of the exact distance\n", moved_nearest, moved);
+  MN_CHECK(moved_nearest == 0. && std::abs(moved - 1.) < 0.05, "slow particles: moved {} of the distance\n", moved);
+  return mn_test::result("test_fixed_point");
+}
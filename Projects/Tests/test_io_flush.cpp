@@ -0,0 +1,37 @@
+#include <MnSystem/IO/IO.h>
+#include "check.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// IO::flush() has to wait for the job in flight, not only for the queue to drain.
+// Jobs capture caller data by reference and the caller reuses it right after flush().
+int main() {
+  using namespace mn;
+  for (int round = 0; round < 50; ++round) {
+    std::vector<int> data(1000, round);
+    long long sum = 0;
+    IO::insert_job([&data, &sum]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(2)); //< Still running once popped off the queue
+      for (int v : data) sum += v;
+    });
+    IO::flush();
+    const long long expected = 1000ll * round;
+    data.assign(1000, -1); //< Caller reuses the data, the job must be done with it
+    MN_CHECK(sum == expected, "round {}: job saw sum {} after flush, expected {}\n", round, sum, expected);
+  }
+  // Several queued jobs, all finished and in order after one flush
+  std::vector<int> order;
+  for (int n = 0; n < 16; ++n)
+    IO::insert_job([&order, n]() {
+      std::this_thread::sleep_for(std::chrono::microseconds(200));
+      order.push_back(n);
+    });
+  IO::flush();
+  MN_CHECK(order.size() == 16, "flush returned with {} of 16 jobs finished\n", order.size());
+  for (std::size_t n = 0; n < order.size(); ++n)
+    MN_CHECK(order[n] == (int)n, "job {} ran at position {}\n", order[n], n);
+  IO::flush(); //< Nothing pending, returns at once
+  return mn_test::result("test_io_flush");
+}
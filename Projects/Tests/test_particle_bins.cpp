@@ -0,0 +1,62 @@
+#include "check.h"
+#include <MnBase/Algorithm/RadixSort.h>
+#include <random>
+#include <vector>
+
+// particle_bins has to produce the layout of build_particle_cell_buckets + cell_bucket_to_block + compute_bin_capacity:
+// per-cell counts capped at MaxPPC, block buckets at a stride of MaxPPC * BlockVolume, bins of BinCapacity.
+// The reference below replays the kernels serially, particles in ID order, cells of a block in order.
+namespace {
+constexpr int block_volume = 64, bin_capacity = 32, max_ppc = 4;
+using bins_t = mn::particle_bins<block_volume, bin_capacity, max_ppc>;
+
+void check_against_kernels(mn::thread_pool &pool, const std::vector<uint32_t> &keys, int block_count, const char *what) {
+  const std::size_t n = keys.size();
+  std::vector<int> ppcs(block_count * block_volume, 0), cellbuckets(block_count * bins_t::particle_num_per_block, -1);
+  std::size_t dropped = 0;
+  for (std::size_t p = 0; p < n; ++p) { //< build_particle_cell_buckets
+    const int blockno = keys[p] / block_volume, cellno = keys[p] % block_volume;
+    int pidic = ppcs[keys[p]]++;
+    if (pidic >= max_ppc) {
+      --ppcs[keys[p]], ++dropped;
+      continue;
+    }
+    cellbuckets[blockno * bins_t::particle_num_per_block + cellno * max_ppc + pidic] = (int)p;
+  }
+  std::vector<int> ppbs(block_count, 0), buckets(block_count * bins_t::particle_num_per_block, -1), binsts(block_count + 1, 0);
+  for (int b = 0; b < block_count; ++b) { //< cell_bucket_to_block, compute_bin_capacity + exclScan
+    for (int c = 0; c < block_volume; ++c)
+      for (int i = 0; i < ppcs[b * block_volume + c]; ++i)
+        buckets[b * bins_t::particle_num_per_block + ppbs[b]++] = cellbuckets[b * bins_t::particle_num_per_block + c * max_ppc + i];
+    binsts[b + 1] = binsts[b] + (ppbs[b] + bin_capacity - 1) / bin_capacity;
+  }
+
+  bins_t bins;
+  bins.build(pool, n, keys.data(), block_count);
+  MN_CHECK(bins.ppcs == ppcs, "{}: ppcs differ from the kernels\n", what);
+  MN_CHECK(bins.ppbs == ppbs, "{}: ppbs differ from the kernels\n", what);
+  MN_CHECK(bins.binsts == binsts, "{}: binsts differ from the kernels\n", what);
+  MN_CHECK(bins.bin_count() == binsts.back(), "{}: bin_count {} != {}\n", what, bins.bin_count(), binsts.back());
+  MN_CHECK(bins.buckets == buckets, "{}: block buckets differ from the kernels\n", what);
+  MN_CHECK(bins.dropped == dropped, "{}: dropped {} != {}\n", what, bins.dropped, dropped);
+}
+} // namespace
+
+int main() {
+  for (int threads : {1, 4}) {
+    mn::thread_pool pool(threads);
+    std::mt19937 rng(threads);
+    for (int block_count : {1, 7, 300}) {
+      for (std::size_t n : {std::size_t{0}, std::size_t{1}, std::size_t{5000}, std::size_t{200000}}) {
+        // Uniform keys, mostly under MaxPPC per cell for the larger grids
+        std::vector<uint32_t> keys(n);
+        for (auto &k : keys) k = rng() % (block_count * block_volume);
+        check_against_kernels(pool, keys, block_count, "uniform");
+        // Clustered keys, cells far over MaxPPC and empty blocks between
+        for (auto &k : keys) k = (rng() % ((block_count + 1) / 2)) * 2 * block_volume + rng() % 3;
+        check_against_kernels(pool, keys, block_count, "clustered");
+      }
+    }
+  }
+  return mn_test::result("test_particle_bins");
+}
@@ -0,0 +1,68 @@
+#include "particle_stream.h"
+#include "check.h"
+#include <vector>
+
+// Streamed initialization has to hand the sink the same positions, in the same order and at the same
+// model offsets, as sampling into a std::vector.
+namespace {
+struct OffsetSink : mn::ParticleSink<double> {
+  std::vector<std::array<double, 3>> particles;
+  std::vector<std::size_t> offsets, counts;
+  void consume(std::size_t offset, const std::array<double, 3> *chunk, std::size_t count) override {
+    offsets.push_back(offset), counts.push_back(count);
+    particles.insert(particles.end(), chunk, chunk + count);
+  }
+};
+
+template <typename Out> void sample(Out &out, int n) {
+  for (int i = 0; i < n; ++i) out.push_back({0.001 * i, 0.5 + 0.25 * (i % 7), -0.125 * (i % 3)});
+}
+} // namespace
+
+int main() {
+  for (std::size_t chunk : {std::size_t{1}, std::size_t{7}, std::size_t{64}, std::size_t{1000}, std::size_t{5000}}) {
+    for (int n : {0, 1, 63, 64, 65, 1000, 4321}) {
+      std::vector<std::array<double, 3>> reference;
+      sample(reference, n);
+
+      OffsetSink sink;
+      mn::ParticleStream<double> stream{chunk, &sink};
+      sample(stream, n);
+      MN_CHECK(stream.size() == (std::size_t)n, "chunk {} n {}: size {} before flush\n", chunk, n, stream.size());
+      stream.flush();
+      stream.flush(); //< Second flush has nothing left
+      MN_CHECK(sink.particles == reference, "chunk {} n {}: streamed positions differ from vector sampling\n", chunk, n);
+      MN_CHECK(stream.chunks() == (n + chunk - 1) / chunk, "chunk {} n {}: {} chunks\n", chunk, n, stream.chunks());
+      MN_CHECK(stream.buffer_bytes() <= chunk * sizeof(std::array<double, 3>), "chunk {} n {}: buffer grew past one chunk\n", chunk, n);
+      std::size_t expected_offset = 0;
+      for (std::size_t c = 0; c < sink.offsets.size(); ++c) {
+        MN_CHECK(sink.offsets[c] == expected_offset, "chunk {} n {}: chunk {} at offset {}, expected {}\n", chunk, n, c, sink.offsets[c], expected_offset);
+        MN_CHECK(sink.counts[c] > 0 && sink.counts[c] <= chunk, "chunk {} n {}: chunk {} holds {}\n", chunk, n, c, sink.counts[c]);
+        expected_offset += sink.counts[c];
+      }
+
+      mn::HostParticleSink<double> host;
+      mn::ParticleStream<double> host_stream{chunk, &host};
+      sample(host_stream, n);
+      host_stream.flush();
+      MN_CHECK(host.particles == reference, "chunk {} n {}: HostParticleSink differs\n", chunk, n);
+
+      mn::ParticleStream<double> counter; //< No sink, counting pass only
+      sample(counter, n);
+      counter.flush();
+      MN_CHECK(counter.size() == (std::size_t)n && counter.chunks() == 0 && counter.buffer_bytes() == 0,
+            "chunk {} n {}: counting pass buffered particles\n", chunk, n);
+    }
+  }
+
+  { // HostParticleSink places chunks at their offset, as uploadParticles does on device
+    mn::HostParticleSink<double> host;
+    const std::array<double, 3> tail[2] = {{2., 2., 2.}, {3., 3., 3.}}, head[2] = {{0., 0., 0.}, {1., 1., 1.}};
+    host.consume(2, tail, 2);
+    host.consume(0, head, 2);
+    bool ordered = host.particles.size() == 4;
+    for (std::size_t i = 0; ordered && i < 4; ++i) ordered = host.particles[i][0] == (double)i;
+    MN_CHECK(ordered, "HostParticleSink ignored chunk offsets\n");
+  }
+  return mn_test::result("test_particle_stream");
+}
@@ -0,0 +1,160 @@
+#include "check.h"
+#include <MnBase/Memory/PoolResource.h>
+#include <atomic>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+// caching_pool_resource on host memory: size classes, reuse, stream-ordered release with a controllable fence,
+// cache limit, trim-on-pressure and thread safety. The device pool (pooled_device_memory_resource) is the same class
+// over device_memory_resource with cuda_stream_fence.
+namespace {
+/// Heap upstream that counts bytes and fails past a budget, as cudaMalloc when the GPU is full
+struct counting_resource : mn::Singleton<counting_resource>, mn::memory_resource<counting_resource> {
+  std::atomic<long long> bytes{0}, allocs{0}, frees{0};
+  long long budget = ~0ull >> 1;
+  void *do_allocate(std::size_t n, std::size_t) {
+    if (bytes + (long long)n > budget) throw std::bad_alloc{};
+    bytes += n, ++allocs;
+    return ::operator new(n);
+  }
+  void do_deallocate(void *p, std::size_t n, std::size_t) {
+    bytes -= n, ++frees;
+    ::operator delete(p);
+  }
+};
+
+/// Fence a test completes by hand. Default constructed (plain deallocate) is ready at once.
+struct manual_fence {
+  std::shared_ptr<bool> done;
+  static inline int waits = 0;
+  bool ready() const noexcept { return !done || *done; }
+  void wait() const noexcept {
+    ++waits;
+    if (done) *done = true; //< As cudaEventSynchronize returns once the stream got there
+  }
+  void destroy() noexcept { done.reset(); }
+};
+
+using pool_t = mn::caching_pool_resource<counting_resource, manual_fence>;
+} // namespace
+
+int main() {
+  auto &up = counting_resource::instance();
+  {
+    pool_t pool;
+    // Size classes: at least the request, at most 25% slack above min_block, monotonic
+    std::size_t prev = 0;
+    double worst = 0.;
+    for (std::size_t bytes = 1; bytes < (std::size_t{1} << 22); bytes += 1 + bytes / 7) {
+      std::size_t cls = pool.size_class(bytes);
+      MN_CHECK(cls >= bytes && cls >= prev, "size_class({}) = {}\n", bytes, cls);
+      if (bytes > 256) worst = std::max(worst, (double)(cls - bytes) / bytes);
+      prev = cls;
+    }
+    MN_CHECK(worst <= 0.25, "size class slack {} over 25%\n", worst);
+    fmt::print("worst size class slack {:.1f}%\n", worst * 100);
+
+    // Free then allocate the same class: cached block, no upstream call
+    void *a = pool.allocate(1000);
+    pool.deallocate(a, 1000);
+    void *b = pool.allocate(900); //< Same 1024 class
+    MN_CHECK(a == b, "freed block not reused\n");
+    MN_CHECK(pool.stats().upstream_allocs == 1 && pool.stats().cache_hits == 1, "upstream allocs {}, hits {}\n",
+             pool.stats().upstream_allocs, pool.stats().cache_hits);
+    pool.deallocate(b, 900);
+
+    // Stream-ordered release: an in-flight block is skipped for a ready one, and only waited on when nothing else is free
+    manual_fence pending{std::make_shared<bool>(false)};
+    void *c = pool.allocate(1000); //< Cached block from above
+    void *d = pool.allocate(1000); //< New upstream block
+    pool.deallocate(c, 1000, pending);
+    pool.deallocate(d, 1000); //< Ready at once
+    void *e = pool.allocate(1000);
+    MN_CHECK(e == d && manual_fence::waits == 0, "took the in-flight block ({}) or waited ({})\n", e == c, manual_fence::waits);
+    void *f = pool.allocate(1000);
+    MN_CHECK(f == c && manual_fence::waits == 1 && pool.stats().fence_waits == 1, "in-flight block not waited on before reuse\n");
+    pool.deallocate(e, 1000), pool.deallocate(f, 1000);
+    *pending.done = true;
+
+    // Growing buffer, as particle bins resize: old block freed after the new one is allocated
+    pool.release();
+    const auto before = pool.stats();
+    std::size_t size = 1 << 20;
+    void *buf = pool.allocate(size);
+    for (int step = 0; step < 200; ++step) {
+      std::size_t next = step % 10 < 7 ? size + size / 20 : size - size / 15; //< Mostly growing, sometimes shrinking
+      void *grown = pool.allocate(next);
+      pool.deallocate(buf, size);
+      buf = grown, size = next;
+    }
+    const auto after = pool.stats();
+    fmt::print("200 resizes: {} upstream allocations, peak reserved {:.2f}x the final buffer\n", after.upstream_allocs - before.upstream_allocs,
+               (double)after.peak_bytes_reserved / size);
+    MN_CHECK(after.upstream_allocs - before.upstream_allocs < 100, "resizes did not reuse cached blocks\n");
+    pool.deallocate(buf, size);
+
+    // Cache limit and bypass of large requests
+    pool_t limited(&up, 256, std::size_t{1} << 20, 4096);
+    std::vector<void *> blocks;
+    for (int i = 0; i < 8; ++i) blocks.push_back(limited.allocate(1024));
+    for (void *p : blocks) limited.deallocate(p, 1024);
+    MN_CHECK(limited.stats().bytes_cached <= 4096 && limited.stats().upstream_frees == 4, "cache limit ignored, {} cached\n",
+             limited.stats().bytes_cached);
+    void *big = limited.allocate((std::size_t{1} << 20) + 1);
+    limited.deallocate(big, (std::size_t{1} << 20) + 1);
+    MN_CHECK(limited.stats().bytes_cached <= 4096, "request over max_block was cached\n");
+
+    // Trim on upstream out-of-memory: cached blocks go back and the allocation succeeds
+    limited.release(), pool.release();
+    up.budget = up.bytes + 64 * 1024;
+    pool_t tight(&up);
+    void *g = tight.allocate(40000);
+    tight.deallocate(g, 40000); //< Cached, upstream still holds it
+    void *h = tight.allocate(60000); //< Fits only once the cached block is trimmed
+    MN_CHECK(h && tight.stats().trims >= 1, "no trim on upstream out-of-memory\n");
+    bool threw = false;
+    try {
+      tight.allocate(1 << 20);
+    } catch (const std::bad_alloc &) {
+      threw = true;
+    }
+    MN_CHECK(threw, "allocation over the budget did not throw\n");
+    tight.deallocate(h, 60000);
+    tight.release();
+    up.budget = ~0ull >> 1;
+
+    // Pointer from elsewhere goes straight upstream
+    void *foreign = up.allocate(512);
+    pool.deallocate(foreign, 512);
+
+    // Threads allocating and freeing mixed sizes
+    pool_t shared;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.emplace_back([&shared, t]() {
+        std::mt19937 rng(t);
+        std::vector<std::pair<void *, std::size_t>> held;
+        for (int i = 0; i < 20000; ++i) {
+          if (held.size() < 16 && (held.empty() || rng() % 2)) {
+            std::size_t n = 64 + rng() % 100000;
+            held.emplace_back(shared.allocate(n), n);
+            static_cast<char *>(held.back().first)[n - 1] = 1; //< Usable
+          } else {
+            std::size_t k = rng() % held.size();
+            shared.deallocate(held[k].first, held[k].second);
+            held.erase(held.begin() + k);
+          }
+        }
+        for (auto &p : held) shared.deallocate(p.first, p.second);
+      });
+    for (auto &th : threads) th.join();
+    MN_CHECK(shared.stats().bytes_in_use == 0, "{} bytes still in use after all threads freed\n", shared.stats().bytes_in_use);
+    shared.release();
+    pool.release();
+  }
+  MN_CHECK(up.bytes == 0 && up.allocs == up.frees, "upstream leaked {} bytes ({} allocs, {} frees)\n", up.bytes.load(),
+           up.allocs.load(), up.frees.load());
+  return mn_test::result("test_pool_resource");
+}
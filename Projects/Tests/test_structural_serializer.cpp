@@ -0,0 +1,141 @@
+#include "check.h"
+#include <MnBase/Memory/Allocator.h>
+#include <MnBase/Object/StructuralSerializer.h>
+#include <sstream>
+#include <string>
+
+// Round trips of StructuralSerializer.h through a grid buffer shaped as grid_buffer_ (dynamic aos of 4^3-cell soa blocks,
+// sum_pow2_align), as GridBuffer::save/load write it from the device: same schema back, a changed block type
+// (double precision, an extra attribute, fewer attributes, aosoa cells) converted by position, zero-copy view,
+// and rejected truncated or foreign blobs.
+namespace {
+using namespace mn;
+using namespace mn::placeholder;
+using f32_ = structural_entity<float>;
+using f64_ = structural_entity<double>;
+using block_domain = compact_domain<char, 4, 4, 4>;
+using buffer_domain = compact_domain<int, 1024>;
+constexpr auto full = structural_allocation_policy::full_allocation;
+
+template <attrib_layout Layout, typename... Attribs>
+using block_ = structural<structural_type::dense, decorator<full, structural_padding_policy::sum_pow2_align>, block_domain,
+                         Layout, Attribs...>;
+template <typename Block>
+using buffer_ = structural<structural_type::dynamic, decorator<full, structural_padding_policy::compact>, buffer_domain,
+                           attrib_layout::aos, Block>;
+
+using grid_block_ = block_<attrib_layout::soa, f32_, f32_, f32_, f32_, f32_, f32_, f32_, f32_, f32_>;
+using grid_block_f64_ = block_<attrib_layout::soa, f64_, f64_, f64_, f64_, f64_, f64_, f64_, f64_, f64_, f64_>;
+using grid_block_less_ = block_<attrib_layout::soa, f32_, f32_, f32_, f32_>;
+using grid_block_tiled_ = block_<attrib_layout::aosoa_16, f32_, f32_, f32_, f32_, f32_, f32_, f32_, f32_, f32_>;
+
+constexpr int blocks = 37, capacity = 64, attribs = 9;
+float value(int b, int c, int a) { return (float)(b * 1000 + c * 10 + a) * 0.25f; }
+
+template <typename Inst, std::size_t... A>
+void fill(Inst &buf, std::index_sequence<A...>) {
+  for (int b = 0; b < blocks; ++b) {
+    auto block = buf.ch(_0, b);
+    for (int c = 0; c < 64; ++c) ((block.val_1d(std::integral_constant<attrib_index, A>{}, c) = value(b, c, (int)A)), ...);
+  }
+}
+/// Blocks [0, count) of buf hold value() in attributes [0, present) and 0 in the rest
+template <typename Inst, std::size_t... A>
+bool holds(Inst &buf, int count, int present, std::index_sequence<A...>) {
+  bool ok = true;
+  for (int b = 0; b < count; ++b) {
+    auto block = buf.ch(_0, b);
+    for (int c = 0; c < 64; ++c)
+      ((ok = ok && (double)block.val_1d(std::integral_constant<attrib_index, A>{}, c) ==
+                       ((int)A < present ? (double)value(b, c, (int)A) : 0.)),
+       ...);
+  }
+  return ok;
+}
+
+template <typename Block>
+auto spawn_buffer() {
+  auto buf = spawn<buffer_<Block>, orphan_signature>(heap_allocator{}, capacity);
+  std::memset(buf._handle.ptr, 0xff, buffer_<Block>::storage_size(capacity)); //< Loads must overwrite every byte they claim
+  return buf;
+}
+} // namespace
+
+int main() {
+  auto grid = spawn_buffer<grid_block_>();
+  fill(grid, std::make_index_sequence<attribs>{});
+  std::stringstream file;
+  MN_CHECK(save_structural(file, grid, blocks), "save_structural failed\n");
+  const std::string bytes = file.str();
+
+  structural_blob blob;
+  {
+    std::istringstream in(bytes);
+    MN_CHECK(blob.read(in), "blob did not read back\n");
+  }
+  MN_CHECK(blob.count == blocks && blob.matches<buffer_<grid_block_>>(), "blob count {} or schema wrong\n", blob.count);
+  MN_CHECK(blob.payload.size() == blocks * grid_block_::size, "payload {} bytes, expected {}\n", blob.payload.size(),
+           blocks * grid_block_::size);
+  std::ostringstream schema;
+  blob.schema.describe(schema);
+  fmt::print("{}", schema.str());
+
+  // Same schema: bulk copy
+  auto same = spawn_buffer<grid_block_>();
+  MN_CHECK(load_structural(blob, same, capacity) == blocks, "same schema: wrong block count\n");
+  MN_CHECK(holds(same, blocks, attribs, std::make_index_sequence<attribs>{}), "same schema: values differ\n");
+  MN_CHECK(std::memcmp(same._handle.ptr, grid._handle.ptr, blob.payload.size()) == 0, "same schema: bytes differ\n");
+
+  // Capacity smaller than the blob: truncated to capacity
+  MN_CHECK(load_structural(blob, same, 10) == 10, "load did not stop at capacity\n");
+
+  // Double precision and a 10th attribute: converted, the new attribute zero
+  auto wide = spawn_buffer<grid_block_f64_>();
+  MN_CHECK(load_structural(blob, wide, capacity) == blocks, "f64: wrong block count\n");
+  MN_CHECK(holds(wide, blocks, attribs, std::make_index_sequence<attribs + 1>{}), "f64: values differ\n");
+
+  // Fewer attributes: the rest dropped
+  auto less = spawn_buffer<grid_block_less_>();
+  load_structural(blob, less, capacity);
+  MN_CHECK(holds(less, blocks, 4, std::make_index_sequence<4>{}), "4 attributes: values differ\n");
+
+  // aosoa cells within a block
+  auto tiled = spawn_buffer<grid_block_tiled_>();
+  load_structural(blob, tiled, capacity);
+  MN_CHECK(holds(tiled, blocks, attribs, std::make_index_sequence<attribs>{}), "aosoa_16: values differ\n");
+
+  // And back from the converted double buffer to the original type
+  std::stringstream wide_file;
+  save_structural(wide_file, wide, blocks);
+  structural_blob wide_blob;
+  MN_CHECK(wide_blob.read(wide_file) && !wide_blob.matches<buffer_<grid_block_>>(), "f64 blob wrong\n");
+  auto back = spawn_buffer<grid_block_>();
+  load_structural(wide_blob, back, capacity);
+  MN_CHECK(holds(back, blocks, attribs, std::make_index_sequence<attribs>{}), "f32 -> f64 -> f32 not exact\n");
+
+  // Zero-copy view of a matching blob, refused for another schema
+  Instance<buffer_<grid_block_>> view{};
+  MN_CHECK(view_structural(blob, view) && view._capacity == (std::size_t)blocks &&
+               holds(view, blocks, attribs, std::make_index_sequence<attribs>{}),
+           "view_structural of a matching blob failed\n");
+  Instance<buffer_<grid_block_f64_>> wrong_view{};
+  MN_CHECK(!view_structural(blob, wrong_view), "view_structural accepted another schema\n");
+
+  // Truncated and foreign blobs
+  for (std::size_t cut : {std::size_t{2}, std::size_t{16}, bytes.size() / 2, bytes.size() - 1}) {
+    std::istringstream in(bytes.substr(0, cut));
+    structural_blob b;
+    MN_CHECK(!b.read(in), "blob cut at {} of {} bytes read as valid\n", cut, bytes.size());
+  }
+  {
+    std::string other = bytes;
+    other[0] = 'X';
+    std::istringstream in(other);
+    structural_blob b;
+    MN_CHECK(!b.read(in), "blob with a wrong magic read as valid\n");
+  }
+
+  for (auto *inst : {&grid, &same, &back}) inst->deallocate(heap_allocator{});
+  wide.deallocate(heap_allocator{}), less.deallocate(heap_allocator{}), tiled.deallocate(heap_allocator{});
+  return mn_test::result("test_structural_serializer");
+}
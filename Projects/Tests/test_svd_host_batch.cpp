@@ -0,0 +1,120 @@
+#include "check.h"
+#include <MnBase/Math/Matrix/svd_host.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Accuracy of the batched host SVD (svd_host_batch) against the scalar math::svd it stands in for on the CPU backend.
+// Per matrix kind: reconstruction |U S V^T - A| / max|A|, orthogonality of U and V, det(U) = det(V) = 1,
+// sorted S, and S against math::svd computed in double.
+namespace {
+enum kind_e { Random = 0, NearIdentity, Rank2, Inverted, RowScaled, Zero, Repeated, NumKinds };
+const char *kind_names[NumKinds] = {"random", "near-identity", "rank-2", "inverted", "row-scaled", "zero", "repeated"};
+
+/// Column-major 3x3 of the kind
+void make_matrix(kind_e kind, std::mt19937_64 &rng, double *A) {
+  std::uniform_real_distribution<double> u(-1., 1.);
+  for (int e = 0; e < 9; ++e) A[e] = u(rng);
+  switch (kind) {
+  case NearIdentity:
+    for (int e = 0; e < 9; ++e) A[e] = ((e & 0x3) ? 0. : 1.) + 1e-3 * A[e];
+    break;
+  case Rank2: //< Third column a combination of the first two
+    for (int r = 0; r < 3; ++r) A[6 + r] = 0.3 * A[r] - 0.7 * A[3 + r];
+    break;
+  case Inverted: //< Mirrored deformation, det < 0
+    for (int e = 0; e < 9; ++e) A[e] = ((e & 0x3) ? 0. : 1.) + 0.2 * A[e];
+    for (int c = 0; c < 3; ++c) A[c * 3] = -A[c * 3];
+    break;
+  case RowScaled: //< Strongly anisotropic stretch, 1e3 : 1e-2
+    for (int c = 0; c < 3; ++c) A[c * 3] *= 1e3, A[c * 3 + 2] *= 1e-2;
+    break;
+  case Zero:
+    for (int e = 0; e < 9; ++e) A[e] = 0.;
+    break;
+  case Repeated: { //< Rotation times diag(s, s, s'), two equal singular values
+    double s = 1. + 0.5 * u(rng), q[4] = {u(rng), u(rng), u(rng), u(rng)};
+    double n = std::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (double &x : q) x /= n;
+    double w = q[0], x = q[1], y = q[2], z = q[3];
+    double R[9] = {1 - 2 * (y * y + z * z), 2 * (x * y + w * z),     2 * (x * z - w * y),
+                   2 * (x * y - w * z),     1 - 2 * (x * x + z * z), 2 * (y * z + w * x),
+                   2 * (x * z + w * y),     2 * (y * z - w * x),     1 - 2 * (x * x + y * y)};
+    for (int e = 0; e < 9; ++e) A[e] = R[e] * (e < 6 ? s : 0.5 * s);
+  } break;
+  default:
+    break;
+  }
+}
+
+double det(const double *M) {
+  return M[0] * (M[4] * M[8] - M[7] * M[5]) - M[3] * (M[1] * M[8] - M[7] * M[2]) + M[6] * (M[1] * M[5] - M[4] * M[2]);
+}
+
+struct Errors {
+  double reconstruct = 0., orthogonal = 0., det = 0., sorted = 0., singular = 0.;
+};
+
+/// Check N-wide batches of type T over count matrices of kind
+template <int N, typename T>
+Errors check_batches(kind_e kind, int count, std::mt19937_64 &rng) {
+  Errors err;
+  for (int b = 0; b < count; b += N) {
+    double Ad[N][9];
+    T A[9 * N], U[9 * N], S[3 * N], V[9 * N];
+    for (int l = 0; l < N; ++l) {
+      make_matrix(kind, rng, Ad[l]);
+      for (int e = 0; e < 9; ++e) A[e * N + l] = static_cast<T>(Ad[l][e]);
+    }
+    mn::math::svd_host_batch<N>(A, U, S, V);
+    for (int l = 0; l < N; ++l) {
+      double u[9], v[9], s[3], a[9], scale = 0.;
+      for (int e = 0; e < 9; ++e) u[e] = U[e * N + l], v[e] = V[e * N + l], a[e] = A[e * N + l];
+      for (int d = 0; d < 3; ++d) s[d] = S[d * N + l];
+      for (int e = 0; e < 9; ++e) scale = std::max(scale, std::abs(a[e]));
+      const double rel = 1. / (scale > 0. ? scale : 1.);
+      for (int c = 0; c < 3; ++c)
+        for (int r = 0; r < 3; ++r) {
+          double usv = u[r] * s[0] * v[c] + u[3 + r] * s[1] * v[3 + c] + u[6 + r] * s[2] * v[6 + c];
+          err.reconstruct = std::max(err.reconstruct, std::abs(usv - a[c * 3 + r]) * rel);
+          double uu = u[r] * u[c] + u[3 + r] * u[3 + c] + u[6 + r] * u[6 + c]; //< (U U^T)_rc
+          double vv = v[r] * v[c] + v[3 + r] * v[3 + c] + v[6 + r] * v[6 + c];
+          err.orthogonal = std::max({err.orthogonal, std::abs(uu - (r == c)), std::abs(vv - (r == c))});
+        }
+      err.det = std::max({err.det, std::abs(det(u) - 1.), std::abs(det(v) - 1.)});
+      err.sorted = std::max({err.sorted, (std::abs(s[1]) - s[0]) * rel, (std::abs(s[2]) - s[1]) * rel, -s[0] * rel, -s[1] * rel});
+      // Reference: scalar math::svd on the same (rounded) input, in double, row-major arguments
+      double ru[9], rs[3], rv[9];
+      mn::math::svd<double>(a[0], a[3], a[6], a[1], a[4], a[7], a[2], a[5], a[8], ru[0], ru[3], ru[6], ru[1], ru[4], ru[7],
+                            ru[2], ru[5], ru[8], rs[0], rs[1], rs[2], rv[0], rv[3], rv[6], rv[1], rv[4], rv[7], rv[2], rv[5], rv[8]);
+      for (int d = 0; d < 3; ++d) err.singular = std::max(err.singular, std::abs(s[d] - rs[d]) * rel);
+    }
+  }
+  return err;
+}
+
+/// Errors and tolerances relative to max|A|. Row-scaled matrices lose accuracy through A^T A, as in the device svd.
+template <int N, typename T>
+void check_type(const char *type, double tol, double scaled_tol, int count) {
+  std::mt19937_64 rng(7);
+  fmt::print("svd_host_batch<{}, {}> over [{}] matrices per kind:\n", N, type, count);
+  fmt::print("  {:<14} {:>12} {:>12} {:>12} {:>12} {:>12}\n", "kind", "reconstruct", "orthogonal", "det - 1", "unsorted", "S vs svd");
+  for (int k = 0; k < NumKinds; ++k) {
+    Errors e = check_batches<N, T>((kind_e)k, count, rng);
+    fmt::print("  {:<14} {:>12.3g} {:>12.3g} {:>12.3g} {:>12.3g} {:>12.3g}\n", kind_names[k], e.reconstruct, e.orthogonal, e.det,
+               e.sorted, e.singular);
+    const double t = k == RowScaled ? scaled_tol : tol;
+    MN_CHECK(e.reconstruct <= t, "  {} {}: reconstruction error {} > {}\n", type, kind_names[k], e.reconstruct, t);
+    MN_CHECK(e.orthogonal <= tol && e.det <= tol, "  {} {}: U or V not a rotation, {} {}\n", type, kind_names[k], e.orthogonal, e.det);
+    MN_CHECK(e.sorted <= t, "  {} {}: singular values not sorted by magnitude, {}\n", type, kind_names[k], e.sorted);
+    MN_CHECK(e.singular <= t, "  {} {}: singular values differ from math::svd by {} > {}\n", type, kind_names[k], e.singular, t);
+  }
+}
+} // namespace
+
+int main() {
+  check_type<8, double>("double", 1e-12, 1e-9, 1 << 15);
+  check_type<16, float>("float", 5e-6, 1e-3, 1 << 15); //< Small singular values of A^T A good to ~sqrt(eps) max|A|
+  return mn_test::result("test_svd_host_batch");
+}